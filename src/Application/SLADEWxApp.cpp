@@ -57,7 +57,7 @@
 // ----------------------------------------------------------------------------
 namespace Global
 {
-	string error = "";
+	thread_local string error = "";
 
 	int beta_num = 5;
 	int version_num = 3120;
@@ -248,7 +248,7 @@ public:
 
 		// Last 10 log lines
 		trace += "\nLast Log Messages:\n";
-		auto& log = Log::history();
+		auto log = Log::history();
 		for (auto a = log.size() - 10; a < log.size(); a++)
 			trace += log[a].message + "\n";
 
@@ -42,6 +42,55 @@ CVAR(Bool, backup_archives, true, CVAR_SAVE)
 bool Archive::save_backup = true;
 vector<ArchiveFormat> Archive::formats;
 
+// Frequently sent announcements
+const Announcement::Id EVENT_MODIFIED = Announcement::id("modified");
+const Announcement::Id EVENT_ENTRY_STATE_CHANGED = Announcement::id("entry_state_changed");
+const Announcement::Id EVENT_ENTRY_ADDED = Announcement::id("entry_added");
+const Announcement::Id EVENT_ENTRY_REMOVING = Announcement::id("entry_removing");
+const Announcement::Id EVENT_ENTRY_REMOVED = Announcement::id("entry_removed");
+const Announcement::Id EVENT_ENTRY_RENAMING = Announcement::id("entry_renaming");
+const Announcement::Id EVENT_ENTRIES_CHANGED = Announcement::id("entries_changed");
+
+namespace
+{
+	/* EventData
+	 * Announcement data for entry/directory events - an optional index
+	 * followed by a pointer. The data is held in a buffer on the stack
+	 * rather than allocated, since these are sent for every entry
+	 * added/removed/changed. Listeners must only read from it
+	 *******************************************************************/
+	class EventData : public MemChunk
+	{
+	public:
+		EventData(void* object)
+		{
+			wxUIntPtr ptr = wxPtrToUInt(object);
+			memcpy(buffer_, &ptr, sizeof(wxUIntPtr));
+			data = buffer_;
+			size = sizeof(wxUIntPtr);
+		}
+
+		EventData(int index, void* object)
+		{
+			wxUIntPtr ptr = wxPtrToUInt(object);
+			memcpy(buffer_, &index, sizeof(int));
+			memcpy(buffer_ + sizeof(int), &ptr, sizeof(wxUIntPtr));
+			data = buffer_;
+			size = sizeof(buffer_);
+		}
+
+		~EventData()
+		{
+			// Not allocated, don't let MemChunk free it
+			data = nullptr;
+			size = 0;
+		}
+
+	private:
+		uint8_t	buffer_[sizeof(int) + sizeof(wxUIntPtr)];
+	};
+}
+
 
 /*******************************************************************
  * UNDO STEPS
@@ -320,7 +369,10 @@ Archive::Archive(string format) :
 	on_disk_{ false },
 	read_only_{ false },
 	modified_{ true },
-	dir_root_{ nullptr, this }
+	dir_root_{ nullptr, this },
+	batch_level_{ 0 },
+	batch_changed_{ false },
+	batch_modified_{ false }
 {
 }
 
@@ -474,8 +526,11 @@ void Archive::setModified(bool modified)
 	// Set modified
 	this->modified_ = modified;
 
-	// Announce
-	announce("modified");
+	// Announce (once the batch is committed if batching)
+	if (batch_level_ > 0)
+		batch_modified_ = true;
+	else
+		announce(EVENT_MODIFIED);
 }
 
 /* Archive::checkEntry
@@ -709,12 +764,16 @@ void Archive::entryStateChanged(ArchiveEntry* entry)
 		return;
 
 	// Get the entry index and announce the change
-	MemChunk mc(8);
-	wxUIntPtr ptr = wxPtrToUInt(entry);
-	uint32_t index = entryIndex(entry);
-	mc.write(&index, sizeof(uint32_t));
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("entry_state_changed", mc);
+	if (batch_level_ > 0)
+	{
+		batch_changed_ = true;
+		batch_entries_.insert(entry);
+	}
+	else
+	{
+		EventData event_data(entryIndex(entry), entry);
+		announce(EVENT_ENTRY_STATE_CHANGED, event_data);
+	}
 
 
 	// If entry was set to unmodified, don't set the archive to modified
@@ -725,6 +784,51 @@ void Archive::entryStateChanged(ArchiveEntry* entry)
 	setModified(true);
 }
 
+/* Archive::beginBatchUpdate
+ * Begins a batch update of the archive. Until the matching
+ * commitBatchUpdate call, per-entry added/modified announcements are
+ * not sent - a single 'entries_changed' announcement is sent when
+ * the batch is committed instead, with the entries that were added
+ * or modified during the batch as its data. Entry removal and
+ * renaming are still announced immediately, since listeners may be
+ * holding on to the entry or its old name. Batches can be nested
+ *******************************************************************/
+void Archive::beginBatchUpdate()
+{
+	batch_level_++;
+}
+
+/* Archive::commitBatchUpdate
+ * Ends a batch update of the archive. If this ends the outermost
+ * batch, any announcements held back during the batch are sent
+ *******************************************************************/
+void Archive::commitBatchUpdate()
+{
+	if (batch_level_ == 0 || --batch_level_ > 0)
+		return;
+
+	if (batch_changed_)
+	{
+		// Send the pointers of all entries added/modified during the batch
+		MemChunk event_data(batch_entries_.size() * sizeof(wxUIntPtr));
+		for (auto entry : batch_entries_)
+		{
+			wxUIntPtr ptr = wxPtrToUInt(entry);
+			event_data.write(&ptr, sizeof(wxUIntPtr));
+		}
+
+		batch_changed_ = false;
+		batch_entries_.clear();
+		announce(EVENT_ENTRIES_CHANGED, event_data);
+	}
+
+	if (batch_modified_)
+	{
+		batch_modified_ = false;
+		announce(EVENT_MODIFIED);
+	}
+}
+
 /* Archive::getEntryTreeAsList
  * Adds the directory structure starting from [start] to [list]
  *******************************************************************/
@@ -784,6 +888,9 @@ bool Archive::paste(ArchiveTreeNode* tree, unsigned position, ArchiveTreeNode* b
 	if (!base)
 		base = &dir_root_;
 
+	// Paste as a single batch update
+	BatchUpdate batch(this);
+
 	// Set modified
 	setModified(true);
 
@@ -846,10 +953,8 @@ ArchiveTreeNode* Archive::createDir(string path, ArchiveTreeNode* base)
 	setModified(true);
 
 	// Announce
-	MemChunk mc;
-	wxUIntPtr ptr = wxPtrToUInt(dir);
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("directory_added", mc);
+	EventData event_data(dir);
+	announce("directory_added", event_data);
 
 	return dir;
 }
@@ -876,6 +981,15 @@ bool Archive::removeDir(string path, ArchiveTreeNode* base)
 	if (UndoRedo::currentlyRecording())
 		UndoRedo::currentManager()->recordUndoStep(new DirCreateDeleteUS(false, dir));
 
+	// Don't announce any entries in the directory at the end of the batch
+	if (batch_level_ > 0 && !batch_entries_.empty())
+	{
+		vector<ArchiveEntry*> entries;
+		getEntryTreeAsList(entries, dir);
+		for (auto entry : entries)
+			batch_entries_.erase(entry);
+	}
+
 	// Remove the directory from its parent
 	if (dir->getParent())
 		dir->getParent()->removeChild(dir);
@@ -883,6 +997,13 @@ bool Archive::removeDir(string path, ArchiveTreeNode* base)
 	// Delete the directory
 	delete dir;
 
+	// Entries in the directory aren't announced as removed, so make sure
+	// the batch (if any) is announced as a change
+	if (batch_level_ > 0)
+		batch_changed_ = true;
+	else
+		announce("directory_removed");
+
 	// Set the archive state to modified
 	setModified(true);
 
@@ -916,10 +1037,10 @@ bool Archive::renameDir(ArchiveTreeNode* dir, string new_name)
 		return true;
 
 	// Announce
-	MemChunk mc;
-	wxUIntPtr ptr = wxPtrToUInt(dir);
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("directory_modified", mc);
+	EventData event_data(dir);
+	announce("directory_modified", event_data);
+	if (batch_level_ > 0)
+		batch_changed_ = true;
 
 	// Update variables etc
 	setModified(true);
@@ -960,11 +1081,16 @@ ArchiveEntry* Archive::addEntry(ArchiveEntry* entry, unsigned position, ArchiveT
 	entry->state = 2;
 
 	// Announce
-	MemChunk mc;
-	wxUIntPtr ptr = wxPtrToUInt(entry);
-	mc.write(&position, sizeof(uint32_t));
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("entry_added", mc);
+	if (batch_level_ > 0)
+	{
+		batch_changed_ = true;
+		batch_entries_.insert(entry);
+	}
+	else
+	{
+		EventData event_data(position, entry);
+		announce(EVENT_ENTRY_ADDED, event_data);
+	}
 
 	// Create undo step
 	if (UndoRedo::currentlyRecording())
@@ -1048,11 +1174,8 @@ bool Archive::removeEntry(ArchiveEntry* entry)
 	int index = dir->entryIndex(entry);
 
 	// Announce (before actually removing in case entry is still needed)
-	MemChunk mc;
-	wxUIntPtr ptr = wxPtrToUInt(entry);
-	mc.write(&index, sizeof(int));
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("entry_removing", mc);
+	EventData event_data(index, entry);
+	announce(EVENT_ENTRY_REMOVING, event_data);
 
 	// Remove it from its directory
 	bool ok = dir->removeEntry(index);
@@ -1061,7 +1184,12 @@ bool Archive::removeEntry(ArchiveEntry* entry)
 	if (ok)
 	{
 		// Announce removed
-		announce("entry_removed", mc);
+		announce(EVENT_ENTRY_REMOVED, event_data);
+		if (batch_level_ > 0)
+		{
+			batch_changed_ = true;
+			batch_entries_.erase(entry);
+		}
 
 		// Delete if necessary
 		//if (delete_entry)
@@ -1233,12 +1361,8 @@ bool Archive::renameEntry(ArchiveEntry* entry, string name)
 		return renameDir(getDir(entry->getPath(true)), name);
 
 	// Announce (before actually renaming in case old name is still needed)
-	MemChunk mc;
-	int index = entryIndex(entry);
-	wxUIntPtr ptr = wxPtrToUInt(entry);
-	mc.write(&index, sizeof(int));
-	mc.write(&ptr, sizeof(wxUIntPtr));
-	announce("entry_renaming", mc);
+	EventData event_data(entryIndex(entry), entry);
+	announce(EVENT_ENTRY_RENAMING, event_data);
 
 	// Create undo step
 	if (UndoRedo::currentlyRecording())
@@ -1263,6 +1387,9 @@ bool Archive::importDir(string directory)
 	wxArrayString files;
 	wxDir::GetAllFiles(directory, &files);
 
+	// Import as a single batch update
+	BatchUpdate batch(this);
+
 	// Go through files
 	for (unsigned a = 0; a < files.size(); a++)
 	{
@@ -1706,6 +1833,9 @@ bool TreelessArchive::paste(ArchiveTreeNode* tree, unsigned position, ArchiveTre
 	if (!tree)
 		return false;
 
+	// Paste as a single batch update
+	BatchUpdate batch(this);
+
 	// Paste root entries only
 	for (unsigned a = 0; a < tree->numEntries(); a++)
 	{
@@ -98,6 +98,23 @@ public:
 	virtual bool		importDir(string directory);
 	virtual bool		hasFlatHack() { return false; }
 
+	// Batch updates
+	void	beginBatchUpdate();
+	void	commitBatchUpdate();
+	bool	isBatchUpdating() const { return batch_level_ > 0; }
+
+	// Begins a batch update on the given archive, and commits it when it
+	// goes out of scope
+	class BatchUpdate
+	{
+	public:
+		BatchUpdate(Archive* archive) : archive_{ archive } { if (archive_) archive_->beginBatchUpdate(); }
+		~BatchUpdate() { if (archive_) archive_->commitBatchUpdate(); }
+
+	private:
+		Archive*	archive_;
+	};
+
 	// Directory stuff
 	virtual ArchiveTreeNode*	getDir(string path, ArchiveTreeNode* base = nullptr);
 	virtual ArchiveTreeNode*	createDir(string path, ArchiveTreeNode* base = nullptr);
@@ -165,6 +182,10 @@ protected:
 private:
 	bool			modified_;
 	ArchiveTreeNode	dir_root_;
+	int				batch_level_;
+	bool			batch_changed_;		// Entries were added/modified during the current batch update
+	std::set<ArchiveEntry*>	batch_entries_;	// Entries added/modified during the current batch update
+	bool			batch_modified_;	// Modified status was changed during the current batch update
 
 	static vector<ArchiveFormat>	formats;
 };
@@ -68,6 +68,9 @@ ArchiveEntry::ArchiveEntry(string name, uint32_t size)
 	this->prev = nullptr;
 	this->encrypted = ENC_NONE;
 	this->index_guess = 0;
+	this->content_hash = 0;
+	this->content_hash_version = 0;
+	this->content_hash_valid = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -96,6 +99,11 @@ ArchiveEntry::ArchiveEntry(ArchiveEntry& copy)
 	// Copy data
 	data.importMem(copy.getData(true), copy.getSize());
 
+	// Copy content hash (if it is up to date)
+	this->content_hash = copy.content_hash;
+	this->content_hash_version = data.getVersion();
+	this->content_hash_valid = copy.content_hash_valid && copy.content_hash_version == copy.data.getVersion();
+
 	// Copy extra properties
 	copy.exProps().copyTo(ex_props);
 
@@ -241,13 +249,44 @@ MemChunk& ArchiveEntry::getMCData(bool allow_load)
 	// Load the data if needed (and possible)
 	if (allow_load && !isLoaded() && parent_archive && size > 0)
 	{
+		// Keep the content hash if it was still valid when the data was
+		// unloaded (the data loaded will be the same)
+		bool keep_hash = content_hash_valid && content_hash_version == data.getVersion();
+
 		data_loaded = parent_archive->loadEntryData(this);
 		setState(0);
+
+		if (keep_hash && data_loaded)
+			content_hash_version = data.getVersion();
 	}
 
 	return data;
 }
 
+// ----------------------------------------------------------------------------
+// ArchiveEntry::getContentHash
+//
+// Returns a 64-bit hash of the entry data. The hash is cached and only
+// recalculated when the entry data has changed, and is kept if the data is
+// unloaded. If [allow_load] is true, entry data will be loaded if needed
+// ----------------------------------------------------------------------------
+uint64_t ArchiveEntry::getContentHash(bool allow_load)
+{
+	// Use cached hash if the data hasn't changed since it was calculated
+	if (content_hash_valid && content_hash_version == data.getVersion())
+		return content_hash;
+
+	// Calculate hash (don't cache it if the data couldn't be loaded)
+	MemChunk& mc = getMCData(allow_load);
+	if (!isLoaded() && size > 0)
+		return mc.hash();
+	content_hash = mc.hash();
+	content_hash_version = mc.getVersion();
+	content_hash_valid = true;
+
+	return content_hash;
+}
+
 // ----------------------------------------------------------------------------
 // ArchiveEntry::getShared
 //
@@ -262,6 +301,23 @@ ArchiveEntry::SPtr ArchiveEntry::getShared()
 		return nullptr;
 }
 
+// ----------------------------------------------------------------------------
+// ArchiveEntry::setName
+//
+// Sets the entry's name, keeping the parent directory's name lookup updated
+// ----------------------------------------------------------------------------
+void ArchiveEntry::setName(string name)
+{
+	if (parent)
+		parent->unindexEntryName(this);
+
+	this->name = name;
+	upper_name = name.Upper();
+
+	if (parent)
+		parent->indexEntryName(this);
+}
+
 // ----------------------------------------------------------------------------
 // ArchiveEntry::setState
 //
@@ -300,8 +356,11 @@ void ArchiveEntry::unloadData()
 	if (getState() > 0)
 		return;
 
-	// Delete any data
+	// Delete any data (keeping the content hash if it is up to date)
+	bool keep_hash = content_hash_valid && content_hash_version == data.getVersion();
 	data.clear();
+	if (keep_hash)
+		content_hash_version = data.getVersion();
 
 	// Update variables etc
 	setLoaded(false);
@@ -350,8 +409,7 @@ bool ArchiveEntry::rename(string new_name)
 	}
 
 	// Update attributes
-	name = new_name;
-	upper_name = name.Upper();
+	setName(new_name);
 	setState(1);
 
 	return true;
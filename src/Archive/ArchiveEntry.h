@@ -43,6 +43,11 @@ private:
 	ArchiveEntry*	next;
 	ArchiveEntry*	prev;
 
+	// Content hash cache
+	uint64_t		content_hash;
+	uint32_t		content_hash_version;	// Data version the hash was calculated for
+	bool			content_hash_valid;
+
 public:
 	typedef	std::unique_ptr<ArchiveEntry>	UPtr;
 	typedef	std::shared_ptr<ArchiveEntry>	SPtr;
@@ -74,9 +79,10 @@ public:
 	ArchiveEntry*		nextEntry()			{ return next; }
 	ArchiveEntry*		prevEntry()			{ return prev; }
 	SPtr				getShared();
+	uint64_t			getContentHash(bool allow_load = true);
 
 	// Modifiers (won't change entry state, except setState of course :P)
-	void		setName(string name) { this->name = name; upper_name = name.Upper(); }
+	void		setName(string name);
 	void		setLoaded(bool loaded = true) { data_loaded = loaded; }
 	void		setType(EntryType* type, int r = 0) { this->type = type; reliability = r; }
 	void		setState(uint8_t state);
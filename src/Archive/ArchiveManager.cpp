@@ -635,6 +635,10 @@ bool ArchiveManager::closeArchive(int index)
 	if (index < 0 || index >= (int) open_archives_.size())
 		return false;
 
+	// Send a single resources_updated announcement for this archive and
+	// any open children
+	Announcer::Batch resources_batch(theResourceManager);
+
 	// Announce archive closing
 	MemChunk mc;
 	int32_t temp = index;
@@ -750,6 +754,8 @@ bool ArchiveManager::closeArchive(Archive* archive)
 // ----------------------------------------------------------------------------
 void ArchiveManager::closeAll()
 {
+	Announcer::Batch resources_batch(theResourceManager);
+
 	// Close the first archive in the list until no archives are open
 	while (open_archives_.size() > 0)
 		closeArchive(0);
@@ -946,6 +952,9 @@ bool ArchiveManager::openBaseResource(int index)
 	if (base_resource_archive_ && base_resource == index)
 		return true;
 
+	// Send a single resources_updated announcement for the swap
+	Announcer::Batch resources_batch(theResourceManager);
+
 	// Close/delete current base resource archive
 	if (base_resource_archive_)
 	{
@@ -1339,12 +1348,20 @@ ArchiveEntry* ArchiveManager::getBookmark(unsigned index)
 }
 
 // ----------------------------------------------------------------------------
-// ArchiveManager::onAnnouncement
+// ArchiveManager::onAnnouncementEvent
 //
 // Called when an announcement is recieved from one of the archives in the list
 // ----------------------------------------------------------------------------
-void ArchiveManager::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void ArchiveManager::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id saved = Announcement::id("saved");
+	static const Announcement::Id modified = Announcement::id("modified");
+	static const Announcement::Id entry_modified = Announcement::id("entry_modified");
+
+	// Only interested in saved/modified announcements
+	if (event != saved && event != modified && event != entry_modified)
+		return;
+
 	// Reset event data for reading
 	event_data.seek(0, SEEK_SET);
 
@@ -1353,7 +1370,7 @@ void ArchiveManager::onAnnouncement(Announcer* announcer, string event_name, Mem
 	if (index >= 0)
 	{
 		// If the archive was saved
-		if (event_name == "saved")
+		if (event == saved)
 		{
 			MemChunk mc;
 			mc.write(&index, 4);
@@ -1361,7 +1378,7 @@ void ArchiveManager::onAnnouncement(Announcer* announcer, string event_name, Mem
 		}
 
 		// If the archive was modified
-		if (event_name == "modified" || event_name == "entry_modified")
+		if (event == modified || event == entry_modified)
 		{
 			MemChunk mc;
 			mc.write(&index, 4);
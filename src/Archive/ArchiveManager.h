@@ -68,7 +68,7 @@ public:
 	ArchiveEntry*	getBookmark(unsigned index);
 	unsigned		numBookmarks() const { return bookmarks_.size(); }
 
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override;
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 
 private:
 	struct OpenArchive
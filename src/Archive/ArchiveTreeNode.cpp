@@ -116,7 +116,7 @@ string ArchiveTreeNode::getName()
 // ArchiveTreeNode::entryIndex
 //
 // Returns the index of [entry] within this directory, or -1 if the entry
-// doesn't exist
+// doesn't exist (or is before [startfrom])
 // ----------------------------------------------------------------------------
 int ArchiveTreeNode::entryIndex(ArchiveEntry* entry, size_t startfrom)
 {
@@ -124,39 +124,41 @@ int ArchiveTreeNode::entryIndex(ArchiveEntry* entry, size_t startfrom)
 	if (!entry)
 		return -1;
 
-	// Search for it
-	size_t size = entries_.size();
-	if (entry->index_guess < startfrom || entry->index_guess >= size)
+	// Make sure the cached entry indices are up to date
+	refreshEntryIndices();
+
+	// Check the entry's cached index
+	size_t index = entry->index_guess;
+	if (index < startfrom || index >= entries_.size() || entries_[index].get() != entry)
+		return -1;
+
+	return (int)index;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::entriesNamed
+//
+// Returns all entries in this directory matching [name] (non-case-sensitive),
+// in the order they appear in the directory
+// ----------------------------------------------------------------------------
+vector<ArchiveEntry*> ArchiveTreeNode::entriesNamed(const string& name, bool cut_ext)
+{
+	auto& names = cut_ext ? names_noext_ : names_;
+	auto i = names.find(name.Upper());
+	if (i == names.end())
+		return {};
+
+	vector<ArchiveEntry*> list = i->second;
+	if (list.size() > 1)
 	{
-		for (unsigned a = startfrom; a < size; a++)
-		{
-			if (entries_[a].get() == entry)
-			{
-				entry->index_guess = a;
-				return (int)a;
-			}
-		}
-	} else {
-		for (unsigned a = entry->index_guess; a < size; a++)
-		{
-			if (entries_[a].get() == entry)
-			{
-				entry->index_guess = a;
-				return (int)a;
-			}
-		}
-		for (unsigned a = startfrom; a < entry->index_guess; a++)
+		refreshEntryIndices();
+		std::sort(list.begin(), list.end(), [](ArchiveEntry* left, ArchiveEntry* right)
 		{
-			if (entries_[a].get() == entry)
-			{
-				entry->index_guess = a;
-				return (int)a;
-			}
-		}
+			return left->index_guess < right->index_guess;
+		});
 	}
 
-	// Not found
-	return -1;
+	return list;
 }
 
 vector<ArchiveEntry::SPtr> ArchiveTreeNode::allEntries()
@@ -217,16 +219,13 @@ ArchiveEntry* ArchiveTreeNode::entry(string name, bool cut_ext)
 	if (name == "")
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (S_CMPNOCASE(entry->getName(cut_ext), name))
-			return entry.get();
-	}
+	// Look up (non-case-sensitive) name
+	auto& names = cut_ext ? names_noext_ : names_;
+	auto i = names.find(name.Upper());
+	if (i == names.end())
+		return nullptr;
 
-	// Not found
-	return nullptr;
+	return firstEntryOf(i->second);
 }
 
 // ----------------------------------------------------------------------------
@@ -237,20 +236,7 @@ ArchiveEntry* ArchiveTreeNode::entry(string name, bool cut_ext)
 // ----------------------------------------------------------------------------
 ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(string name, bool cut_ext)
 {
-	// Check name was given
-	if (name == "")
-		return nullptr;
-
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (S_CMPNOCASE(entry->getName(cut_ext), name))
-			return entry;
-	}
-
-	// Not found
-	return nullptr;
+	return sharedEntry(entry(name, cut_ext));
 }
 
 // ----------------------------------------------------------------------------
@@ -261,13 +247,11 @@ ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(string name, bool cut_ext)
 // ----------------------------------------------------------------------------
 ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(ArchiveEntry* entry)
 {
-	// Find entry
-	for (auto& e : entries_)
-		if (entry == e.get())
-			return e;
+	int index = entryIndex(entry);
+	if (index < 0)
+		return nullptr; // Not in this ArchiveTreeNode
 
-	// Not in this ArchiveTreeNode
-	return nullptr;
+	return entries_[index];
 }
 
 // ----------------------------------------------------------------------------
@@ -327,6 +311,9 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry* entry, unsigned index)
 
 		// Add it to end
 		entries_.push_back(ArchiveEntry::SPtr(entry));
+		entry->index_guess = entries_.size() - 1;
+		if (index_refresh_from_ == entry->index_guess)
+			index_refresh_from_++;
 	}
 	else
 	{
@@ -341,10 +328,12 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry* entry, unsigned index)
 
 		// Add it at index
 		entries_.insert(entries_.begin() + index, ArchiveEntry::SPtr(entry));
+		index_refresh_from_ = MIN(index_refresh_from_, index);
 	}
 
 	// Set entry's parent to this node
 	entry->parent = this;
+	indexEntryName(entry);
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -380,6 +369,9 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry::SPtr& entry, unsigned index)
 
 		// Add it to end
 		entries_.push_back(ArchiveEntry::SPtr(entry));
+		entry->index_guess = entries_.size() - 1;
+		if (index_refresh_from_ == entry->index_guess)
+			index_refresh_from_++;
 	}
 	else
 	{
@@ -394,10 +386,12 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry::SPtr& entry, unsigned index)
 
 		// Add it at index
 		entries_.insert(entries_.begin() + index, ArchiveEntry::SPtr(entry));
+		index_refresh_from_ = MIN(index_refresh_from_, index);
 	}
 
 	// Set entry's parent to this node
 	entry->parent = this;
+	indexEntryName(entry.get());
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -418,7 +412,8 @@ bool ArchiveTreeNode::removeEntry(unsigned index)
 	if (index >= entries_.size())
 		return false;
 
-	// De-parent entry
+	// Remove from name lookup and de-parent entry
+	unindexEntryName(entries_[index].get());
 	entries_[index]->parent = nullptr;
 
 	// De-link entry
@@ -429,6 +424,7 @@ bool ArchiveTreeNode::removeEntry(unsigned index)
 
 	// Remove it from the entry list
 	entries_.erase(entries_.begin() + index);
+	index_refresh_from_ = MIN(index_refresh_from_, index);
 
 	return true;
 }
@@ -453,6 +449,8 @@ bool ArchiveTreeNode::swapEntries(unsigned index1, unsigned index2)
 	//entries[index1] = entry2;
 	//entries[index2] = entry1;
 	entries_[index1].swap(entries_[index2]);
+	entry1->index_guess = index2;
+	entry2->index_guess = index1;
 
 	// Update links
 	linkEntries(entryAt(index1-1), entry2);
@@ -472,6 +470,9 @@ void ArchiveTreeNode::clear()
 {
 	// Clear entries
 	entries_.clear();
+	names_.clear();
+	names_noext_.clear();
+	index_refresh_from_ = 0;
 
 	// Clear subdirs
 	for (unsigned a = 0; a < children.size(); a++)
@@ -573,32 +574,104 @@ bool ArchiveTreeNode::exportTo(string path)
 	return true;
 }
 
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::ensureUniqueName
+//
+// Renames [entry] with a numbered suffix if any other entry in this directory
+// has the same name
+// ----------------------------------------------------------------------------
 void ArchiveTreeNode::ensureUniqueName(ArchiveEntry* entry)
 {
-	unsigned index = 0;
 	unsigned number = 0;
-	unsigned n_entries = entries_.size();
 	wxFileName fn(entry->getName());
 	string name = fn.GetFullName();
-	while (index < n_entries)
+	while (true)
 	{
-		if (entries_[index].get() == entry)
-		{
-			index++;
-			continue;
-		}
-
-		if (S_CMPNOCASE(entries_[index]->getName(false), name))
-		{
-			fn.SetName(S_FMT("%s%d", CHR(entry->getName(true)), ++number));
-			name = fn.GetFullName();
-			index = 0;
-			continue;
-		}
+		// Check for any other entry with the same name
+		auto i = names_.find(name.Upper());
+		if (i == names_.end() || (i->second.size() == 1 && i->second[0] == entry))
+			break;
 
-		index++;
+		fn.SetName(S_FMT("%s%d", CHR(entry->getName(true)), ++number));
+		name = fn.GetFullName();
 	}
 
 	if (number > 0)
 		entry->rename(name);
 }
+
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::refreshEntryIndices
+//
+// Updates the cached index of all entries whose index may have changed since
+// the last refresh (ie. after an insertion or removal)
+// ----------------------------------------------------------------------------
+void ArchiveTreeNode::refreshEntryIndices()
+{
+	for (size_t a = index_refresh_from_; a < entries_.size(); a++)
+		entries_[a]->index_guess = a;
+
+	index_refresh_from_ = entries_.size();
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::indexEntryName
+//
+// Adds [entry] to the name lookup maps, if it is in this directory
+// ----------------------------------------------------------------------------
+void ArchiveTreeNode::indexEntryName(ArchiveEntry* entry)
+{
+	if (entryIndex(entry) < 0)
+		return;
+
+	names_[entry->upper_name].push_back(entry);
+	names_noext_[entry->getName(true).Upper()].push_back(entry);
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::unindexEntryName
+//
+// Removes [entry] from the name lookup maps, if it is in this directory.
+// Must be called before the entry's name is changed
+// ----------------------------------------------------------------------------
+void ArchiveTreeNode::unindexEntryName(ArchiveEntry* entry)
+{
+	if (entryIndex(entry) < 0)
+		return;
+
+	auto unindex = [entry](EntryNameMap& names, const string& key)
+	{
+		auto i = names.find(key);
+		if (i == names.end())
+			return;
+
+		auto& list = i->second;
+		list.erase(std::remove(list.begin(), list.end(), entry), list.end());
+		if (list.empty())
+			names.erase(i);
+	};
+
+	unindex(names_, entry->upper_name);
+	unindex(names_noext_, entry->getName(true).Upper());
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveTreeNode::firstEntryOf
+//
+// Returns the entry in [list] that comes first in this directory
+// ----------------------------------------------------------------------------
+ArchiveEntry* ArchiveTreeNode::firstEntryOf(const vector<ArchiveEntry*>& list)
+{
+	if (list.empty())
+		return nullptr;
+	if (list.size() == 1)
+		return list[0];
+
+	refreshEntryIndices();
+	ArchiveEntry* first = list[0];
+	for (auto entry : list)
+		if (entry->index_guess < first->index_guess)
+			first = entry;
+
+	return first;
+}
@@ -6,6 +6,7 @@
 class ArchiveTreeNode : public STreeNode
 {
 	friend class Archive;
+	friend class ArchiveEntry;
 public:
 	ArchiveTreeNode(ArchiveTreeNode* parent = nullptr, Archive* archive = nullptr);
 	~ArchiveTreeNode();
@@ -28,6 +29,7 @@ public:
 	ArchiveEntry::SPtr	sharedEntry(ArchiveEntry* entry);
 	unsigned			numEntries(bool inc_subdirs = false);
 	int					entryIndex(ArchiveEntry* entry, size_t startfrom = 0);
+	vector<ArchiveEntry*>	entriesNamed(const string& name, bool cut_ext = false);
 
 	vector<ArchiveEntry::SPtr>	allEntries();
 
@@ -63,5 +65,15 @@ private:
 	vector<ArchiveEntry::SPtr>	entries_;
 	bool						allow_duplicate_names_ = true;
 
-	void	ensureUniqueName(ArchiveEntry* entry);
+	// Name lookup (keys are upper-case names)
+	typedef std::unordered_map<string, vector<ArchiveEntry*>, wxStringHash> EntryNameMap;
+	EntryNameMap	names_;
+	EntryNameMap	names_noext_;
+	size_t			index_refresh_from_ = 0;	// Entries from this index onwards may have a stale index_guess
+
+	void			ensureUniqueName(ArchiveEntry* entry);
+	void			refreshEntryIndices();
+	void			indexEntryName(ArchiveEntry* entry);
+	void			unindexEntryName(ArchiveEntry* entry);
+	ArchiveEntry*	firstEntryOf(const vector<ArchiveEntry*>& list);
 };
@@ -32,9 +32,18 @@
  *******************************************************************/
 #include "Main.h"
 #include "DirArchive.h"
+#include "DirArchiveWatcher.h"
 #include "General/UI.h"
 #include "WadArchive.h"
 #include "App.h"
+#include "Utility/Parallel.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+CVAR(Bool, dir_archive_watch, true, CVAR_SAVE)
+CVAR(Int, dir_archive_detect_size, 1024, CVAR_SAVE)	// Files larger than this (KB) are type-detected from their header only
 
 
 /*******************************************************************
@@ -43,6 +52,30 @@
 EXTERN_CVAR(Bool, archive_load_data)
 
 
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* readEntryFile
+ * Reads the first [len] bytes of the file at [path] into [entry]'s
+ * data (or the whole file if [len] is 0), without notifying the
+ * parent archive. Safe to call from worker threads as long as each
+ * thread reads into a different entry
+ *******************************************************************/
+static bool readEntryFile(ArchiveEntry* entry, const string& path, uint32_t len)
+{
+	wxFile file(path);
+	if (!file.IsOpened())
+		return false;
+
+	if (!entry->getMCData(false).importFileStream(file, len))
+		return false;
+
+	entry->setLoaded(true);
+	return true;
+}
+
+
 /*******************************************************************
  * DIRARCHIVE CLASS FUNCTIONS
  *******************************************************************/
@@ -84,25 +117,36 @@ bool DirArchive::open(string filename)
 	wxDir dir(filename);
 	dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
 
+	// Get file sizes and modification times (only needs a stat per file, so
+	// can be done in parallel)
+	vector<uint32_t> sizes(files.size(), 0);
+	vector<time_t> mtimes(files.size(), 0);
+	Parallel::forEach(files.size(), [&](unsigned a)
+	{
+		wxStructStat info;
+		if (wxStat(files[a], &info) == 0)
+		{
+			sizes[a] = info.st_size;
+			mtimes[a] = info.st_mtime;
+		}
+	});
+
 	// Stop announcements (don't want to be announcing modification due to entries being added etc)
 	setMuted(true);
 
-	UI::setSplashProgressMessage("Reading files");
+	// Create entries (data isn't read yet)
+	vector<ArchiveEntry*> new_entries(files.size());
 	for (unsigned a = 0; a < files.size(); a++)
 	{
-		UI::setSplashProgress((float)a / (float)files.size());
-
 		// Cut off directory to get entry name + relative path
 		string name = files[a];
 		name.Remove(0, filename.Length());
 		if (name.StartsWith(separator_))
 			name.Remove(0, 1);
 
-		//LOG_MESSAGE(3, fn.GetPath(true, wxPATH_UNIX));
-
 		// Create entry
 		wxFileName fn(name);
-		ArchiveEntry* new_entry = new ArchiveEntry(fn.GetFullName());
+		ArchiveEntry* new_entry = new ArchiveEntry(fn.GetFullName(), sizes[a]);
 
 		// Setup entry info
 		new_entry->setLoaded(false);
@@ -113,20 +157,54 @@ bool DirArchive::open(string filename)
 		ndir->addEntry(new_entry);
 		ndir->dirEntry()->exProp("filePath") = filename + fn.GetPath(true, wxPATH_UNIX);
 
-		// Read entry data
-		new_entry->importFile(files[a]);
-		new_entry->setLoaded(true);
+		file_modification_times_[new_entry] = mtimes[a];
+		new_entries[a] = new_entry;
+	}
 
-		time_t modtime = wxFileModificationTime(files[a]);
-		file_modification_times_[new_entry] = modtime;
+	// Detect entry types in parallel. Large files only have their header read
+	// (unless all data is to be loaded), if that isn't enough to detect the
+	// type the whole file is read
+	UI::setSplashProgressMessage("Detecting entry types");
+	UI::setSplashProgress(0);
+	uint32_t header_size = MAX(0, (int)dir_archive_detect_size) * 1024;
+	bool load_data = archive_load_data;
+	vector<uint8_t> partial(files.size(), 0);
+	Parallel::forEach(
+		new_entries.size(),
+		[&](unsigned a)
+		{
+			ArchiveEntry* entry = new_entries[a];
+			bool full = load_data || sizes[a] <= header_size;
+			if (!readEntryFile(entry, files[a], full ? 0 : header_size))
+				return;
+			EntryType::detectEntryType(entry);
 
-		// Detect entry type
-		EntryType::detectEntryType(new_entry);
+			if (!full && entry->getType() == EntryType::unknownType())
+			{
+				full = true;
+				if (readEntryFile(entry, files[a], 0))
+					EntryType::detectEntryType(entry);
+			}
+			partial[a] = full ? 0 : 1;
 
-		// Unload data if needed
-		if (!archive_load_data)
-			new_entry->unloadData();
-	}
+			// Unload data if needed
+			if (!load_data)
+			{
+				entry->getMCData(false).clear();
+				entry->setLoaded(false);
+			}
+		},
+		[](unsigned done, unsigned total)
+		{
+			UI::setSplashProgress((float)done / (float)total);
+			return true;
+		}
+	);
+
+	// Keep track of entries with a type detected from the header only
+	for (unsigned a = 0; a < new_entries.size(); a++)
+		if (partial[a])
+			header_typed_.insert(new_entries[a]);
 
 	// Add empty directories
 	for (unsigned a = 0; a < dirs.size(); a++)
@@ -154,6 +232,10 @@ bool DirArchive::open(string filename)
 	setModified(false);
 	on_disk_ = true;
 
+	// Start tracking changes on disk
+	if (dir_archive_watch)
+		watcher_ = std::make_unique<DirArchiveWatcher>(filename);
+
 	UI::setSplashProgressMessage("");
 
 	return true;
@@ -304,6 +386,11 @@ bool DirArchive::loadEntryData(ArchiveEntry* entry)
 	if (entry->importFile(entry->exProp("filePath").getStringValue()))
 	{
 		file_modification_times_[entry] = wxFileModificationTime(entry->exProp("filePath").getStringValue());
+
+		// Redetect type if it was only detected from the file header on open
+		if (header_typed_.erase(entry) > 0)
+			EntryType::detectEntryType(entry);
+
 		return true;
 	}
 
@@ -340,6 +427,7 @@ bool DirArchive::removeDir(string path, ArchiveTreeNode* base)
 	{
 		LOG_MESSAGE(2, entries[a]->exProp("filePath").getStringValue());
 		removed_files_.push_back(entries[a]->exProp("filePath").getStringValue());
+		header_typed_.erase(entries[a]);
 	}
 
 	// Do normal dir remove
@@ -390,7 +478,10 @@ bool DirArchive::removeEntry(ArchiveEntry* entry)
 	string old_name = entry->exProp("filePath").getStringValue();
 	bool success = Archive::removeEntry(entry);
 	if (success)
+	{
 		removed_files_.push_back(old_name);
+		header_typed_.erase(entry);
+	}
 	return success;
 }
 
@@ -461,6 +552,11 @@ vector<Archive::MapDesc> DirArchive::detectMaps()
 	{
 		ArchiveEntry* entry = mapdir->entryAt(a);
 
+		// Load the entry if its type was only detected from the header, so
+		// that wad archives are detected properly
+		if (header_typed_.count(entry) > 0)
+			entry->getMCData();
+
 		// Maps can only be wad archives
 		if (entry->getType()->formatId() != "archive_wad")
 			continue;
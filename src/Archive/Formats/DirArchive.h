@@ -4,6 +4,9 @@
 
 #include "Archive/Archive.h"
 #include "common.h"
+#include <unordered_set>
+
+class DirArchiveWatcher;
 
 struct DirEntryChange
 {
@@ -43,6 +46,7 @@ public:
 	const vector<string>&	removedFiles() const { return removed_files_; }
 	time_t					fileModificationTime(ArchiveEntry* entry)
 							{ return file_modification_times_[entry]; }
+	DirArchiveWatcher*		watcher() const { return watcher_.get(); }
 
 	// Opening
 	bool	open(string filename) override;		// Open from File
@@ -86,6 +90,11 @@ private:
 	std::map<ArchiveEntry*, time_t>	file_modification_times_;
 	vector<string>					removed_files_;
 	IgnoredFileChanges				ignored_file_changes_;
+	std::unique_ptr<DirArchiveWatcher>	watcher_;
+
+	// Entries with a type detected from the file header only (on open),
+	// redetected when their data is loaded
+	std::unordered_set<ArchiveEntry*>	header_typed_;
 };
 
 class DirArchiveTraverser : public wxDirTraverser
@@ -0,0 +1,315 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    DirArchiveWatcher.cpp
+// Description: DirArchiveWatcher class, tracks changes to the files in a
+//              directory archive's folder on disk (via inotify on Linux) so
+//              that external changes can be found without rescanning the
+//              whole folder
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "DirArchiveWatcher.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// Past this many changed paths it's cheaper to just rescan
+	const unsigned max_changes = 50000;
+
+#ifdef __linux__
+	const uint32_t watch_mask =
+		IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+		IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// DirArchiveWatcher Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::DirArchiveWatcher
+//
+// DirArchiveWatcher class constructor. Starts watching the folder at [path]
+// on a background thread (if supported)
+// ----------------------------------------------------------------------------
+DirArchiveWatcher::DirArchiveWatcher(const string& path) :
+	path_{ path },
+	active_{ false },
+	stop_{ false }
+{
+	// Paths from wxDir never have a trailing separator
+	if (path_.length() > 1 && (path_.EndsWith("/") || path_.EndsWith("\\")))
+		path_.RemoveLast();
+
+#ifdef __linux__
+	thread_ = std::thread(&DirArchiveWatcher::run, this);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::~DirArchiveWatcher
+//
+// DirArchiveWatcher class destructor
+// ----------------------------------------------------------------------------
+DirArchiveWatcher::~DirArchiveWatcher()
+{
+	stop_ = true;
+	if (thread_.joinable())
+		thread_.join();
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::takeChanges
+//
+// Moves the paths of all files and directories changed since the last call
+// into [paths]. Returns false if the changes couldn't be tracked, in which case
+// the whole folder needs to be rescanned
+// ----------------------------------------------------------------------------
+bool DirArchiveWatcher::takeChanges(vector<string>& paths)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	paths.assign(changed_.begin(), changed_.end());
+	changed_.clear();
+
+	// Any changes from here on are tracked if we're watching, so only one
+	// rescan is needed
+	if (rescan_ || !active_)
+	{
+		rescan_ = !active_;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::run
+//
+// Watcher thread function. Adds watches for the folder and all its
+// subfolders, then records changes as they're reported
+// ----------------------------------------------------------------------------
+void DirArchiveWatcher::run()
+{
+#ifdef __linux__
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0)
+		return;
+
+	// Watch all folders (if we run out of watches, changes can't be tracked)
+	if (!addWatches(path_, true))
+	{
+		close(fd_);
+		fd_ = -1;
+		return;
+	}
+	active_ = true;
+
+	// Wait for events
+	pollfd pfd = { fd_, POLLIN, 0 };
+	while (!stop_)
+	{
+		int ret = poll(&pfd, 1, 250);
+		if (ret > 0 && (pfd.revents & POLLIN))
+			readEvents();
+		else if (ret < 0 && errno != EINTR)
+		{
+			active_ = false;
+			break;
+		}
+	}
+
+	close(fd_);
+	fd_ = -1;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::pathChanged
+//
+// Records a change to the file or directory at [path]
+// ----------------------------------------------------------------------------
+void DirArchiveWatcher::pathChanged(const string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (rescan_)
+		return;
+
+	changed_.insert(path);
+	if (changed_.size() > max_changes)
+	{
+		rescan_ = true;
+		changed_.clear();
+	}
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::needRescan
+//
+// Called when changes were missed, the next check will rescan the folder
+// ----------------------------------------------------------------------------
+void DirArchiveWatcher::needRescan()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	rescan_ = true;
+	changed_.clear();
+}
+
+#ifdef __linux__
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::addWatches
+//
+// Watches [dir] and all its subdirectories. If not [initial], the contents of
+// [dir] are also recorded as changed (since they may have been created before
+// the watch was added). Returns false if any watch couldn't be added
+// ----------------------------------------------------------------------------
+bool DirArchiveWatcher::addWatches(const string& dir, bool initial)
+{
+	int wd = inotify_add_watch(fd_, dir.fn_str(), watch_mask);
+	if (wd < 0)
+		return false;
+	watch_paths_[wd] = dir;
+
+	wxDir wxdir(dir);
+	if (!wxdir.IsOpened())
+		return true;
+
+	// Record new files
+	string name;
+	if (!initial)
+	{
+		bool cont = wxdir.GetFirst(&name, wxEmptyString, wxDIR_FILES);
+		while (cont)
+		{
+			pathChanged(dir + "/" + name);
+			cont = wxdir.GetNext(&name);
+		}
+	}
+
+	// Watch subdirectories
+	bool ok = true;
+	bool cont = wxdir.GetFirst(&name, wxEmptyString, wxDIR_DIRS);
+	while (cont && !stop_)
+	{
+		string subdir = dir + "/" + name;
+		if (!initial)
+			pathChanged(subdir);
+		ok = addWatches(subdir, initial) && ok;
+		cont = wxdir.GetNext(&name);
+	}
+
+	return ok;
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveWatcher::readEvents
+//
+// Reads and handles all pending inotify events
+// ----------------------------------------------------------------------------
+void DirArchiveWatcher::readEvents()
+{
+	alignas(inotify_event) char buffer[16384];
+
+	while (!stop_)
+	{
+		ssize_t length = read(fd_, buffer, sizeof(buffer));
+		if (length <= 0)
+			return;
+
+		const char* ptr = buffer;
+		while (ptr < buffer + length)
+		{
+			auto event = (const inotify_event*)ptr;
+			ptr += sizeof(inotify_event) + event->len;
+
+			// Events were lost
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				needRescan();
+				continue;
+			}
+
+			// Watch removed (directory deleted or moved away)
+			if (event->mask & IN_IGNORED)
+			{
+				auto i = watch_paths_.find(event->wd);
+				if (i != watch_paths_.end())
+				{
+					if (i->second == path_)
+						needRescan();
+					watch_paths_.erase(i);
+				}
+				continue;
+			}
+
+			// Get changed path (hidden files aren't part of the archive)
+			auto dir = watch_paths_.find(event->wd);
+			if (dir == watch_paths_.end() || event->len == 0 || event->name[0] == '.')
+				continue;
+			string path = dir->second + "/" + wxString(event->name, *wxConvFileName);
+			pathChanged(path);
+
+			if (!(event->mask & IN_ISDIR))
+				continue;
+
+			// Directory moved away, stop watching it (it will be watched
+			// again if it was moved within the archive)
+			if (event->mask & IN_MOVED_FROM)
+			{
+				for (auto& watch : watch_paths_)
+					if (watch.second == path || watch.second.StartsWith(path + "/"))
+						inotify_rm_watch(fd_, watch.first);
+			}
+
+			// Directory created or moved in, watch it and its contents
+			else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+			{
+				if (!addWatches(path, false))
+					needRescan();
+			}
+		}
+	}
+}
+#endif
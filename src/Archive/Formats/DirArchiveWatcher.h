@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Watches a directory archive's folder on disk for changes (using inotify on
+// Linux) and keeps track of which paths have changed, so that checking the
+// archive for external changes only needs to look at those paths. If changes
+// can't be tracked (no inotify, watch limit reached, event queue overflow)
+// the archive has to be fully rescanned instead
+class DirArchiveWatcher
+{
+public:
+	DirArchiveWatcher(const string& path);
+	~DirArchiveWatcher();
+
+	bool	isActive() const { return active_; }
+	bool	takeChanges(vector<string>& paths);
+
+private:
+	string				path_;
+	std::atomic<bool>	active_;
+	std::atomic<bool>	stop_;
+	std::thread			thread_;
+
+	// Changes (shared with the watcher thread)
+	std::mutex			mutex_;
+	std::set<string>	changed_;
+	bool				rescan_	= true;
+
+#ifdef __linux__
+	int								fd_	= -1;
+	std::unordered_map<int, string>	watch_paths_;
+
+	bool	addWatches(const string& dir, bool initial);
+	void	readEvents();
+#endif
+
+	void	run();
+	void	pathChanged(const string& path);
+	void	needRescan();
+};
@@ -294,13 +294,81 @@ void WadArchive::updateNamespaces()
 				ns.name = special_namespaces[n].name;
 		}
 
-		ns.start_index = entryIndex(ns.start);
-		ns.end_index = entryIndex(ns.end);
-
 		// Testing
 		//LOG_MESSAGE(1, "Namespace %s from %s (%d) to %s (%d)", ns.name,
 		//	ns.start->getName(), ns.start_index, ns.end->getName(), ns.end_index);
 	}
+
+	// Update namespace indices and intervals
+	updateNamespaceIndices();
+	ns_stale_ = false;
+}
+
+/* WadArchive::updateNamespaceIndices
+ * Updates the start/end entry indices of all namespaces, and rebuilds
+ * the namespace interval map used by detectNamespace
+ *******************************************************************/
+void WadArchive::updateNamespaceIndices()
+{
+	// Update indices from the namespace marker entries
+	std::set<size_t> bounds{ 0 };
+	for (auto& ns : namespaces_)
+	{
+		ns.start_index = entryIndex(ns.start);
+		ns.end_index = entryIndex(ns.end);
+		bounds.insert(ns.start_index);
+		bounds.insert(ns.end_index + 1);
+	}
+
+	// Build interval map - each region between bounds belongs to the first
+	// namespace (in list order) that contains it
+	ns_intervals_.clear();
+	int previous = -2;
+	for (auto bound : bounds)
+	{
+		int ns_index = -1;
+		for (unsigned a = 0; a < namespaces_.size(); a++)
+		{
+			if (namespaces_[a].start_index <= bound && bound <= namespaces_[a].end_index)
+			{
+				ns_index = a;
+				break;
+			}
+		}
+
+		if (ns_index != previous)
+			ns_intervals_[bound] = ns_index;
+		previous = ns_index;
+	}
+
+	ns_indices_stale_ = false;
+}
+
+/* WadArchive::namespacesChanged
+ * Called when a namespace marker entry was added, removed or moved.
+ * Updates the namespace list, or if a batch update is in progress,
+ * marks it to be updated when next needed
+ *******************************************************************/
+void WadArchive::namespacesChanged()
+{
+	if (isBatchUpdating())
+		ns_stale_ = true;
+	else
+		updateNamespaces();
+}
+
+/* WadArchive::refreshNamespaces
+ * Updates the namespace list and/or namespace indices if they are out
+ * of date
+ *******************************************************************/
+void WadArchive::refreshNamespaces()
+{
+	// The namespace list can reference removed marker entries if it is
+	// stale, so it has to be rebuilt rather than just re-indexed
+	if (ns_stale_)
+		updateNamespaces();
+	else if (ns_indices_stale_)
+		updateNamespaceIndices();
 }
 
 /* WadArchive::hasFlatHack
@@ -308,6 +376,8 @@ void WadArchive::updateNamespaces()
  *******************************************************************/
 bool WadArchive::hasFlatHack()
 {
+	refreshNamespaces();
+
 	for (size_t i = 0; i < namespaces_.size(); ++i)
 	{
 		if (namespaces_[i].name == "f")
@@ -744,7 +814,9 @@ ArchiveEntry* WadArchive::addEntry(ArchiveEntry* entry, unsigned position, Archi
 	// Update namespaces if necessary
 	if (name.EndsWith("_START") ||
 	        name.EndsWith("_END"))
-		updateNamespaces();
+		namespacesChanged();
+	else if (entryIndex(entry) < (int)numEntries() - 1)
+		ns_indices_stale_ = true;	// Inserted before other entries
 
 	return entry;
 }
@@ -757,6 +829,7 @@ ArchiveEntry* WadArchive::addEntry(ArchiveEntry* entry, unsigned position, Archi
 ArchiveEntry* WadArchive::addEntry(ArchiveEntry* entry, string add_namespace, bool copy)
 {
 	// Find requested namespace
+	refreshNamespaces();
 	for (unsigned a = 0; a < namespaces_.size(); a++)
 	{
 		if (S_CMPNOCASE(namespaces_[a].name, add_namespace))
@@ -801,7 +874,9 @@ bool WadArchive::removeEntry(ArchiveEntry* entry)
 		// Update namespaces if necessary
 		if (name.Upper().Matches("*_START") ||
 		        name.Upper().Matches("*_END"))
-			updateNamespaces();
+			namespacesChanged();
+		else
+			ns_indices_stale_ = true;
 
 		return true;
 	}
@@ -853,7 +928,7 @@ bool WadArchive::renameEntry(ArchiveEntry* entry, string name)
 		// Update namespaces if necessary
 		if (entry->getName().Upper().Matches("*_START") ||
 		        entry->getName().Upper().Matches("*_END"))
-			updateNamespaces();
+			namespacesChanged();
 
 		return true;
 	}
@@ -879,7 +954,7 @@ bool WadArchive::swapEntries(ArchiveEntry* entry1, ArchiveEntry* entry2)
 		        entry1->getName().Upper().Matches("*_END") ||
 		        entry2->getName().Upper().Matches("*_START") ||
 		        entry2->getName().Upper().Matches("*_END"))
-			updateNamespaces();
+			namespacesChanged();
 
 		return true;
 	}
@@ -904,7 +979,9 @@ bool WadArchive::moveEntry(ArchiveEntry* entry, unsigned position, ArchiveTreeNo
 		// Update namespaces if necessary
 		if (entry->getName().Upper().Matches("*_START") ||
 		        entry->getName().Upper().Matches("*_END"))
-			updateNamespaces();
+			namespacesChanged();
+		else
+			ns_indices_stale_ = true;
 
 		return true;
 	}
@@ -1231,20 +1308,19 @@ string WadArchive::detectNamespace(ArchiveEntry* entry)
  *******************************************************************/
 string WadArchive::detectNamespace(size_t index, ArchiveTreeNode * dir)
 {
-	// Go through namespaces
-	for (unsigned a = 0; a < namespaces_.size(); a++)
-	{
-		// Get namespace start and end indices
-		size_t start = namespaces_[a].start_index;
-		size_t end = namespaces_[a].end_index;
+	refreshNamespaces();
 
-		// Check if the entry is within this namespace
-		if (start <= index && index <= end)
-			return namespaces_[a].name;
-	}
+	// Find the namespace interval the index is within
+	auto interval = ns_intervals_.upper_bound(index);
+	if (interval == ns_intervals_.begin())
+		return "global";
+	--interval;
 
 	// In no namespace
-	return "global";
+	if (interval->second < 0)
+		return "global";
+
+	return namespaces_[interval->second].name;
 }
 
 /* WadArchive::detectIncludes
@@ -1307,6 +1383,59 @@ void WadArchive::detectIncludes()
 	}
 }
 
+/* WadArchive::getSearchRange
+ * Gets the range of entry indices [start, end) to search within for
+ * namespace [ns]. Returns false if the namespace doesn't exist
+ *******************************************************************/
+bool WadArchive::getSearchRange(const string& ns, size_t& start, size_t& end)
+{
+	// No namespace, search everything
+	if (ns.IsEmpty())
+	{
+		start = 0;
+		end = numEntries();
+		return true;
+	}
+
+	refreshNamespaces();
+
+	// Find matching namespace (excluding the markers themselves)
+	for (auto& nspair : namespaces_)
+	{
+		if (nspair.name == ns)
+		{
+			start = nspair.start_index + 1;
+			end = nspair.end_index;
+			return true;
+		}
+	}
+
+	// Namespace not found
+	return false;
+}
+
+/* isExactName
+ * Returns true if [name] contains no wildcard characters
+ *******************************************************************/
+static bool isExactName(const string& name)
+{
+	return !name.IsEmpty() && name.find_first_of("*?") == string::npos;
+}
+
+/* matchesSearchType
+ * Returns true if [entry] is of [type] (or [type] is null)
+ *******************************************************************/
+static bool matchesSearchType(ArchiveEntry* entry, EntryType* type)
+{
+	if (!type)
+		return true;
+
+	if (entry->getType() == EntryType::unknownType())
+		return type->isThisType(entry);
+
+	return type == entry->getType();
+}
+
 /* WadArchive::findFirst
  * Returns the first entry matching the search criteria in [options],
  * or NULL if no matching entry was found
@@ -1314,66 +1443,42 @@ void WadArchive::detectIncludes()
 ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 {
 	// Init search variables
-	ArchiveEntry* start = getEntry(0);
-	ArchiveEntry* end = nullptr;
 	options.match_name = options.match_name.Lower();
 
 	// "graphics" namespace is the global namespace in a wad
 	if (options.match_namespace == "graphics")
 		options.match_namespace = "";
 
-	// Check for namespace to search
-	if (!options.match_namespace.IsEmpty())
+	// Check for namespace to search (return none if namespace not found)
+	size_t start, end;
+	if (!getSearchRange(options.match_namespace, start, end))
+		return nullptr;
+
+	// Exact name, only need to check entries with that name
+	if (isExactName(options.match_name))
 	{
-		// Find matching namespace
-		bool ns_found = false;
-		for (unsigned a = 0; a < namespaces_.size(); a++)
+		for (auto entry : rootDir()->entriesNamed(options.match_name))
 		{
-			if (namespaces_[a].name == options.match_namespace)
-			{
-				start = namespaces_[a].start->nextEntry();
-				end = namespaces_[a].end;
-				ns_found = true;
-				break;
-			}
+			size_t index = entryIndex(entry);
+			if (index >= start && index < end && matchesSearchType(entry, options.match_type))
+				return entry;
 		}
 
-		// Return none if namespace not found
-		if (!ns_found)
-			return nullptr;
+		return nullptr;
 	}
 
 	// Begin search
-	ArchiveEntry* entry = start;
-	while (entry != end)
+	for (size_t a = start; a < end; a++)
 	{
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->nextEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
-		}
+		ArchiveEntry* entry = rootDir()->entryAt(a);
 
 		// Check name
-		if (!options.match_name.IsEmpty())
-		{
-			if (!options.match_name.Matches(entry->getName().Lower()))
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
-		}
+		if (!options.match_name.IsEmpty() && !options.match_name.Matches(entry->getName().Lower()))
+			continue;
+
+		// Check type
+		if (!matchesSearchType(entry, options.match_type))
+			continue;
 
 		// Entry passed all checks so far, so we found a match
 		return entry;
@@ -1390,8 +1495,6 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 {
 	// Init search variables
-	ArchiveEntry* start = getEntry(numEntries()-1);
-	ArchiveEntry* end = nullptr;
 	options.match_name = options.match_name.Lower();
 
 	// "graphics" namespace is the global namespace in a wad
@@ -1402,58 +1505,37 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 	if (options.match_namespace == "global")
 		options.match_namespace = "";
 
-	// Check for namespace to search
-	if (!options.match_namespace.IsEmpty())
+	// Check for namespace to search (return none if namespace not found)
+	size_t start, end;
+	if (!getSearchRange(options.match_namespace, start, end))
+		return nullptr;
+
+	// Exact name, only need to check entries with that name
+	if (isExactName(options.match_name))
 	{
-		// Find matching namespace
-		bool ns_found = false;
-		for (unsigned a = 0; a < namespaces_.size(); a++)
+		auto entries = rootDir()->entriesNamed(options.match_name);
+		for (auto i = entries.rbegin(); i != entries.rend(); ++i)
 		{
-			if (namespaces_[a].name == options.match_namespace)
-			{
-				start = namespaces_[a].end->prevEntry();
-				end = namespaces_[a].start;
-				ns_found = true;
-				break;
-			}
+			size_t index = entryIndex(*i);
+			if (index >= start && index < end && matchesSearchType(*i, options.match_type))
+				return *i;
 		}
 
-		// Return none if namespace not found
-		if (!ns_found)
-			return nullptr;
+		return nullptr;
 	}
 
-	// Begin search
-	ArchiveEntry* entry = start;
-	while (entry != end)
+	// Begin search (bottom-up)
+	for (size_t a = end; a > start; a--)
 	{
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->prevEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->prevEntry();
-				continue;
-			}
-		}
+		ArchiveEntry* entry = rootDir()->entryAt(a - 1);
 
 		// Check name
-		if (!options.match_name.IsEmpty())
-		{
-			if (!options.match_name.Matches(entry->getName().Lower()))
-			{
-				entry = entry->prevEntry();
-				continue;
-			}
-		}
+		if (!options.match_name.IsEmpty() && !options.match_name.Matches(entry->getName().Lower()))
+			continue;
+
+		// Check type
+		if (!matchesSearchType(entry, options.match_type))
+			continue;
 
 		// Entry passed all checks so far, so we found a match
 		return entry;
@@ -1469,8 +1551,6 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 {
 	// Init search variables
-	ArchiveEntry* start = getEntry(0);
-	ArchiveEntry* end = nullptr;
 	options.match_name = options.match_name.Upper();
 	vector<ArchiveEntry*> ret;
 
@@ -1478,62 +1558,38 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 	if (options.match_namespace == "graphics")
 		options.match_namespace = "";
 
-	// Check for namespace to search
-	if (!options.match_namespace.IsEmpty())
+	// Check for namespace to search (return none if namespace not found)
+	size_t start, end;
+	if (!getSearchRange(options.match_namespace, start, end))
+		return ret;
+
+	// Exact name, only need to check entries with that name
+	if (isExactName(options.match_name))
 	{
-		// Find matching namespace
-		bool ns_found = false;
-		size_t namespaces_size = namespaces_.size();
-		for (unsigned a = 0; a < namespaces_size; a++)
+		for (auto entry : rootDir()->entriesNamed(options.match_name))
 		{
-			if (namespaces_[a].name == options.match_namespace)
-			{
-				start = namespaces_[a].start->nextEntry();
-				end = namespaces_[a].end;
-				ns_found = true;
-				break;
-			}
+			size_t index = entryIndex(entry);
+			if (index >= start && index < end && matchesSearchType(entry, options.match_type))
+				ret.push_back(entry);
 		}
 
-		// Return none if namespace not found
-		if (!ns_found)
-			return ret;
+		return ret;
 	}
 
-	ArchiveEntry* entry = start;
-	while (entry != end)
+	for (size_t a = start; a < end; a++)
 	{
-		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->nextEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
-		}
+		ArchiveEntry* entry = rootDir()->entryAt(a);
 
 		// Check name
-		if (!options.match_name.IsEmpty())
-		{
-			if (!options.match_name.Matches(entry->getUpperName()))
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
-		}
+		if (!options.match_name.IsEmpty() && !options.match_name.Matches(entry->getUpperName()))
+			continue;
+
+		// Check type
+		if (!matchesSearchType(entry, options.match_type))
+			continue;
 
 		// Entry passed all checks so far, so we found a match
 		ret.push_back(entry);
-		entry = entry->nextEntry();
 	}
 
 	// Return search result
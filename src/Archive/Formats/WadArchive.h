@@ -100,7 +100,15 @@ private:
 	};
 
 	bool				iwad_;
-	vector<NSPair>	namespaces_;
+	vector<NSPair>		namespaces_;
+	std::map<size_t, int>	ns_intervals_;			// Entry index a namespace region begins at -> namespace (-1 for global)
+	bool				ns_indices_stale_ = false;	// Entries were added/removed since namespace indices were updated
+	bool				ns_stale_ = false;			// Namespace markers were changed during a batch update
+
+	void	updateNamespaceIndices();
+	void	namespacesChanged();
+	void	refreshNamespaces();
+	bool	getSearchRange(const string& ns, size_t& start, size_t& end);
 };
 
 #endif//__WADARCHIVE_H__
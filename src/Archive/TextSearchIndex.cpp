@@ -0,0 +1,690 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextSearchIndex.cpp
+// Description: TextSearchIndex namespace, a trigram index over the contents of
+//              all text entries in open archives, used for fast 'find in files'
+//              searches. The index is updated lazily (entries are re-indexed
+//              only when their content hash changes) and the indexing itself
+//              is done on a background thread
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "TextSearchIndex.h"
+#include "Archive.h"
+#include "ArchiveManager.h"
+#include "Utility/Parallel.h"
+#include <atomic>
+#include <thread>
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+namespace TextSearchIndex
+{
+	struct Doc
+	{
+		ArchiveEntry::WPtr	entry;
+		ArchiveEntry*		key;		// Only used for lookups, never dereferenced
+		uint64_t			hash;
+		std::string			text;
+		std::string			text_lower;	// Lowercase (see lowerCase), same byte offsets as text
+		vector<uint32_t>	trigrams;	// Sorted, only kept until added to postings
+		bool				live;
+	};
+	typedef std::unique_ptr<Doc> DocPtr;
+
+	// Runs indexing of new/modified entries on a background thread. Nothing
+	// else touches the index while it is running
+	class Indexer
+	{
+	public:
+		~Indexer() { wait(); }
+
+		void		start(vector<DocPtr> pending);
+		void		wait() { if (thread_.joinable()) thread_.join(); }
+		bool		running() const { return running_; }
+		unsigned	done() const { return done_; }
+		unsigned	total() const { return total_; }
+
+	private:
+		std::thread				thread_;
+		std::atomic<bool>		running_{ false };
+		std::atomic<unsigned>	done_{ 0 };
+		std::atomic<unsigned>	total_{ 0 };
+	};
+
+	vector<DocPtr>									docs;
+	std::unordered_map<ArchiveEntry*, unsigned>		doc_map;	// Entry -> live doc index
+	std::unordered_map<uint32_t, vector<unsigned>>	postings;	// Trigram -> doc indices (ascending)
+	unsigned										n_dead = 0;
+	Indexer											indexer;	// Declared last so it is joined first
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// TextSearchIndex Namespace Functions
+//
+// ----------------------------------------------------------------------------
+namespace TextSearchIndex
+{
+	// ------------------------------------------------------------------------
+	// trigram
+	//
+	// Returns the 3 characters at [c] packed into an int
+	// ------------------------------------------------------------------------
+	inline uint32_t trigram(const char* c)
+	{
+		return ((uint8_t)c[0] << 16) | ((uint8_t)c[1] << 8) | (uint8_t)c[2];
+	}
+
+	// ------------------------------------------------------------------------
+	// lowerCodePoint
+	//
+	// Returns the lowercase version of unicode code point [cp]. Latin, Greek
+	// and Cyrillic letters are mapped directly, since the C library functions
+	// only handle ASCII in the "C" locale SLADE runs with
+	// ------------------------------------------------------------------------
+	uint32_t lowerCodePoint(uint32_t cp)
+	{
+		if (cp >= 'A' && cp <= 'Z')
+			return cp + 0x20;
+		if (cp < 0xC0)
+			return cp;
+
+		// Latin-1 Supplement
+		if (cp <= 0xDE)
+			return cp == 0xD7 ? cp : cp + 0x20;
+
+		// Latin Extended-A (dotted capital I lowercases to ASCII, so is skipped)
+		if (cp == 0x130)
+			return cp;
+		if ((cp >= 0x100 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177))
+			return cp | 1;
+		if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E))
+			return (cp & 1) ? cp + 1 : cp;
+		if (cp == 0x178)
+			return 0xFF;
+
+		// Greek
+		if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2)
+			return cp + 0x20;
+		if (cp == 0x386)
+			return 0x3AC;
+		if (cp >= 0x388 && cp <= 0x38A)
+			return cp + 0x25;
+		if (cp == 0x38C)
+			return 0x3CC;
+		if (cp == 0x38E || cp == 0x38F)
+			return cp + 0x3F;
+
+		// Cyrillic
+		if (cp >= 0x400 && cp <= 0x40F)
+			return cp + 0x50;
+		if (cp >= 0x410 && cp <= 0x42F)
+			return cp + 0x20;
+		if ((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF))
+			return cp | 1;
+
+		return cp;
+	}
+
+	// ------------------------------------------------------------------------
+	// lowerCase
+	//
+	// Returns UTF8 [str] converted to lowercase (see lowerCodePoint). Only
+	// characters whose lowercase version encodes to the same number of bytes
+	// are converted, and invalid UTF8 bytes are left alone, so offsets into
+	// the result match offsets into [str]
+	// ------------------------------------------------------------------------
+	std::string lowerCase(const std::string& str)
+	{
+		std::string lower(str);
+		size_t a = 0;
+		while (a < lower.size())
+		{
+			uint8_t c = lower[a];
+			if (c < 0x80)
+			{
+				if (c >= 'A' && c <= 'Z')
+					lower[a] = c + 0x20;
+				a++;
+				continue;
+			}
+
+			// Only 2-byte sequences contain characters with a lowercase
+			// version handled by lowerCodePoint
+			if ((c & 0xE0) != 0xC0 || a + 1 >= lower.size() || (lower[a + 1] & 0xC0) != 0x80)
+			{
+				a++;
+				continue;
+			}
+
+			uint32_t cp = ((c & 0x1F) << 6) | (lower[a + 1] & 0x3F);
+			uint32_t lcp = lowerCodePoint(cp);
+			if (lcp != cp && lcp >= 0x80 && lcp < 0x800)
+			{
+				lower[a] = 0xC0 | (lcp >> 6);
+				lower[a + 1] = 0x80 | (lcp & 0x3F);
+			}
+			a += 2;
+		}
+
+		return lower;
+	}
+
+	// ------------------------------------------------------------------------
+	// trigramsOf
+	//
+	// Writes the sorted, unique trigrams in [text] to [out]. Trigrams that span
+	// a line break are skipped since searches never match across lines
+	// ------------------------------------------------------------------------
+	void trigramsOf(const std::string& text, vector<uint32_t>& out)
+	{
+		out.clear();
+		for (size_t a = 0; a + 2 < text.size(); a++)
+		{
+			if (text[a] == '\n' || text[a + 1] == '\n' || text[a + 2] == '\n')
+				continue;
+			out.push_back(trigram(&text[a]));
+		}
+
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+		out.shrink_to_fit();
+	}
+
+	// ------------------------------------------------------------------------
+	// removeDoc
+	//
+	// Marks the doc at [index] as dead and frees its text. Its postings are
+	// left in place until the next compact()
+	// ------------------------------------------------------------------------
+	void removeDoc(unsigned index)
+	{
+		auto& doc = *docs[index];
+		doc.live = false;
+		std::string().swap(doc.text);
+		std::string().swap(doc.text_lower);
+		n_dead++;
+	}
+
+	// ------------------------------------------------------------------------
+	// addDoc
+	//
+	// Adds [doc] (with trigrams already built) to the index, replacing any
+	// existing doc for the same entry
+	// ------------------------------------------------------------------------
+	void addDoc(DocPtr doc)
+	{
+		unsigned index = docs.size();
+
+		auto existing = doc_map.find(doc->key);
+		if (existing != doc_map.end())
+			removeDoc(existing->second);
+		doc_map[doc->key] = index;
+
+		for (auto t : doc->trigrams)
+			postings[t].push_back(index);
+		vector<uint32_t>().swap(doc->trigrams);
+
+		docs.push_back(std::move(doc));
+	}
+
+	// ------------------------------------------------------------------------
+	// compact
+	//
+	// Rebuilds the index without dead docs
+	// ------------------------------------------------------------------------
+	void compact()
+	{
+		vector<DocPtr> live;
+		for (auto& doc : docs)
+			if (doc->live)
+				live.push_back(std::move(doc));
+
+		docs.clear();
+		doc_map.clear();
+		postings.clear();
+		n_dead = 0;
+
+		Parallel::forEach(live.size(), [&](unsigned a) { trigramsOf(live[a]->text_lower, live[a]->trigrams); });
+		for (auto& doc : live)
+			addDoc(std::move(doc));
+	}
+
+	// ------------------------------------------------------------------------
+	// Indexer::start
+	//
+	// Starts indexing [pending] docs on the background thread
+	// ------------------------------------------------------------------------
+	void Indexer::start(vector<DocPtr> pending)
+	{
+		wait();
+		running_ = true;
+		done_ = 0;
+		total_ = pending.size();
+		thread_ = std::thread([this](vector<DocPtr> pending)
+		{
+			Parallel::forEach(pending.size(), [&](unsigned a)
+			{
+				pending[a]->text_lower = lowerCase(pending[a]->text);
+				trigramsOf(pending[a]->text_lower, pending[a]->trigrams);
+				done_++;
+			});
+
+			for (auto& doc : pending)
+				addDoc(std::move(doc));
+
+			if (n_dead > 64 && n_dead > docs.size() / 2)
+				compact();
+
+			running_ = false;
+		}, std::move(pending));
+	}
+
+	// ------------------------------------------------------------------------
+	// regexLiterals
+	//
+	// Returns (lowercase) literal strings of 3+ characters that any match of
+	// [regex] must contain. This is conservative - groups and bracket
+	// expressions are skipped entirely, and nothing is returned if there is
+	// a top-level alternation
+	// ------------------------------------------------------------------------
+	vector<std::string> regexLiterals(const std::string& regex)
+	{
+		vector<std::string> literals;
+		std::string current;
+		auto flush = [&]()
+		{
+			if (current.size() >= 3)
+				literals.push_back(lowerCase(current));
+			current.clear();
+		};
+		auto skipBracket = [&](size_t a)
+		{
+			// Returns the index of the ']' closing the bracket expression at [a]
+			a++;
+			if (a < regex.size() && regex[a] == '^') a++;
+			if (a < regex.size() && regex[a] == ']') a++;
+			while (a < regex.size() && regex[a] != ']')
+				a += regex[a] == '\\' ? 2 : 1;
+			return a;
+		};
+
+		int depth = 0;
+		for (size_t a = 0; a < regex.size(); a++)
+		{
+			char c = regex[a];
+
+			// Skip group contents
+			if (depth > 0)
+			{
+				if (c == '\\') a++;
+				else if (c == '[') a = skipBracket(a);
+				else if (c == '(') depth++;
+				else if (c == ')') depth--;
+				continue;
+			}
+
+			switch (c)
+			{
+			case '|':
+				return {};
+			case '(':
+				flush();
+				depth++;
+				break;
+			case '[':
+				flush();
+				a = skipBracket(a);
+				break;
+			case '*': case '?': case '{':
+				// Previous character is optional
+				if (!current.empty())
+					current.pop_back();
+				flush();
+				if (c == '{')
+					while (a < regex.size() && regex[a] != '}')
+						a++;
+				break;
+			case '+': case '.': case '^': case '$': case ')':
+				flush();
+				break;
+			case '\\':
+				if (a + 1 < regex.size() && !isalnum((uint8_t)regex[a + 1]))
+					current += regex[++a];
+				else
+				{
+					flush();
+					a++;
+				}
+				break;
+			default:
+				current += c;
+			}
+		}
+		flush();
+
+		return literals;
+	}
+
+	// ------------------------------------------------------------------------
+	// candidateDocs
+	//
+	// Returns the indices of all live docs that contain every trigram of the
+	// [required] (lowercase) strings
+	// ------------------------------------------------------------------------
+	vector<unsigned> candidateDocs(const vector<std::string>& required)
+	{
+		vector<uint32_t> trigrams, tg;
+		for (auto& str : required)
+		{
+			trigramsOf(str, tg);
+			trigrams.insert(trigrams.end(), tg.begin(), tg.end());
+		}
+
+		vector<unsigned> result;
+		if (trigrams.empty())
+		{
+			// Nothing to narrow down with, check all docs
+			for (unsigned a = 0; a < docs.size(); a++)
+				if (docs[a]->live)
+					result.push_back(a);
+			return result;
+		}
+
+		// Get postings lists, smallest first
+		vector<const vector<unsigned>*> lists;
+		for (auto t : trigrams)
+		{
+			auto list = postings.find(t);
+			if (list == postings.end())
+				return result;
+			lists.push_back(&list->second);
+		}
+		std::sort(lists.begin(), lists.end(), [](const vector<unsigned>* l, const vector<unsigned>* r)
+		{
+			return l->size() < r->size();
+		});
+
+		// Intersect
+		result = *lists[0];
+		vector<unsigned> temp;
+		for (unsigned a = 1; a < lists.size() && !result.empty(); a++)
+		{
+			temp.clear();
+			std::set_intersection(
+				result.begin(), result.end(),
+				lists[a]->begin(), lists[a]->end(),
+				std::back_inserter(temp)
+			);
+			result.swap(temp);
+		}
+
+		result.erase(
+			std::remove_if(result.begin(), result.end(), [](unsigned d) { return !docs[d]->live; }),
+			result.end()
+		);
+		return result;
+	}
+
+	// ------------------------------------------------------------------------
+	// toWxString
+	//
+	// Converts [len] bytes of text at [str] to a wxString, as UTF8 if valid
+	// or 8-bit data otherwise
+	// ------------------------------------------------------------------------
+	string toWxString(const char* str, size_t len)
+	{
+		string wx = wxString::FromUTF8(str, len);
+		if (wx.empty() && len > 0)
+			wx = wxString::From8BitData(str, len);
+		return wx;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::update
+//
+// Brings the index up to date with the text entries in all open archives.
+// Entry content is read here (on the calling thread) but only new or modified
+// entries are re-indexed, on a background thread. Does nothing if indexing is
+// already in progress
+// ----------------------------------------------------------------------------
+void TextSearchIndex::update()
+{
+	if (indexer.running())
+		return;
+	indexer.wait();
+
+	// Get all entries in open archives
+	vector<ArchiveEntry::SPtr> entries;
+	auto& manager = App::archiveManager();
+	for (int a = 0; a < manager.numArchives(); a++)
+		manager.getArchive(a)->getEntryTreeAsList(entries);
+
+	// Check for new or modified text entries
+	vector<bool> seen(docs.size(), false);
+	vector<DocPtr> pending;
+	for (auto& entry : entries)
+	{
+		if (!S_CMPNOCASE(entry->getType()->category(), "Text"))
+			continue;
+
+		uint64_t hash = entry->getContentHash();
+		auto existing = doc_map.find(entry.get());
+		if (existing != doc_map.end() && docs[existing->second]->entry.lock() == entry)
+		{
+			seen[existing->second] = true;
+			if (docs[existing->second]->hash == hash)
+				continue;
+		}
+
+		DocPtr doc(new Doc);
+		doc->entry = entry;
+		doc->key = entry.get();
+		doc->hash = hash;
+		doc->live = true;
+		if (entry->getSize() > 0)
+			doc->text.assign((const char*)entry->getData(), entry->getSize());
+		pending.push_back(std::move(doc));
+	}
+
+	// Remove docs for entries that no longer exist
+	bool removed = false;
+	for (unsigned a = 0; a < seen.size(); a++)
+	{
+		if (docs[a]->live && !seen[a])
+		{
+			doc_map.erase(docs[a]->key);
+			removeDoc(a);
+			removed = true;
+		}
+	}
+
+	if (!pending.empty() || removed)
+		indexer.start(std::move(pending));
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::isIndexing
+//
+// Returns true if the index is currently being updated in the background
+// ----------------------------------------------------------------------------
+bool TextSearchIndex::isIndexing()
+{
+	return indexer.running();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::waitForIndexing
+//
+// Blocks until any background indexing has finished
+// ----------------------------------------------------------------------------
+void TextSearchIndex::waitForIndexing()
+{
+	indexer.wait();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::indexingProgress
+//
+// Sets [done] and [total] to the number of entries indexed so far and the
+// number being indexed by the current (or last) background update
+// ----------------------------------------------------------------------------
+void TextSearchIndex::indexingProgress(unsigned& done, unsigned& total)
+{
+	done = indexer.done();
+	total = indexer.total();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::numIndexedEntries
+//
+// Returns the number of entries currently in the index (0 while indexing)
+// ----------------------------------------------------------------------------
+unsigned TextSearchIndex::numIndexedEntries()
+{
+	if (indexer.running())
+		return 0;
+
+	return docs.size() - n_dead;
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchIndex::search
+//
+// Searches all indexed text entries for lines matching [query], adding the
+// results to [hits]. The index should be brought up to date with update()
+// first - this doesn't wait for it. Returns false if [query] is an invalid
+// regular expression or the index is currently being updated
+// ----------------------------------------------------------------------------
+bool TextSearchIndex::search(const string& query, const Options& options, vector<Hit>& hits)
+{
+	hits.clear();
+	if (query.empty())
+		return true;
+
+	if (indexer.running())
+	{
+		Global::error = "Search index is being updated";
+		return false;
+	}
+	indexer.wait();
+
+	// Compile regex
+	wxRegEx regex;
+	if (options.regex)
+	{
+		wxLogNull no_log;
+		if (!regex.Compile(query, options.match_case ? wxRE_DEFAULT : wxRE_DEFAULT | wxRE_ICASE))
+		{
+			Global::error = "Invalid regular expression";
+			return false;
+		}
+	}
+
+	// Get strings that must appear in every matching line
+	std::string query_str = query.ToUTF8().data();
+	vector<std::string> required;
+	if (options.regex)
+		required = regexLiterals(query_str);
+	else
+		required.push_back(lowerCase(query_str));
+
+	// Lines to check are found by searching for an 'anchor' string, either
+	// the literal query or the longest required string from the regex. If
+	// there is no anchor all lines are checked
+	std::string anchor;
+	for (auto& str : required)
+		if (str.size() > anchor.size())
+			anchor = str;
+	bool anchor_case = !options.regex && options.match_case;
+	if (anchor_case)
+		anchor = query_str;
+
+	for (auto index : candidateDocs(required))
+	{
+		auto& doc = *docs[index];
+		auto entry = doc.entry.lock();
+		if (!entry)
+			continue;
+
+		string entry_path = entry->getPath(true);
+		if (entry->getParent())
+			entry_path = entry->getParent()->filename(false) + entry_path;
+
+		const std::string& text = doc.text;
+		const std::string& haystack = anchor_case ? doc.text : doc.text_lower;
+		size_t pos = 0;
+		size_t counted = 0;
+		int line = 0;
+		while (pos <= text.size() && hits.size() < options.max_hits)
+		{
+			if (!anchor.empty())
+			{
+				pos = haystack.find(anchor, pos);
+				if (pos == std::string::npos)
+					break;
+			}
+
+			// Get line containing pos
+			line += std::count(text.begin() + counted, text.begin() + pos, '\n');
+			counted = pos;
+			size_t line_start = pos > 0 ? text.rfind('\n', pos - 1) : std::string::npos;
+			line_start = (line_start == std::string::npos) ? 0 : line_start + 1;
+			size_t line_end = text.find('\n', pos);
+			if (line_end == std::string::npos)
+				line_end = text.size();
+			size_t len = line_end - line_start;
+			if (len > 0 && text[line_end - 1] == '\r')
+				len--;
+
+			// Check line and add hit
+			string line_text = toWxString(text.data() + line_start, len);
+			if (!options.regex || regex.Matches(line_text))
+			{
+				line_text.Trim(true).Trim(false);
+				if (line_text.size() > 256)
+					line_text = line_text.Left(256) + "...";
+				hits.push_back({ entry, entry_path, line, line_text });
+			}
+
+			pos = line_end + 1;
+		}
+
+		if (hits.size() >= options.max_hits)
+			break;
+	}
+
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ArchiveEntry.h"
+
+namespace TextSearchIndex
+{
+	struct Hit
+	{
+		ArchiveEntry::WPtr	entry;
+		string				entry_path;	// Archive filename + entry path, for display
+		int					line;		// 0-based
+		string				text;
+	};
+
+	struct Options
+	{
+		bool		regex		= false;
+		bool		match_case	= false;
+		unsigned	max_hits	= 5000;
+	};
+
+	void		update();
+	bool		isIndexing();
+	void		waitForIndexing();
+	void		indexingProgress(unsigned& done, unsigned& total);
+	unsigned	numIndexedEntries();
+
+	bool		search(const string& query, const Options& options, vector<Hit>& hits);
+}
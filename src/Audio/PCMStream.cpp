@@ -0,0 +1,552 @@
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    PCMStream.cpp
+ * Description: PCMStream class, an SFML sound stream that plays raw
+ *              PCM based sound formats (Doom, Wolf3D, Jaguar, VOC,
+ *              Sun AU), decoding the samples in small chunks as
+ *              they are needed rather than converting the whole
+ *              sound to WAV beforehand
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "PCMStream.h"
+#include "MainEditor/Conversions.h"
+
+
+/*******************************************************************
+ * EXTERNAL VARIABLES
+ *******************************************************************/
+EXTERN_CVAR(Bool, dmx_padding)
+EXTERN_CVAR(Int, wolfsnd_rate)
+
+
+/*******************************************************************
+ * PCMSTREAM CLASS FUNCTIONS
+ *******************************************************************/
+
+/* PCMStream::PCMStream
+ * PCMStream class constructor
+ *******************************************************************/
+PCMStream::PCMStream()
+{
+	data = nullptr;
+	data_size = 0;
+	format = PCM_U8;
+	channels = 1;
+	rate = 0;
+	frame_size = 1;
+	num_frames = 0;
+	position = 0;
+}
+
+/* PCMStream::~PCMStream
+ * PCMStream class destructor
+ *******************************************************************/
+PCMStream::~PCMStream()
+{
+	// The streaming thread must be stopped before our data goes away
+	stop();
+}
+
+/* PCMStream::close
+ * Stops playback and releases the current sample data
+ *******************************************************************/
+void PCMStream::close()
+{
+	stop();
+	data = nullptr;
+	data_size = 0;
+	vector<uint8_t>().swap(gathered);
+	num_frames = 0;
+	position = 0;
+}
+
+/* PCMStream::setData
+ * Sets the undecoded sample data to stream to [size] bytes at [src].
+ * The data isn't copied, so it must stay valid until the stream is
+ * closed or reopened
+ *******************************************************************/
+void PCMStream::setData(const uint8_t* src, size_t size)
+{
+	data = src;
+	data_size = size;
+}
+
+/* PCMStream::setup
+ * Sets the sample [format], number of [channels] and sample [rate]
+ * of the data added so far and initialises the stream for playback.
+ * Returns false if the parameters aren't playable
+ *******************************************************************/
+bool PCMStream::setup(SampleFormat format, unsigned channels, unsigned rate)
+{
+	if (channels < 1 || channels > 2)
+	{
+		Global::error = S_FMT("Unsupported number of channels (%d)", channels);
+		return false;
+	}
+	if (rate == 0)
+	{
+		Global::error = "Invalid sample rate";
+		return false;
+	}
+
+	this->format = format;
+	this->channels = channels;
+	this->rate = rate;
+	switch (format)
+	{
+	case PCM_S16LE:
+	case PCM_S16BE:	frame_size = 2; break;
+	case PCM_S24BE:	frame_size = 3; break;
+	case PCM_S32BE:	frame_size = 4; break;
+	default:		frame_size = 1; break;
+	}
+	frame_size *= channels;
+	num_frames = data_size / frame_size;
+	position = 0;
+
+	if (num_frames == 0)
+	{
+		Global::error = "No sound data";
+		return false;
+	}
+
+	// Decode roughly a quarter of a second per chunk
+	samples.resize(MAX(rate / 4, 1024u) * channels);
+
+	initialize(channels, rate);
+	return true;
+}
+
+/* PCMStream::getDuration
+ * Returns the duration of the currently loaded sound
+ *******************************************************************/
+sf::Time PCMStream::getDuration() const
+{
+	if (rate == 0)
+		return sf::Time::Zero;
+
+	return sf::microseconds((sf::Int64)num_frames * 1000000 / rate);
+}
+
+/* PCMStream::onSeek
+ * Called when seeking is requested on the sound stream
+ *******************************************************************/
+void PCMStream::onSeek(sf::Time timeOffset)
+{
+	sf::Int64 frame = timeOffset.asMicroseconds() * rate / 1000000;
+	if (frame < 0)
+		frame = 0;
+	position = MIN((size_t)frame, num_frames);
+}
+
+/* PCMStream::onGetData
+ * Called from the streaming thread when more sound data is needed.
+ * Decodes the next chunk of samples to 16-bit signed PCM
+ *******************************************************************/
+bool PCMStream::onGetData(Chunk& chunk)
+{
+	size_t frames = MIN(samples.size() / channels, num_frames - position);
+	if (frames == 0)
+		return false;
+
+	const uint8_t* src = data + position * frame_size;
+	sf::Int16* out = samples.data();
+	size_t count = frames * channels;
+	switch (format)
+	{
+	case PCM_U8:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (src[a] - 128) * 256;
+		break;
+	case PCM_S8:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (int8_t)src[a] * 256;
+		break;
+	case PCM_S16LE:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (sf::Int16)READ_L16(src, a * 2);
+		break;
+	case PCM_S16BE:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (sf::Int16)READ_B16(src, a * 2);
+		break;
+	case PCM_S24BE:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (sf::Int16)READ_B16(src, a * 3);
+		break;
+	case PCM_S32BE:
+		for (size_t a = 0; a < count; a++)
+			out[a] = (sf::Int16)READ_B16(src, a * 4);
+		break;
+	case PCM_ULAW:
+		for (size_t a = 0; a < count; a++)
+			out[a] = Conversions::mulawToLinear(src[a]);
+		break;
+	case PCM_ALAW:
+		for (size_t a = 0; a < count; a++)
+			out[a] = Conversions::AlawToLinear(src[a]);
+		break;
+	}
+
+	position += frames;
+	chunk.samples = out;
+	chunk.sampleCount = count;
+	return true;
+}
+
+/* PCMStream::openDoomSound
+ * Opens Doom format sound data [mc] for playback
+ *******************************************************************/
+bool PCMStream::openDoomSound(const MemChunk& mc)
+{
+	close();
+
+	const uint8_t* d = mc.getData();
+	size_t size = mc.getSize();
+	if (size < 8)
+	{
+		Global::error = "Invalid Doom Sound";
+		return false;
+	}
+
+	// Some sounds created on Mac platforms have their identifier and
+	// samplerate in BE format, the number of samples is still LE
+	uint16_t three = READ_L16(d, 0);
+	uint16_t samplerate = (three == 0x300) ? READ_B16(d, 2) : READ_L16(d, 2);
+	size_t num_samples = (uint32_t)READ_L32(d, 4);
+	if ((three != 3 && three != 0x300) || num_samples > size - 8 || num_samples <= 4)
+	{
+		Global::error = "Invalid Doom Sound";
+		return false;
+	}
+
+	// Skip DMX padding if present (16 leading copies of the first
+	// sample and 16 trailing copies of the last one)
+	const uint8_t* src = d + 8;
+	if (num_samples > 33 && dmx_padding)
+	{
+		size_t e = num_samples - 16;
+		bool padded = true;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (src[i] != src[16] || src[e+i] != src[e-1])
+			{
+				padded = false;
+				break;
+			}
+		}
+		if (padded)
+		{
+			src += 16;
+			num_samples -= 32;
+		}
+	}
+
+	setData(src, num_samples);
+	return setup(PCM_U8, 1, samplerate);
+}
+
+/* PCMStream::openWolfSound
+ * Opens Wolfenstein 3D format sound data [mc] for playback
+ *******************************************************************/
+bool PCMStream::openWolfSound(const MemChunk& mc)
+{
+	close();
+
+	setData(mc.getData(), mc.getSize());
+	return setup(PCM_U8, 1, wolfsnd_rate);
+}
+
+/* PCMStream::openJaguarSound
+ * Opens Jaguar Doom format sound data [mc] for playback
+ *******************************************************************/
+bool PCMStream::openJaguarSound(const MemChunk& mc)
+{
+	close();
+
+	const uint8_t* d = mc.getData();
+	size_t size = mc.getSize();
+	size_t num_samples = (size >= 28) ? (uint32_t)READ_B32(d, 0) : 0;
+	if (size < 28 || num_samples > size - 28 || num_samples <= 4)
+	{
+		Global::error = "Invalid Jaguar Doom Sound";
+		return false;
+	}
+
+	setData(d + 28, num_samples);
+	return setup(PCM_U8, 1, 11025);
+}
+
+/* PCMStream::openVoc
+ * Opens Creative Voice File data [mc] for playback. Only the block
+ * structure is parsed here, sample data split over several sound
+ * blocks is gathered into one buffer to be decoded while streaming
+ *******************************************************************/
+bool PCMStream::openVoc(const MemChunk& mc)
+{
+	close();
+
+	const uint8_t* d = mc.getData();
+	size_t e = mc.getSize();
+	if (e < 26 || d[19] != 26 || d[20] != 26 || d[21] != 0
+	        || (0x1234 + ~(READ_L16(d, 22)) != (READ_L16(d, 24))))
+	{
+		Global::error = "Invalid VOC";
+		return false;
+	}
+
+	// Sound data ranges, a null pointer means [size] frames of silence
+	struct block_t
+	{
+		const uint8_t*	src;
+		size_t			size;
+	};
+	vector<block_t> blocks;
+
+	int codec = -1;
+	unsigned vrate = 0;
+	unsigned vchannels = 1;
+	bool gotextra = false;
+	size_t datasize = 0;
+	size_t i = 26;
+	int blockcount = 0;
+	while (i + 4 <= e)
+	{
+		// Parse through blocks
+		uint8_t blocktype = d[i];
+		if (blocktype == 0)	// Terminator, the rest should be ignored
+			break;
+		size_t blocksize = READ_L24(d, i+1);
+		i += 4;
+		if (i + blocksize > e)
+		{
+			Global::error = S_FMT("VOC file cut abruptly in block %i", blockcount);
+			return false;
+		}
+		blockcount++;
+
+		switch (blocktype)
+		{
+		case 1: // Sound data
+			if (blocksize < 2)
+				break;
+			if (codec == -1)
+			{
+				vrate = 1000000/(256 - d[i]);
+				vchannels = 1;
+				codec = d[i+1];
+			}
+			else if (!gotextra && codec != d[i+1])
+			{
+				Global::error = "VOC files with different codecs are not supported";
+				return false;
+			}
+			blocks.push_back({ d+i+2, blocksize - 2 });
+			datasize += blocksize - 2;
+			break;
+		case 2: // Sound data continuation
+			if (codec == -1)
+			{
+				Global::error = "Sound data without codec in VOC file";
+				return false;
+			}
+			blocks.push_back({ d+i, blocksize });
+			datasize += blocksize;
+			break;
+		case 3: // Silence
+			if (blocksize >= 3)
+			{
+				size_t length = READ_L16(d, i) + 1;
+				blocks.push_back({ nullptr, length });
+				datasize += length;
+			}
+			break;
+		case 8: // Extra info, overrides any following sound data codec info
+			if (codec != -1)
+			{
+				Global::error = "Extra info block must precede sound data info block in VOC file";
+				return false;
+			}
+			if (blocksize >= 4)
+			{
+				vchannels = d[i+3] + 1;
+				vrate = 256000000/(vchannels * (65536 - READ_L16(d, i)));
+				codec = d[i+2];
+				gotextra = true;
+			}
+			break;
+		case 9: // Sound data in new format
+			if (blocksize < 12)
+				break;
+			if (codec == -1)
+			{
+				vrate = READ_L32(d, i);
+				vchannels = d[i+5];
+				codec = READ_L16(d, i+6);
+			}
+			else if (codec != READ_L16(d, i+6))
+			{
+				Global::error = "VOC files with different codecs are not supported";
+				return false;
+			}
+			blocks.push_back({ d+i+12, blocksize - 12 });
+			datasize += blocksize - 12;
+			break;
+		default: // Markers, text, repeats: nothing to play
+			break;
+		}
+		i += blocksize;
+	}
+
+	SampleFormat vformat;
+	uint8_t silence;
+	switch (codec)
+	{
+	case 0: vformat = PCM_U8;		silence = 0x80;	break;	// 8 bits unsigned PCM
+	case 4: vformat = PCM_S16LE;	silence = 0;	break;	// 16 bits signed PCM
+	case 6: vformat = PCM_ALAW;		silence = 0xD5;	break;	// alaw
+	case 7: vformat = PCM_ULAW;		silence = 0xFF;	break;	// ulaw
+	case 1: // 4 bits to 8 bits Creative ADPCM
+	case 2: // 3 bits to 8 bits Creative ADPCM (AKA 2.6 bits)
+	case 3: // 2 bits to 8 bits Creative ADPCM
+	case 0x200: // 4 bits to 16 bits Creative ADPCM (only valid in block type 0x09)
+		Global::error = S_FMT("Unsupported codec %i in VOC file", codec);
+		return false;
+	default:
+		Global::error = S_FMT("Unknown codec %i in VOC file", codec);
+		return false;
+	}
+
+	// Sound data in a single block can be streamed as it is, otherwise
+	// it has to be gathered into one buffer
+	if (blocks.size() == 1 && blocks[0].src)
+		setData(blocks[0].src, blocks[0].size);
+	else
+	{
+		size_t frame_bytes = (vformat == PCM_S16LE ? 2 : 1) * MAX(vchannels, 1u);
+		gathered.reserve(datasize);
+		for (auto& block : blocks)
+		{
+			if (block.src)
+				gathered.insert(gathered.end(), block.src, block.src + block.size);
+			else
+				gathered.insert(gathered.end(), block.size * frame_bytes, silence);
+		}
+		setData(gathered.data(), gathered.size());
+	}
+
+	return setup(vformat, vchannels, vrate);
+}
+
+/* PCMStream::openSunSound
+ * Opens Sun/NeXT format sound data [mc] for playback
+ *******************************************************************/
+bool PCMStream::openSunSound(const MemChunk& mc)
+{
+	close();
+
+	const uint8_t* d = mc.getData();
+	size_t size = mc.getSize();
+	if (size < 24 || READ_B32(d, 0) != 0x2E736E64)	// ASCII code for ".snd"
+	{
+		Global::error = "Invalid Sun Sound";
+		return false;
+	}
+
+	size_t offset = (uint32_t)READ_B32(d, 4);
+	size_t datasize = (uint32_t)READ_B32(d, 8);
+	unsigned encoding = READ_B32(d, 12);
+	unsigned samplerate = READ_B32(d, 16);
+	unsigned numchannels = READ_B32(d, 20);
+
+	SampleFormat sformat;
+	switch (encoding)
+	{
+	case 1:		sformat = PCM_ULAW; break;
+	case 2:		sformat = PCM_S8; break;
+	case 3:		sformat = PCM_S16BE; break;
+	case 4:		sformat = PCM_S24BE; break;
+	case 5:		sformat = PCM_S32BE; break;
+	case 27:	sformat = PCM_ALAW; break;
+	default:
+		Global::error = S_FMT("Unsupported Sun Sound format (%d)", encoding);
+		return false;
+	}
+
+	// The data size may be unknown (0xFFFFFFFF), in which case the
+	// sound data runs to the end of the file
+	if (offset > size)
+	{
+		Global::error = "Invalid Sun Sound";
+		return false;
+	}
+	if (datasize > size - offset)
+		datasize = size - offset;
+
+	setData(d + offset, datasize);
+	return setup(sformat, numchannels, samplerate);
+}
+
+/* PCMStream::openFormat
+ * Opens sound data [mc] of the entry format [format_id] for playback.
+ * Samples are decoded straight from [mc] while streaming, so it must
+ * not be changed or freed until the stream is closed or reopened
+ *******************************************************************/
+bool PCMStream::openFormat(const MemChunk& mc, string format_id)
+{
+	if (format_id == "snd_doom" || format_id == "snd_doom_mac")
+		return openDoomSound(mc);
+	else if (format_id == "snd_wolf")
+		return openWolfSound(mc);
+	else if (format_id == "snd_jaguar")
+		return openJaguarSound(mc);
+	else if (format_id == "snd_voc")
+		return openVoc(mc);
+	else if (format_id == "snd_sun")
+		return openSunSound(mc);
+
+	Global::error = "Unsupported sound format";
+	return false;
+}
+
+
+/*******************************************************************
+ * PCMSTREAM CLASS STATIC FUNCTIONS
+ *******************************************************************/
+
+/* PCMStream::canOpen
+ * Returns true if entries of format [format_id] can be streamed
+ * with PCMStream
+ *******************************************************************/
+bool PCMStream::canOpen(string format_id)
+{
+	return	format_id == "snd_doom" ||
+			format_id == "snd_doom_mac" ||
+			format_id == "snd_wolf" ||
+			format_id == "snd_jaguar" ||
+			format_id == "snd_voc" ||
+			format_id == "snd_sun";
+}
@@ -0,0 +1,56 @@
+#ifndef __PCM_STREAM_H__
+#define __PCM_STREAM_H__
+
+#include <SFML/Audio.hpp>
+
+class PCMStream : public sf::SoundStream
+{
+public:
+	enum SampleFormat
+	{
+		PCM_U8,
+		PCM_S8,
+		PCM_S16LE,
+		PCM_S16BE,
+		PCM_S24BE,
+		PCM_S32BE,
+		PCM_ULAW,
+		PCM_ALAW,
+	};
+
+private:
+	bool onGetData(Chunk& data);
+	void onSeek(sf::Time timeOffset);
+	bool setup(SampleFormat format, unsigned channels, unsigned rate);
+	void setData(const uint8_t* data, size_t size);
+
+	const uint8_t*		data;		// Undecoded sample data, not owned
+	size_t				data_size;
+	vector<uint8_t>		gathered;	// Sample data gathered from several blocks
+	vector<sf::Int16>	samples;	// Decoded chunk buffer
+	SampleFormat		format;
+	unsigned			channels;
+	unsigned			rate;
+	unsigned			frame_size;
+	size_t				num_frames;
+	size_t				position;	// Next frame to decode
+
+public:
+	PCMStream();
+	~PCMStream();
+
+	bool		openDoomSound(const MemChunk& mc);
+	bool		openWolfSound(const MemChunk& mc);
+	bool		openJaguarSound(const MemChunk& mc);
+	bool		openVoc(const MemChunk& mc);
+	bool		openSunSound(const MemChunk& mc);
+	bool		openFormat(const MemChunk& mc, string format_id);
+	void		close();
+
+	sf::Time	getDuration() const;
+	size_t		numFrames() const { return num_frames; }
+
+	static bool	canOpen(string format_id);
+};
+
+#endif//__PCM_STREAM_H__
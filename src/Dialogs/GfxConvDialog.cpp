@@ -32,6 +32,7 @@
 #include "GfxConvDialog.h"
 #include "Archive/ArchiveManager.h"
 #include "Dialogs/Preferences/PreferencesDialog.h"
+#include "Graphics/GfxConvert.h"
 #include "General/Console/Console.h"
 #include "General/Misc.h"
 #include "General/UI.h"
@@ -514,16 +515,29 @@ void GfxConvDialog::getConvertOptions(SIFormat::convert_options_t& opt)
 		opt.mask_source = SIFormat::MASK_BRIGHTNESS;
 
 	// Set conversion palettes
-	//opt.pal_current = gfx_current->getPalette();
-	//opt.pal_target = gfx_target->getPalette();
-	// Palettes were already set
-	opt.pal_current = pal_chooser_current->getSelectedPalette(items[current_item].entry);
-	opt.pal_target = pal_chooser_target->getSelectedPalette(items[current_item].entry);
+	getItemPalettes(current_item, opt.pal_current, opt.pal_target);
 
 	// Set conversion colour format
 	opt.col_format = current_format.coltype;
 }
 
+/* GfxConvDialog::getItemPalettes
+ * Gets the current and target conversion palettes for the item at
+ * [index]. If the item's image has its own palette and the 'current'
+ * palette chooser is set to the archive/global palette, the image's
+ * palette is used as the current palette
+ *******************************************************************/
+void GfxConvDialog::getItemPalettes(size_t index, Palette*& pal_current, Palette*& pal_target)
+{
+	gcd_item_t& item = items[index];
+
+	if (item.image.hasPalette() && pal_chooser_current->globalSelected())
+		pal_current = item.image.getPalette();
+	else
+		pal_current = pal_chooser_current->getSelectedPalette(item.entry);
+	pal_target = pal_chooser_target->getSelectedPalette(item.entry);
+}
+
 /* GfxConvDialog::itemModified
  * Returns true if the item at [index] has been modified, false
  * otherwise
@@ -591,6 +605,110 @@ void GfxConvDialog::applyConversion()
 }
 
 
+/* GfxConvDialog::convertAll
+ * Applies the current conversion to the current item and all items
+ * after it. The images are decoded and converted on multiple threads
+ * (see GfxConvert). Any items that can't be converted to the current
+ * format are left unmodified
+ *******************************************************************/
+void GfxConvDialog::convertAll()
+{
+	if (current_item >= items.size())
+		return;
+
+	// Show splash window
+	UI::showSplash("Converting Gfx...", true);
+
+	// Gets a palette that won't change while converting. The 'global' palette
+	// of a PaletteChooser is reloaded for each entry, so it is copied (and
+	// shared between items with the same palette)
+	auto stablePalette = [this](PaletteChooser* chooser, Palette* pal)
+	{
+		if (!pal || !chooser->globalSelected() || pal != chooser->getSelectedPalette())
+			return pal;
+
+		for (auto& copy : batch_palettes)
+		{
+			bool same = true;
+			for (unsigned c = 0; c < 256 && same; c++)
+				same = copy->colour(c).equals(pal->colour(c));
+			if (same)
+				return copy.get();
+		}
+
+		batch_palettes.push_back(std::make_unique<Palette>(*pal));
+		return batch_palettes.back().get();
+	};
+
+	// Setup conversion jobs
+	SIFormat::convert_options_t opt;
+	getConvertOptions(opt);
+	vector<GfxConvert::Job> jobs(items.size() - current_item);
+	for (size_t a = current_item; a < items.size(); a++)
+	{
+		gcd_item_t& item = items[a];
+		GfxConvert::Job& job = jobs[a - current_item];
+		job.format = current_format.format;
+		job.opt = opt;
+
+		// Use the same palettes as converting the item individually would
+		getItemPalettes(a, job.opt.pal_current, job.opt.pal_target);
+		job.opt.pal_current = stablePalette(pal_chooser_current, job.opt.pal_current);
+		job.opt.pal_target = stablePalette(pal_chooser_target, job.opt.pal_target);
+		job.force_writable = true;
+		job.encode = false;
+
+		// Get source image
+		bool valid = true;
+		if (item.image.isValid())
+			job.image.copyImage(&item.image);
+		else if (item.entry)
+			valid = GfxConvert::setupEntryJob(job, item.entry);
+		else if (item.texture)
+		{
+			if (item.force_rgba)
+				job.image.convertRGBA(item.palette);
+			valid = item.texture->toImage(job.image, item.archive, item.palette, item.force_rgba);
+		}
+		else
+			valid = false;
+
+		if (!valid)
+			job.error = "Not a valid image";
+	}
+
+	// Convert
+	GfxConvert::run(jobs, [](unsigned done, unsigned total)
+	{
+		UI::setSplashProgressMessage(S_FMT("%d of %d", done / 2, total / 2));
+		UI::setSplashProgress((float)done / (float)total);
+		return true;
+	});
+
+	// Update items
+	for (size_t a = current_item; a < items.size(); a++)
+	{
+		gcd_item_t& item = items[a];
+		GfxConvert::Job& job = jobs[a - current_item];
+		if (!job.ok)
+		{
+			if (item.entry)
+				LOG_MESSAGE(1, "Unable to convert entry \"%s\": %s", item.entry->getName(), job.error);
+			continue;
+		}
+
+		item.image.copyImage(&job.image);
+		item.modified = true;
+		item.new_format = job.format;
+		item.palette = job.opt.pal_target;
+	}
+	current_item = items.size();
+
+	// Hide splash window
+	UI::hideSplash();
+}
+
+
 /*******************************************************************
  * GFXCONVDIALOG EVENTS
  *******************************************************************/
@@ -622,19 +740,8 @@ void GfxConvDialog::onBtnConvert(wxCommandEvent& e)
  *******************************************************************/
 void GfxConvDialog::onBtnConvertAll(wxCommandEvent& e)
 {
-	// Show splash window
-	UI::showSplash("Converting Gfx...", true);
-
-	// Convert all images
-	for (size_t a = current_item; a < items.size(); a++)
-	{
-		applyConversion();
-		if (!nextItem())
-			break;
-	}
-
-	// Hide splash window
-	UI::hideSplash();
+	convertAll();
+	this->Close(true);
 }
 
 /* GfxConvDialog::btnSkipClicked
@@ -115,7 +115,11 @@ private:
 	bool			keep_trans;
 	rgba_t			colour_trans;
 
+	// Palettes used by items converted with 'Convert All'
+	vector<Palette::UPtr>	batch_palettes;
+
 	bool		nextItem();
+	void		getItemPalettes(size_t index, Palette*& pal_current, Palette*& pal_target);
 
 	// Static
 	static string	current_palette_name;
@@ -140,6 +144,7 @@ public:
 	Palette*	getItemPalette(int index);
 
 	void	applyConversion();
+	void	convertAll();
 
 	// Events
 	void	onResize(wxSizeEvent& e);
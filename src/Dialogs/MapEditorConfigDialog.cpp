@@ -701,8 +701,7 @@ void MapEditorConfigDialog::onMapSelected(wxListEvent& e)
 		return;
 
 	Archive::MapDesc map = selectedMap();
-	canvas_preview->clearMap();
-	canvas_preview->openMap(map);
+	canvas_preview->openMapAsync(map);
 	btn_ok->Enable(configMatchesMap(map));
 }
 
@@ -43,6 +43,7 @@ EXTERN_CVAR(Bool, swap_epanel_bars)
 EXTERN_CVAR(Bool, context_submenus)
 EXTERN_CVAR(Bool, list_font_monospace)
 EXTERN_CVAR(Bool, elist_type_bgcol)
+EXTERN_CVAR(Bool, elist_thumbnails)
 EXTERN_CVAR(Int, toolbar_size)
 EXTERN_CVAR(Int, tab_style)
 EXTERN_CVAR(Bool, am_file_browser_tab)
@@ -144,6 +145,10 @@ InterfacePrefsPanel::InterfacePrefsPanel(wxWindow* parent) : PrefsPanelBase(pare
 	cb_elist_bgcol = new wxCheckBox(panel, -1, "Colour entry list item background by entry type");
 	gb_sizer->Add(cb_elist_bgcol, wxGBPosition(row++, 0), wxGBSpan(1, 2), wxEXPAND);
 
+	// Entry list thumbnails
+	cb_elist_thumbnails = new wxCheckBox(panel, -1, "Show thumbnails for graphics and maps in the entry list");
+	gb_sizer->Add(cb_elist_thumbnails, wxGBPosition(row++, 0), wxGBSpan(1, 2), wxEXPAND);
+
 	// Context menu submenus
 	cb_context_submenus = new wxCheckBox(panel, -1, "Group related entry context menu items into submenus");
 	gb_sizer->Add(cb_context_submenus, wxGBPosition(row++, 0), wxGBSpan(1, 2), wxEXPAND);
@@ -188,6 +193,7 @@ void InterfacePrefsPanel::init()
 	cb_start_page->SetValue(show_start_page);
 	cb_context_submenus->SetValue(context_submenus);
 	cb_elist_bgcol->SetValue(elist_type_bgcol);
+	cb_elist_thumbnails->SetValue(elist_thumbnails);
 	cb_file_browser->SetValue(am_file_browser_tab);
 	cb_condensed_tabs->SetValue(tabs_condensed);
 	cb_web_dark_theme->SetValue(web_dark_theme);
@@ -232,6 +238,7 @@ void InterfacePrefsPanel::applyPreferences()
 	show_start_page = cb_start_page->GetValue();
 	context_submenus = cb_context_submenus->GetValue();
 	elist_type_bgcol = cb_elist_bgcol->GetValue();
+	elist_thumbnails = cb_elist_thumbnails->GetValue();
 	am_file_browser_tab = cb_file_browser->GetValue();
 	tabs_condensed = cb_condensed_tabs->GetValue();
 	web_dark_theme = cb_web_dark_theme->GetValue();
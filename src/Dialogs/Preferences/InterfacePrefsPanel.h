@@ -13,6 +13,7 @@ private:
 	wxCheckBox*	cb_start_page;
 	wxCheckBox*	cb_context_submenus;
 	wxCheckBox*	cb_elist_bgcol;
+	wxCheckBox*	cb_elist_thumbnails;
 	wxCheckBox* cb_file_browser;
 	wxCheckBox*	cb_condensed_tabs;
 	wxCheckBox*	cb_web_dark_theme;
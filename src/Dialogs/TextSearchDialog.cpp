@@ -0,0 +1,255 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextSearchDialog.cpp
+// Description: A dialog for searching the contents of all text entries in
+//              open archives ('find in files'), using the TextSearchIndex.
+//              Activating a result opens the entry at the matching line
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "TextSearchDialog.h"
+#include "Archive/Archive.h"
+#include "MainEditor/MainEditor.h"
+#include "MainEditor/UI/EntryPanel/TextEntryPanel.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// TextSearchDialog Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::TextSearchDialog
+//
+// TextSearchDialog class constructor
+// ----------------------------------------------------------------------------
+TextSearchDialog::TextSearchDialog(wxWindow* parent) :
+	SDialog(parent, "Find in Files", "text_search", 700, 500)
+{
+	auto sizer = new wxBoxSizer(wxVERTICAL);
+	SetSizer(sizer);
+
+	// Query
+	auto hbox = new wxBoxSizer(wxHORIZONTAL);
+	sizer->Add(hbox, 0, wxEXPAND | wxLEFT | wxRIGHT | wxTOP, 10);
+	hbox->Add(new wxStaticText(this, -1, "Find:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
+	text_query_ = new wxTextCtrl(this, -1, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	hbox->Add(text_query_, 1, wxEXPAND | wxRIGHT, 4);
+	btn_search_ = new wxButton(this, -1, "Search");
+	hbox->Add(btn_search_, 0, wxEXPAND);
+
+	// Options
+	hbox = new wxBoxSizer(wxHORIZONTAL);
+	sizer->Add(hbox, 0, wxEXPAND | wxLEFT | wxRIGHT | wxTOP, 10);
+	cb_regex_ = new wxCheckBox(this, -1, "Regular Expression");
+	hbox->Add(cb_regex_, 0, wxEXPAND | wxRIGHT, 8);
+	cb_match_case_ = new wxCheckBox(this, -1, "Match Case");
+	hbox->Add(cb_match_case_, 0, wxEXPAND | wxRIGHT, 8);
+	hbox->AddStretchSpacer();
+	label_status_ = new wxStaticText(this, -1, "");
+	hbox->Add(label_status_, 0, wxALIGN_CENTER_VERTICAL);
+
+	// Results list
+	list_hits_ = new wxDataViewListCtrl(this, -1);
+	list_hits_->AppendTextColumn("Entry", wxDATAVIEW_CELL_INERT, 200);
+	list_hits_->AppendTextColumn("Line", wxDATAVIEW_CELL_INERT, 50, wxALIGN_RIGHT);
+	list_hits_->AppendTextColumn("Text", wxDATAVIEW_CELL_INERT, -2);
+	list_hits_->SetMinSize(wxSize(0, 200));
+	sizer->Add(list_hits_, 1, wxEXPAND | wxALL, 10);
+
+	// Bind events
+	text_query_->Bind(wxEVT_TEXT_ENTER, &TextSearchDialog::onSearch, this);
+	btn_search_->Bind(wxEVT_BUTTON, &TextSearchDialog::onSearch, this);
+	list_hits_->Bind(wxEVT_DATAVIEW_ITEM_ACTIVATED, &TextSearchDialog::onHitActivated, this);
+	timer_status_.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { updateStatus(); });
+
+	Layout();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::~TextSearchDialog
+//
+// TextSearchDialog class destructor
+// ----------------------------------------------------------------------------
+TextSearchDialog::~TextSearchDialog()
+{
+	timer_status_.Stop();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::open
+//
+// Shows the dialog and starts updating the search index in the background
+// ----------------------------------------------------------------------------
+void TextSearchDialog::open()
+{
+	TextSearchIndex::update();
+	updateStatus();
+
+	Show();
+	Raise();
+	text_query_->SetFocus();
+	text_query_->SelectAll();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::search
+//
+// Runs a search with the current query and options and populates the
+// results list. If the search index is being updated, the search is run once
+// it has finished
+// ----------------------------------------------------------------------------
+void TextSearchDialog::search()
+{
+	// Pick up any entries changed since the last search, and wait for the
+	// background indexing to finish if there were any
+	if (!search_pending_)
+		TextSearchIndex::update();
+	if (TextSearchIndex::isIndexing())
+	{
+		search_pending_ = true;
+		list_hits_->DeleteAllItems();
+		updateStatus();
+		return;
+	}
+	search_pending_ = false;
+
+	TextSearchIndex::Options options;
+	options.regex = cb_regex_->GetValue();
+	options.match_case = cb_match_case_->GetValue();
+
+	list_hits_->DeleteAllItems();
+
+	wxBusyCursor busy;
+	long start = App::runTimer();
+	if (!TextSearchIndex::search(text_query_->GetValue(), options, hits_))
+	{
+		last_status_ = Global::error;
+		updateStatus();
+		return;
+	}
+	long time = App::runTimer() - start;
+
+	// Populate list
+	wxVector<wxVariant> row;
+	for (auto& hit : hits_)
+	{
+		row.push_back(wxVariant(hit.entry_path));
+		row.push_back(wxVariant(S_FMT("%d", hit.line + 1)));
+		row.push_back(wxVariant(hit.text));
+		list_hits_->AppendItem(row);
+		row.clear();
+	}
+
+	last_status_ = S_FMT("%d matches (%ldms)", (int)hits_.size(), time);
+	if (hits_.size() >= options.max_hits)
+		last_status_ += ", results truncated";
+	updateStatus();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::updateStatus
+//
+// Updates the status label, polling until any background indexing finishes
+// (and running the pending search, if any)
+// ----------------------------------------------------------------------------
+void TextSearchDialog::updateStatus()
+{
+	if (TextSearchIndex::isIndexing())
+	{
+		unsigned done, total;
+		TextSearchIndex::indexingProgress(done, total);
+		label_status_->SetLabel(S_FMT("Indexing %u of %u entries...", done, total));
+		if (!timer_status_.IsRunning())
+			timer_status_.Start(100);
+	}
+	else
+	{
+		timer_status_.Stop();
+		if (search_pending_)
+		{
+			search();
+			return;
+		}
+
+		if (last_status_.empty())
+			label_status_->SetLabel(S_FMT("%d text entries indexed", TextSearchIndex::numIndexedEntries()));
+		else
+			label_status_->SetLabel(last_status_);
+	}
+
+	Layout();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// TextSearchDialog Class Events
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::onSearch
+//
+// Called when the 'Search' button is clicked or enter is pressed in the
+// query text box
+// ----------------------------------------------------------------------------
+void TextSearchDialog::onSearch(wxCommandEvent& e)
+{
+	search();
+}
+
+// ----------------------------------------------------------------------------
+// TextSearchDialog::onHitActivated
+//
+// Called when a search result is double-clicked or enter is pressed on it.
+// Opens the entry and goes to the matching line
+// ----------------------------------------------------------------------------
+void TextSearchDialog::onHitActivated(wxDataViewEvent& e)
+{
+	int row = list_hits_->ItemToRow(e.GetItem());
+	if (row < 0 || row >= (int)hits_.size())
+		return;
+
+	auto entry = hits_[row].entry.lock();
+	if (!entry || !entry->getParent())
+	{
+		wxMessageBox("The entry no longer exists", "Find in Files", wxICON_ERROR);
+		return;
+	}
+
+	MainEditor::openArchiveTab(entry->getParent());
+	MainEditor::openEntry(entry.get());
+
+	auto panel = MainEditor::currentEntryPanel();
+	if (panel && panel->getName() == "text")
+		((TextEntryPanel*)panel)->jumpToLine(hits_[row].line);
+}
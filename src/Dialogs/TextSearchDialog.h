@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Archive/TextSearchIndex.h"
+#include "UI/SDialog.h"
+
+class wxDataViewListCtrl;
+class wxDataViewEvent;
+class TextSearchDialog : public SDialog
+{
+public:
+	TextSearchDialog(wxWindow* parent);
+	~TextSearchDialog();
+
+	void	open();
+	void	search();
+	void	updateStatus();
+
+	// Events
+	void	onSearch(wxCommandEvent& e);
+	void	onHitActivated(wxDataViewEvent& e);
+
+private:
+	wxTextCtrl*					text_query_;
+	wxCheckBox*					cb_regex_;
+	wxCheckBox*					cb_match_case_;
+	wxButton*					btn_search_;
+	wxStaticText*				label_status_;
+	wxDataViewListCtrl*			list_hits_;
+	wxTimer						timer_status_;
+	vector<TextSearchIndex::Hit>	hits_;
+	string						last_status_;
+	bool						search_pending_	= false;
+};
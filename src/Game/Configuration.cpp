@@ -57,6 +57,42 @@ EXTERN_CVAR(String, port_configuration)
 CVAR(Bool, debug_configuration, false, CVAR_SAVE)
 
 
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	const string prop_flags = "flags";
+
+	// UDMF names of basic flags, in ThingBasicFlag/LineBasicFlag order
+	const string thing_basic_flag_names[] =
+	{
+		"skill1", "skill2", "skill3", "skill4", "skill5",
+		"single", "coop", "dm",
+		"class1", "class2", "class3"
+	};
+	const string line_basic_flag_names[] = { "blocking", "twosided", "dontpegtop", "dontpegbottom" };
+	const int line_basic_flag_bits[] = { 1, 4, 8, 16 };
+
+	// ------------------------------------------------------------------------
+	// basicFlagId
+	//
+	// Returns the index of [name] in [names] (size [count]), or -1 if it isn't
+	// a basic flag
+	// ------------------------------------------------------------------------
+	int basicFlagId(const string& name, const string* names, int count)
+	{
+		for (int a = 0; a < count; a++)
+			if (names[a] == name)
+				return a;
+
+		return -1;
+	}
+}
+
+
 // ----------------------------------------------------------------------------
 //
 // Configuration Class Functions
@@ -565,6 +601,7 @@ bool Configuration::readConfiguration(string& cfg, string source, uint8_t format
 		udmf_sector_props_.clear();
 		udmf_thing_props_.clear();
 		tt_group_defaults_.clear();
+		compileLookups();
 	}
 
 	// Parse the full configuration
@@ -883,9 +920,99 @@ bool Configuration::readConfiguration(string& cfg, string source, uint8_t format
 			LOG_MESSAGE(1, "Warning: Unexpected game configuration section \"%s\", skipping", node->getName());
 	}
 
+	// Precompile flag and UDMF property lookups
+	compileLookups();
+
 	return true;
 }
 
+// ----------------------------------------------------------------------------
+// Configuration::compileLookups
+//
+// Builds the lookup tables used to resolve flags and UDMF properties without
+// string comparisons. Must be called whenever the flag or UDMF property
+// definitions change
+// ----------------------------------------------------------------------------
+void Configuration::compileLookups()
+{
+	// Flag indices by UDMF name (the first definition is used if duplicated)
+	thing_flag_index_.clear();
+	for (unsigned a = 0; a < flags_thing_.size(); a++)
+		thing_flag_index_.emplace(flags_thing_[a].udmf, a);
+	line_flag_index_.clear();
+	for (unsigned a = 0; a < flags_line_.size(); a++)
+		line_flag_index_.emplace(flags_line_[a].udmf, a);
+
+	// Basic thing flags, for Doom-style [0] and Hexen-style [1] flags
+	auto set_bits = [](FlagBits& bits, int mask, bool invert)
+	{
+		bits.mask = mask;
+		bits.invert = invert;
+		bits.valid = true;
+	};
+	auto& bits = thing_basic_bits_;
+	for (auto& flag : bits)
+		flag[0] = flag[1] = {};
+	for (unsigned hexen = 0; hexen < 2; hexen++)
+	{
+		// Skill levels
+		set_bits(bits[(int)ThingBasicFlag::Skill1][hexen], 1, false);
+		set_bits(bits[(int)ThingBasicFlag::Skill2][hexen], 1, false);
+		set_bits(bits[(int)ThingBasicFlag::Skill3][hexen], 2, false);
+		set_bits(bits[(int)ThingBasicFlag::Skill4][hexen], 4, false);
+		set_bits(bits[(int)ThingBasicFlag::Skill5][hexen], 4, false);
+	}
+
+	// Game mode flags (Hexen)
+	set_bits(bits[(int)ThingBasicFlag::Single][1], 256, false);
+	set_bits(bits[(int)ThingBasicFlag::Coop][1], 512, false);
+	set_bits(bits[(int)ThingBasicFlag::DM][1], 1024, false);
+
+	// Game mode flags (Doom), inverted - *not* multiplayer/not in coop/not in
+	// dm. Without Boom, coop and dm are always set (empty mask)
+	bool boom = supported_features_[Feature::Boom];
+	set_bits(bits[(int)ThingBasicFlag::Single][0], 16, true);
+	set_bits(bits[(int)ThingBasicFlag::Coop][0], boom ? 64 : 0, true);
+	set_bits(bits[(int)ThingBasicFlag::DM][0], boom ? 32 : 0, true);
+
+	// Class flags: fixed for Hexen, otherwise whatever the configuration defines
+	set_bits(bits[(int)ThingBasicFlag::Class1][1], 32, false);
+	set_bits(bits[(int)ThingBasicFlag::Class2][1], 64, false);
+	set_bits(bits[(int)ThingBasicFlag::Class3][1], 128, false);
+	for (int a = (int)ThingBasicFlag::Class1; a <= (int)ThingBasicFlag::Class3; a++)
+	{
+		int index = thingFlagIndex(thing_basic_flag_names[a]);
+		if (index >= 0)
+			set_bits(bits[a][0], flags_thing_[index].flag, false);
+	}
+
+	// UDMF property ids, unique by name across all MapObject types
+	UDMFPropMap* prop_maps[] =
+	{
+		&udmf_vertex_props_,
+		&udmf_linedef_props_,
+		&udmf_sidedef_props_,
+		&udmf_sector_props_,
+		&udmf_thing_props_
+	};
+	udmf_prop_ids_.clear();
+	for (auto map : prop_maps)
+		for (auto& i : *map)
+			if (udmf_prop_ids_.find(i.first) == udmf_prop_ids_.end())
+			{
+				int id = udmf_prop_ids_.size();
+				udmf_prop_ids_[i.first] = id;
+			}
+
+	// UDMF property definitions by [type][id]
+	for (unsigned t = 0; t < 5; t++)
+	{
+		udmf_props_by_id_[t].assign(udmf_prop_ids_.size(), nullptr);
+		for (auto& i : *prop_maps[t])
+			udmf_props_by_id_[t][udmf_prop_ids_[i.first]] = &i.second;
+	}
+}
+
 // ----------------------------------------------------------------------------
 // Configuration::openConfig
 //
@@ -1114,17 +1241,15 @@ bool Configuration::thingFlagSet(string flag, MapThing* thing, int map_format)
 	if (map_format == MAP_UDMF)
 		return thing->boolProperty(flag);
 
-	// Get current flags
-	unsigned long flags = thing->intProperty("flags");
-
-	// Iterate through flags
-	for (size_t i = 0; i < flags_thing_.size(); ++i)
+	// Find flag
+	int index = thingFlagIndex(flag);
+	if (index < 0)
 	{
-		if (flags_thing_[i].udmf == flag)
-			return !!(flags & flags_thing_[i].flag);
+		LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
+		return false;
 	}
-	LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
-	return false;
+
+	return !!(thing->intProperty(prop_flags) & flags_thing_[index].flag);
 }
 
 // ----------------------------------------------------------------------------
@@ -1138,73 +1263,50 @@ bool Configuration::thingBasicFlagSet(string flag, MapThing* thing, int map_form
 	if (map_format == MAP_UDMF)
 		return thing->boolProperty(flag);
 
-	// Get current flags
-	unsigned long flags = thing->intProperty("flags");
-
-	// Hexen-style flags in Hexen-format maps
-	bool hexen = map_format == MAP_HEXEN;
+	// Check basic flags
+	int id = basicFlagId(flag, thing_basic_flag_names, 11);
+	if (id >= 0)
+		return thingBasicFlagSet((ThingBasicFlag)id, thing, map_format);
 
-	// Easy Skill
-	if (flag == "skill2" || flag == "skill1")
-		return !!(flags & 1);
-
-	// Medium Skill
-	else if (flag == "skill3")
-		return !!(flags & 2);
+	// Not basic
+	return thingFlagSet(flag, thing, map_format);
+}
 
-	// Hard Skill
-	else if (flag == "skill4" || flag == "skill5")
-		return !!(flags & 4);
+// ----------------------------------------------------------------------------
+// Configuration::thingBasicFlagSet
+//
+// Returns true if the basic [flag] is set for [thing]. Uses the flag bits
+// compiled when the configuration was read, so no string lookups are needed
+// for non-UDMF maps
+// ----------------------------------------------------------------------------
+bool Configuration::thingBasicFlagSet(ThingBasicFlag flag, MapThing* thing, int map_format)
+{
+	// If UDMF, just get the bool value
+	if (map_format == MAP_UDMF)
+		return thing->boolProperty(thing_basic_flag_names[(int)flag]);
 
-	// Game mode flags
-	else if (flag == "single")
-	{
-		// Single Player
-		if (hexen)
-			return !!(flags & 256);
-		// *Not* Multiplayer
-		else
-			return !(flags & 16);
-	}
-	else if (flag == "coop")
-	{
-		// Coop
-		if (hexen)
-			return !!(flags & 512);
-		// *Not* Not In Coop
-		else if (supported_features_[Feature::Boom])
-			return !(flags & 64);
-		else
-			return true;
-	}
-	else if (flag == "dm")
+	// Hexen-style flags in Hexen-format maps
+	auto& bits = thing_basic_bits_[(int)flag][map_format == MAP_HEXEN ? 1 : 0];
+	if (!bits.valid)
 	{
-		// Deathmatch
-		if (hexen)
-			return !!(flags & 1024);
-		// *Not* Not In DM
-		else if (supported_features_[Feature::Boom])
-			return !(flags & 32);
-		else
-			return true;
+		LOG_MESSAGE(2, "Flag %s does not exist in this configuration", thing_basic_flag_names[(int)flag]);
+		return false;
 	}
 
-	// Hexen class flags
-	else if (hexen && flag.StartsWith("class"))
-	{
-		// Fighter
-		if (flag == "class1")
-			return !!(flags & 32);
-		// Cleric
-		else if (flag == "class2")
-			return !!(flags & 64);
-		// Mage
-		else if (flag == "class3")
-			return !!(flags & 128);
-	}
+	bool set = (thing->intProperty(prop_flags) & bits.mask) != 0;
+	return bits.invert ? !set : set;
+}
 
-	// Not basic
-	return thingFlagSet(flag, thing, map_format);
+// ----------------------------------------------------------------------------
+// Configuration::thingFlagIndex
+//
+// Returns the index of the thing flag with UDMF name [udmf_name], or -1 if it
+// isn't defined in this configuration
+// ----------------------------------------------------------------------------
+int Configuration::thingFlagIndex(const string& udmf_name) const
+{
+	auto i = thing_flag_index_.find(udmf_name);
+	return i != thing_flag_index_.end() ? i->second : -1;
 }
 
 // ----------------------------------------------------------------------------
@@ -1273,17 +1375,9 @@ void Configuration::setThingFlag(string flag, MapThing* thing, int map_format, b
 		return;
 	}
 
-	// Iterate through flags
-	unsigned long flag_val = 0;
-	for (size_t i = 0; i < flags_thing_.size(); ++i)
-	{
-		if (flags_thing_[i].udmf == flag)
-		{
-			flag_val = flags_thing_[i].flag;
-			break;
-		}
-	}
-
+	// Find flag
+	int index = thingFlagIndex(flag);
+	unsigned long flag_val = index >= 0 ? flags_thing_[index].flag : 0;
 	if (flag_val == 0)
 	{
 		LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
@@ -1525,17 +1619,15 @@ bool Configuration::lineFlagSet(string flag, MapLine* line, int map_format)
 	if (map_format == MAP_UDMF)
 		return line->boolProperty(flag);
 
-	// Get current flags
-	unsigned long flags = line->intProperty("flags");
-
-	// Iterate through flags
-	for (size_t i = 0; i < flags_line_.size(); ++i)
+	// Find flag
+	int index = lineFlagIndex(flag);
+	if (index < 0)
 	{
-		if (flags_line_[i].udmf == flag)
-			return !!(flags & flags_line_[i].flag);
+		LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
+		return false;
 	}
-	LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
-	return false;
+
+	return !!(line->intProperty(prop_flags) & flags_line_[index].flag);
 }
 
 // ----------------------------------------------------------------------------
@@ -1551,27 +1643,40 @@ bool Configuration::lineBasicFlagSet(string flag, MapLine* line, int map_format)
 	if (map_format == MAP_UDMF)
 		return line->boolProperty(flag);
 
-	// Get current flags
-	unsigned long flags = line->intProperty("flags");
+	// Check basic flags
+	int id = basicFlagId(flag, line_basic_flag_names, 4);
+	if (id >= 0)
+		return lineBasicFlagSet((LineBasicFlag)id, line, map_format);
 
-	// Impassable
-	if (flag == "blocking")
-		return !!(flags & 1);
-
-	// Two Sided
-	else if (flag == "twosided")
-		return !!(flags & 4);
+	// Not basic
+	return lineFlagSet(flag, line, map_format);
+}
 
-	// Upper unpegged
-	else if (flag == "dontpegtop")
-		return !!(flags & 8);
+// ----------------------------------------------------------------------------
+// Configuration::lineBasicFlagSet
+//
+// Returns true if the basic [flag] is set for [line], without any string
+// lookups for non-UDMF maps
+// ----------------------------------------------------------------------------
+bool Configuration::lineBasicFlagSet(LineBasicFlag flag, MapLine* line, int map_format)
+{
+	// If UDMF, just get the bool value
+	if (map_format == MAP_UDMF)
+		return line->boolProperty(line_basic_flag_names[(int)flag]);
 
-	// Lower unpegged
-	else if (flag == "dontpegbottom")
-		return !!(flags & 16);
+	return !!(line->intProperty(prop_flags) & line_basic_flag_bits[(int)flag]);
+}
 
-	// Not basic
-	return lineFlagSet(flag, line, map_format);
+// ----------------------------------------------------------------------------
+// Configuration::lineFlagIndex
+//
+// Returns the index of the line flag with UDMF name [udmf_name], or -1 if it
+// isn't defined in this configuration
+// ----------------------------------------------------------------------------
+int Configuration::lineFlagIndex(const string& udmf_name) const
+{
+	auto i = line_flag_index_.find(udmf_name);
+	return i != line_flag_index_.end() ? i->second : -1;
 }
 
 // ----------------------------------------------------------------------------
@@ -1646,17 +1751,9 @@ void Configuration::setLineFlag(string flag, MapLine* line, int map_format, bool
 		return;
 	}
 
-	// Iterate through flags
-	unsigned long flag_val = 0;
-	for (size_t i = 0; i < flags_line_.size(); ++i)
-	{
-		if (flags_line_[i].udmf == flag)
-		{
-			flag_val = flags_line_[i].flag;
-			break;
-		}
-	}
-
+	// Find flag
+	int index = lineFlagIndex(flag);
+	unsigned long flag_val = index >= 0 ? flags_line_[index].flag : 0;
 	if (flag_val == 0)
 	{
 		LOG_MESSAGE(2, "Flag %s does not exist in this configuration", flag);
@@ -1862,18 +1959,43 @@ string Configuration::spacTriggerUDMFName(unsigned trigger_index)
 // ----------------------------------------------------------------------------
 UDMFProperty* Configuration::getUDMFProperty(string name, int type)
 {
-	if (type == MOBJ_VERTEX)
-		return &udmf_vertex_props_[name];
-	else if (type == MOBJ_LINE)
-		return &udmf_linedef_props_[name];
-	else if (type == MOBJ_SIDE)
-		return &udmf_sidedef_props_[name];
-	else if (type == MOBJ_SECTOR)
-		return &udmf_sector_props_[name];
-	else if (type == MOBJ_THING)
-		return &udmf_thing_props_[name];
-	else
+	if (type < MOBJ_VERTEX || type > MOBJ_THING)
+		return nullptr;
+
+	// Properties not defined for [type] get a blank definition (no default)
+	auto prop = udmfProperty(udmfPropertyId(name), type);
+	return prop ? prop : &udmf_prop_undefined_;
+}
+
+// ----------------------------------------------------------------------------
+// Configuration::udmfPropertyId
+//
+// Returns the id of the UDMF property matching [name], or -1 if no property
+// with that name is defined for any MapObject type. Ids are only valid until
+// the configuration is next read
+// ----------------------------------------------------------------------------
+int Configuration::udmfPropertyId(const string& name) const
+{
+	auto i = udmf_prop_ids_.find(name);
+	return i != udmf_prop_ids_.end() ? i->second : -1;
+}
+
+// ----------------------------------------------------------------------------
+// Configuration::udmfProperty
+//
+// Returns the UDMF property definition with [id] for MapObject [type], or
+// null if it isn't defined for that type
+// ----------------------------------------------------------------------------
+UDMFProperty* Configuration::udmfProperty(int id, int type)
+{
+	if (type < MOBJ_VERTEX || type > MOBJ_THING)
 		return nullptr;
+
+	auto& props = udmf_props_by_id_[type - MOBJ_VERTEX];
+	if (id < 0 || (unsigned)id >= props.size())
+		return nullptr;
+
+	return props[id];
 }
 
 // ----------------------------------------------------------------------------
@@ -1908,51 +2030,39 @@ UDMFPropMap& Configuration::allUDMFProperties(int type)
 // ----------------------------------------------------------------------------
 void Configuration::cleanObjectUDMFProps(MapObject* object)
 {
-	// Get UDMF properties list for type
-	UDMFPropMap* map = nullptr;
 	int type = object->getObjType();
-	if (type == MOBJ_VERTEX)
-		map = &udmf_vertex_props_;
-	else if (type == MOBJ_LINE)
-		map = &udmf_linedef_props_;
-	else if (type == MOBJ_SIDE)
-		map = &udmf_sidedef_props_;
-	else if (type == MOBJ_SECTOR)
-		map = &udmf_sector_props_;
-	else if (type == MOBJ_THING)
-		map = &udmf_thing_props_;
-	else
+	if (type < MOBJ_VERTEX || type > MOBJ_THING)
 		return;
 
-	// Go through properties
-	for (auto& i : *map)
+	// Go through the object's properties (usually far fewer than the
+	// configuration defines)
+	auto props = object->props().allProperties();
+	auto is_default = [&](MobjPropertyList::prop_t& prop)
 	{
-		// Check if the object even has this property
-		if (!object->hasProp(i.first))
-			continue;
+		if (!prop.value.hasValue())
+			return false;
 
-		// Remove the property from the object if it is the default value
-		if (i.second.defaultValue().getType() == PROP_BOOL)
-		{
-			if (i.second.defaultValue().getBoolValue() == object->boolProperty(i.first))
-				object->props().removeProperty(i.first);
-		}
-		else if (i.second.defaultValue().getType() == PROP_INT)
-		{
-			if (i.second.defaultValue().getIntValue() == object->intProperty(i.first))
-				object->props().removeProperty(i.first);
-		}
-		else if (i.second.defaultValue().getType() == PROP_FLOAT)
-		{
-			if (i.second.defaultValue().getFloatValue() == object->floatProperty(i.first))
-				object->props().removeProperty(i.first);
-		}
-		else if (i.second.defaultValue().getType() == PROP_STRING)
+		// Get the property definition
+		auto def = udmfProperty(udmfPropertyId(prop.name), type);
+		if (!def)
+			return false;
+
+		// Check if the value is the default
+		auto& def_val = def->defaultValue();
+		switch (def_val.getType())
 		{
-			if (i.second.defaultValue().getStringValue() == object->stringProperty(i.first))
-				object->props().removeProperty(i.first);
+		case PROP_BOOL:		return def_val.getBoolValue() == prop.value.getBoolValue();
+		case PROP_INT:		return def_val.getIntValue() == prop.value.getIntValue();
+		case PROP_FLOAT:	return def_val.getFloatValue() == prop.value.getFloatValue();
+		case PROP_STRING:	return def_val.getStringValue() == prop.value.getStringValue();
+		default:			return false;
 		}
-	}
+	};
+
+	// Remove any properties with default values
+	for (auto& prop : props)
+		if (is_default(prop))
+			object->props().removeProperty(prop.name);
 }
 
 // ----------------------------------------------------------------------------
@@ -2465,6 +2575,155 @@ void Configuration::dumpUDMFProperties()
 }
 
 
+// ----------------------------------------------------------------------------
+// Configuration::benchmarkLookups
+//
+// Logs the per-call cost of flag and UDMF property lookups, comparing lookups
+// by name (as done before lookups were compiled) with the typed accessors.
+// Each test is run [iterations] times
+// ----------------------------------------------------------------------------
+void Configuration::benchmarkLookups(unsigned iterations)
+{
+	if (iterations == 0)
+		return;
+
+	MapThing thing;
+	MapLine line;
+	thing.setIntProperty("flags", 7);
+	line.setIntProperty("flags", 9);
+	int result = 0;
+
+	wxStopWatch sw;
+	auto report = [&sw](const char* test, unsigned calls)
+	{
+		double ns = sw.TimeInMicro().ToDouble() * 1000.0 / calls;
+		Log::console(S_FMT("%-42s %8.1fns/call", test, ns));
+	};
+
+	// Thing basic flags: comparison chain by name (old) vs. compiled bits
+	string names[] = { "skill3", "coop", "dm" };
+	auto old_basic = [&](const string& flag)
+	{
+		unsigned long flags = thing.intProperty("flags");
+		if (flag == "skill2" || flag == "skill1")	return !!(flags & 1);
+		else if (flag == "skill3")					return !!(flags & 2);
+		else if (flag == "skill4" || flag == "skill5")	return !!(flags & 4);
+		else if (flag == "single")					return !(flags & 16);
+		else if (flag == "coop")					return !(flags & 64);
+		else if (flag == "dm")						return !(flags & 32);
+		return false;
+	};
+	sw.Start();
+	for (unsigned a = 0; a < iterations; a++)
+		for (auto& name : names)
+			result += old_basic(name);
+	report("thing basic flag (compare names, old)", iterations * 3);
+	sw.Start();
+	for (unsigned a = 0; a < iterations; a++)
+		for (auto& name : names)
+			result += thingBasicFlagSet(name, &thing, MAP_DOOM);
+	report("thing basic flag (by name)", iterations * 3);
+	ThingBasicFlag typed[] = { ThingBasicFlag::Skill3, ThingBasicFlag::Coop, ThingBasicFlag::DM };
+	sw.Start();
+	for (unsigned a = 0; a < iterations; a++)
+		for (auto flag : typed)
+			result += thingBasicFlagSet(flag, &thing, MAP_DOOM);
+	report("thing basic flag (typed)", iterations * 3);
+
+	// Line flags: linear search by UDMF name (old) vs. compiled index
+	if (!flags_line_.empty())
+	{
+		string last = flags_line_.back().udmf;
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+		{
+			unsigned long flags = line.intProperty("flags");
+			for (auto& flag : flags_line_)
+				if (flag.udmf == last)
+				{
+					result += !!(flags & flag.flag);
+					break;
+				}
+		}
+		report("line flag (linear search, old)", iterations);
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+			result += lineFlagSet(last, &line, MAP_DOOM);
+		report("line flag (by name)", iterations);
+		int index = lineFlagIndex(last);
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+			result += lineFlagSet(index, &line);
+		report("line flag (by index)", iterations);
+	}
+	sw.Start();
+	for (unsigned a = 0; a < iterations; a++)
+		result += lineBasicFlagSet(LineBasicFlag::DontPegTop, &line, MAP_DOOM);
+	report("line basic flag (typed)", iterations);
+
+	// UDMF property definitions: std::map (old) vs. dense id
+	if (!udmf_thing_props_.empty())
+	{
+		string name = udmf_thing_props_.rbegin()->first;
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+			result += udmf_thing_props_[name].isFlag();
+		report("udmf property (map lookup, old)", iterations);
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+			result += getUDMFProperty(name, MOBJ_THING)->isFlag();
+		report("udmf property (by name)", iterations);
+		int id = udmfPropertyId(name);
+		sw.Start();
+		for (unsigned a = 0; a < iterations; a++)
+			result += udmfProperty(id, MOBJ_THING)->isFlag();
+		report("udmf property (by id)", iterations);
+	}
+
+	// Cleaning default UDMF properties from a thing with a few properties:
+	// checking every definition (old) vs. checking the thing's properties
+	unsigned n_clean = MAX(1u, iterations / 100);
+	auto setup_thing = [&]()
+	{
+		thing.props().clear();
+		unsigned count = 0;
+		for (auto& i : udmf_thing_props_)
+		{
+			thing.props()[i.first] = i.second.defaultValue();
+			if (++count == 4)
+				break;
+		}
+		thing.props()["comment"] = Property(string("test"));
+	};
+	sw.Start();
+	for (unsigned a = 0; a < n_clean; a++)
+	{
+		setup_thing();
+		for (auto& i : udmf_thing_props_)
+		{
+			if (!thing.hasProp(i.first))
+				continue;
+
+			auto& def = i.second.defaultValue();
+			if ((def.getType() == PROP_BOOL && def.getBoolValue() == thing.boolProperty(i.first)) ||
+				(def.getType() == PROP_INT && def.getIntValue() == thing.intProperty(i.first)) ||
+				(def.getType() == PROP_FLOAT && def.getFloatValue() == thing.floatProperty(i.first)) ||
+				(def.getType() == PROP_STRING && def.getStringValue() == thing.stringProperty(i.first)))
+				thing.props().removeProperty(i.first);
+		}
+	}
+	report("clean udmf props (all definitions, old)", n_clean);
+	sw.Start();
+	for (unsigned a = 0; a < n_clean; a++)
+	{
+		setup_thing();
+		cleanObjectUDMFProps(&thing);
+	}
+	report("clean udmf props (object properties)", n_clean);
+
+	Log::debug(2, S_FMT("benchmarkLookups: checksum %d", result));
+}
+
 // ----------------------------------------------------------------------------
 //
 // Console Commands
@@ -2491,6 +2750,15 @@ CONSOLE_COMMAND(dumpudmfprops, 0, false)
 	Game::configuration().dumpUDMFProperties();
 }
 
+CONSOLE_COMMAND(test_gc_lookups, 0, false)
+{
+	long iterations = 100000;
+	if (args.size() > 0)
+		args[0].ToLong(&iterations);
+
+	Game::configuration().benchmarkLookups(MAX(1, iterations));
+}
+
 CONSOLE_COMMAND(dumpthingtypes, 0, false)
 {
 	Game::configuration().dumpThingTypes();
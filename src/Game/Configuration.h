@@ -46,6 +46,29 @@ namespace Game
 		ThingRotation,		// Per-thing pitch and yaw rotation
 	};
 
+	// 'Basic' flags, available in some way or another in all game configurations
+	enum class ThingBasicFlag
+	{
+		Skill1,
+		Skill2,
+		Skill3,
+		Skill4,
+		Skill5,
+		Single,
+		Coop,
+		DM,
+		Class1,
+		Class2,
+		Class3,
+	};
+	enum class LineBasicFlag
+	{
+		Blocking,
+		TwoSided,
+		DontPegTop,
+		DontPegBottom,
+	};
+
 	struct gc_mapinfo_t
 	{
 		string	mapname;
@@ -123,6 +146,8 @@ namespace Game
 		bool	thingFlagSet(unsigned flag_index, MapThing* thing);
 		bool	thingFlagSet(string udmf_name, MapThing* thing, int map_format);
 		bool	thingBasicFlagSet(string flag, MapThing* line, int map_format);
+		bool	thingBasicFlagSet(ThingBasicFlag flag, MapThing* thing, int map_format);
+		int		thingFlagIndex(const string& udmf_name) const;
 		string	thingFlagsString(int flags);
 		void	setThingFlag(unsigned flag_index, MapThing* thing, bool set = true);
 		void	setThingFlag(string udmf_name, MapThing* thing, int map_format, bool set = true);
@@ -146,6 +171,8 @@ namespace Game
 		bool		lineFlagSet(unsigned flag_index, MapLine* line);
 		bool		lineFlagSet(string udmf_name, MapLine* line, int map_format);
 		bool		lineBasicFlagSet(string flag, MapLine* line, int map_format);
+		bool		lineBasicFlagSet(LineBasicFlag flag, MapLine* line, int map_format);
+		int			lineFlagIndex(const string& udmf_name) const;
 		string		lineFlagsString(MapLine* line);
 		void		setLineFlag(unsigned flag_index, MapLine* line, bool set = true);
 		void		setLineFlag(string udmf_name, MapLine* line, int map_format, bool set = true);
@@ -160,6 +187,8 @@ namespace Game
 
 		// UDMF properties
 		UDMFProperty*	getUDMFProperty(string name, int type);
+		int				udmfPropertyId(const string& name) const;
+		UDMFProperty*	udmfProperty(int id, int type);
 		UDMFPropMap&	allUDMFProperties(int type);
 		void			cleanObjectUDMFProps(MapObject* object);
 
@@ -193,8 +222,18 @@ namespace Game
 		void	dumpThingTypes();
 		void	dumpValidMapNames();
 		void	dumpUDMFProperties();
+		void	benchmarkLookups(unsigned iterations);
 
 	private:
+		// Precompiled flag bits for a basic flag
+		struct FlagBits
+		{
+			int		mask	= 0;
+			bool	invert	= false;	// The flag is set if [mask] is *not* set
+			bool	valid	= false;
+		};
+		typedef std::unordered_map<string, int, wxStringHash> NameIndexMap;
+
 		string		current_game_;				// Current game name
 		string		current_port_;				// Current port name (empty if none)
 		bool		map_formats_[4];			// Supported map formats
@@ -233,6 +272,14 @@ namespace Game
 		UDMFPropMap	udmf_sector_props_;
 		UDMFPropMap	udmf_thing_props_;
 
+		// Compiled lookups (see compileLookups)
+		NameIndexMap			thing_flag_index_;		// UDMF name -> index in flags_thing_
+		NameIndexMap			line_flag_index_;		// UDMF name -> index in flags_line_
+		FlagBits				thing_basic_bits_[11][2];	// [ThingBasicFlag][hexen format]
+		NameIndexMap			udmf_prop_ids_;			// UDMF property name -> id
+		vector<UDMFProperty*>	udmf_props_by_id_[5];	// [MapObject type - 1][id]
+		UDMFProperty			udmf_prop_undefined_;
+
 		// Defaults
 		PropertyList	defaults_line_;
 		PropertyList	defaults_line_udmf_;
@@ -249,5 +296,7 @@ namespace Game
 
 		// Special Presets
 		vector<SpecialPreset>	special_presets_;
+
+		void	compileLookups();
 	};
 }
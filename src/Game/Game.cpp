@@ -82,11 +82,14 @@ public:
 		listenTo(&App::archiveManager());
 	}
 
-	void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override
+	void onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override
 	{
+		static const Announcement::Id archive_added = Announcement::id("archive_added");
+		static const Announcement::Id archive_closed = Announcement::id("archive_closed");
+
 		if (announcer == &App::archiveManager())
 		{
-			if (event_name == "archive_added" || event_name == "archive_closed")
+			if (event == archive_added || event == archive_closed)
 				updateCustomDefinitions();
 		}
 	}
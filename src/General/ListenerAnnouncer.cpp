@@ -32,6 +32,67 @@
  *******************************************************************/
 #include "Main.h"
 #include "General/ListenerAnnouncer.h"
+#include <deque>
+#include <mutex>
+
+
+/*******************************************************************
+ * ANNOUNCEMENT NAMESPACE FUNCTIONS
+ *******************************************************************/
+namespace Announcement
+{
+	// Constructed on first use, since ids can be requested during static
+	// initialisation. Names are kept in a deque so references to them stay
+	// valid when more are added
+	struct IdTable
+	{
+		std::unordered_map<string, Id, wxStringHash>	ids;
+		std::deque<string>								names;
+		std::mutex										mutex;
+	};
+	IdTable& idTable()
+	{
+		static IdTable table;
+		return table;
+	}
+
+	// Passed to listeners for announcements without any extra data
+	MemChunk& noData()
+	{
+		static MemChunk empty;
+		return empty;
+	}
+}
+
+/* Announcement::id
+ * Returns the interned id for [event_name], adding it if it hasn't
+ * been used before
+ *******************************************************************/
+Announcement::Id Announcement::id(const string& event_name)
+{
+	auto& table = idTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	auto i = table.ids.find(event_name);
+	if (i != table.ids.end())
+		return i->second;
+
+	Id id = table.names.size();
+	table.ids[event_name] = id;
+	table.names.push_back(event_name);
+	return id;
+}
+
+/* Announcement::name
+ * Returns the event name for [id]
+ *******************************************************************/
+const string& Announcement::name(Id id)
+{
+	auto& table = idTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	return table.names[id];
+}
 
 
 /*******************************************************************
@@ -88,6 +149,17 @@ void Listener::onAnnouncement(Announcer* announcer, string event_name, MemChunk&
 {
 }
 
+/* Listener::onAnnouncementEvent
+ * Called when an announcer that this listener is listening to
+ * announces an event. By default this passes the event name on to
+ * onAnnouncement, listeners that receive a lot of announcements can
+ * override this instead to check event ids rather than names
+ *******************************************************************/
+void Listener::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
+{
+	onAnnouncement(announcer, Announcement::name(event), event_data);
+}
+
 
 /*******************************************************************
  * ANNOUNCER CLASS FUNCTIONS
@@ -96,9 +168,11 @@ void Listener::onAnnouncement(Announcer* announcer, string event_name, MemChunk&
 /* Announcer::Announcer
  * Announcer class constructor
  *******************************************************************/
-Announcer::Announcer()
+Announcer::Announcer() :
+	muted{ false },
+	batch_level{ 0 },
+	self{ std::make_shared<Announcer*>(this) }
 {
-	muted = false;
 }
 
 /* Announcer::~Announcer
@@ -138,24 +212,107 @@ void Announcer::removeListener(Listener* l)
  * list, ie all Listeners that are 'listening' to this announcer.
  *******************************************************************/
 void Announcer::announce(string event_name, MemChunk& event_data)
+{
+	announce(Announcement::id(event_name), event_data);
+}
+
+/* Announcer::announce
+ * 'Announces' an event to all listeners currently in the listeners
+ * list, ie all Listeners that are 'listening' to this announcer.
+ * For announcements that don't require any extra data
+ *******************************************************************/
+void Announcer::announce(string event_name)
+{
+	announce(Announcement::id(event_name), Announcement::noData());
+}
+
+/* Announcer::announce
+ * 'Announces' [event] to all listeners currently in the listeners
+ * list. If called from a thread other than the main thread, the
+ * announcement is passed on to the main thread and sent from there.
+ * If a batch is in progress, the announcement is queued until the
+ * batch ends (identical announcements are only queued once)
+ *******************************************************************/
+void Announcer::announce(Announcement::Id event, MemChunk& event_data)
 {
 	if (isMuted())
 		return;
 
+	// Send to the main thread if needed
+	if (!wxThread::IsMain() && wxTheApp)
+	{
+		std::weak_ptr<Announcer*> announcer = self;
+		vector<uint8_t> data(event_data.getData(), event_data.getData() + event_data.getSize());
+		wxTheApp->CallAfter([announcer, event, data]()
+		{
+			// Check the announcer wasn't deleted in the meantime
+			auto a = announcer.lock();
+			if (!a)
+				return;
+
+			MemChunk mc(data.data(), data.size());
+			(*a)->announce(event, mc);
+		});
+
+		return;
+	}
+
+	// Queue if batching
+	if (batch_level > 0)
+	{
+		QueuedEvent queued;
+		queued.event = event;
+		queued.data.assign(event_data.getData(), event_data.getData() + event_data.getSize());
+		if (batch_events_queued.insert(queued).second)
+			batch_events.push_back(std::move(queued));
+
+		return;
+	}
+
 	for (size_t a = 0; a < listeners.size(); a++)
 	{
 		if (!listeners[a]->isDeaf())
-			listeners[a]->onAnnouncement(this, event_name, event_data);
+			listeners[a]->onAnnouncementEvent(this, event, event_data);
 	}
 }
 
 /* Announcer::announce
- * 'Announces' an event to all listeners currently in the listeners
- * list, ie all Listeners that are 'listening' to this announcer.
- * For announcements that don't require any extra data
+ * 'Announces' [event] to all listeners currently in the listeners
+ * list. For announcements that don't require any extra data
  *******************************************************************/
-void Announcer::announce(string event_name)
+void Announcer::announce(Announcement::Id event)
 {
-	MemChunk mc;
-	announce(event_name, mc);
+	announce(event, Announcement::noData());
+}
+
+/* Announcer::beginBatch
+ * Begins an announcement batch - any announcements made until the
+ * matching endBatch call are queued (and coalesced) rather than sent.
+ * Batches can be nested
+ *******************************************************************/
+void Announcer::beginBatch()
+{
+	batch_level++;
+}
+
+/* Announcer::endBatch
+ * Ends an announcement batch. If this ends the outermost batch, all
+ * queued announcements are sent, in the order they were first made
+ *******************************************************************/
+void Announcer::endBatch()
+{
+	if (batch_level == 0 || --batch_level > 0)
+		return;
+
+	// Take the queued events (more may be queued if a listener begins a
+	// new batch while they are being sent)
+	vector<QueuedEvent> events;
+	events.swap(batch_events);
+	batch_events_queued.clear();
+
+	for (auto& queued : events)
+	{
+		MemChunk mc(queued.data.data(), queued.data.size());
+		announce(queued.event, mc);
+	}
 }
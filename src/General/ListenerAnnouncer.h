@@ -1,9 +1,18 @@
-
 #ifndef __LISTENERANNOUNCER_H__
 #define __LISTENERANNOUNCER_H__
 
 class Announcer;
 
+// Announcement event names are interned to integer ids, so events can be
+// dispatched and compared without any string work
+namespace Announcement
+{
+	typedef unsigned Id;
+
+	Id				id(const string& event_name);
+	const string&	name(Id id);
+}
+
 class Listener
 {
 private:
@@ -18,6 +27,7 @@ public:
 	void stopListening(Announcer* a);
 	void clearAnnouncers() { announcers.clear(); }
 	virtual void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	virtual void onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data);
 
 	bool	isDeaf() { return deaf; }
 	void	setDeaf(bool d) { deaf = d; }
@@ -29,6 +39,25 @@ private:
 	vector<Listener*>	listeners;
 	bool				muted;
 
+	// Batching
+	struct QueuedEvent
+	{
+		Announcement::Id	event;
+		vector<uint8_t>		data;
+
+		bool operator<(const QueuedEvent& other) const
+		{
+			return event < other.event || (event == other.event && data < other.data);
+		}
+	};
+	int						batch_level;
+	vector<QueuedEvent>		batch_events;
+	std::set<QueuedEvent>	batch_events_queued;
+
+	// Used to check the announcer still exists when dispatching
+	// announcements made from other threads
+	std::shared_ptr<Announcer*>	self;
+
 public:
 	Announcer();
 	virtual ~Announcer();
@@ -37,9 +66,27 @@ public:
 	void removeListener(Listener* l);
 	void announce(string event_name, MemChunk& event_data);
 	void announce(string event_name);
+	void announce(Announcement::Id event, MemChunk& event_data);
+	void announce(Announcement::Id event);
 
 	bool	isMuted() { return muted; }
 	void	setMuted(bool m) { muted = m; }
+
+	void	beginBatch();
+	void	endBatch();
+	bool	isBatching() { return batch_level > 0; }
+
+	// Begins an announcement batch on the given announcer, and ends it when
+	// it goes out of scope
+	class Batch
+	{
+	public:
+		Batch(Announcer* announcer) : announcer{ announcer } { if (announcer) announcer->beginBatch(); }
+		~Batch() { if (announcer) announcer->endBatch(); }
+
+	private:
+		Announcer*	announcer;
+	};
 };
 
 #endif //__LISTENERANNOUNCER_H__
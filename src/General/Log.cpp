@@ -31,7 +31,9 @@
 // ----------------------------------------------------------------------------
 #include "Main.h"
 #include "App.h"
+#include <deque>
 #include <fstream>
+#include <mutex>
 
 
 // ----------------------------------------------------------------------------
@@ -41,8 +43,9 @@
 // ----------------------------------------------------------------------------
 namespace Log
 {
-	vector<Message>	log;
-	std::ofstream	log_file;
+	std::deque<Message>	log;		// Deque so pointers from since() stay valid
+	std::mutex			log_mutex;
+	std::ofstream		log_file;
 }
 CVAR(Int, log_verbosity, 1, CVAR_SAVE)
 
@@ -137,11 +140,16 @@ void Log::init()
 // ----------------------------------------------------------------------------
 // Log::history
 //
-// Returns the log message history
+// Returns a copy of the log message history, starting from message [first]
 // ----------------------------------------------------------------------------
-const vector<Log::Message>& Log::history()
+vector<Log::Message> Log::history(unsigned first)
 {
-	return log;
+	std::lock_guard<std::mutex> lock(log_mutex);
+
+	vector<Message> list;
+	for (size_t a = first; a < log.size(); a++)
+		list.push_back(log[a]);
+	return list;
 }
 
 // ----------------------------------------------------------------------------
@@ -172,7 +180,8 @@ void Log::setVerbosity(int verbosity)
 // ----------------------------------------------------------------------------
 void Log::message(MessageType type, const char* text)
 {
-	// Add log message
+	// Add log message (can be called from any thread)
+	std::lock_guard<std::mutex> lock(log_mutex);
 	log.push_back({ text, type, wxDateTime::Now().GetTicks() });
 
 	// Write to log file
@@ -188,6 +197,8 @@ void Log::message(MessageType type, const char* text)
 // ----------------------------------------------------------------------------
 vector<Log::Message*> Log::since(time_t time, MessageType type)
 {
+	std::lock_guard<std::mutex> lock(log_mutex);
+
 	vector<Message*> list;
 	for (auto& msg : log)
 		if (msg.timestamp >= time && (type == MessageType::Any || msg.type == type))
@@ -227,7 +238,8 @@ void Log::message(MessageType type, int level, const char* text)
 	if (level > log_verbosity)
 		return;
 
-	// Add log message
+	// Add log message (can be called from any thread)
+	std::lock_guard<std::mutex> lock(log_mutex);
 	log.push_back({ text, type, wxDateTime::Now().GetTicks() });
 
 	// Write to log file
@@ -22,8 +22,8 @@ namespace Log
 		string	formattedMessageLine() const;
 	};
 
-	const vector<Message>&	history();
-	int						verbosity();
+	vector<Message>	history(unsigned first = 0);
+	int				verbosity();
 
 	void	setVerbosity(int verbosity);
 
@@ -647,6 +647,116 @@ uint32_t Misc::crc(const uint8_t* buf, uint32_t len)
 	return update_crc(0xffffffffL, buf, len) ^ 0xffffffffL;
 }
 
+// 64-bit hash stuff (XXH64 algorithm)
+
+static const uint64_t HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t HASH_PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t HASH_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t HASH_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t hashRotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hashRead64(const uint8_t* p)
+{
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return wxUINT64_SWAP_ON_BE(v);
+}
+
+static inline uint32_t hashRead32(const uint8_t* p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return wxUINT32_SWAP_ON_BE(v);
+}
+
+static inline uint64_t hashRound(uint64_t acc, uint64_t input)
+{
+	acc += input * HASH_PRIME2;
+	acc = hashRotl(acc, 31);
+	return acc * HASH_PRIME1;
+}
+
+static inline uint64_t hashMergeRound(uint64_t acc, uint64_t val)
+{
+	acc ^= hashRound(0, val);
+	return acc * HASH_PRIME1 + HASH_PRIME4;
+}
+
+/* Misc::hash64
+ * Returns a 64-bit hash of the bytes buf[0..len-1]. This is much
+ * faster than crc and has far fewer collisions, so it is suitable
+ * for comparing entry content
+ *******************************************************************/
+uint64_t Misc::hash64(const uint8_t* buf, uint32_t len)
+{
+	const uint8_t* p = buf;
+	const uint8_t* end = buf + len;
+	uint64_t h;
+
+	if (len >= 32)
+	{
+		uint64_t v1 = HASH_PRIME1 + HASH_PRIME2;
+		uint64_t v2 = HASH_PRIME2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0 - HASH_PRIME1;
+
+		const uint8_t* limit = end - 32;
+		do
+		{
+			v1 = hashRound(v1, hashRead64(p));
+			v2 = hashRound(v2, hashRead64(p + 8));
+			v3 = hashRound(v3, hashRead64(p + 16));
+			v4 = hashRound(v4, hashRead64(p + 24));
+			p += 32;
+		}
+		while (p <= limit);
+
+		h = hashRotl(v1, 1) + hashRotl(v2, 7) + hashRotl(v3, 12) + hashRotl(v4, 18);
+		h = hashMergeRound(h, v1);
+		h = hashMergeRound(h, v2);
+		h = hashMergeRound(h, v3);
+		h = hashMergeRound(h, v4);
+	}
+	else
+		h = HASH_PRIME5;
+
+	h += len;
+
+	// Remaining bytes
+	while (p + 8 <= end)
+	{
+		h ^= hashRound(0, hashRead64(p));
+		h = hashRotl(h, 27) * HASH_PRIME1 + HASH_PRIME4;
+		p += 8;
+	}
+	if (p + 4 <= end)
+	{
+		h ^= (uint64_t)hashRead32(p) * HASH_PRIME1;
+		h = hashRotl(h, 23) * HASH_PRIME2 + HASH_PRIME3;
+		p += 4;
+	}
+	while (p < end)
+	{
+		h ^= (*p) * HASH_PRIME5;
+		h = hashRotl(h, 11) * HASH_PRIME1;
+		p++;
+	}
+
+	// Final avalanche
+	h ^= h >> 33;
+	h *= HASH_PRIME2;
+	h ^= h >> 29;
+	h *= HASH_PRIME3;
+	h ^= h >> 32;
+
+	return h;
+}
+
 
 /* Misc::findJaguarTextureDimensions
  * Find the given name in a texture lump and returns a point2_t
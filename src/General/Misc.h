@@ -31,6 +31,7 @@ namespace Misc
 	string		lumpNameToFileName(string lump);
 	string		fileNameToLumpName(string file);
 	uint32_t	crc(const uint8_t* buf, uint32_t len);
+	uint64_t	hash64(const uint8_t* buf, uint32_t len);
 	hsl_t		rgbToHsl(double r, double g, double b);
 	rgba_t		hslToRgb(double h, double s, double t);
 	lab_t		rgbToLab(double r, double g, double b);
@@ -32,6 +32,7 @@
 #include "Main.h"
 #include "ResourceManager.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/Formats/WadArchive.h"
 #include "General/Console/Console.h"
 #include "Graphics/CTexture/CTexture.h"
 #include "Graphics/CTexture/TextureXList.h"
@@ -51,7 +52,10 @@ string ResourceManager::Doom64HashTable[65536];
 /* EntryResource::EntryResource
  * EntryResource class constructor
  *******************************************************************/
-EntryResource::EntryResource() : Resource("entry")
+EntryResource::EntryResource() :
+	Resource("entry"),
+	cached_priority{ nullptr },
+	cached{ false }
 {
 }
 
@@ -68,22 +72,35 @@ EntryResource::~EntryResource()
 void EntryResource::add(ArchiveEntry::SPtr& entry)
 {
 	if (entry->getParent())
+	{
 		entries.push_back(entry);
+		cached = false;
+	}
 }
 
 /* EntryResource::remove
- * Removes matching [entry] from the resource
+ * Removes matching [entry] from the resource. Returns true if the
+ * entry was part of the resource
  *******************************************************************/
-void EntryResource::remove(ArchiveEntry::SPtr& entry)
+bool EntryResource::remove(ArchiveEntry::SPtr& entry)
 {
+	bool removed = false;
 	unsigned a = 0;
 	while (a < entries.size())
 	{
 		if (entries[a].lock() == entry)
+		{
 			entries.erase(entries.begin() + a);
+			removed = true;
+		}
 		else
 			a++;
 	}
+
+	if (removed)
+		cached = false;
+
+	return removed;
 }
 
 /* EntryResource::length
@@ -107,7 +124,16 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, string nspace, bool ns_
 	if (entries.empty())
 		return nullptr;
 
-	auto best = entries[0].lock();
+	// Use cached result if possible (the cache is cleared whenever an entry
+	// is added or removed, and the relative order of archives never changes)
+	if (nspace.IsEmpty() && cached && cached_priority == priority)
+	{
+		auto entry = cached_entry.lock();
+		if (entry && entry->getParent())
+			return entry.get();
+	}
+
+	ArchiveEntry::SPtr best;
 	auto i = entries.begin();
 	while (i != entries.end())
 	{
@@ -121,6 +147,14 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, string nspace, bool ns_
 		auto entry = i->lock();
 		i++;
 
+		// Ignore entries that are no longer part of an archive
+		Archive* parent = entry->getParent();
+		if (!parent)
+			continue;
+
+		if (!best)
+			best = entry;
+
 		// Check namespace if required
 		if (ns_required && !nspace.IsEmpty())
 			if (!entry->isInNamespace(nspace))
@@ -128,7 +162,7 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, string nspace, bool ns_
 
 		// Check if in priority archive (or its parent)
 		if (priority &&
-			(entry->getParent() == priority || entry->getParent()->parentArchive() == priority))
+			(parent == priority || (parent->parentArchive() && parent->parentArchive() == priority)))
 		{
 			best = entry;
 			break;
@@ -146,13 +180,31 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, string nspace, bool ns_
 
 		// Otherwise, if it's in a 'later' archive than the current resource entry, set it
 		if (App::archiveManager().archiveIndex(best.get()->getParent()) <=
-			App::archiveManager().archiveIndex(entry.get()->getParent()))
+			App::archiveManager().archiveIndex(parent))
 			best = entry;
 	}
 
+	// Cache result
+	if (nspace.IsEmpty())
+	{
+		cached_entry = best;
+		cached_priority = priority;
+		cached = true;
+	}
+
 	return best.get();
 }
 
+/* EntryResource::getEntryRef
+ * Same as getEntry (with no namespace), but returns a weak pointer
+ * to the entry
+ *******************************************************************/
+std::weak_ptr<ArchiveEntry> EntryResource::getEntryRef(Archive* priority)
+{
+	getEntry(priority);
+	return cached_entry;
+}
+
 
 /*******************************************************************
  * TEXTURERESOURCE CLASS FUNCTIONS
@@ -186,19 +238,25 @@ void TextureResource::add(CTexture* tex, Archive* parent)
 
 /* TextureResource::remove
  * Removes any textures in this resource that are part of [parent]
- * archive
+ * archive. Returns true if any textures were removed
  *******************************************************************/
-void TextureResource::remove(Archive* parent)
+bool TextureResource::remove(Archive* parent)
 {
 	// Remove any textures with matching parent
+	bool removed = false;
 	auto i = textures.begin();
 	while (i != textures.end())
 	{
 		if (i->get()->parent == parent)
+		{
 			i = textures.erase(i);
+			removed = true;
+		}
 		else
 			i++;
 	}
+
+	return removed;
 }
 
 /* TextureResource::length
@@ -210,6 +268,200 @@ int TextureResource::length()
 }
 
 
+/*******************************************************************
+ * RESOURCENAMEINDEX CLASS FUNCTIONS
+ *******************************************************************/
+
+/* ResourceNameIndex::add
+ * Adds [name] to the index
+ *******************************************************************/
+void ResourceNameIndex::add(const string& name)
+{
+	if (names.insert(name).second)
+		names_updated = true;
+}
+
+/* ResourceNameIndex::remove
+ * Removes [name] from the index
+ *******************************************************************/
+void ResourceNameIndex::remove(const string& name)
+{
+	if (names.erase(name) > 0)
+		names_updated = true;
+}
+
+/* ResourceNameIndex::clear
+ * Removes all names (and cached entries) from the index
+ *******************************************************************/
+void ResourceNameIndex::clear()
+{
+	names.clear();
+	names_updated = true;
+	resolved.clear();
+	resolved_valid = false;
+	resolved_updated = true;
+}
+
+/* ResourceNameIndex::allNames
+ * Returns a (sorted) list of all names in the index. The list is
+ * only rebuilt if names were added or removed since the last call
+ *******************************************************************/
+const vector<string>& ResourceNameIndex::allNames()
+{
+	if (names_updated)
+	{
+		names_list.assign(names.begin(), names.end());
+		names_updated = false;
+	}
+
+	return names_list;
+}
+
+/* ResourceNameIndex::namesWithPrefix
+ * Adds all names beginning with [prefix] (uppercase) to [list], sorted
+ *******************************************************************/
+void ResourceNameIndex::namesWithPrefix(const string& prefix, vector<string>& list) const
+{
+	for (auto i = names.lower_bound(prefix); i != names.end() && i->StartsWith(prefix); ++i)
+		list.push_back(*i);
+}
+
+/* ResourceNameIndex::fuzzyMatch
+ * Adds all names fuzzy-matching [search] (uppercase) to [list], best
+ * matches first. If [max] is non-zero, only that many are added
+ *******************************************************************/
+void ResourceNameIndex::fuzzyMatch(const string& search, vector<string>& list, unsigned max) const
+{
+	// Score all names
+	vector<std::pair<int, const string*>> matches;
+	for (auto& name : names)
+	{
+		int score = fuzzyScore(search, name);
+		if (score >= 0)
+			matches.push_back({ score, &name });
+	}
+
+	// Sort by score (names are already sorted, so keep that order for equal scores)
+	std::stable_sort(matches.begin(), matches.end(), [](const std::pair<int, const string*>& left, const std::pair<int, const string*>& right)
+	{
+		return left.first > right.first;
+	});
+
+	// Add to list
+	if (max > 0 && matches.size() > max)
+		matches.resize(max);
+	for (auto& match : matches)
+		list.push_back(*match.second);
+}
+
+/* ResourceNameIndex::entryChanged
+ * Updates the cached most relevant entry of resource [name] in [map],
+ * after an entry was added to or removed from it
+ *******************************************************************/
+void ResourceNameIndex::entryChanged(EntryResourceMap& map, const string& name)
+{
+	// Nothing cached yet
+	if (!resolved_valid)
+		return;
+
+	auto res = map.find(name);
+	if (res != map.end() && res->second.length() > 0)
+		resolved[name] = res->second.getEntryRef(resolved_priority);
+	else
+		resolved.erase(name);
+
+	resolved_updated = true;
+}
+
+/* ResourceNameIndex::getEntries
+ * Adds the most relevant entry (see EntryResource::getEntry) of each
+ * resource in [map] to [list]. The entries are cached, so resources
+ * only need to be checked again if [priority] differs from the last
+ * call
+ *******************************************************************/
+void ResourceNameIndex::getEntries(EntryResourceMap& map, Archive* priority, vector<ArchiveEntry*>& list)
+{
+	// Resolve all resources if needed
+	if (!resolved_valid || priority != resolved_priority)
+	{
+		resolved.clear();
+		resolved_priority = priority;
+		resolved_valid = true;
+		resolved_updated = true;
+		for (auto& i : map)
+			if (i.second.length() > 0)
+				resolved[i.first] = i.second.getEntryRef(priority);
+	}
+
+	// Update list (in name order) if needed
+	if (resolved_updated)
+	{
+		resolved_list.clear();
+		resolved_list.reserve(resolved.size());
+		for (auto& i : resolved)
+			resolved_list.push_back({ &i.first, i.second });
+		resolved_updated = false;
+	}
+
+	list.reserve(list.size() + resolved_list.size());
+	for (auto& i : resolved_list)
+	{
+		auto entry = i.second.lock();
+
+		// Entries can be deleted without being removed from the resource
+		// (eg. when their directory is removed), so check again if needed
+		if (!entry || !entry->getParent())
+		{
+			auto res = map.find(*i.first);
+			if (res == map.end())
+				continue;
+			i.second = res->second.getEntryRef(priority);
+			resolved[*i.first] = i.second;
+			entry = i.second.lock();
+			if (!entry)
+				continue;
+		}
+
+		list.push_back(entry.get());
+	}
+}
+
+/* ResourceNameIndex::fuzzyScore
+ * Returns how well [name] matches [search] (both uppercase), or -1 if
+ * it doesn't match at all. All characters in [search] must appear in
+ * [name] in order; consecutive matches and matches at the start of
+ * [name] score higher, and shorter names are preferred
+ *******************************************************************/
+int ResourceNameIndex::fuzzyScore(const string& search, const string& name)
+{
+	if (search.IsEmpty())
+		return 0;
+
+	int score = 0;
+	size_t pos = 0;
+	size_t last_match = string::npos;
+	for (size_t c = 0; c < search.length(); c++)
+	{
+		// Find next occurrence of the character
+		wxUniChar ch = search[c];
+		pos = name.find(ch, pos);
+		if (pos == string::npos)
+			return -1;
+
+		score += 1;
+		if (pos == 0)
+			score += 10;
+		else if (last_match != string::npos && pos == last_match + 1)
+			score += 5;
+
+		last_match = pos++;
+	}
+
+	// Prefer shorter names (ie. closer to an exact match)
+	return MAX(score * 8 - (int)(name.length() - search.length()), 0);
+}
+
+
 /*******************************************************************
  * RESOURCEMANAGER CLASS FUNCTIONS
  *******************************************************************/
@@ -217,7 +469,7 @@ int TextureResource::length()
 /* ResourceManager::ResourceManager
  * ResourceManager class constructor
  *******************************************************************/
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager() : batch_updated(false)
 {
 }
 
@@ -269,6 +521,37 @@ void ResourceManager::removeArchive(Archive* archive)
 	announce("resources_updated");
 }
 
+/* ResourceManager::addEntryResource
+ * Adds [entry] to the resource [name] in [map], and adds [name] to
+ * [index] if it is the first entry for that resource
+ *******************************************************************/
+void ResourceManager::addEntryResource(EntryResourceMap& map, ResourceNameIndex& index, const string& name, ArchiveEntry::SPtr& entry)
+{
+	EntryResource& res = map[name];
+	res.add(entry);
+	if (res.length() == 1)
+		index.add(name);
+	index.entryChanged(map, name);
+}
+
+/* ResourceManager::removeEntryResource
+ * Removes [entry] from the resource [name] in [map], and removes
+ * [name] from [index] if the resource no longer has any entries
+ *******************************************************************/
+void ResourceManager::removeEntryResource(EntryResourceMap& map, ResourceNameIndex& index, const string& name, ArchiveEntry::SPtr& entry)
+{
+	auto i = map.find(name);
+	if (i == map.end())
+		return;
+
+	if (!i->second.remove(entry))
+		return;
+
+	if (i->second.length() == 0)
+		index.remove(name);
+	index.entryChanged(map, name);
+}
+
 /* ResourceManager::getTextureHash
  * Returns the Doom64 hash of a given texture name, computed using
  * the same hash algorithm as Doom64 EX itself
@@ -327,7 +610,7 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry)
 		// Check for patch entry
 		if (type->extraProps().propertyExists("patch") || entry->isInNamespace("patches"))
 		{
-			patches[name].add(entry);
+			addEntryResource(patches, patch_names, name, entry);
 			/*
 			if (name.Length() > 8) patches[name.Left(8)].add(entry);
 			if (!entry->getParent()->isTreeless())
@@ -338,19 +621,19 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry)
 		// Check for flat entry
 		if (type->id() == "gfx_flat" || entry->isInNamespace("flats"))
 		{
-			flats[name].add(entry);
+			addEntryResource(flats, flat_names, name, entry);
 			// if (name.Length() > 8) flats[name.Left(8)].add(entry);
 			if (!entry->getParent()->isTreeless())
-				flats[path].add(entry);
+				addEntryResource(flats, flat_names, path, entry);
 		}
 
 		// Check for stand-alone texture entry
 		if (entry->isInNamespace("textures") || entry->isInNamespace("hires"))
 		{
-			satextures[name].add(entry);
+			addEntryResource(satextures, satexture_names, name, entry);
 			// if (name.Length() > 8) satextures[name.Left(8)].add(entry);
 			if (!entry->getParent()->isTreeless())
-				satextures[path].add(entry);
+				addEntryResource(satextures, satexture_names, path, entry);
 
 			// Add name to hash table
 			ResourceManager::Doom64HashTable[getTextureHash(name)] = name;
@@ -388,7 +671,10 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry)
 		for (unsigned a = 0; a < tx.nTextures(); a++)
 		{
 			tex = tx.getTexture(a);
-			textures[tex->getName()].add(tex, entry->getParent());
+			TextureResource& res = textures[tex->getName()];
+			res.add(tex, entry->getParent());
+			if (res.length() == 1)
+				texture_names.add(tex->getName());
 		}
 	}
 }
@@ -406,18 +692,20 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry)
 	string path = entry->getPath(true).Upper().Mid(1);
 
 	// Remove from palettes
-	palettes[name].remove(entry);
+	auto pal = palettes.find(name);
+	if (pal != palettes.end())
+		pal->second.remove(entry);
 
 	// Remove from patches
-	patches[name].remove(entry);
+	removeEntryResource(patches, patch_names, name, entry);
 
 	// Remove from flats
-	flats[name].remove(entry);
-	flats[path].remove(entry);
+	removeEntryResource(flats, flat_names, name, entry);
+	removeEntryResource(flats, flat_names, path, entry);
 
 	// Remove from stand-alone textures
-	satextures[name].remove(entry);
-	satextures[path].remove(entry);
+	removeEntryResource(satextures, satexture_names, name, entry);
+	removeEntryResource(satextures, satexture_names, path, entry);
 
 	// Check for TEXTUREx entry
 	int txentry = 0;
@@ -437,7 +725,11 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry)
 
 		// Remove all texture resources
 		for (unsigned a = 0; a < tx.nTextures(); a++)
-			textures[tx.getTexture(a)->getName()].remove(entry->getParent());
+		{
+			auto res = textures.find(tx.getTexture(a)->getName());
+			if (res != textures.end() && res->second.remove(entry->getParent()) && res->second.length() == 0)
+				texture_names.remove(res->first);
+		}
 	}
 }
 
@@ -459,12 +751,7 @@ void ResourceManager::listAllPatches()
  *******************************************************************/
 void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* priority)
 {
-	for (auto& i : patches)
-	{
-		auto entry = i.second.getEntry(priority);
-		if (entry)
-			list.push_back(entry);
-	}
+	patch_names.getEntries(patches, priority, list);
 }
 
 /* ResourceManager::getAllTextures
@@ -510,10 +797,8 @@ void ResourceManager::getAllTextures(vector<TextureResource::Texture*>& list, Ar
  *******************************************************************/
 void ResourceManager::getAllTextureNames(vector<string>& list)
 {
-	// Add all primary textures to the list
-	for (auto& i : textures)
-		if (i.second.length() > 0)	// Ignore if no entries
-			list.push_back(i.first);
+	auto& names = texture_names.allNames();
+	list.insert(list.end(), names.begin(), names.end());
 }
 
 /* ResourceManager::getAllFlatEntries
@@ -521,12 +806,7 @@ void ResourceManager::getAllTextureNames(vector<string>& list)
  *******************************************************************/
 void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* priority)
 {
-	for (auto& i : flats)
-	{
-		auto entry = i.second.getEntry(priority);
-		if (entry)
-			list.push_back(entry);
-	}
+	flat_names.getEntries(flats, priority, list);
 }
 
 /* ResourceManager::getAllFlatNames
@@ -534,10 +814,8 @@ void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* pr
  *******************************************************************/
 void ResourceManager::getAllFlatNames(vector<string>& list)
 {
-	// Add all primary flats to the list
-	for (auto& i : flats)
-		if (i.second.length() > 0)	// Ignore if no entries
-			list.push_back(i.first);
+	auto& names = flat_names.allNames();
+	list.insert(list.end(), names.begin(), names.end());
 }
 
 /* ResourceManager::getPaletteEntry
@@ -546,7 +824,8 @@ void ResourceManager::getAllFlatNames(vector<string>& list)
  *******************************************************************/
 ArchiveEntry* ResourceManager::getPaletteEntry(string palette, Archive* priority)
 {
-	return palettes[palette.Upper()].getEntry(priority);
+	auto res = palettes.find(palette.Upper());
+	return res != palettes.end() ? res->second.getEntry(priority) : nullptr;
 }
 
 /* ResourceManager::getPatchEntry
@@ -563,7 +842,8 @@ ArchiveEntry* ResourceManager::getPatchEntry(string patch, string nspace, Archiv
 	if (!nspace.CmpNoCase("textures"))
 		return getTextureEntry(patch, "textures", priority);
 
-	return patches[patch.Upper()].getEntry(priority, nspace, true);
+	auto res = patches.find(patch.Upper());
+	return res != patches.end() ? res->second.getEntry(priority, nspace, true) : nullptr;
 }
 
 /* ResourceManager::getFlatEntry
@@ -573,12 +853,12 @@ ArchiveEntry* ResourceManager::getPatchEntry(string patch, string nspace, Archiv
 ArchiveEntry* ResourceManager::getFlatEntry(string flat, Archive* priority)
 {
 	// Check resource with matching name exists
-	EntryResource& res = flats[flat.Upper()];
-	if (res.entries.size() == 0)
+	auto res = flats.find(flat.Upper());
+	if (res == flats.end() || res->second.entries.size() == 0)
 		return nullptr;
 
 	// Return most relevant entry
-	return res.getEntry(priority);
+	return res->second.getEntry(priority);
 }
 
 /* ResourceManager::getTextureEntry
@@ -587,7 +867,8 @@ ArchiveEntry* ResourceManager::getFlatEntry(string flat, Archive* priority)
  *******************************************************************/
 ArchiveEntry* ResourceManager::getTextureEntry(string texture, string nspace, Archive* priority)
 {
-	return satextures[texture.Upper()].getEntry(priority, nspace, true);
+	auto res = satextures.find(texture.Upper());
+	return res != satextures.end() ? res->second.getEntry(priority, nspace, true) : nullptr;
 }
 
 /* ResourceManager::getTexture
@@ -597,9 +878,10 @@ ArchiveEntry* ResourceManager::getTextureEntry(string texture, string nspace, Ar
 CTexture* ResourceManager::getTexture(string texture, Archive* priority, Archive* ignore)
 {
 	// Check texture resource with matching name exists
-	TextureResource& res = textures[texture.Upper()];
-	if (res.textures.size() == 0)
+	auto found = textures.find(texture.Upper());
+	if (found == textures.end() || found->second.textures.size() == 0)
 		return nullptr;
+	TextureResource& res = found->second;
 
 	// Go through resource textures
 	CTexture* tex = &res.textures[0].get()->tex;
@@ -630,43 +912,89 @@ CTexture* ResourceManager::getTexture(string texture, Archive* priority, Archive
 		return nullptr;
 }
 
-/* ResourceManager::onAnnouncement
+/* ResourceManager::onAnnouncementEvent
  * Called when an announcement is recieved from any managed archive
  *******************************************************************/
-void ResourceManager::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void ResourceManager::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id entry_state_changed = Announcement::id("entry_state_changed");
+	static const Announcement::Id entry_removing = Announcement::id("entry_removing");
+	static const Announcement::Id entry_renaming = Announcement::id("entry_renaming");
+	static const Announcement::Id entry_added = Announcement::id("entry_added");
+	static const Announcement::Id entries_changed = Announcement::id("entries_changed");
+
+	// Only archives are listened to
+	Archive* archive = dynamic_cast<Archive*>(announcer);
+	if (!archive)
+		return;
+
 	event_data.seek(0, SEEK_SET);
 
+	// A batch update was committed - individual entry additions and
+	// modifications aren't announced during batch updates, the batch
+	// instead sends all the entries that were changed. This is also sent
+	// without any data just to refresh views (eg. after an undo), in which
+	// case the changes have already come through individually
+	if (event == entries_changed)
+	{
+		wxUIntPtr ptr;
+		while (event_data.read(&ptr, sizeof(wxUIntPtr)))
+		{
+			ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
+			if (!entry->getParentDir())
+				continue;
+			auto esp = entry->getParentDir()->sharedEntry(entry);
+			removeEntry(esp);
+			addEntry(esp);
+			batch_updated = true;
+		}
+
+		if (batch_updated)
+		{
+			batch_updated = false;
+			announce("resources_updated");
+		}
+
+		return;
+	}
+
+	// Don't announce each entry removed or renamed during a batch update,
+	// resources_updated will be announced when the batch is committed
+	bool batch = archive->isBatchUpdating();
+
 	// An entry is modified
-	if (event_name == "entry_state_changed")
+	if (event == entry_state_changed)
 	{
 		wxUIntPtr ptr;
 		event_data.read(&ptr, sizeof(wxUIntPtr), 4);
 		ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
-		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
+		auto esp = entry->getParentDir()->sharedEntry(entry);
 		removeEntry(esp);
 		addEntry(esp);
 		announce("resources_updated");
 	}
 
 	// An entry is removed or renamed
-	if (event_name == "entry_removing" || event_name == "entry_renaming")
+	if (event == entry_removing || event == entry_renaming)
 	{
 		wxUIntPtr ptr;
 		event_data.read(&ptr, sizeof(wxUIntPtr), sizeof(int));
 		ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
-		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
+		auto esp = entry->getParentDir()->sharedEntry(entry);
 		removeEntry(esp);
-		announce("resources_updated");
+		if (batch)
+			batch_updated = true;
+		else
+			announce("resources_updated");
 	}
 
 	// An entry is added
-	if (event_name == "entry_added")
+	if (event == entry_added)
 	{
 		wxUIntPtr ptr;
 		event_data.read(&ptr, sizeof(wxUIntPtr), 4);
 		ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
-		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
+		auto esp = entry->getParentDir()->sharedEntry(entry);
 		addEntry(esp);
 		announce("resources_updated");
 	}
@@ -681,6 +1009,93 @@ CONSOLE_COMMAND(list_res_patches, 0, false)
 	theResourceManager->listAllPatches();
 }
 
+// Checks that entries removed during an archive batch update are dropped from
+// the resource manager once the batch is committed, even if something (eg. an
+// undo step) still holds on to them
+CONSOLE_COMMAND(test_res_batch_remove, 0, false)
+{
+	WadArchive archive;
+	theResourceManager->addArchive(&archive);
+
+	// Add some palettes
+	vector<ArchiveEntry::SPtr> removed;
+	for (unsigned a = 0; a < 4; a++)
+	{
+		ArchiveEntry* entry = new ArchiveEntry(S_FMT("TESTPAL%d", a));
+		entry->setType(EntryType::fromId("palette"));
+		archive.addEntry(entry);
+		removed.push_back(archive.entryAtPathShared(entry->getPath(true)));
+	}
+	bool added = theResourceManager->getPaletteEntry("TESTPAL0") == removed[0].get();
+
+	// Remove them all in a single batch
+	{
+		Archive::BatchUpdate batch(&archive);
+		for (auto& entry : removed)
+			archive.removeEntry(entry.get());
+	}
+
+	// Check none of them are still resources
+	unsigned stale = 0;
+	for (unsigned a = 0; a < removed.size(); a++)
+		if (theResourceManager->getPaletteEntry(S_FMT("TESTPAL%d", a)))
+			stale++;
+
+	theResourceManager->removeArchive(&archive);
+
+	if (!added)
+		Log::console("FAILED: Added entry not found in resources");
+	else if (stale > 0)
+		Log::console(S_FMT("FAILED: %d removed entries still in resources", stale));
+	else
+		Log::console("Passed");
+}
+
+// Checks that entries added and renamed during an archive batch update are
+// picked up by the resource manager once the batch is committed
+CONSOLE_COMMAND(test_res_batch_update, 0, false)
+{
+	WadArchive archive;
+	theResourceManager->addArchive(&archive);
+
+	// Add some palettes in a single batch
+	vector<ArchiveEntry*> added;
+	{
+		Archive::BatchUpdate batch(&archive);
+		for (unsigned a = 0; a < 4; a++)
+		{
+			ArchiveEntry* entry = new ArchiveEntry(S_FMT("TESTPAL%d", a));
+			entry->setType(EntryType::fromId("palette"));
+			archive.addEntry(entry);
+			added.push_back(entry);
+		}
+	}
+
+	// Check they were all added
+	unsigned missing = 0;
+	for (unsigned a = 0; a < added.size(); a++)
+		if (theResourceManager->getPaletteEntry(S_FMT("TESTPAL%d", a)) != added[a])
+			missing++;
+
+	// Rename one in a batch
+	{
+		Archive::BatchUpdate batch(&archive);
+		archive.renameEntry(added[0], "TESTPALX");
+	}
+	bool renamed =
+		theResourceManager->getPaletteEntry("TESTPAL0") == nullptr &&
+		theResourceManager->getPaletteEntry("TESTPALX") == added[0];
+
+	theResourceManager->removeArchive(&archive);
+
+	if (missing > 0)
+		Log::console(S_FMT("FAILED: %d entries added in batch not found in resources", missing));
+	else if (!renamed)
+		Log::console("FAILED: Entry renamed in batch not updated in resources");
+	else
+		Log::console("Passed");
+}
+
 #include "App.h"
 CONSOLE_COMMAND(test_res_speed, 0, false)
 {
@@ -29,16 +29,22 @@ class EntryResource : public Resource
 private:
 	vector<std::weak_ptr<ArchiveEntry>>	entries;
 
+	// Cached result of getEntry (without namespace)
+	std::weak_ptr<ArchiveEntry>	cached_entry;
+	Archive*					cached_priority;
+	bool						cached;
+
 public:
 	EntryResource();
 	~EntryResource();
 
 	void	add(ArchiveEntry::SPtr& entry);
-	void	remove(ArchiveEntry::SPtr& entry);
+	bool	remove(ArchiveEntry::SPtr& entry);
 
 	int		length();
 
-	ArchiveEntry*	getEntry(Archive* priority = nullptr, string nspace = "", bool ns_required = false);
+	ArchiveEntry*					getEntry(Archive* priority = nullptr, string nspace = "", bool ns_required = false);
+	std::weak_ptr<ArchiveEntry>		getEntryRef(Archive* priority);
 };
 
 class TextureResource : public Resource
@@ -61,7 +67,7 @@ public:
 	~TextureResource();
 
 	void	add(CTexture* tex, Archive* parent);
-	void	remove(Archive* parent);
+	bool	remove(Archive* parent);
 
 	int		length();
 
@@ -72,6 +78,43 @@ private:
 typedef std::map<string, EntryResource> EntryResourceMap;
 typedef std::map<string, TextureResource> TextureResourceMap;
 
+// Sorted set of resource names, used for fast name listing and prefix/fuzzy
+// searches without having to go through every resource. For entry resources
+// it also keeps the most relevant entry of each resource (for one priority
+// archive at a time), updated as entries are added/removed
+class ResourceNameIndex
+{
+public:
+	ResourceNameIndex() : names_updated(false), resolved_priority(nullptr), resolved_valid(false), resolved_updated(false) {}
+	~ResourceNameIndex() {}
+
+	void	add(const string& name);
+	void	remove(const string& name);
+	bool	contains(const string& name) const { return names.count(name) > 0; }
+	void	clear();
+
+	const vector<string>&	allNames();
+	void					namesWithPrefix(const string& prefix, vector<string>& list) const;
+	void					fuzzyMatch(const string& search, vector<string>& list, unsigned max = 0) const;
+
+	void	entryChanged(EntryResourceMap& map, const string& name);
+	void	getEntries(EntryResourceMap& map, Archive* priority, vector<ArchiveEntry*>& list);
+
+	static int	fuzzyScore(const string& search, const string& name);
+
+private:
+	std::set<string>	names;
+	vector<string>		names_list;
+	bool				names_updated;
+
+	// Most relevant entry of each resource for [resolved_priority]
+	std::map<string, std::weak_ptr<ArchiveEntry>>				resolved;
+	vector<std::pair<const string*, std::weak_ptr<ArchiveEntry>>>	resolved_list;
+	Archive*													resolved_priority;
+	bool														resolved_valid;
+	bool														resolved_updated;
+};
+
 class ResourceManager : public Listener, public Announcer
 {
 private:
@@ -82,6 +125,19 @@ private:
 	EntryResourceMap	satextures;	// Stand Alone textures (e.g., between TX_ or T_ markers)
 	TextureResourceMap	textures;	// Composite textures (defined in a TEXTUREx/TEXTURES lump)
 
+	// Name indices (of resources with at least one entry/texture)
+	ResourceNameIndex	patch_names;
+	ResourceNameIndex	flat_names;
+	ResourceNameIndex	satexture_names;
+	ResourceNameIndex	texture_names;
+
+	void	addEntryResource(EntryResourceMap& map, ResourceNameIndex& index, const string& name, ArchiveEntry::SPtr& entry);
+	void	removeEntryResource(EntryResourceMap& map, ResourceNameIndex& index, const string& name, ArchiveEntry::SPtr& entry);
+
+	// Entries were removed/renamed during a batch update of an archive,
+	// resources_updated needs announcing when the batch is committed
+	bool	batch_updated;
+
 	static ResourceManager*	instance;
 	static string Doom64HashTable[65536];
 
@@ -112,6 +168,10 @@ public:
 	void	getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* priority);
 	void	getAllFlatNames(vector<string>& list);
 
+	ResourceNameIndex&	flatNames() { return flat_names; }
+	ResourceNameIndex&	saTextureNames() { return satexture_names; }
+	ResourceNameIndex&	textureNames() { return texture_names; }
+
 	ArchiveEntry*	getPaletteEntry(string palette, Archive* priority = nullptr);
 	ArchiveEntry*	getPatchEntry(string patch, string nspace = "patches", Archive* priority = nullptr);
 	ArchiveEntry*	getFlatEntry(string flat, Archive* priority = nullptr);
@@ -120,7 +180,7 @@ public:
 	string			getTextureName(uint16_t hash) { return Doom64HashTable[hash]; }
 	uint16_t		getTextureHash(string name);
 
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 };
 
 // Define for less cumbersome ResourceManager::getInstance()
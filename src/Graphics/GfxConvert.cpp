@@ -0,0 +1,273 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    GfxConvert.cpp
+// Description: GfxConvert namespace, a pipeline for decoding, converting and
+//              encoding many images at once across multiple threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "GfxConvert.h"
+#include "Archive/ArchiveEntry.h"
+#include "General/Misc.h"
+#include "Graphics/Palette/PaletteLookup.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// GfxConvert Namespace Functions
+//
+// ----------------------------------------------------------------------------
+namespace GfxConvert
+{
+	// ------------------------------------------------------------------------
+	// needsPaletteLookup
+	//
+	// Returns true if converting [job] will (most likely) involve nearest
+	// colour matching to its target palette
+	// ------------------------------------------------------------------------
+	bool needsPaletteLookup(Job& job)
+	{
+		if (!job.convert || !job.opt.pal_target || !job.format)
+			return false;
+
+		return job.col_format == PALMASK ||
+			job.opt.col_format == PALMASK ||
+			!job.format->canWriteType(RGBA);
+	}
+
+	// ------------------------------------------------------------------------
+	// decode
+	//
+	// Decodes the source image for [job] if needed. If it will be converted to
+	// a palette, the (unique) colours used in the image are added to
+	// [colours]. Runs on a worker thread
+	// ------------------------------------------------------------------------
+	void decode(Job& job, vector<uint32_t>& colours)
+	{
+		if (!job.format || !job.error.IsEmpty())
+			return;
+
+		if (job.data)
+		{
+			// Try SIFormat system, then FreeImage (as Misc::loadImageFromEntry)
+			MemChunk& data = const_cast<MemChunk&>(*job.data);
+			Global::error = "";
+			if (!job.image.open(data, 0, job.format_hint) &&
+				!(SIFormat::generalFormat()->isThisFormat(data) && SIFormat::generalFormat()->loadImage(job.image, data)))
+			{
+				job.error = Global::error.IsEmpty() ? "Not a known image format" : Global::error;
+				return;
+			}
+		}
+		if (!job.image.isValid())
+		{
+			job.error = "Invalid image";
+			return;
+		}
+
+		if (!needsPaletteLookup(job))
+			return;
+
+		// Get colours used
+		MemChunk rgba;
+		job.image.getRGBAData(rgba, job.opt.pal_current);
+		const uint8_t* pixel = rgba.getData();
+		unsigned n_pixels = rgba.getSize() / 4;
+		colours.reserve(n_pixels);
+		for (unsigned a = 0; a < n_pixels; a++, pixel += 4)
+			colours.push_back((pixel[0] << 16) | (pixel[1] << 8) | pixel[2]);
+		std::sort(colours.begin(), colours.end());
+		colours.erase(std::unique(colours.begin(), colours.end()), colours.end());
+	}
+
+	// ------------------------------------------------------------------------
+	// convertAndEncode
+	//
+	// Converts and/or encodes the (decoded) image for [job]. Runs on a worker
+	// thread
+	// ------------------------------------------------------------------------
+	void convertAndEncode(Job& job)
+	{
+		if (!job.format || !job.error.IsEmpty())
+			return;
+
+		// Convert
+		if (job.convert)
+		{
+			int writable = job.format->canWrite(job.image);
+			if (writable == SIFormat::NOTWRITABLE)
+			{
+				job.error = S_FMT("Image could not be converted to target format \"%s\"", job.format->getName());
+				return;
+			}
+			else if (writable == SIFormat::CONVERTIBLE || job.force_writable)
+				job.format->convertWritable(job.image, job.opt);
+
+			// Apply the target colour format (if any)
+			if (job.col_format == PALMASK)
+				job.image.convertPaletted(job.opt.pal_target, job.opt.pal_current, job.opt.pal_lookup);
+			else if (job.col_format == RGBA)
+				job.image.convertRGBA(job.opt.pal_current);
+		}
+
+		// Encode
+		if (job.encode)
+		{
+			Palette* pal = job.pal_save ? job.pal_save : job.opt.pal_target;
+			Global::error = "";
+			if (!job.format->saveImage(job.image, job.output, pal))
+			{
+				job.error = Global::error.IsEmpty() ?
+					S_FMT("Unable to write image as \"%s\"", job.format->getName()) :
+					Global::error;
+				return;
+			}
+		}
+
+		job.ok = true;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// GfxConvert::setupEntryJob
+//
+// Sets up [job] to decode the image in [entry]. Images in formats not handled
+// by the SIFormat system are loaded here (on the calling thread) rather than
+// by the job. The entry data must stay loaded until the job is run. Returns
+// false if [entry] is not a valid image
+// ----------------------------------------------------------------------------
+bool GfxConvert::setupEntryJob(Job& job, ArchiveEntry* entry)
+{
+	// Detect entry type if it isn't already
+	if (entry->getType() == EntryType::unknownType())
+		EntryType::detectEntryType(entry);
+
+	// Check for format "image" property
+	if (!entry->getType()->extraProps().propertyExists("image"))
+		return false;
+
+	// Fonts, Jaguar and raw gfx need manual loading (see Misc::loadImageFromEntry)
+	string format = entry->getType()->formatId();
+	if (format.StartsWith("font_") || format.StartsWith("img_jaguar_") || format == "img_raw")
+		return Misc::loadImageFromEntry(&job.image, entry);
+
+	// Everything else can be decoded by the job
+	job.data = &entry->getMCData();
+	job.format_hint = "";
+	if (entry->getType()->extraProps().propertyExists("image_format"))
+		job.format_hint = entry->getType()->extraProps()["image_format"].getStringValue();
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// GfxConvert::run
+//
+// Processes all [jobs] in three stages:
+// - All source images are decoded in parallel, gathering the colours that
+//   need matching to a target palette
+// - A single read-only PaletteLookup is built for each target palette, which
+//   is then shared by all jobs converting to it
+// - All images are converted and encoded in parallel
+//
+// Jobs with no format or an error already set are skipped. [progress] is
+// called periodically from the calling thread, and can cancel the operation
+// by returning false. Returns false if cancelled (in which case no job will
+// be marked ok)
+// ----------------------------------------------------------------------------
+bool GfxConvert::run(vector<Job>& jobs, Parallel::ProgressFunc progress)
+{
+	unsigned n_jobs = jobs.size();
+	if (n_jobs == 0)
+		return true;
+
+	// Images are only used on worker threads, don't send events back to the
+	// main thread for them
+	for (auto& job : jobs)
+	{
+		job.image.setMuted(true);
+		job.ok = false;
+		job.opt.pal_lookup = nullptr;
+	}
+
+	// Decode (first half of progress)
+	vector<vector<uint32_t>> colours(n_jobs);
+	bool completed = Parallel::forEach(n_jobs, [&](unsigned index)
+	{
+		decode(jobs[index], colours[index]);
+	},
+	[&](unsigned done, unsigned total)
+	{
+		return progress ? progress(done, total * 2) : true;
+	});
+	if (!completed)
+		return false;
+
+	// Build shared palette lookups
+	std::map<Palette*, std::unique_ptr<PaletteLookup>> lookups;
+	std::map<Palette*, vector<uint32_t>> lookup_colours;
+	for (unsigned a = 0; a < n_jobs; a++)
+	{
+		if (colours[a].empty())
+			continue;
+
+		auto& pal_colours = lookup_colours[jobs[a].opt.pal_target];
+		pal_colours.insert(pal_colours.end(), colours[a].begin(), colours[a].end());
+		vector<uint32_t>().swap(colours[a]);
+	}
+	for (auto& i : lookup_colours)
+	{
+		lookups[i.first] = std::make_unique<PaletteLookup>(*i.first);
+		lookups[i.first]->addColours(i.second);
+	}
+	for (auto& job : jobs)
+	{
+		auto i = lookups.find(job.opt.pal_target);
+		if (i != lookups.end())
+			job.opt.pal_lookup = i->second.get();
+	}
+
+	// Convert + encode (second half of progress)
+	completed = Parallel::forEach(n_jobs, [&](unsigned index)
+	{
+		convertAndEncode(jobs[index]);
+	},
+	[&](unsigned done, unsigned total)
+	{
+		return progress ? progress(total + done, total * 2) : true;
+	});
+
+	// Lookups are about to go away
+	for (auto& job : jobs)
+	{
+		job.opt.pal_lookup = nullptr;
+		if (!completed)
+			job.ok = false;
+	}
+
+	return completed;
+}
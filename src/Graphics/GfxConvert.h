@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Graphics/SImage/SImage.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Utility/Parallel.h"
+
+class ArchiveEntry;
+
+namespace GfxConvert
+{
+	// A single image to convert. Jobs are set up on the main thread and
+	// processed by GfxConvert::run on worker threads
+	struct Job
+	{
+		// Source: either encoded [data] (decoded to [image] when run), or
+		// [image] already loaded by the caller if [data] is null
+		const MemChunk*	data = nullptr;
+		string			format_hint;
+
+		// Target format and conversion options
+		SIFormat*					format = nullptr;
+		SIFormat::convert_options_t	opt;
+		int							col_format = -1;	// Colour format to convert to after making writable
+		bool						convert = true;		// Convert the image to be writable as [format]
+		bool						force_writable = false;	// Call convertWritable even if already writable
+		bool						encode = true;		// Write the image as [format] to [output]
+		Palette*					pal_save = nullptr;	// Palette to write with (opt.pal_target if null)
+
+		// Results
+		SImage		image;
+		MemChunk	output;
+		bool		ok = false;
+		string		error;
+	};
+
+	bool	setupEntryJob(Job& job, ArchiveEntry* entry);
+	bool	run(vector<Job>& jobs, Parallel::ProgressFunc progress = nullptr);
+}
@@ -0,0 +1,505 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    PNGOptimizer.cpp
+// Description: PNGOptimizer namespace, functions for losslessly reducing the
+//              size of PNG data by searching for the best combination of
+//              scanline filters and deflate parameters
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "PNGOptimizer.h"
+#include "External/zlib/zlib.h"
+#include "Utility/Parallel.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+CVAR(Int, png_opt_threads, 0, CVAR_SAVE)	// 0 = use max_worker_threads
+
+namespace PNGOptimizer
+{
+	const uint8_t png_signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	// Deflate strategies to try for each filtered image
+	const int deflate_strategies[] = { Z_DEFAULT_STRATEGY, Z_FILTERED, Z_RLE };
+
+	// Adam7 interlacing passes
+	const unsigned adam7_x_start[] = { 0, 4, 0, 2, 0, 1, 0 };
+	const unsigned adam7_y_start[] = { 0, 0, 4, 0, 2, 0, 1 };
+	const unsigned adam7_x_step[] = { 8, 8, 4, 4, 2, 2, 1 };
+	const unsigned adam7_y_step[] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	// Filter type used to select the best filter for each row
+	const unsigned FILTER_ADAPTIVE = 5;
+
+	struct Chunk
+	{
+		char			type[4];
+		const uint8_t*	start;	// Start of the chunk (length field)
+		uint32_t		length;	// Length of the chunk data
+	};
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// PNGOptimizer Namespace Functions
+//
+// ----------------------------------------------------------------------------
+namespace PNGOptimizer
+{
+	// ------------------------------------------------------------------------
+	// readBE32
+	//
+	// Reads a big-endian 32bit value from [p]
+	// ------------------------------------------------------------------------
+	uint32_t readBE32(const uint8_t* p)
+	{
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+	}
+
+	// ------------------------------------------------------------------------
+	// writeBE32
+	//
+	// Appends [value] to [out] as a big-endian 32bit value
+	// ------------------------------------------------------------------------
+	void writeBE32(vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(value >> 24);
+		out.push_back((value >> 16) & 0xFF);
+		out.push_back((value >> 8) & 0xFF);
+		out.push_back(value & 0xFF);
+	}
+
+	// ------------------------------------------------------------------------
+	// isChunk
+	//
+	// Returns true if [chunk] is of [type]
+	// ------------------------------------------------------------------------
+	bool isChunk(const Chunk& chunk, const char* type)
+	{
+		return memcmp(chunk.type, type, 4) == 0;
+	}
+
+	// ------------------------------------------------------------------------
+	// writeChunk
+	//
+	// Appends a chunk of [type] containing [data] to [out]
+	// ------------------------------------------------------------------------
+	void writeChunk(vector<uint8_t>& out, const char* type, const vector<uint8_t>& data)
+	{
+		writeBE32(out, data.size());
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		uLong crc = crc32(0, (const Bytef*)type, 4);
+		crc = crc32(crc, data.data(), data.size());
+		writeBE32(out, crc);
+	}
+
+	// ------------------------------------------------------------------------
+	// numChannels
+	//
+	// Returns the number of channels for PNG [colour_type], or 0 if invalid
+	// ------------------------------------------------------------------------
+	unsigned numChannels(uint8_t colour_type)
+	{
+		switch (colour_type)
+		{
+		case 0: return 1;	// Greyscale
+		case 2: return 3;	// RGB
+		case 3: return 1;	// Paletted
+		case 4: return 2;	// Greyscale + Alpha
+		case 6: return 4;	// RGBA
+		default: return 0;
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// paeth
+	//
+	// The PNG paeth predictor function
+	// ------------------------------------------------------------------------
+	uint8_t paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+
+		if (pa <= pb && pa <= pc)
+			return a;
+		if (pb <= pc)
+			return b;
+		return c;
+	}
+
+	// ------------------------------------------------------------------------
+	// predict
+	//
+	// Returns the value predicted by filter [type] for byte [i] in [row], with
+	// [prev] being the previous (unfiltered) row
+	// ------------------------------------------------------------------------
+	uint8_t predict(unsigned type, const uint8_t* row, const uint8_t* prev, size_t i, unsigned bpp)
+	{
+		uint8_t a = i >= bpp ? row[i - bpp] : 0;
+		uint8_t b = prev[i];
+		uint8_t c = i >= bpp ? prev[i - bpp] : 0;
+
+		switch (type)
+		{
+		case 1: return a;
+		case 2: return b;
+		case 3: return (a + b) >> 1;
+		case 4: return paeth(a, b, c);
+		default: return 0;
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// unfilter
+	//
+	// Reverses the scanline filtering of [filtered] ([rows] rows of
+	// [row_bytes] bytes, each preceded by its filter type) into [pixels].
+	// Returns false if an invalid filter type was found
+	// ------------------------------------------------------------------------
+	bool unfilter(const vector<uint8_t>& filtered, size_t rows, size_t row_bytes, unsigned bpp, vector<uint8_t>& pixels)
+	{
+		vector<uint8_t> zero(row_bytes, 0);
+		pixels.resize(rows * row_bytes);
+
+		for (size_t y = 0; y < rows; y++)
+		{
+			const uint8_t* src = &filtered[y * (row_bytes + 1)];
+			uint8_t type = *src++;
+			if (type > 4)
+				return false;
+
+			uint8_t* row = &pixels[y * row_bytes];
+			const uint8_t* prev = y > 0 ? row - row_bytes : zero.data();
+			for (size_t i = 0; i < row_bytes; i++)
+				row[i] = src[i] + predict(type, row, prev, i, bpp);
+		}
+
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// filter
+	//
+	// Applies scanline filter [type] to [pixels] ([rows] rows of [row_bytes]
+	// bytes), writing the result to [filtered]. If [type] is FILTER_ADAPTIVE,
+	// the filter giving the lowest sum of absolute differences is used for
+	// each row
+	// ------------------------------------------------------------------------
+	void filter(const vector<uint8_t>& pixels, size_t rows, size_t row_bytes, unsigned bpp, unsigned type, vector<uint8_t>& filtered)
+	{
+		vector<uint8_t> zero(row_bytes, 0);
+		vector<uint8_t> trial(row_bytes);
+		filtered.resize(rows * (row_bytes + 1));
+
+		for (size_t y = 0; y < rows; y++)
+		{
+			const uint8_t* row = &pixels[y * row_bytes];
+			const uint8_t* prev = y > 0 ? row - row_bytes : zero.data();
+			uint8_t* dst = &filtered[y * (row_bytes + 1)];
+
+			// Single filter type
+			if (type < FILTER_ADAPTIVE)
+			{
+				dst[0] = type;
+				for (size_t i = 0; i < row_bytes; i++)
+					dst[i + 1] = row[i] - predict(type, row, prev, i, bpp);
+
+				continue;
+			}
+
+			// Adaptive, try each filter type and use the one with the lowest
+			// sum of absolute differences
+			uint64_t best_sum = UINT64_MAX;
+			for (unsigned t = 0; t < FILTER_ADAPTIVE; t++)
+			{
+				uint64_t sum = 0;
+				for (size_t i = 0; i < row_bytes; i++)
+				{
+					uint8_t v = row[i] - predict(t, row, prev, i, bpp);
+					trial[i] = v;
+					sum += v < 128 ? v : 256 - v;
+				}
+
+				if (sum < best_sum)
+				{
+					best_sum = sum;
+					dst[0] = t;
+					memcpy(dst + 1, trial.data(), row_bytes);
+				}
+			}
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// inflateData
+	//
+	// Inflates zlib stream [in] to [out], which must be exactly [size] bytes
+	// when inflated
+	// ------------------------------------------------------------------------
+	bool inflateData(const vector<uint8_t>& in, size_t size, vector<uint8_t>& out)
+	{
+		z_stream strm;
+		memset(&strm, 0, sizeof(z_stream));
+		if (inflateInit(&strm) != Z_OK)
+			return false;
+
+		out.resize(size);
+		strm.next_in = (Bytef*)in.data();
+		strm.avail_in = in.size();
+		strm.next_out = out.data();
+		strm.avail_out = size;
+		int ret = inflate(&strm, Z_FINISH);
+		bool ok = (ret == Z_STREAM_END && strm.total_out == size);
+		inflateEnd(&strm);
+
+		return ok;
+	}
+
+	// ------------------------------------------------------------------------
+	// deflateData
+	//
+	// Deflates [in] to a zlib stream in [out] at maximum compression using
+	// [strategy]
+	// ------------------------------------------------------------------------
+	bool deflateData(const vector<uint8_t>& in, int strategy, vector<uint8_t>& out)
+	{
+		z_stream strm;
+		memset(&strm, 0, sizeof(z_stream));
+		if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS, MAX_MEM_LEVEL, strategy) != Z_OK)
+			return false;
+
+		out.resize(deflateBound(&strm, in.size()));
+		strm.next_in = (Bytef*)in.data();
+		strm.avail_in = in.size();
+		strm.next_out = out.data();
+		strm.avail_out = out.size();
+		int ret = deflate(&strm, Z_FINISH);
+		out.resize(strm.total_out);
+		deflateEnd(&strm);
+
+		return ret == Z_STREAM_END;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// PNGOptimizer::optimize
+//
+// Losslessly recompresses the PNG data in [in], trying each scanline filter
+// type and a number of deflate strategies, and writes the smallest result to
+// [out]. All chunks other than IDAT (including SLADE's grAb and alPh chunks)
+// are kept as they are. Returns false if [in] isn't a valid PNG or couldn't
+// be made any smaller.
+// Can be called from any thread
+// ----------------------------------------------------------------------------
+bool PNGOptimizer::optimize(const MemChunk& in, MemChunk& out)
+{
+	const uint8_t* data = in.getData();
+	uint32_t size = in.getSize();
+
+	// Check PNG signature
+	if (!data || size < 8 || memcmp(data, png_signature, 8) != 0)
+		return false;
+
+	// Read chunks (all IDAT chunks are combined into one)
+	vector<Chunk> chunks;
+	vector<uint8_t> idat;
+	bool idat_found = false;
+	bool iend_found = false;
+	uint32_t pos = 8;
+	while (pos + 12 <= size)
+	{
+		Chunk chunk;
+		chunk.start = data + pos;
+		chunk.length = readBE32(data + pos);
+		memcpy(chunk.type, data + pos + 4, 4);
+		if (chunk.length > size - pos - 12)
+			return false;
+
+		if (isChunk(chunk, "IDAT"))
+		{
+			idat.insert(idat.end(), data + pos + 8, data + pos + 8 + chunk.length);
+			if (!idat_found)
+				chunks.push_back(chunk);
+			idat_found = true;
+		}
+		else
+			chunks.push_back(chunk);
+
+		pos += chunk.length + 12;
+
+		if (isChunk(chunk, "IEND"))
+		{
+			iend_found = true;
+			break;
+		}
+	}
+	if (!idat_found || !iend_found || !isChunk(chunks[0], "IHDR") || chunks[0].length < 13)
+		return false;
+
+	// Read header
+	const uint8_t* ihdr = chunks[0].start + 8;
+	uint32_t width = readBE32(ihdr);
+	uint32_t height = readBE32(ihdr + 4);
+	uint8_t bit_depth = ihdr[8];
+	uint8_t colour_type = ihdr[9];
+	bool interlaced = (ihdr[12] != 0);
+	unsigned channels = numChannels(colour_type);
+	if (width == 0 || height == 0 || channels == 0 || ihdr[10] != 0 || ihdr[11] != 0)
+		return false;
+	if (bit_depth != 1 && bit_depth != 2 && bit_depth != 4 && bit_depth != 8 && bit_depth != 16)
+		return false;
+
+	// Determine filtered image data size
+	uint64_t bits_per_pixel = channels * bit_depth;
+	unsigned bpp = MAX(1, bits_per_pixel / 8);
+	uint64_t row_bytes = (width * bits_per_pixel + 7) / 8;
+	uint64_t raw_size = 0;
+	if (!interlaced)
+		raw_size = height * (row_bytes + 1);
+	else
+	{
+		for (unsigned p = 0; p < 7; p++)
+		{
+			if (width <= adam7_x_start[p] || height <= adam7_y_start[p])
+				continue;
+
+			uint64_t pass_width = (width - adam7_x_start[p] + adam7_x_step[p] - 1) / adam7_x_step[p];
+			uint64_t pass_height = (height - adam7_y_start[p] + adam7_y_step[p] - 1) / adam7_y_step[p];
+			raw_size += pass_height * ((pass_width * bits_per_pixel + 7) / 8 + 1);
+		}
+	}
+	if (raw_size > 0x20000000)	// Don't bother with anything over 512mb
+		return false;
+
+	// Inflate image data
+	vector<uint8_t> raw;
+	if (!inflateData(idat, raw_size, raw))
+		return false;
+
+	// Compress each candidate filtered image with each strategy, keeping the
+	// smallest result
+	vector<uint8_t> best;
+	vector<uint8_t> trial;
+	bool best_found = false;
+	auto tryCandidate = [&](const vector<uint8_t>& filtered)
+	{
+		for (int strategy : deflate_strategies)
+		{
+			if (deflateData(filtered, strategy, trial) && (!best_found || trial.size() < best.size()))
+			{
+				best.swap(trial);
+				best_found = true;
+			}
+		}
+	};
+
+	// Existing filters
+	tryCandidate(raw);
+
+	// Other filters (interlaced images are only recompressed)
+	if (!interlaced)
+	{
+		vector<uint8_t> pixels;
+		vector<uint8_t> filtered;
+		if (unfilter(raw, height, row_bytes, bpp, pixels))
+		{
+			for (unsigned type = 0; type <= FILTER_ADAPTIVE; type++)
+			{
+				filter(pixels, height, row_bytes, bpp, type, filtered);
+				tryCandidate(filtered);
+			}
+		}
+	}
+
+	if (!best_found)
+		return false;
+
+	// Build optimized PNG
+	vector<uint8_t> png(png_signature, png_signature + 8);
+	for (auto& chunk : chunks)
+	{
+		if (isChunk(chunk, "IDAT"))
+			writeChunk(png, "IDAT", best);
+		else
+			png.insert(png.end(), chunk.start, chunk.start + chunk.length + 12);
+	}
+
+	// Check it's actually smaller
+	if (png.size() >= size)
+		return false;
+
+	out.importMem(png.data(), png.size());
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// PNGOptimizer::optimizeAll
+//
+// Optimizes each PNG in [in] to the corresponding MemChunk in [out], using
+// multiple threads. [optimized] is set to 1 for each PNG that was optimized
+// (0 if it wasn't a valid PNG or couldn't be made smaller). [progress] is
+// called periodically from the calling thread and can cancel the operation
+// by returning false. Returns false if cancelled
+// ----------------------------------------------------------------------------
+bool PNGOptimizer::optimizeAll(
+	const vector<const MemChunk*>& in,
+	const vector<MemChunk*>& out,
+	vector<uint8_t>& optimized,
+	ProgressFunc progress)
+{
+	unsigned total = in.size();
+	optimized.assign(total, 0);
+	if (total == 0 || out.size() < total)
+		return true;
+
+	return Parallel::forEach(
+		total,
+		[&](unsigned index) { optimized[index] = optimize(*in[index], *out[index]) ? 1 : 0; },
+		progress,
+		png_opt_threads
+	);
+}
+
+// ----------------------------------------------------------------------------
+// PNGOptimizer::numThreads
+//
+// Returns the number of threads to use when optimizing multiple PNGs
+// ----------------------------------------------------------------------------
+unsigned PNGOptimizer::numThreads()
+{
+	return Parallel::numThreads(png_opt_threads);
+}
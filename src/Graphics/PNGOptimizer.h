@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Utility/Parallel.h"
+
+namespace PNGOptimizer
+{
+	typedef Parallel::ProgressFunc ProgressFunc;
+
+	bool		optimize(const MemChunk& in, MemChunk& out);
+	bool		optimizeAll(
+					const vector<const MemChunk*>& in,
+					const vector<MemChunk*>& out,
+					vector<uint8_t>& optimized,
+					ProgressFunc progress = nullptr
+				);
+	unsigned	numThreads();
+}
@@ -557,7 +557,7 @@ short Palette::findColour(rgba_t colour)
 // palette colour at [index], using the colour matching method specified in
 // [match]
 // ----------------------------------------------------------------------------
-double Palette::colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, ColourMatch match)
+double Palette::colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, ColourMatch match) const
 {
 	double d1, d2, d3;
 	switch(match)
@@ -602,7 +602,7 @@ double Palette::colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, Colou
 //
 // Returns the index of the closest colour in the palette to [colour]
 // ----------------------------------------------------------------------------
-short Palette::nearestColour(rgba_t colour, ColourMatch match)
+short Palette::nearestColour(rgba_t colour, ColourMatch match) const
 {
 	double min_d = 999999;
 	short index = 0;
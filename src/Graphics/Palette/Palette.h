@@ -28,7 +28,7 @@ public:
 	Palette(unsigned size = 256);
 	~Palette();
 
-	rgba_t	colour(uint8_t index) { return colours_[index]; }
+	rgba_t	colour(uint8_t index) const { return colours_[index]; }
 	short	transIndex() { return index_trans_; }
 
 	bool	loadMem(MemChunk& mc);
@@ -47,7 +47,7 @@ public:
 	
 	void	copyPalette(Palette* copy);
 	short	findColour(rgba_t colour);
-	short	nearestColour(rgba_t colour, ColourMatch match = ColourMatch::Default);
+	short	nearestColour(rgba_t colour, ColourMatch match = ColourMatch::Default) const;
 	size_t	countColours();
 	void	applyTranslation(Translation* trans);
 
@@ -71,5 +71,5 @@ private:
 	vector<lab_t>	colours_lab_;
 	short			index_trans_;
 
-	double	colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, ColourMatch match);
+	double	colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, ColourMatch match) const;
 };
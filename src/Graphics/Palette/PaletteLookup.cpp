@@ -0,0 +1,124 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         https://slade.mancubus.net
+// Filename:    PaletteLookup.cpp
+// Description: PaletteLookup class, a precomputed colour -> nearest palette
+//              index table for fast (and thread-safe) palette conversion
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "PaletteLookup.h"
+#include "Utility/Parallel.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// PaletteLookup Class Functions
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// PaletteLookup::PaletteLookup
+//
+// PaletteLookup class constructor. Takes a copy of [palette], so the lookup
+// stays valid if the original palette is changed or deleted
+// ----------------------------------------------------------------------------
+PaletteLookup::PaletteLookup(const Palette& palette, Palette::ColourMatch match) :
+	palette_(palette),
+	match_(match)
+{
+}
+
+// ----------------------------------------------------------------------------
+// PaletteLookup::matches
+//
+// Returns true if [palette] has the same colours as the lookup palette
+// ----------------------------------------------------------------------------
+bool PaletteLookup::matches(const Palette* palette) const
+{
+	if (!palette)
+		return false;
+
+	for (unsigned a = 0; a < 256; a++)
+	{
+		rgba_t c1 = palette->colour(a);
+		rgba_t c2 = palette_.colour(a);
+		if (c1.r != c2.r || c1.g != c2.g || c1.b != c2.b)
+			return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// PaletteLookup::addColours
+//
+// Adds [colours] (as lookup keys, see key()) to the table, finding the
+// nearest palette index for each of them across [n_threads] threads. This
+// must not be called while the lookup is being used by other threads.
+// [colours] is sorted and has duplicates removed
+// ----------------------------------------------------------------------------
+void PaletteLookup::addColours(vector<uint32_t>& colours, int n_threads)
+{
+	std::sort(colours.begin(), colours.end());
+	colours.erase(std::unique(colours.begin(), colours.end()), colours.end());
+
+	// Remove colours already in the table
+	colours.erase(
+		std::remove_if(colours.begin(), colours.end(), [this](uint32_t c) { return nearest_.count(c) > 0; }),
+		colours.end()
+	);
+	if (colours.empty())
+		return;
+
+	// Find nearest indices
+	vector<uint8_t> indices(colours.size());
+	Parallel::forEach(colours.size(), [&](unsigned index)
+	{
+		uint32_t c = colours[index];
+		indices[index] = palette_.nearestColour(rgba_t(c >> 16, (c >> 8) & 0xFF, c & 0xFF, 255), match_);
+	}, nullptr, n_threads);
+
+	// Add to table
+	nearest_.reserve(nearest_.size() + colours.size());
+	for (unsigned a = 0; a < colours.size(); a++)
+		nearest_[colours[a]] = indices[a];
+}
+
+// ----------------------------------------------------------------------------
+// PaletteLookup::nearestColour
+//
+// Returns the index of the closest colour in the palette to [colour]. Falls
+// back to a full palette search if the colour isn't in the table
+// ----------------------------------------------------------------------------
+short PaletteLookup::nearestColour(rgba_t colour) const
+{
+	auto i = nearest_.find(key(colour));
+	if (i != nearest_.end())
+		return i->second;
+
+	return palette_.nearestColour(colour, match_);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Palette.h"
+
+// A read-only table of nearest palette indices for a set of colours, built
+// up-front so it can be shared by multiple threads converting images to the
+// same palette
+class PaletteLookup
+{
+public:
+	PaletteLookup(const Palette& palette, Palette::ColourMatch match = Palette::ColourMatch::Default);
+
+	const Palette&	palette() const { return palette_; }
+	size_t			size() const { return nearest_.size(); }
+
+	bool	matches(const Palette* palette) const;
+	void	addColours(vector<uint32_t>& colours, int n_threads = 0);
+	short	nearestColour(rgba_t colour) const;
+
+	static uint32_t	key(const rgba_t& colour) { return (colour.r << 16) | (colour.g << 8) | colour.b; }
+
+private:
+	Palette									palette_;
+	Palette::ColourMatch					match_;
+	std::unordered_map<uint32_t, uint8_t>	nearest_;
+};
@@ -419,7 +419,7 @@ public:
 			image.cutoffMask(opt.alpha_threshold);
 
 		// Convert to paletted
-		image.convertPaletted(opt.pal_target, opt.pal_current);
+		image.convertPaletted(opt.pal_target, opt.pal_current, opt.pal_lookup);
 
 		return true;
 	}
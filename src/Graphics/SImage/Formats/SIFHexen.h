@@ -230,7 +230,7 @@ public:
 	bool convertWritable(SImage& image, convert_options_t opt)
 	{
 		// First convert image to paletted
-		image.convertPaletted(opt.pal_target, opt.pal_current);
+		image.convertPaletted(opt.pal_target, opt.pal_current, opt.pal_lookup);
 
 		// Now crop the image if it's too large
 		if (image.getWidth() > 640 || image.getHeight() > 480)
@@ -521,7 +521,7 @@ public:
 				image.fillAlpha(255);
 
 			// Convert colours
-			image.convertPaletted(opt.pal_target, opt.pal_current);
+			image.convertPaletted(opt.pal_target, opt.pal_current, opt.pal_lookup);
 		}
 
 		// RGBA
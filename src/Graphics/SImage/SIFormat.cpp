@@ -426,7 +426,7 @@ public:
 	bool convertWritable(SImage& image, convert_options_t opt)
 	{
 		// Firstly, make image paletted
-		image.convertPaletted(opt.pal_target, opt.pal_current);
+		image.convertPaletted(opt.pal_target, opt.pal_current, opt.pal_lookup);
 
 		// Secondly, remove any alpha information
 		image.fillAlpha(255);
@@ -34,6 +34,7 @@ public:
 	{
 		Palette*	pal_current;
 		Palette*	pal_target;
+		const PaletteLookup*	pal_lookup;	// Optional, used when converting to pal_target
 		int				mask_source;
 		rgba_t			mask_colour;
 		uint8_t			alpha_threshold;
@@ -43,6 +44,7 @@ public:
 		convert_options_t()
 		{
 			pal_current = pal_target = nullptr;
+			pal_lookup = nullptr;
 			mask_source = MASK_ALPHA;
 			transparency = true;
 			col_format = -1;
@@ -35,6 +35,7 @@
 #include "Main.h"
 #include "SImage.h"
 #include "SIFormat.h"
+#include "Graphics/Palette/PaletteLookup.h"
 #include "Graphics/Translation.h"
 #include "Utility/MathStuff.h"
 
@@ -686,9 +687,10 @@ bool SImage::convertRGBA(Palette* pal)
  * Converts the image to paletted + mask. [pal_target] is the new
  * palette to convert to (the image's palette will also be set to
  * this). [pal_current] will be used as the image's current palette
- * if it doesn't already have one
+ * if it doesn't already have one. If [lookup] is given and matches
+ * [pal_target], it is used to find nearest colours
  *******************************************************************/
-bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
+bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current, const PaletteLookup* lookup)
 {
 	// Check image/parameters are valid
 	if (!isValid() || !pal_target)
@@ -721,6 +723,8 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 	clearData(false);
 
 	// Do conversion
+	if (lookup && !lookup->matches(pal_target))
+		lookup = nullptr;
 	data = new uint8_t[width * height];
 	unsigned i = 0;
 	rgba_t col;
@@ -729,7 +733,7 @@ bool SImage::convertPaletted(Palette* pal_target, Palette* pal_current)
 		col.r = rgba_data[i++];
 		col.g = rgba_data[i++];
 		col.b = rgba_data[i++];
-		data[a] = palette.nearestColour(col);
+		data[a] = lookup ? lookup->nearestColour(col) : palette.nearestColour(col);
 		i++;	// Skip alpha
 	}
 
@@ -33,6 +33,7 @@ struct si_drawprops_t
 
 class Translation;
 class SIFormat;
+class PaletteLookup;
 
 class SImage : public Announcer
 {
@@ -141,7 +142,7 @@ public:
 
 	// Conversion stuff
 	bool	convertRGBA(Palette* pal = nullptr);
-	bool	convertPaletted(Palette* pal_target, Palette* pal_current = nullptr);
+	bool	convertPaletted(Palette* pal_target, Palette* pal_current = nullptr, const PaletteLookup* lookup = nullptr);
 	bool	convertAlphaMap(int alpha_source = BRIGHTNESS, Palette* pal = nullptr);
 	bool	maskFromColour(rgba_t colour, Palette* pal = nullptr);
 	bool	maskFromBrightness(Palette* pal = nullptr);
@@ -0,0 +1,645 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThumbnailCache.cpp
+// Description: ThumbnailCache namespace, renders image and map thumbnails and
+//              parses map preview data on background threads. Thumbnails are
+//              cached on disk, keyed by a hash of the source content, so they
+//              only need to be rendered once. The least recently used cached
+//              thumbnails are removed when the cache grows too large
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "App.h"
+#include "ThumbnailCache.h"
+#include "General/Console/Console.h"
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+CVAR(Bool, thumbnail_disk_cache, true, CVAR_SAVE)
+CVAR(Int, thumbnail_disk_cache_max_mb, 32, CVAR_SAVE)
+CVAR(Int, thumbnail_threads, 2, CVAR_SAVE)
+
+namespace ThumbnailCache
+{
+	// Runs queued jobs on worker threads. The most recently added job is run
+	// first, since that is most likely what is currently visible
+	class WorkQueue
+	{
+	public:
+		typedef std::function<void(unsigned ticket)> JobFunc;
+
+		~WorkQueue();
+
+		unsigned	add(JobFunc func);
+		void		cancel(unsigned ticket);
+		bool		finish(unsigned ticket);
+
+	private:
+		struct Job
+		{
+			unsigned	ticket;
+			JobFunc		func;
+		};
+
+		std::mutex					mutex_;
+		std::condition_variable		cv_;
+		std::deque<Job>				jobs_;
+		std::unordered_set<unsigned>	active_;
+		vector<std::thread>			threads_;
+		bool						stop_ = false;
+		unsigned					next_ticket_ = 1;
+
+		void	work();
+	};
+
+	WorkQueue queue;
+
+	// Recently parsed map data, most recent first
+	std::list<MapPreviewData::SPtr>	map_data_cache;
+	const unsigned					map_data_cache_size = 16;
+
+	// Total size of the disk cache in bytes (-1 if not yet known)
+	std::mutex	disk_mutex;
+	int64_t		disk_cache_size = -1;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// ThumbnailCache::WorkQueue Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// WorkQueue::~WorkQueue
+//
+// WorkQueue class destructor, stops and joins the worker threads
+// ----------------------------------------------------------------------------
+ThumbnailCache::WorkQueue::~WorkQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+
+	for (auto& thread : threads_)
+		thread.join();
+}
+
+// ----------------------------------------------------------------------------
+// WorkQueue::add
+//
+// Queues [func] to be run on a worker thread and returns its ticket
+// ----------------------------------------------------------------------------
+unsigned ThumbnailCache::WorkQueue::add(JobFunc func)
+{
+	unsigned ticket;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// Start worker threads if needed
+		if (threads_.empty())
+		{
+			int n_threads = MAX((int)thumbnail_threads, 1);
+			for (int a = 0; a < n_threads; a++)
+				threads_.emplace_back(&WorkQueue::work, this);
+		}
+
+		ticket = next_ticket_++;
+		if (next_ticket_ == 0)
+			next_ticket_ = 1;
+		active_.insert(ticket);
+		jobs_.push_back({ ticket, std::move(func) });
+	}
+	cv_.notify_one();
+
+	return ticket;
+}
+
+// ----------------------------------------------------------------------------
+// WorkQueue::cancel
+//
+// Cancels the job with [ticket]. If it hasn't started it won't be run, and
+// if it has its result won't be delivered
+// ----------------------------------------------------------------------------
+void ThumbnailCache::WorkQueue::cancel(unsigned ticket)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	active_.erase(ticket);
+}
+
+// ----------------------------------------------------------------------------
+// WorkQueue::finish
+//
+// Marks the job with [ticket] as finished. Returns false if it was cancelled
+// ----------------------------------------------------------------------------
+bool ThumbnailCache::WorkQueue::finish(unsigned ticket)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return active_.erase(ticket) > 0;
+}
+
+// ----------------------------------------------------------------------------
+// WorkQueue::work
+//
+// Worker thread function
+// ----------------------------------------------------------------------------
+void ThumbnailCache::WorkQueue::work()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+			if (stop_)
+				return;
+
+			job = std::move(jobs_.back());
+			jobs_.pop_back();
+
+			// Skip cancelled jobs
+			if (active_.find(job.ticket) == active_.end())
+				continue;
+		}
+
+		job.func(job.ticket);
+	}
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// ThumbnailCache Namespace Functions
+//
+// ----------------------------------------------------------------------------
+namespace ThumbnailCache
+{
+	// ------------------------------------------------------------------------
+	// combineHash
+	//
+	// Mixes [value] into [hash]
+	// ------------------------------------------------------------------------
+	uint64_t combineHash(uint64_t hash, uint64_t value)
+	{
+		return (hash ^ value) * 1099511628211ULL;
+	}
+
+	// ------------------------------------------------------------------------
+	// colourHash
+	//
+	// Mixes [col] into [hash]
+	// ------------------------------------------------------------------------
+	uint64_t colourHash(uint64_t hash, rgba_t col)
+	{
+		return combineHash(hash, ((uint64_t)col.r << 24) | (col.g << 16) | (col.b << 8) | col.a);
+	}
+
+	// ------------------------------------------------------------------------
+	// cacheFile
+	//
+	// Returns the disk cache path for a thumbnail with [hash] and [size]
+	// ------------------------------------------------------------------------
+	string cacheFile(uint64_t hash, int size)
+	{
+		string dir = cacheDir();
+		if (!wxDirExists(dir))
+			wxMkdir(dir);
+
+		return S_FMT("%s/%016llx_%d.png", dir, (unsigned long long)hash, size);
+	}
+
+	// ------------------------------------------------------------------------
+	// trimDiskCache
+	//
+	// Recalculates the disk cache size and, if it is over the maximum size,
+	// deletes the least recently used thumbnails until it is below 3/4 of
+	// the maximum. disk_mutex must be locked
+	// ------------------------------------------------------------------------
+	void trimDiskCache()
+	{
+		struct CachedFile
+		{
+			string	path;
+			time_t	used;
+			int64_t	size;
+		};
+
+		wxArrayString files;
+		if (wxDirExists(cacheDir()))
+			wxDir::GetAllFiles(cacheDir(), &files, "*.png", wxDIR_FILES);
+
+		vector<CachedFile> cached;
+		disk_cache_size = 0;
+		for (auto& file : files)
+		{
+			wxFileName fn(file);
+			int64_t size = fn.GetSize().GetValue();
+			cached.push_back({ file, fn.GetModificationTime().GetTicks(), size });
+			disk_cache_size += size;
+		}
+
+		int64_t max_size = (int64_t)MAX((int)thumbnail_disk_cache_max_mb, 1) * 1024 * 1024;
+		if (disk_cache_size <= max_size)
+			return;
+
+		// Delete least recently used first
+		std::sort(cached.begin(), cached.end(), [](const CachedFile& a, const CachedFile& b)
+		{
+			return a.used < b.used;
+		});
+		for (auto& file : cached)
+		{
+			if (disk_cache_size <= max_size * 3 / 4)
+				break;
+			if (wxRemoveFile(file.path))
+				disk_cache_size -= file.size;
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// loadCached
+	//
+	// Loads the cached thumbnail [file] into [image], if it exists. The file
+	// modification time is updated so the least recently used thumbnails can
+	// be removed first when the cache is trimmed
+	// ------------------------------------------------------------------------
+	bool loadCached(const string& file, SImage& image)
+	{
+		if (!thumbnail_disk_cache || !wxFileExists(file))
+			return false;
+
+		MemChunk mc;
+		if (!mc.importFile(file) || !image.open(mc, 0, "png"))
+			return false;
+
+		std::lock_guard<std::mutex> lock(disk_mutex);
+		wxFileName(file).Touch();
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// saveCached
+	//
+	// Writes [image] to the disk cache as [file], trimming the cache if it is
+	// over the maximum size
+	// ------------------------------------------------------------------------
+	void saveCached(const string& file, SImage& image)
+	{
+		if (!thumbnail_disk_cache)
+			return;
+
+		MemChunk mc;
+		if (!SIFormat::getFormat("png")->saveImage(image, mc))
+			return;
+
+		std::lock_guard<std::mutex> lock(disk_mutex);
+		if (!mc.exportFile(file))
+			return;
+
+		int64_t max_size = (int64_t)MAX((int)thumbnail_disk_cache_max_mb, 1) * 1024 * 1024;
+		if (disk_cache_size >= 0)
+			disk_cache_size += mc.getSize();
+		if (disk_cache_size < 0 || disk_cache_size > max_size)
+			trimDiskCache();
+	}
+
+	// ------------------------------------------------------------------------
+	// makeThumbnail
+	//
+	// Scales [image] down (if needed) to fit in a [size]x[size] RGBA image,
+	// centered with a transparent border, and writes it to [thumb]
+	// ------------------------------------------------------------------------
+	bool makeThumbnail(SImage& image, Palette* palette, int size, SImage& thumb)
+	{
+		MemChunk rgba;
+		if (!image.getRGBAData(rgba, palette))
+			return false;
+		const uint8_t* src = rgba.getData();
+
+		int width = image.getWidth();
+		int height = image.getHeight();
+		double scale = MIN(1.0, MIN((double)size / width, (double)size / height));
+		int t_width = MAX(1, (int)(width * scale));
+		int t_height = MAX(1, (int)(height * scale));
+		int x_offset = (size - t_width) / 2;
+		int y_offset = (size - t_height) / 2;
+
+		uint8_t* data = new uint8_t[size * size * 4];
+		memset(data, 0, size * size * 4);
+
+		// Box filter, weighted by alpha so transparent pixels don't darken edges
+		for (int ty = 0; ty < t_height; ty++)
+		{
+			int y1 = ty * height / t_height;
+			int y2 = MAX(y1 + 1, (ty + 1) * height / t_height);
+			for (int tx = 0; tx < t_width; tx++)
+			{
+				int x1 = tx * width / t_width;
+				int x2 = MAX(x1 + 1, (tx + 1) * width / t_width);
+
+				unsigned r = 0, g = 0, b = 0, a = 0, count = 0;
+				for (int y = y1; y < y2; y++)
+				{
+					for (int x = x1; x < x2; x++)
+					{
+						const uint8_t* pixel = src + (y * width + x) * 4;
+						r += pixel[0] * pixel[3];
+						g += pixel[1] * pixel[3];
+						b += pixel[2] * pixel[3];
+						a += pixel[3];
+						count++;
+					}
+				}
+
+				uint8_t* out = data + ((ty + y_offset) * size + tx + x_offset) * 4;
+				if (a > 0)
+				{
+					out[0] = r / a;
+					out[1] = g / a;
+					out[2] = b / a;
+					out[3] = a / count;
+				}
+			}
+		}
+
+		return thumb.setImageData(data, size, size, RGBA);
+	}
+
+	// ------------------------------------------------------------------------
+	// deliver
+	//
+	// Calls [func] on the main thread, unless [ticket] was cancelled
+	// ------------------------------------------------------------------------
+	void deliver(unsigned ticket, std::function<void()> func)
+	{
+		if (!wxTheApp)
+			return;
+
+		wxTheApp->CallAfter([ticket, func]()
+		{
+			if (queue.finish(ticket))
+				func();
+		});
+	}
+
+	// ------------------------------------------------------------------------
+	// failImage
+	//
+	// Calls [callback] for a failed image request
+	// ------------------------------------------------------------------------
+	unsigned failImage(ImageCallback& callback)
+	{
+		SImage image;
+		callback(image, false);
+		return 0;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::requestImage
+//
+// Requests a [size]x[size] thumbnail of the image [entry], using [palette]
+// for paletted images. [callback] is called on the main thread when ready
+// ----------------------------------------------------------------------------
+unsigned ThumbnailCache::requestImage(ArchiveEntry* entry, int size, Palette* palette, ImageCallback callback)
+{
+	// Check the entry is an image that can be opened via SIFormat (fonts and
+	// Jaguar formats need other entries or special handling)
+	EntryType* type = entry->getType();
+	string format = type->formatId();
+	if (!type->extraProps().propertyExists("image") ||
+		format.StartsWith("font_") ||
+		format.StartsWith("img_jaguar"))
+		return failImage(callback);
+
+	string format_hint;
+	if (type->extraProps().propertyExists("image_format"))
+		format_hint = type->extraProps()["image_format"].getStringValue();
+
+	// Copy entry data and palette for the worker thread
+	auto data = std::make_shared<MemChunk>(entry->getData(), entry->getSize());
+	auto pal = std::make_shared<Palette>();
+	if (palette)
+		pal->copyPalette(palette);
+
+	// Thumbnails depend on the image, palette and size
+	uint64_t hash = combineHash(entry->getContentHash(), size);
+	for (unsigned a = 0; a < 256; a++)
+		hash = colourHash(hash, pal->colour(a));
+	string file = cacheFile(hash, size);
+
+	return queue.add([=](unsigned ticket)
+	{
+		// Images are only used on this thread until delivered, so don't
+		// send their change announcements back to the main thread
+		auto thumb = std::make_shared<SImage>();
+		thumb->setMuted(true);
+		bool ok = loadCached(file, *thumb);
+		if (!ok)
+		{
+			SImage image;
+			image.setMuted(true);
+			ok = image.open(*data, 0, format_hint) && makeThumbnail(image, pal.get(), size, *thumb);
+			if (ok)
+				saveCached(file, *thumb);
+		}
+
+		deliver(ticket, [thumb, ok, callback]() { callback(*thumb, ok); });
+	});
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::requestMapImage
+//
+// Requests a [size]x[size] thumbnail of [map]. [callback] is called on the
+// main thread when ready
+// ----------------------------------------------------------------------------
+unsigned ThumbnailCache::requestMapImage(const Archive::MapDesc& map, int size, ImageCallback callback)
+{
+	auto data = std::make_shared<MapPreviewData>();
+	if (!data->read(map))
+		return failImage(callback);
+
+	// Thumbnails depend on the map content, colours and size
+	MapPreviewData::ImageColours colours;
+	colours.load();
+	uint64_t hash = combineHash(data->contentHash(), size);
+	hash = colourHash(hash, colours.background);
+	hash = colourHash(hash, colours.line_1s);
+	hash = colourHash(hash, colours.line_2s);
+	hash = colourHash(hash, colours.line_special);
+	hash = colourHash(hash, colours.line_macro);
+	string file = cacheFile(hash, size);
+
+	return queue.add([=](unsigned ticket)
+	{
+		// Images are only used on this thread until delivered, so don't
+		// send their change announcements back to the main thread
+		auto thumb = std::make_shared<SImage>();
+		thumb->setMuted(true);
+		bool ok = loadCached(file, *thumb);
+		string error;
+		if (!ok)
+		{
+			if (data->parse())
+			{
+				data->drawImage(*thumb, size, size, colours);
+				saveCached(file, *thumb);
+				ok = true;
+			}
+			else
+				error = data->error();
+		}
+
+		deliver(ticket, [thumb, ok, error, callback]()
+		{
+			if (!error.empty())
+				LOG_MESSAGE(1, error);
+			callback(*thumb, ok);
+		});
+	});
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::requestMapData
+//
+// Requests parsed preview data for [map]. [callback] is called on the main
+// thread with the data, or nullptr if the map is invalid. Recently parsed
+// maps are kept in memory and returned immediately
+// ----------------------------------------------------------------------------
+unsigned ThumbnailCache::requestMapData(const Archive::MapDesc& map, MapDataCallback callback)
+{
+	auto data = std::make_shared<MapPreviewData>();
+	if (!data->read(map))
+	{
+		callback(nullptr);
+		return 0;
+	}
+
+	// Check for recently parsed data with the same content
+	for (auto i = map_data_cache.begin(); i != map_data_cache.end(); ++i)
+	{
+		if ((*i)->contentHash() == data->contentHash())
+		{
+			auto cached = *i;
+			map_data_cache.erase(i);
+			map_data_cache.push_front(cached);
+			callback(cached);
+			return 0;
+		}
+	}
+
+	return queue.add([data, callback](unsigned ticket)
+	{
+		bool ok = data->parse();
+		deliver(ticket, [data, ok, callback]()
+		{
+			if (!ok)
+			{
+				LOG_MESSAGE(1, data->error());
+				callback(nullptr);
+				return;
+			}
+
+			map_data_cache.push_front(data);
+			if (map_data_cache.size() > map_data_cache_size)
+				map_data_cache.pop_back();
+			callback(data);
+		});
+	});
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::cancel
+//
+// Cancels the request with [ticket], its callback will not be called
+// ----------------------------------------------------------------------------
+void ThumbnailCache::cancel(unsigned ticket)
+{
+	if (ticket > 0)
+		queue.cancel(ticket);
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::cacheDir
+//
+// Returns the directory thumbnails are cached in
+// ----------------------------------------------------------------------------
+string ThumbnailCache::cacheDir()
+{
+	return App::path("thumbnails", App::Dir::User);
+}
+
+// ----------------------------------------------------------------------------
+// ThumbnailCache::clearDiskCache
+//
+// Deletes all cached thumbnails on disk
+// ----------------------------------------------------------------------------
+void ThumbnailCache::clearDiskCache()
+{
+	std::lock_guard<std::mutex> lock(disk_mutex);
+
+	wxArrayString files;
+	if (wxDirExists(cacheDir()))
+		wxDir::GetAllFiles(cacheDir(), &files, "*.png", wxDIR_FILES);
+
+	for (auto& file : files)
+		wxRemoveFile(file);
+	disk_cache_size = 0;
+
+	LOG_MESSAGE(1, "Removed %d cached thumbnails", (int)files.size());
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// ----------------------------------------------------------------------------
+
+
+CONSOLE_COMMAND(thumbnail_cache_clear, 0, false)
+{
+	ThumbnailCache::clearDiskCache();
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "MapEditor/MapPreviewData.h"
+
+class Palette;
+class SImage;
+
+namespace ThumbnailCache
+{
+	typedef std::function<void(SImage& image, bool ok)>		ImageCallback;
+	typedef std::function<void(MapPreviewData::SPtr data)>	MapDataCallback;
+
+	// Requests return a ticket that can be passed to cancel(), or 0 if the
+	// callback was already called. That only happens if the request failed
+	// immediately, or for map data found in the in-memory cache - thumbnails
+	// found in the disk cache are still loaded and delivered asynchronously
+	unsigned	requestImage(ArchiveEntry* entry, int size, Palette* palette, ImageCallback callback);
+	unsigned	requestMapImage(const Archive::MapDesc& map, int size, ImageCallback callback);
+	unsigned	requestMapData(const Archive::MapDesc& map, MapDataCallback callback);
+	void		cancel(unsigned ticket);
+
+	string		cacheDir();
+	void		clearDiskCache();
+}
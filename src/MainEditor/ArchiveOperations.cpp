@@ -42,6 +42,7 @@
 #include "MapEditor/SLADEMap/MapThing.h"
 #include "MapEditor/SLADEMap/MapLine.h"
 #include "General/Console/Console.h"
+#include "Utility/Parallel.h"
 #include "Utility/Tokenizer.h"
 
 
@@ -50,7 +51,7 @@
  *******************************************************************/
 typedef std::map<string, int> StrIntMap;
 typedef std::map<string, vector<ArchiveEntry*> > PathMap;
-typedef std::map<int, vector<ArchiveEntry*> > CRCMap;
+typedef std::map<uint64_t, vector<ArchiveEntry*> > ContentHashMap;
 
 
 /*******************************************************************
@@ -122,19 +123,24 @@ bool ArchiveOperations::removeUnusedPatches(Archive* archive)
 		}
 	}
 
-	// Remove unused patch entries
-	for (unsigned a = 0; a < to_remove.size(); a++)
+	// Apply changes to the archive as a single batch update
 	{
-		LOG_MESSAGE(1, "Removed entry %s", to_remove[a]->getName());
-		archive->removeEntry(to_remove[a]);
-	}
+		Archive::BatchUpdate batch(archive);
 
-	// Write PNAMES changes
-	ptable.writePNAMES(pnames);
+		// Remove unused patch entries
+		for (unsigned a = 0; a < to_remove.size(); a++)
+		{
+			LOG_MESSAGE(1, "Removed entry %s", to_remove[a]->getName());
+			archive->removeEntry(to_remove[a]);
+		}
 
-	// Write TEXTUREx changes
-	for (unsigned a = 0; a < tx_lists.size(); a++)
-		tx_lists[a]->writeTEXTUREXData(tx_entries[a], ptable);
+		// Write PNAMES changes
+		ptable.writePNAMES(pnames);
+
+		// Write TEXTUREx changes
+		for (unsigned a = 0; a < tx_lists.size(); a++)
+			tx_lists[a]->writeTEXTUREXData(tx_entries[a], ptable);
+	}
 
 	// Cleanup
 	for (unsigned a = 0; a < tx_lists.size(); a++)
@@ -253,28 +259,33 @@ void ArchiveOperations::removeEntriesUnchangedFromIWAD(Archive* archive)
 	size_t count = 0;
 
 	// Go through list
-	for (unsigned a = 0; a < entries.size(); a++)
 	{
-		// Skip directory entries
-		if (entries[a]->getType() == EntryType::folderType())
-			continue;
-
-		// Skip markers
-		if (entries[a]->getType() == EntryType::mapMarkerType() || entries[a]->getSize() == 0)
-			continue;
-
-		// Now, let's look for a counterpart in the IWAD
-		search.match_namespace = archive->detectNamespace(entries[a]);
-		search.match_name = entries[a]->getName();
-		other = bra->findLast(search);
-
-		// If there is one, and it is identical, remove it
-		if (other != nullptr && (other->getMCData().crc() == entries[a]->getMCData().crc()))
+		Archive::BatchUpdate batch(archive);
+		for (unsigned a = 0; a < entries.size(); a++)
 		{
-			++count;
-			dups += S_FMT("%s\n", search.match_name);
-			archive->removeEntry(entries[a]);
-			entries[a] = nullptr;
+			// Skip directory entries
+			if (entries[a]->getType() == EntryType::folderType())
+				continue;
+
+			// Skip markers
+			if (entries[a]->getType() == EntryType::mapMarkerType() || entries[a]->getSize() == 0)
+				continue;
+
+			// Now, let's look for a counterpart in the IWAD
+			search.match_namespace = archive->detectNamespace(entries[a]);
+			search.match_name = entries[a]->getName();
+			other = bra->findLast(search);
+
+			// If there is one, and it is identical, remove it
+			if (other != nullptr &&
+				other->getSize() == entries[a]->getSize() &&
+				other->getContentHash() == entries[a]->getContentHash())
+			{
+				++count;
+				dups += S_FMT("%s\n", search.match_name);
+				archive->removeEntry(entries[a]);
+				entries[a] = nullptr;
+			}
 		}
 	}
 
@@ -302,7 +313,8 @@ void ArchiveOperations::removeEntriesUnchangedFromIWAD(Archive* archive)
  *******************************************************************/
 bool ArchiveOperations::checkDuplicateEntryContent(Archive* archive)
 {
-	CRCMap map_entries;
+	std::map<uint32_t, vector<ArchiveEntry*>> size_groups;
+	ContentHashMap map_entries;
 
 	// Get list of all entries in archive
 	vector<ArchiveEntry*> entries;
@@ -320,18 +332,29 @@ bool ArchiveOperations::checkDuplicateEntryContent(Archive* archive)
 		if (entries[a]->getType() == EntryType::mapMarkerType() || entries[a]->getSize() == 0)
 			continue;
 
-		// Enqueue entries
-		map_entries[entries[a]->getMCData().crc()].push_back(entries[a]);
+		// Group by size first (entries can only have the same data if they
+		// are the same size)
+		size_groups[entries[a]->getSize()].push_back(entries[a]);
+	}
+
+	// Enqueue entries that share their size with another entry by content
+	for (auto& group : size_groups)
+	{
+		if (group.second.size() < 2)
+			continue;
+
+		for (auto entry : group.second)
+			map_entries[entry->getContentHash()].push_back(entry);
 	}
 
 	// Now iterate through the dupes to list the name of the duplicated entries
-	CRCMap::iterator i = map_entries.begin();
+	ContentHashMap::iterator i = map_entries.begin();
 	while (i != map_entries.end())
 	{
 		if (i->second.size() > 1)
 		{
 			string name = i->second[0]->getPath(true); name.Remove(0, 1);
-			dups += S_FMT("\n%s\t(%8x) duplicated by", name, i->first);
+			dups += S_FMT("\n%s\t(%016llx) duplicated by", name, (unsigned long long)i->first);
 			vector<ArchiveEntry*>::iterator j = i->second.begin() + 1;
 			while (j != i->second.end())
 			{
@@ -798,6 +821,7 @@ void ArchiveOperations::removeUnusedFlats(Archive* archive)
 	if (dialog.ShowModal() == wxID_OK)
 	{
 		// Go through selected flats
+		Archive::BatchUpdate batch(archive);
 		selection = dialog.GetSelections();
 		opt.match_namespace = "flats";
 		for (unsigned a = 0; a < selection.size(); a++)
@@ -825,202 +849,423 @@ CONSOLE_COMMAND(test_cleanflats, 0, false)
 	if (current) ArchiveOperations::removeUnusedFlats(current);
 }
 
-size_t replaceThingsDoom(ArchiveEntry* entry, int oldtype, int newtype)
+/*******************************************************************
+ * MAP REPLACE OPERATIONS
+ *******************************************************************/
+namespace
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numthings = size / sizeof(doomthing_t);
-	size_t changed = 0;
+	// A single map lump, patched in-place
+	struct MapLump
+	{
+		uint8_t*	data = nullptr;
+		size_t		size = 0;
+		bool		changed = false;
 
-	doomthing_t* things = new doomthing_t[numthings];
-	memcpy(things, entry->getData(), size);
+		void set(vector<uint8_t>& buffer, size_t offset = 0, size_t length = 0)
+		{
+			data = buffer.data() + offset;
+			size = length > 0 ? length : buffer.size();
+		}
+	};
 
-	// Perform replacement
-	for (size_t t = 0; t < numthings; ++t)
+	// The lumps of a map that can be modified by the replace operations
+	struct MapLumps
 	{
-		if (things[t].type == oldtype)
+		enum
 		{
-			things[t].type = newtype;
-			++changed;
-		}
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(things, size);
-	delete[] things;
+			THINGS,
+			LINEDEFS,
+			SIDEDEFS,
+			SECTORS,
+			TEXTMAP,
+			NUM_LUMPS
+		};
+
+		uint8_t	format = MAP_UNKNOWN;
+		MapLump	lumps[NUM_LUMPS];
+
+		MapLump& things() { return lumps[THINGS]; }
+		MapLump& linedefs() { return lumps[LINEDEFS]; }
+		MapLump& sidedefs() { return lumps[SIDEDEFS]; }
+		MapLump& sectors() { return lumps[SECTORS]; }
+		MapLump& textmap() { return lumps[TEXTMAP]; }
+	};
 
-	return changed;
-}
-size_t replaceThingsDoom64(ArchiveEntry* entry, int oldtype, int newtype)
-{
-	if (entry == nullptr)
-		return 0;
+	// Patches the given map lumps, returning the number of elements changed.
+	// Called from worker threads, so it must not touch any archives/entries
+	typedef std::function<size_t(MapLumps&)> MapPatchFunc;
 
-	size_t size = entry->getSize();
-	size_t numthings = size / sizeof(doom64thing_t);
-	size_t changed = 0;
+	// A map (or a wad containing maps, for maps in zips) to be patched
+	struct MapPatchTask
+	{
+		// Source
+		Archive::MapDesc	map;
+		string				name;
+		const uint8_t*		source[MapLumps::NUM_LUMPS] = {};
+		size_t				source_size[MapLumps::NUM_LUMPS] = {};
+		ArchiveEntry*		entries[MapLumps::NUM_LUMPS] = {};
+
+		// Patched data (each lump, or the whole wad if embedded)
+		vector<uint8_t>		data[MapLumps::NUM_LUMPS];
+		MapLumps			lumps;
+		bool				wad_changed = false;
+
+		// Results (map name and number of elements changed)
+		vector<std::pair<std::string, size_t>>	results;
+		std::string								error;
+	};
+
+	// Lump names that can be part of a (non-UDMF) map
+	const char* const binary_map_lumps[] =
+	{
+		"THINGS", "VERTEXES", "LINEDEFS", "SIDEDEFS", "SECTORS", "SEGS", "SSECTORS",
+		"NODES", "BLOCKMAP", "REJECT", "SCRIPTS", "BEHAVIOR", "LEAFS", "LIGHTS",
+		"MACROS", "GL_VERT", "GL_SEGS", "GL_SSECT", "GL_NODES", "GL_PVS", "ZNODES"
+	};
+
+	/* isBinaryMapLump
+	 * Returns true if [name] is a binary format map lump name
+	 *******************************************************************/
+	bool isBinaryMapLump(const std::string& name)
+	{
+		for (auto lump : binary_map_lumps)
+			if (name == lump)
+				return true;
 
-	doom64thing_t* things = new doom64thing_t[numthings];
-	memcpy(things, entry->getData(), size);
+		return name.compare(0, 3, "GL_") == 0;
+	}
 
-	// Perform replacement
-	for (size_t t = 0; t < numthings; ++t)
+	/* patchWad
+	 * Finds all maps in the wad file [wad] by reading its directory, and
+	 * applies [patch] to each of them in-place. Since the patches never
+	 * change lump sizes, the wad doesn't need to be rebuilt. Returns
+	 * false if [wad] isn't a valid wad file
+	 *******************************************************************/
+	bool patchWad(vector<uint8_t>& wad, MapPatchFunc& patch, MapPatchTask& task)
 	{
-		if (things[t].type == oldtype)
+		// Read header
+		if (wad.size() < 12 || (memcmp(wad.data(), "PWAD", 4) != 0 && memcmp(wad.data(), "IWAD", 4) != 0))
+			return false;
+		int32_t num_lumps, dir_offset;
+		memcpy(&num_lumps, wad.data() + 4, 4);
+		memcpy(&dir_offset, wad.data() + 8, 4);
+		num_lumps = wxINT32_SWAP_ON_BE(num_lumps);
+		dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
+		if (num_lumps < 0 || dir_offset < 0 || (size_t)dir_offset + (size_t)num_lumps * 16 > wad.size())
+			return false;
+
+		// Read directory
+		struct Lump
+		{
+			std::string	name;
+			size_t		offset;
+			size_t		size;
+		};
+		vector<Lump> lumps(num_lumps);
+		for (int a = 0; a < num_lumps; a++)
 		{
-			things[t].type = newtype;
-			++changed;
+			const uint8_t* dir_entry = wad.data() + dir_offset + a * 16;
+			int32_t offset, size;
+			memcpy(&offset, dir_entry, 4);
+			memcpy(&size, dir_entry + 4, 4);
+			offset = wxINT32_SWAP_ON_BE(offset);
+			size = wxINT32_SWAP_ON_BE(size);
+			if (offset < 0 || size < 0 || (size_t)offset + (size_t)size > wad.size())
+				return false;
+
+			char name[9] = {};
+			memcpy(name, dir_entry + 8, 8);
+			lumps[a].name = name;
+			lumps[a].offset = offset;
+			lumps[a].size = size;
 		}
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(things, size);
-	delete[] things;
 
-	return changed;
-}
-size_t replaceThingsHexen(ArchiveEntry* entry, int oldtype, int newtype)
-{
-	if (entry == nullptr)
-		return 0;
+		// Find maps (a header lump followed by THINGS or TEXTMAP)
+		for (int a = 0; a + 1 < num_lumps; a++)
+		{
+			bool udmf = lumps[a + 1].name == "TEXTMAP";
+			if (!udmf && lumps[a + 1].name != "THINGS")
+				continue;
+
+			MapLumps map;
+			bool behavior = false;
+			unsigned d64_lumps = 0;
+			int l = a + 1;
+			for (; l < num_lumps; l++)
+			{
+				const std::string& name = lumps[l].name;
+				if (udmf && name == "ENDMAP")
+					break;
+				if (!udmf && !isBinaryMapLump(name))
+					break;
 
-	size_t size = entry->getSize();
-	size_t numthings = size / sizeof(hexenthing_t);
-	size_t changed = 0;
+				MapLump* lump = nullptr;
+				if (name == "THINGS") lump = &map.things();
+				else if (name == "LINEDEFS") lump = &map.linedefs();
+				else if (name == "SIDEDEFS") lump = &map.sidedefs();
+				else if (name == "SECTORS") lump = &map.sectors();
+				else if (name == "TEXTMAP") lump = &map.textmap();
+				else if (name == "BEHAVIOR") behavior = true;
+				else if (name == "LEAFS" || name == "LIGHTS" || name == "MACROS") d64_lumps++;
+
+				if (lump && lumps[l].size > 0)
+					lump->set(wad, lumps[l].offset, lumps[l].size);
+			}
+
+			// Determine format (as WadArchive::detectMapFormat)
+			if (udmf)
+				map.format = MAP_UDMF;
+			else if (behavior)
+				map.format = MAP_HEXEN;
+			else if (d64_lumps == 3)
+				map.format = MAP_DOOM64;
+			else
+				map.format = MAP_DOOM;
 
-	hexenthing_t* things = new hexenthing_t[numthings];
-	memcpy(things, entry->getData(), size);
+			task.results.push_back(std::make_pair(lumps[a].name, patch(map)));
+			for (auto& lump : map.lumps)
+				if (lump.changed)
+					task.wad_changed = true;
 
-	// Perform replacement
-	for (size_t t = 0; t < numthings; ++t)
+			a = l - 1;
+		}
+
+		return true;
+	}
+
+	/* runMapPatchTask
+	 * Applies [patch] to the map(s) in [task]. Runs on a worker thread
+	 *******************************************************************/
+	void runMapPatchTask(MapPatchTask& task, MapPatchFunc& patch)
 	{
-		if (things[t].type == oldtype)
+		// Embedded wad
+		if (task.map.archive)
 		{
-			things[t].type = newtype;
-			++changed;
+			vector<uint8_t>& wad = task.data[0];
+			wad.assign(task.source[0], task.source[0] + task.source_size[0]);
+			if (!patchWad(wad, patch, task))
+				task.error = "Not a valid wad file";
+
+			return;
 		}
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(things, size);
-	delete[] things;
 
-	return changed;
-}
-size_t replaceThingsUDMF(ArchiveEntry* entry, int oldtype, int newtype)
-{
-	if (entry == nullptr) return 0;
+		// Map in this archive
+		task.lumps.format = task.map.format;
+		for (unsigned a = 0; a < MapLumps::NUM_LUMPS; a++)
+		{
+			if (!task.source[a] || task.source_size[a] == 0)
+				continue;
 
-	size_t changed = 0;
-	// TODO: parse and replace code
-	// Import the changes if needed
-	if (changed > 0)
-	{
-		//entry->importMemChunk(mc);
+			task.data[a].assign(task.source[a], task.source[a] + task.source_size[a]);
+			task.lumps.lumps[a].set(task.data[a]);
+		}
+		task.results.push_back(std::make_pair(std::string(), patch(task.lumps)));
 	}
-	return changed;
-}
-size_t ArchiveOperations::replaceThings(Archive* archive, int oldtype, int newtype)
-{
-	size_t changed = 0;
-	// Check archive was given
-	if (!archive)
-		return changed;
-
-	// Get all maps
-	vector<Archive::MapDesc> maps = archive->detectMaps();
-	string report = "";
 
-	for (size_t a = 0; a < maps.size(); ++a)
+	/* patchMaps
+	 * Applies [patch] to all maps in [archive]. The maps are patched
+	 * concurrently, and all changes are written back to the archive in a
+	 * single batch update at the end. A report of the number of [what]
+	 * changed in each map is written to the log. Returns the total number
+	 * of elements changed
+	 *******************************************************************/
+	size_t patchMaps(Archive* archive, MapPatchFunc patch, const string& what)
 	{
-		size_t achanged = 0;
-		// Is it an embedded wad?
-		if (maps[a].archive)
+		// Check archive was given
+		if (!archive)
+			return 0;
+
+		// Setup tasks for all maps (entry data must be loaded on this thread)
+		vector<Archive::MapDesc> maps = archive->detectMaps();
+		vector<MapPatchTask> tasks(maps.size());
+		EntryType* lump_types[MapLumps::NUM_LUMPS] =
 		{
-			// Attempt to open entry as wad archive
-			Archive* temp_archive = new WadArchive();
-			if (temp_archive->open(maps[a].head))
+			EntryType::fromId("map_things"),
+			EntryType::fromId("map_linedefs"),
+			EntryType::fromId("map_sidedefs"),
+			EntryType::fromId("map_sectors"),
+			EntryType::fromId("udmf_textmap")
+		};
+		for (size_t a = 0; a < maps.size(); a++)
+		{
+			MapPatchTask& task = tasks[a];
+			task.map = maps[a];
+			task.name = maps[a].head->getName();
+
+			// Embedded wad
+			if (maps[a].archive)
 			{
-				achanged = ArchiveOperations::replaceThings(temp_archive, oldtype, newtype);
-				MemChunk mc;
-				if (!(temp_archive->write(mc, true)))
-				{
-					achanged = 0;
-				}
-				else
-				{
-					temp_archive->close();
-					if (!(maps[a].head->importMemChunk(mc)))
-					{
-						achanged = 0;
-					}
-				}
+				task.entries[0] = maps[a].head;
+				task.source[0] = maps[a].head->getData();
+				task.source_size[0] = maps[a].head->getSize();
+				continue;
 			}
 
-			// Cleanup
-			delete temp_archive;
-
-		}
-		else
-		{
-			// Find the map entry to modify
+			// Find map lump entries
 			ArchiveEntry* mapentry = maps[a].head;
-			ArchiveEntry* things = nullptr;
-			if (maps[a].format == MAP_DOOM || maps[a].format == MAP_DOOM64 || maps[a].format == MAP_HEXEN)
+			while (mapentry && mapentry != maps[a].end)
 			{
-				while (mapentry && mapentry != maps[a].end)
+				for (unsigned l = 0; l < MapLumps::NUM_LUMPS; l++)
 				{
-					if (mapentry->getType() == EntryType::fromId("map_things"))
+					if (!task.entries[l] && mapentry->getType() == lump_types[l])
 					{
-						things = mapentry;
-						break;
+						task.entries[l] = mapentry;
+						task.source[l] = mapentry->getData();
+						task.source_size[l] = mapentry->getSize();
 					}
-					mapentry = mapentry->nextEntry();
 				}
+				mapentry = mapentry->nextEntry();
 			}
-			else if (maps[a].format == MAP_UDMF)
+			if (maps[a].end && maps[a].end != maps[a].head)
 			{
-				while (mapentry && mapentry != maps[a].end)
+				for (unsigned l = 0; l < MapLumps::NUM_LUMPS; l++)
 				{
-					if (mapentry->getType() == EntryType::fromId("udmf_textmap"))
+					if (!task.entries[l] && maps[a].end->getType() == lump_types[l])
 					{
-						things = mapentry;
-						break;
+						task.entries[l] = maps[a].end;
+						task.source[l] = maps[a].end->getData();
+						task.source_size[l] = maps[a].end->getSize();
 					}
-					mapentry = mapentry->nextEntry();
 				}
 			}
+		}
+
+		// Patch all maps
+		Parallel::forEach(tasks.size(), [&](unsigned index) { runMapPatchTask(tasks[index], patch); });
+
+		// Apply all changes as a single batch update
+		Archive::BatchUpdate batch(archive);
+		size_t changed = 0;
+		unsigned maps_changed = 0;
+		string report = "";
+		for (auto& task : tasks)
+		{
+			if (!task.error.empty())
+			{
+				report += S_FMT("%s:\t%s\n", task.name, task.error);
+				continue;
+			}
 
-			// Did we get a map entry?
-			if (things)
+			// Write changed data back
+			if (task.map.archive)
 			{
-				switch(maps[a].format)
+				if (task.wad_changed && !task.entries[0]->importMem(task.data[0].data(), task.data[0].size()))
 				{
-				case MAP_DOOM:
-					achanged = replaceThingsDoom(things, oldtype, newtype);
-					break;
-				case MAP_HEXEN:
-					achanged = replaceThingsHexen(things, oldtype, newtype);
-					break;
-				case MAP_DOOM64:
-					achanged = replaceThingsDoom64(things, oldtype, newtype);
-					break;
-				case MAP_UDMF:
-					achanged = replaceThingsUDMF(things, oldtype, newtype);
-					break;
-				default:
-					LOG_MESSAGE(1, "Unknown map format for " + maps[a].head->getName());
-					break;
+					report += S_FMT("%s:\tUnable to write changes\n", task.name);
+					continue;
 				}
 			}
+			else
+			{
+				for (unsigned l = 0; l < MapLumps::NUM_LUMPS; l++)
+					if (task.lumps.lumps[l].changed && task.entries[l])
+						task.entries[l]->importMem(task.data[l].data(), task.data[l].size());
+			}
+
+			// Add to report
+			for (auto& result : task.results)
+			{
+				string name = task.name;
+				if (!result.first.empty())
+					name += "/" + wxString::FromAscii(result.first.c_str());
+
+				report += S_FMT("%s:\t%d %s changed\n", name, (int)result.second, what);
+				changed += result.second;
+				if (result.second > 0)
+					maps_changed++;
+			}
+		}
+
+		LOG_MESSAGE(1, "%d %s changed in %u of %u maps:\n%s", (int)changed, what, maps_changed, (unsigned)tasks.size(), report);
+		return changed;
+	}
+
+	/* patchRecords
+	 * Calls [func] on each record of type T in [lump], writing back any
+	 * records it modified (when it returns true). Returns the number of
+	 * records modified
+	 *******************************************************************/
+	template<typename T, typename F> size_t patchRecords(MapLump& lump, F func)
+	{
+		if (!lump.data)
+			return 0;
+
+		size_t changed = 0;
+		size_t count = lump.size / sizeof(T);
+		T record;
+		for (size_t a = 0; a < count; a++)
+		{
+			uint8_t* ptr = lump.data + a * sizeof(T);
+			memcpy(&record, ptr, sizeof(T));
+			if (func(record))
+			{
+				memcpy(ptr, &record, sizeof(T));
+				changed++;
+			}
 		}
-		report += S_FMT("%s:\t%i things changed\n", maps[a].head->getName(), achanged);
-		changed += achanged;
+
+		if (changed > 0)
+			lump.changed = true;
+
+		return changed;
 	}
-	LOG_MESSAGE(1, report);
+}
+
+size_t replaceThingsDoom(MapLump& lump, int oldtype, int newtype)
+{
+	return patchRecords<doomthing_t>(lump, [=](doomthing_t& thing)
+	{
+		if (thing.type != oldtype)
+			return false;
+
+		thing.type = newtype;
+		return true;
+	});
+}
+size_t replaceThingsDoom64(MapLump& lump, int oldtype, int newtype)
+{
+	return patchRecords<doom64thing_t>(lump, [=](doom64thing_t& thing)
+	{
+		if (thing.type != oldtype)
+			return false;
+
+		thing.type = newtype;
+		return true;
+	});
+}
+size_t replaceThingsHexen(MapLump& lump, int oldtype, int newtype)
+{
+	return patchRecords<hexenthing_t>(lump, [=](hexenthing_t& thing)
+	{
+		if (thing.type != oldtype)
+			return false;
+
+		thing.type = newtype;
+		return true;
+	});
+}
+size_t replaceThingsUDMF(MapLump& lump, int oldtype, int newtype)
+{
+	if (!lump.data) return 0;
+
+	size_t changed = 0;
+	// TODO: parse and replace code
 	return changed;
 }
+size_t ArchiveOperations::replaceThings(Archive* archive, int oldtype, int newtype)
+{
+	return patchMaps(archive, [=](MapLumps& map) -> size_t
+	{
+		switch (map.format)
+		{
+		case MAP_DOOM:		return replaceThingsDoom(map.things(), oldtype, newtype);
+		case MAP_HEXEN:		return replaceThingsHexen(map.things(), oldtype, newtype);
+		case MAP_DOOM64:	return replaceThingsDoom64(map.things(), oldtype, newtype);
+		case MAP_UDMF:		return replaceThingsUDMF(map.textmap(), oldtype, newtype);
+		default:			return 0;
+		}
+	}, "things");
+}
 
 CONSOLE_COMMAND(replacethings, 2, true)
 {
@@ -1099,147 +1344,61 @@ CONSOLE_COMMAND(convertmapchex2to3, 0, false)
 	}
 }
 
-size_t replaceSpecialsDoom(ArchiveEntry* entry, int oldtype, int newtype, bool tag, int oldtag, int newtag)
+size_t replaceSpecialsDoom(MapLump& lump, int oldtype, int newtype, bool tag, int oldtag, int newtag)
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numlines = size / sizeof(doomline_t);
-	size_t changed = 0;
-
-	doomline_t* lines = new doomline_t[numlines];
-	memcpy(lines, entry->getData(), size);
-
-	// Perform replacement
-	for (size_t l = 0; l < numlines; ++l)
+	return patchRecords<doomline_t>(lump, [=](doomline_t& line)
 	{
-		if (lines[l].type == oldtype)
-		{
-			if (!tag || lines[l].sector_tag == oldtag)
-			{
-				lines[l].type = newtype;
-				if (tag)
-					lines[l].sector_tag = newtag;
-				++changed;
-			}
-		}
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(lines, size);
-	delete[] lines;
-
-	return changed;
+		if (line.type != oldtype || (tag && line.sector_tag != oldtag))
+			return false;
+
+		line.type = newtype;
+		if (tag)
+			line.sector_tag = newtag;
+		return true;
+	});
 }
-size_t replaceSpecialsDoom64(ArchiveEntry* entry, int oldtype, int newtype, bool tag, int oldtag, int newtag)
+size_t replaceSpecialsDoom64(MapLump& lump, int oldtype, int newtype, bool tag, int oldtag, int newtag)
 {
 	return 0;
 }
-size_t replaceSpecialsHexen(ArchiveEntry* l_entry, ArchiveEntry* t_entry, int oldtype, int newtype,
+size_t replaceSpecialsHexen(MapLump& l_lump, MapLump& t_lump, int oldtype, int newtype,
 							bool arg0, bool arg1, bool arg2, bool arg3, bool arg4,
 							int oldarg0, int oldarg1, int oldarg2, int oldarg3, int oldarg4,
 							int newarg0, int newarg1, int newarg2, int newarg3, int newarg4)
 {
-	if (l_entry == nullptr && t_entry == nullptr)
-		return 0;
-
-	size_t size = 0;
-	size_t changed = 0;
-
-	if (l_entry)
-	{
-		size = l_entry->getSize();
-		size_t numlines = size / sizeof(hexenline_t);
-
-		hexenline_t* lines = new hexenline_t[numlines];
-		memcpy(lines, l_entry->getData(), size);
-		size_t lchanged = 0;
-
-		// Perform replacement
-		for (size_t l = 0; l < numlines; ++l)
-		{
-			if (lines[l].type == oldtype)
-			{
-				if ((!arg0 || lines[l].args[0] == oldarg0) &&
-						(!arg1 || lines[l].args[1] == oldarg1) &&
-						(!arg2 || lines[l].args[2] == oldarg2) &&
-						(!arg3 || lines[l].args[3] == oldarg3) &&
-						(!arg4 || lines[l].args[4] == oldarg4))
-				{
-					lines[l].type = newtype;
-					if (arg0) lines[l].args[0] = newarg0;
-					if (arg1) lines[l].args[1] = newarg1;
-					if (arg2) lines[l].args[2] = newarg2;
-					if (arg3) lines[l].args[3] = newarg3;
-					if (arg4) lines[l].args[4] = newarg4;
-					++lchanged;
-				}
-			}
-		}
-		// Import the changes if needed
-		if (lchanged > 0)
-		{
-			l_entry->importMem(lines, size);
-			changed += lchanged;
-		}
-		delete[] lines;
-	}
+	bool check[5] = { arg0, arg1, arg2, arg3, arg4 };
+	int oldargs[5] = { oldarg0, oldarg1, oldarg2, oldarg3, oldarg4 };
+	int newargs[5] = { newarg0, newarg1, newarg2, newarg3, newarg4 };
 
-	if (t_entry)
+	// Replaces the special and args if they match, returns true if replaced
+	auto replace = [&](uint8_t& special, uint8_t* args)
 	{
-		size = t_entry->getSize();
-		size_t numthings = size / sizeof(hexenthing_t);
-
-		hexenthing_t* things = new hexenthing_t[numthings];
-		memcpy(things, t_entry->getData(), size);
-		size_t tchanged = 0;
-
-		// Perform replacement
-		for (size_t t = 0; t < numthings; ++t)
-		{
-			if (things[t].type == oldtype)
-			{
-				if ((!arg0 || things[t].args[0] == oldarg0) &&
-						(!arg1 || things[t].args[1] == oldarg1) &&
-						(!arg2 || things[t].args[2] == oldarg2) &&
-						(!arg3 || things[t].args[3] == oldarg3) &&
-						(!arg4 || things[t].args[4] == oldarg4))
-				{
-					things[t].type = newtype;
-					if (arg0) things[t].args[0] = newarg0;
-					if (arg1) things[t].args[1] = newarg1;
-					if (arg2) things[t].args[2] = newarg2;
-					if (arg3) things[t].args[3] = newarg3;
-					if (arg4) things[t].args[4] = newarg4;
-					++tchanged;
-				}
-			}
-		}
-		// Import the changes if needed
-		if (tchanged > 0)
-		{
-			t_entry->importMem(things, size);
-			changed += tchanged;
-		}
-		delete[] things;
-	}
+		if (special != oldtype)
+			return false;
+		for (unsigned a = 0; a < 5; a++)
+			if (check[a] && args[a] != oldargs[a])
+				return false;
+
+		special = newtype;
+		for (unsigned a = 0; a < 5; a++)
+			if (check[a])
+				args[a] = newargs[a];
+		return true;
+	};
 
+	size_t changed = patchRecords<hexenline_t>(l_lump, [&](hexenline_t& line) { return replace(line.type, line.args); });
+	changed += patchRecords<hexenthing_t>(t_lump, [&](hexenthing_t& thing) { return replace(thing.special, thing.args); });
 	return changed;
 }
-size_t replaceSpecialsUDMF(ArchiveEntry* entry, int oldtype, int newtype,
+size_t replaceSpecialsUDMF(MapLump& lump, int oldtype, int newtype,
 						   bool arg0, bool arg1, bool arg2, bool arg3, bool arg4,
 						   int oldarg0, int oldarg1, int oldarg2, int oldarg3, int oldarg4,
 						   int newarg0, int newarg1, int newarg2, int newarg3, int newarg4)
 {
-	if (entry == nullptr) return 0;
+	if (!lump.data) return 0;
 
 	size_t changed = 0;
 	// TODO: parse and replace code
-	// Import the changes if needed
-	if (changed > 0)
-	{
-		//entry->importMemChunk(mc);
-	}
 	return changed;
 }
 size_t ArchiveOperations::replaceSpecials(Archive* archive, int oldtype, int newtype, bool lines, bool things,
@@ -1249,118 +1408,34 @@ size_t ArchiveOperations::replaceSpecials(Archive* archive, int oldtype, int new
 		bool arg3, int oldarg3, int newarg3,
 		bool arg4, int oldarg4, int newarg4)
 {
-	size_t changed = 0;
-	// Check archive was given
-	if (!archive)
-		return changed;
-
-	// Get all maps
-	vector<Archive::MapDesc> maps = archive->detectMaps();
-	string report = "";
-
-	for (size_t a = 0; a < maps.size(); ++a)
+	return patchMaps(archive, [=](MapLumps& map) -> size_t
 	{
-		size_t achanged = 0;
-		// Is it an embedded wad?
-		if (maps[a].archive)
-		{
-			// Attempt to open entry as wad archive
-			Archive* temp_archive = new WadArchive();
-			if (temp_archive->open(maps[a].head))
-			{
-				achanged = ArchiveOperations::replaceSpecials(temp_archive, oldtype, newtype, lines, things,
-						   arg0, oldarg0, newarg0, arg1, oldarg1, newarg1, arg2, oldarg2, newarg2, arg3, oldarg3, newarg3, arg4, oldarg4, newarg4);
-				MemChunk mc;
-				if (!(temp_archive->write(mc, true)))
-				{
-					achanged = 0;
-				}
-				else
-				{
-					temp_archive->close();
-					if (!(maps[a].head->importMemChunk(mc)))
-					{
-						achanged = 0;
-					}
-				}
-			}
+		MapLump none;
+		MapLump& l_lump = lines ? map.linedefs() : none;
+		MapLump& t_lump = things ? map.things() : none;
 
-			// Cleanup
-			delete temp_archive;
-
-		}
-		else
+		switch (map.format)
 		{
-			// Find the map entry to modify
-			ArchiveEntry* mapentry = maps[a].head;
-			ArchiveEntry* t_entry = nullptr;
-			ArchiveEntry* l_entry = nullptr;
-			if (maps[a].format == MAP_DOOM || maps[a].format == MAP_DOOM64 || maps[a].format == MAP_HEXEN)
-			{
-				while (mapentry && mapentry != maps[a].end)
-				{
-					if (things && mapentry->getType() == EntryType::fromId("map_things"))
-					{
-						t_entry = mapentry;
-						if (l_entry || !lines) break;
-					}
-					if (lines && mapentry->getType() == EntryType::fromId("map_linedefs"))
-					{
-						l_entry = mapentry;
-						if (t_entry || !things) break;
-					}
-					mapentry = mapentry->nextEntry();
-				}
-			}
-			else if (maps[a].format == MAP_UDMF)
-			{
-				while (mapentry && mapentry != maps[a].end)
-				{
-					if (mapentry->getType() == EntryType::fromId("udmf_textmap"))
-					{
-						l_entry = t_entry = mapentry;
-						break;
-					}
-					mapentry = mapentry->nextEntry();
-				}
-			}
-
-			// Did we get a map entry?
-			if (l_entry || t_entry)
-			{
-				switch(maps[a].format)
-				{
-				case MAP_DOOM:
-					if (arg1 || arg2 || arg3 || arg4) // Do nothing if Hexen specials are being modified
-						break;
-					achanged = replaceSpecialsDoom(l_entry, oldtype, newtype, arg0, oldarg0, newarg0);
-					break;
-				case MAP_HEXEN:
-					if (oldtype > 255 || newtype > 255) // Do nothing if Doom specials are being modified
-						break;
-					achanged = replaceSpecialsHexen(l_entry, t_entry, oldtype, newtype, arg0, arg1, arg2, arg3, arg4,
-													oldarg0, oldarg1, oldarg2, oldarg3, oldarg4, newarg0, newarg1, newarg2, newarg3, newarg4);
-					break;
-				case MAP_DOOM64:
-					if (arg1 || arg2 || arg3 || arg4) // Do nothing if Hexen specials are being modified
-						break;
-					achanged = replaceSpecialsDoom64(l_entry, oldtype, newtype, arg0, oldarg0, newarg0);
-					break;
-				case MAP_UDMF:
-					achanged = replaceSpecialsUDMF(l_entry, oldtype, newtype, arg0, arg1, arg2, arg3, arg4,
-												   oldarg0, oldarg1, oldarg2, oldarg3, oldarg4, newarg0, newarg1, newarg2, newarg3, newarg4);
-					break;
-				default:
-					LOG_MESSAGE(1, "Unknown map format for " + maps[a].head->getName());
-					break;
-				}
-			}
+		case MAP_DOOM:
+			if (arg1 || arg2 || arg3 || arg4) // Do nothing if Hexen specials are being modified
+				return 0;
+			return replaceSpecialsDoom(l_lump, oldtype, newtype, arg0, oldarg0, newarg0);
+		case MAP_HEXEN:
+			if (oldtype > 255 || newtype > 255) // Do nothing if Doom specials are being modified
+				return 0;
+			return replaceSpecialsHexen(l_lump, t_lump, oldtype, newtype, arg0, arg1, arg2, arg3, arg4,
+										oldarg0, oldarg1, oldarg2, oldarg3, oldarg4, newarg0, newarg1, newarg2, newarg3, newarg4);
+		case MAP_DOOM64:
+			if (arg1 || arg2 || arg3 || arg4) // Do nothing if Hexen specials are being modified
+				return 0;
+			return replaceSpecialsDoom64(l_lump, oldtype, newtype, arg0, oldarg0, newarg0);
+		case MAP_UDMF:
+			return replaceSpecialsUDMF(map.textmap(), oldtype, newtype, arg0, arg1, arg2, arg3, arg4,
+									   oldarg0, oldarg1, oldarg2, oldarg3, oldarg4, newarg0, newarg1, newarg2, newarg3, newarg4);
+		default:
+			return 0;
 		}
-		report += S_FMT("%s:\t%i specials changed\n", maps[a].head->getName(), achanged);
-		changed += achanged;
-	}
-	LOG_MESSAGE(1, report);
-	return changed;
+	}, "specials");
 }
 
 CONSOLE_COMMAND(replacespecials, 2, true)
@@ -1405,10 +1480,10 @@ CONSOLE_COMMAND(replacespecials, 2, true)
 	}
 }
 
-bool replaceTextureString(char* str, string oldtex, string newtex)
+bool replaceTextureString(char* str, const std::string& oldtex, const std::string& newtex)
 {
 	bool go = true;
-	for (unsigned c = 0; c < oldtex.Length(); ++c)
+	for (unsigned c = 0; c < oldtex.size(); ++c)
 	{
 		if (str[c] != oldtex[c] && oldtex[c] != '?' && oldtex[c] != '*')
 			go = false;
@@ -1419,7 +1494,7 @@ bool replaceTextureString(char* str, string oldtex, string newtex)
 	{
 		for (unsigned i = 0; i < 8; ++i)
 		{
-			if (i < newtex.Len())
+			if (i < newtex.size())
 			{
 				// Keep the rest of the name as-is?
 				if (newtex[i] == '*') break;
@@ -1434,276 +1509,109 @@ bool replaceTextureString(char* str, string oldtex, string newtex)
 	}
 	return go;
 }
-size_t replaceFlatsDoomHexen(ArchiveEntry* entry, string oldtex, string newtex, bool floor, bool ceiling)
+size_t replaceFlatsDoomHexen(MapLump& lump, const std::string& oldtex, const std::string& newtex, bool floor, bool ceiling)
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numsectors = size / sizeof(doomsector_t);
-	bool fchanged, cchanged;
-	size_t changed = 0;
-
-	doomsector_t* sectors = new doomsector_t[numsectors];
-	memcpy(sectors, entry->getData(), size);
-
-	// Perform replacement
-	for (size_t s = 0; s < numsectors; ++s)
+	return patchRecords<doomsector_t>(lump, [&](doomsector_t& sector)
 	{
-		fchanged = cchanged = false;
-		if (floor)
-			fchanged = replaceTextureString(sectors[s].f_tex, oldtex, newtex);
-		if (ceiling)
-			cchanged = replaceTextureString(sectors[s].c_tex, oldtex, newtex);
-		if (fchanged || cchanged)
-			++changed;
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(sectors, size);
-	delete[] sectors;
-
-	return changed;
+		bool fchanged = floor && replaceTextureString(sector.f_tex, oldtex, newtex);
+		bool cchanged = ceiling && replaceTextureString(sector.c_tex, oldtex, newtex);
+		return fchanged || cchanged;
+	});
 }
-size_t replaceWallsDoomHexen(ArchiveEntry* entry, string oldtex, string newtex, bool lower, bool middle, bool upper)
+size_t replaceWallsDoomHexen(MapLump& lump, const std::string& oldtex, const std::string& newtex, bool lower, bool middle, bool upper)
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numsides = size / sizeof(doomside_t);
-	bool lchanged, mchanged, uchanged;
-	size_t changed = 0;
-
-	doomside_t* sides = new doomside_t[numsides];
-	memcpy(sides, entry->getData(), size);
-	char compare[9]; compare[8] = 0;
-
-	// Perform replacement
-	for (size_t s = 0; s < numsides; ++s)
+	return patchRecords<doomside_t>(lump, [&](doomside_t& side)
 	{
-		lchanged = mchanged = uchanged = false;
-		if (lower)
-			lchanged = replaceTextureString(sides[s].tex_lower, oldtex, newtex);
-		if (middle)
-			mchanged = replaceTextureString(sides[s].tex_middle, oldtex, newtex);
-		if (upper)
-			uchanged = replaceTextureString(sides[s].tex_upper, oldtex, newtex);
-		if (lchanged || mchanged || uchanged)
-			++changed;
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(sides, size);
-	delete[] sides;
-
-	return changed;
+		bool lchanged = lower && replaceTextureString(side.tex_lower, oldtex, newtex);
+		bool mchanged = middle && replaceTextureString(side.tex_middle, oldtex, newtex);
+		bool uchanged = upper && replaceTextureString(side.tex_upper, oldtex, newtex);
+		return lchanged || mchanged || uchanged;
+	});
 }
-size_t replaceFlatsDoom64(ArchiveEntry* entry, string oldtex, string newtex, bool floor, bool ceiling)
+size_t replaceFlatsDoom64(MapLump& lump, uint16_t oldhash, uint16_t newhash, bool floor, bool ceiling)
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numsectors = size / sizeof(doom64sector_t);
-	bool fchanged, cchanged;
-	size_t changed = 0;
-
-	uint16_t oldhash = theResourceManager->getTextureHash(oldtex);
-	uint16_t newhash = theResourceManager->getTextureHash(newtex);
-
-	doom64sector_t* sectors = new doom64sector_t[numsectors];
-	memcpy(sectors, entry->getData(), size);
-
-	// Perform replacement
-	for (size_t s = 0; s < numsectors; ++s)
+	return patchRecords<doom64sector_t>(lump, [=](doom64sector_t& sector)
 	{
-		fchanged = cchanged = false;
-		if (floor && oldhash == sectors[s].f_tex)
+		bool fchanged = false, cchanged = false;
+		if (floor && oldhash == sector.f_tex)
 		{
-			sectors[s].f_tex = newhash;
+			sector.f_tex = newhash;
 			fchanged = true;
 		}
-		if (ceiling && oldhash == sectors[s].c_tex)
+		if (ceiling && oldhash == sector.c_tex)
 		{
-			sectors[s].c_tex = newhash;
+			sector.c_tex = newhash;
 			cchanged = true;
 		}
-		if (fchanged || cchanged)
-			++changed;
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(sectors, size);
-	delete[] sectors;
-
-	return changed;
+		return fchanged || cchanged;
+	});
 }
-size_t replaceWallsDoom64(ArchiveEntry* entry, string oldtex, string newtex, bool lower, bool middle, bool upper)
+size_t replaceWallsDoom64(MapLump& lump, uint16_t oldhash, uint16_t newhash, bool lower, bool middle, bool upper)
 {
-	if (entry == nullptr) return 0;
-
-	size_t size = entry->getSize();
-	size_t numsides = size / sizeof(doom64side_t);
-	bool lchanged, mchanged, uchanged;
-	size_t changed = 0;
-
-	uint16_t oldhash = theResourceManager->getTextureHash(oldtex);
-	uint16_t newhash = theResourceManager->getTextureHash(newtex);
-
-	doom64side_t* sides = new doom64side_t[numsides];
-	memcpy(sides, entry->getData(), size);
-
-	// Perform replacement
-	for (size_t s = 0; s < numsides; ++s)
+	return patchRecords<doom64side_t>(lump, [=](doom64side_t& side)
 	{
-		lchanged = mchanged = uchanged = false;
-		if (lower && oldhash == sides[s].tex_lower)
+		bool lchanged = false, mchanged = false, uchanged = false;
+		if (lower && oldhash == side.tex_lower)
 		{
-			sides[s].tex_lower = newhash;
+			side.tex_lower = newhash;
 			lchanged = true;
 		}
-		if (middle && oldhash == sides[s].tex_middle)
+		if (middle && oldhash == side.tex_middle)
 		{
-			sides[s].tex_middle = newhash;
+			side.tex_middle = newhash;
 			mchanged = true;
 		}
-		if (upper && oldhash == sides[s].tex_upper)
+		if (upper && oldhash == side.tex_upper)
 		{
-			sides[s].tex_upper = newhash;
+			side.tex_upper = newhash;
 			uchanged = true;
 		}
-		if (lchanged || mchanged || uchanged)
-			++changed;
-	}
-	// Import the changes if needed
-	if (changed > 0)
-		entry->importMem(sides, size);
-	delete[] sides;
-
-	return changed;
+		return lchanged || mchanged || uchanged;
+	});
 }
-size_t replaceTexturesUDMF(ArchiveEntry* entry, string oldtex, string newtex, bool floor, bool ceiling, bool lower, bool middle, bool upper)
+size_t replaceTexturesUDMF(MapLump& lump, const std::string& oldtex, const std::string& newtex, bool floor, bool ceiling, bool lower, bool middle, bool upper)
 {
-	if (entry == nullptr) return 0;
+	if (!lump.data) return 0;
 
 	size_t changed = 0;
 	// TODO: parse and replace code
-	// Import the changes if needed
-	if (changed > 0)
-	{
-		//entry->importMemChunk(mc);
-	}
 	return changed;
 }
 size_t ArchiveOperations::replaceTextures(Archive* archive, string oldtex, string newtex, bool floor, bool ceiling, bool lower, bool middle, bool upper)
 {
-	size_t changed = 0;
-	// Check archive was given
-	if (!archive)
-		return changed;
-
-	// Get all maps
-	vector<Archive::MapDesc> maps = archive->detectMaps();
-	string report = "";
+	// Texture names and hashes are worked out here, as the maps are
+	// patched on worker threads
+	std::string oldname = oldtex.ToStdString();
+	std::string newname = newtex.ToStdString();
+	uint16_t oldhash = theResourceManager->getTextureHash(oldtex);
+	uint16_t newhash = theResourceManager->getTextureHash(newtex);
 
-	for (size_t a = 0; a < maps.size(); ++a)
+	return patchMaps(archive, [=](MapLumps& map) -> size_t
 	{
-		size_t achanged = 0;
-		// Is it an embedded wad?
-		if (maps[a].archive)
-		{
-			// Attempt to open entry as wad archive
-			Archive* temp_archive = new WadArchive();
-			if (temp_archive->open(maps[a].head))
-			{
-				achanged = ArchiveOperations::replaceTextures(temp_archive, oldtex, newtex, floor, ceiling, lower, middle, upper);
-				MemChunk mc;
-				if (!(temp_archive->write(mc, true)))
-				{
-					achanged = 0;
-				}
-				else
-				{
-					temp_archive->close();
-					if (!(maps[a].head->importMemChunk(mc)))
-					{
-						achanged = 0;
-					}
-				}
-			}
-
-			// Cleanup
-			delete temp_archive;
-
-		}
-		else
+		size_t changed = 0;
+		switch (map.format)
 		{
-			// Find the map entry to modify
-			ArchiveEntry* mapentry = maps[a].head;
-			ArchiveEntry* sectors = nullptr;
-			ArchiveEntry* sides = nullptr;
-			if (maps[a].format == MAP_DOOM || maps[a].format == MAP_DOOM64 || maps[a].format == MAP_HEXEN)
-			{
-				while (mapentry && mapentry != maps[a].end)
-				{
-					if ((floor || ceiling) && (mapentry->getType() == EntryType::fromId("map_sectors")))
-					{
-						sectors = mapentry;
-						if (sides || !(lower || middle || upper)) break;
-					}
-					if ((lower || middle || upper) && (mapentry->getType() == EntryType::fromId("map_sidedefs")))
-					{
-						sides = mapentry;
-						if (sectors || !(floor || ceiling)) break;
-					}
-					mapentry = mapentry->nextEntry();
-				}
-			}
-			else if (maps[a].format == MAP_UDMF)
-			{
-				while (mapentry && mapentry != maps[a].end)
-				{
-					if (mapentry->getType() == EntryType::fromId("udmf_textmap"))
-					{
-						sectors = sides = mapentry;
-						break;
-					}
-					mapentry = mapentry->nextEntry();
-				}
-			}
-
-			// Did we get a map entry?
-			if (sectors || sides)
-			{
-				switch(maps[a].format)
-				{
-				case MAP_DOOM:
-				case MAP_HEXEN:
-					achanged = 0;
-					if (sectors)
-						achanged += replaceFlatsDoomHexen(sectors, oldtex, newtex, floor, ceiling);
-					if (sides)
-						achanged += replaceWallsDoomHexen(sides, oldtex, newtex, lower, middle, upper);
-					break;
-				case MAP_DOOM64:
-					achanged = 0;
-					if (sectors)
-						achanged += replaceFlatsDoom64(sectors, oldtex, newtex, floor, ceiling);
-					if (sides)
-						achanged += replaceWallsDoom64(sides, oldtex, newtex, lower, middle, upper);
-					break;
-				case MAP_UDMF:
-					achanged = replaceTexturesUDMF(sectors, oldtex, newtex, floor, ceiling, lower, middle, upper);
-					break;
-				default:
-					LOG_MESSAGE(1, "Unknown map format for " + maps[a].head->getName());
-					break;
-				}
-			}
+		case MAP_DOOM:
+		case MAP_HEXEN:
+			if (floor || ceiling)
+				changed += replaceFlatsDoomHexen(map.sectors(), oldname, newname, floor, ceiling);
+			if (lower || middle || upper)
+				changed += replaceWallsDoomHexen(map.sidedefs(), oldname, newname, lower, middle, upper);
+			break;
+		case MAP_DOOM64:
+			if (floor || ceiling)
+				changed += replaceFlatsDoom64(map.sectors(), oldhash, newhash, floor, ceiling);
+			if (lower || middle || upper)
+				changed += replaceWallsDoom64(map.sidedefs(), oldhash, newhash, lower, middle, upper);
+			break;
+		case MAP_UDMF:
+			changed = replaceTexturesUDMF(map.textmap(), oldname, newname, floor, ceiling, lower, middle, upper);
+			break;
+		default:
+			break;
 		}
-		report += S_FMT("%s:\t%i elements changed\n", maps[a].head->getName(), achanged);
-		changed += achanged;
-	}
-	LOG_MESSAGE(1, report);
-	return changed;
+		return changed;
+	}, "elements");
 }
 
 CONSOLE_COMMAND(replacetextures, 2, true)
@@ -112,8 +112,6 @@ namespace Conversions
 	uint8_t pcm24to8bits(int32_t val);
 	uint8_t pcm32to8bits(int32_t val);
 	uint8_t stereoToMono(uint8_t left, uint8_t right);
-	int16_t AlawToLinear(uint8_t alaw);
-	int16_t mulawToLinear(uint8_t ulaw);
 }
 
 /* Conversions::doomSndToWav
@@ -19,6 +19,8 @@ namespace Conversions
 	bool	gmidToMidi(MemChunk& in, MemChunk& out);
 	bool	rmidToMidi(MemChunk& in, MemChunk& out);
 	bool	addImfHeader(MemChunk& in, MemChunk& out);
+	int16_t	AlawToLinear(uint8_t alaw);
+	int16_t	mulawToLinear(uint8_t ulaw);
 };
 
 #endif//__CONVERSIONS_H__
@@ -43,6 +43,7 @@
 #include "Dialogs/ModifyOffsetsDialog.h"
 #include "UI/PaletteChooser.h"
 #include "App.h"
+#include "Graphics/PNGOptimizer.h"
 
 
 /*******************************************************************
@@ -50,9 +51,6 @@
  *******************************************************************/
 CVAR(String, path_acc, "", CVAR_SAVE);
 CVAR(String, path_acc_libs, "", CVAR_SAVE);
-CVAR(String, path_pngout, "", CVAR_SAVE);
-CVAR(String, path_pngcrush, "", CVAR_SAVE);
-CVAR(String, path_deflopt, "", CVAR_SAVE);
 CVAR(String, path_db2, "", CVAR_SAVE)
 CVAR(Bool, acc_always_show_output, false, CVAR_SAVE);
 
@@ -1408,7 +1406,9 @@ bool EntryOperations::exportAsPNG(ArchiveEntry* entry, string filename)
 }
 
 /* EntryOperations::optimizePNG
- * Attempts to optimize [entry] using external PNG optimizers.
+ * Losslessly recompresses the PNG data in [entry] (see PNGOptimizer),
+ * keeping any grAb/alPh chunks. Returns false if the entry is not a
+ * valid PNG, true otherwise (even if it couldn't be made smaller)
  *******************************************************************/
 bool EntryOperations::optimizePNG(ArchiveEntry* entry)
 {
@@ -1427,184 +1427,16 @@ bool EntryOperations::optimizePNG(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Check if the PNG tools path are set up, at least one of them should be
-	string pngpathc = path_pngcrush;
-	string pngpatho = path_pngout;
-	string pngpathd = path_deflopt;
-	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) &&
-	        (pngpatho.IsEmpty() || !wxFileExists(pngpatho)) &&
-	        (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
-	{
-		LOG_MESSAGE(1, "PNG tool paths not defined or invalid, no optimization done.");
-		return false;
-	}
-
-	// Save special chunks
-	point2_t offsets;
-	bool alphchunk = getalPhChunk(entry);
-	bool grabchunk = readgrAbChunk(entry, offsets);
-	string errormessages = "";
-	wxArrayString output;
-	wxArrayString errors;
+	// Optimize
+	MemChunk optimized;
 	size_t oldsize = entry->getSize();
-	size_t crushsize = 0, outsize = 0, deflsize = 0;
-	bool crushed = false, outed = false;
-
-	// Run PNGCrush
-	if (!pngpathc.IsEmpty() && wxFileExists(pngpathc))
-	{
-		wxFileName fn(pngpathc);
-		fn.SetExt("opt");
-		string pngfile = fn.GetFullPath();
-		fn.SetExt("png");
-		string optfile = fn.GetFullPath();
-		entry->exportFile(pngfile);
-
-		string command = path_pngcrush + " -brute \"" + pngfile + "\" \"" + optfile + "\"";
-		output.Empty(); errors.Empty();
-		wxExecute(command, output, errors, wxEXEC_SYNC);
-
-		if (wxFileExists(optfile))
-		{
-			if (optfile.size() < oldsize)
-			{
-				entry->importFile(optfile);
-				wxRemoveFile(optfile);
-				wxRemoveFile(pngfile);
-			}
-			else errormessages += "PNGCrush failed to reduce file size further.\n";
-			crushed = true;
-		}
-		else errormessages += "PNGCrush failed to create optimized file.\n";
-		crushsize = entry->getSize();
-
-		// send app output to console if wanted
-		if (0)
-		{
-			string crushlog = "";
-			if (errors.GetCount())
-			{
-				crushlog += "PNGCrush error messages:\n";
-				for (size_t i = 0; i < errors.GetCount(); ++i)
-					crushlog += errors[i] + "\n";
-				errormessages += crushlog;
-			}
-			if (output.GetCount())
-			{
-				crushlog += "PNGCrush output messages:\n";
-				for (size_t i = 0; i < output.GetCount(); ++i)
-					crushlog += output[i] + "\n";
-			}
-			LOG_MESSAGE(1, crushlog);
-		}
-	}
-
-	// Run PNGOut
-	if (!pngpatho.IsEmpty() && wxFileExists(pngpatho))
-	{
-		wxFileName fn(pngpatho);
-		fn.SetExt("opt");
-		string pngfile = fn.GetFullPath();
-		fn.SetExt("png");
-		string optfile = fn.GetFullPath();
-		entry->exportFile(pngfile);
-
-		string command = path_pngout + " /y \"" + pngfile + "\" \"" + optfile + "\"";
-		output.Empty(); errors.Empty();
-		wxExecute(command, output, errors, wxEXEC_SYNC);
-
-		if (wxFileExists(optfile))
-		{
-			if (optfile.size() < oldsize)
-			{
-				entry->importFile(optfile);
-				wxRemoveFile(optfile);
-				wxRemoveFile(pngfile);
-			}
-			else errormessages += "PNGout failed to reduce file size further.\n";
-			outed = true;
-		}
-		else if (!crushed)
-			// Don't treat it as an error if PNGout couldn't create a smaller file than PNGCrush
-			errormessages += "PNGout failed to create optimized file.\n";
-		outsize = entry->getSize();
-
-		// send app output to console if wanted
-		if (0)
-		{
-			string pngoutlog = "";
-			if (errors.GetCount())
-			{
-				pngoutlog += "PNGOut error messages:\n";
-				for (size_t i = 0; i < errors.GetCount(); ++i)
-					pngoutlog += errors[i] + "\n";
-				errormessages += pngoutlog;
-			}
-			if (output.GetCount())
-			{
-				pngoutlog += "PNGOut output messages:\n";
-				for (size_t i = 0; i < output.GetCount(); ++i)
-					pngoutlog += output[i] + "\n";
-			}
-			LOG_MESSAGE(1, pngoutlog);
-		}
-	}
-
-	// Run deflopt
-	if (!pngpathd.IsEmpty() && wxFileExists(pngpathd))
-	{
-		wxFileName fn(pngpathd);
-		fn.SetExt("png");
-		string pngfile = fn.GetFullPath();
-		entry->exportFile(pngfile);
-
-		string command = path_deflopt + " /sf \"" + pngfile + "\"";
-		output.Empty(); errors.Empty();
-		wxExecute(command, output, errors, wxEXEC_SYNC);
-
-		entry->importFile(pngfile);
-		wxRemoveFile(pngfile);
-		deflsize = entry->getSize();
-
-		// send app output to console if wanted
-		if (0)
-		{
-			string defloptlog = "";
-			if (errors.GetCount())
-			{
-				defloptlog += "DeflOpt error messages:\n";
-				for (size_t i = 0; i < errors.GetCount(); ++i)
-					defloptlog += errors[i] + "\n";
-				errormessages += defloptlog;
-			}
-			if (output.GetCount())
-			{
-				defloptlog += "DeflOpt output messages:\n";
-				for (size_t i = 0; i < output.GetCount(); ++i)
-					defloptlog += output[i] + "\n";
-			}
-			LOG_MESSAGE(1, defloptlog);
-		}
-	}
-	output.Clear(); errors.Clear();
-
-	// Rewrite special chunks
-	if (alphchunk) modifyalPhChunk(entry, true);
-	if (grabchunk) setGfxOffsets(entry, offsets.x, offsets.y);
-
-	LOG_MESSAGE(1, "PNG %s size %i =PNGCrush=> %i =PNGout=> %i =DeflOpt=> %i =+grAb/alPh=> %i",
-	             entry->getName(), oldsize, crushsize, outsize, deflsize, entry->getSize());
-
-
-	if (!crushed && !outed && !errormessages.IsEmpty())
+	if (PNGOptimizer::optimize(entry->getMCData(), optimized))
 	{
-		ExtMessageDialog dlg(nullptr, "Optimizing Report");
-		dlg.setMessage("The following issues were encountered while optimizing:");
-		dlg.setExt(errormessages);
-		dlg.ShowModal();
-
-		return false;
+		entry->importMemChunk(optimized);
+		LOG_MESSAGE(1, "PNG %s size %i => %i", entry->getName(), oldsize, entry->getSize());
 	}
+	else
+		LOG_MESSAGE(1, "PNG %s could not be made any smaller", entry->getName());
 
 	return true;
 }
@@ -96,15 +96,17 @@ public:
 		return ok;
 	}
 
-	void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+	void onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override
 	{
+		static const Announcement::Id entry_removed = Announcement::id("entry_removed");
+
 		if (announcer != entry->getParent())
 			return;
 
 		bool finished = false;
 
 		// Entry removed
-		if (event_name == "entry_removed")
+		if (event == entry_removed)
 		{
 			int index;
 			wxUIntPtr ptr;
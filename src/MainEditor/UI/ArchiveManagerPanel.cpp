@@ -35,6 +35,7 @@
 #include "ArchiveManagerPanel.h"
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/DirArchive.h"
+#include "Archive/Formats/DirArchiveWatcher.h"
 #include "ArchivePanel.h"
 #include "Dialogs/DirArchiveUpdateDialog.h"
 #include "EntryPanel/EntryPanel.h"
@@ -79,12 +80,14 @@ wxDEFINE_EVENT(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED, wxThreadEvent);
 //
 // DirArchiveCheck class constructor
 // ----------------------------------------------------------------------------
-DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive)
+DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive) :
+	full_check_{ true }
 {
 	this->handler_ = handler;
 	dir_path_ = archive->filename();
-	removed_files_ = archive->removedFiles();
 	change_list_.archive = archive;
+	for (auto& path : archive->removedFiles())
+		removed_files_[path] = 0;
 
 	// Get flat entry list
 	vector<ArchiveEntry*> entries;
@@ -98,8 +101,17 @@ DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive)
 		inf.entry_path = entries[a]->getPath(true);
 		inf.is_dir = (entries[a]->getType() == EntryType::folderType());
 		inf.file_modified = archive->fileModificationTime(entries[a]);
+		entry_index_.emplace(inf.file_path, entry_info_.size());
 		entry_info_.push_back(inf);
 	}
+
+	// Get changed paths from the archive's watcher, if it's able to track them
+	if (archive->watcher())
+		full_check_ = !archive->watcher()->takeChanges(changed_paths_);
+	if (full_check_)
+		LOG_MESSAGE(2, "Rescanning %s", CHR(dir_path_));
+	else
+		LOG_MESSAGE(2, "%d changed paths in %s", (int)changed_paths_.size(), CHR(dir_path_));
 }
 
 // ----------------------------------------------------------------------------
@@ -123,11 +135,11 @@ void DirArchiveCheck::addChange(DirEntryChange change)
 }
 
 // ----------------------------------------------------------------------------
-// DirArchiveCheck::Entry
+// DirArchiveCheck::checkAll
 //
-// DirArchiveCheck thread entry function
+// Rescans the whole directory for changes
 // ----------------------------------------------------------------------------
-wxThread::ExitCode DirArchiveCheck::Entry()
+void DirArchiveCheck::checkAll()
 {
 	// Get current directory structure
 	vector<string> files, dirs;
@@ -136,6 +148,11 @@ wxThread::ExitCode DirArchiveCheck::Entry()
 	dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
 
 	// Check for deleted files
+	PathMap on_disk;
+	for (auto& path : files)
+		on_disk[path] = 0;
+	for (auto& path : dirs)
+		on_disk[path] = 1;
 	for (unsigned a = 0; a < entry_info_.size(); a++)
 	{
 		string path = entry_info_[a].file_path;
@@ -144,14 +161,19 @@ wxThread::ExitCode DirArchiveCheck::Entry()
 		if (path.IsEmpty())
 			continue;
 
+		// Check the traversal results first (the traversal skips hidden files,
+		// so check the file system directly for anything not found)
+		auto found = on_disk.find(path);
 		if (entry_info_[a].is_dir)
 		{
-			if (!wxDirExists(path))
+			bool exists = found != on_disk.end() ? found->second == 1 : wxDirExists(path);
+			if (!exists)
 				addChange(DirEntryChange(DirEntryChange::DELETED_DIR, path, entry_info_[a].entry_path));
 		}
 		else
 		{
-			if (!wxFileExists(path))
+			bool exists = found != on_disk.end() ? found->second == 0 : wxFileExists(path);
+			if (!exists)
 				addChange(DirEntryChange(DirEntryChange::DELETED_FILE, path, entry_info_[a].entry_path));
 		}
 	}
@@ -160,57 +182,100 @@ wxThread::ExitCode DirArchiveCheck::Entry()
 	for (unsigned a = 0; a < files.size(); a++)
 	{
 		// Ignore files removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, files[a]))
+		if (removed_files_.count(files[a]))
 			continue;
 
 		// Find file in archive
-		EntryInfo inf;
-		bool found = false;
-		for (unsigned b = 0; b < entry_info_.size(); b++)
-		{
-			if (entry_info_[b].file_path == files[a])
-			{
-				inf = entry_info_[b];
-				found = true;
-				break;
-			}
-		}
+		auto found = entry_index_.find(files[a]);
 
 		time_t mod = wxFileModificationTime(files[a]);
 		// No match, added to archive
-		if (!found)
+		if (found == entry_index_.end())
 			addChange(DirEntryChange(DirEntryChange::ADDED_FILE, files[a], "", mod));
 		// Matched, check modification time
-		else if (mod > inf.file_modified)
-			addChange(DirEntryChange(DirEntryChange::UPDATED, files[a], inf.entry_path, mod));
+		else if (mod > entry_info_[found->second].file_modified)
+			addChange(DirEntryChange(DirEntryChange::UPDATED, files[a], entry_info_[found->second].entry_path, mod));
 	}
 
 	// Check for new dirs
 	for (unsigned a = 0; a < dirs.size(); a++)
 	{
 		// Ignore dirs removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, dirs[a]))
+		if (removed_files_.count(dirs[a]))
 			continue;
 
-		// Find dir in archive
-		EntryInfo inf;
-		bool found = false;
-		for (unsigned b = 0; b < entry_info_.size(); b++)
+		// No match, added to archive
+		if (!entry_index_.count(dirs[a]))
+			addChange(DirEntryChange(DirEntryChange::ADDED_DIR, dirs[a], "", wxDateTime::Now().GetTicks()));
+	}
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::checkChangedPaths
+//
+// Checks only the paths the archive's watcher reported as changed
+// ----------------------------------------------------------------------------
+void DirArchiveCheck::checkChangedPaths()
+{
+	vector<DirEntryChange> deleted, files, dirs;
+	for (auto& path : changed_paths_)
+	{
+		// Ignore files removed from archive since last save
+		if (removed_files_.count(path))
+			continue;
+
+		auto found = entry_index_.find(path);
+		auto info = found != entry_index_.end() ? &entry_info_[found->second] : nullptr;
+
+		// New dir
+		if (wxDirExists(path))
 		{
-			if (entry_info_[b].file_path == dirs[a])
-			{
-				inf = entry_info_[b];
-				found = true;
-				break;
-			}
+			if (!info)
+				dirs.push_back(DirEntryChange(DirEntryChange::ADDED_DIR, path, "", wxDateTime::Now().GetTicks()));
 		}
 
-		time_t mod = wxDateTime::Now().GetTicks();
-		// No match, added to archive
-		if (!found)
-			addChange(DirEntryChange(DirEntryChange::ADDED_DIR, dirs[a], "", mod));
+		// New/updated file
+		else if (wxFileExists(path))
+		{
+			time_t mod = wxFileModificationTime(path);
+			if (!info)
+				files.push_back(DirEntryChange(DirEntryChange::ADDED_FILE, path, "", mod));
+			else if (mod > info->file_modified)
+				files.push_back(DirEntryChange(DirEntryChange::UPDATED, path, info->entry_path, mod));
+		}
+
+		// Deleted file/dir
+		else if (info)
+		{
+			deleted.push_back(DirEntryChange(
+				info->is_dir ? DirEntryChange::DELETED_DIR : DirEntryChange::DELETED_FILE,
+				path,
+				info->entry_path
+			));
+		}
 	}
 
+	// Add changes in the same order as a full check
+	for (auto& change : deleted)
+		addChange(change);
+	for (auto& change : files)
+		addChange(change);
+	for (auto& change : dirs)
+		addChange(change);
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::Entry
+//
+// DirArchiveCheck thread entry function
+// ----------------------------------------------------------------------------
+wxThread::ExitCode DirArchiveCheck::Entry()
+{
+	if (full_check_)
+		checkAll();
+	else
+		checkChangedPaths();
+
 	// Send changes via event
 	wxThreadEvent* event = new wxThreadEvent(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED);
 	event->SetPayload<DirArchiveChangeList>(change_list_);
@@ -1675,17 +1740,27 @@ vector<int> ArchiveManagerPanel::getSelectedBookmarks() const
 }
 
 // ----------------------------------------------------------------------------
-// ArchiveManagerPanel::onAnnouncement
+// ArchiveManagerPanel::onAnnouncementEvent
 //
 // Called when an announcement is recieved from the Archive Manager
 // ----------------------------------------------------------------------------
-void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void ArchiveManagerPanel::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id archive_closing = Announcement::id("archive_closing");
+	static const Announcement::Id archive_closed = Announcement::id("archive_closed");
+	static const Announcement::Id archive_added = Announcement::id("archive_added");
+	static const Announcement::Id archive_opened = Announcement::id("archive_opened");
+	static const Announcement::Id archive_saved = Announcement::id("archive_saved");
+	static const Announcement::Id archive_modified = Announcement::id("archive_modified");
+	static const Announcement::Id open_tex_editor = Announcement::id("open_tex_editor");
+	static const Announcement::Id recent_files_changed = Announcement::id("recent_files_changed");
+	static const Announcement::Id bookmarks_changed = Announcement::id("bookmarks_changed");
+
 	// Reset event data for reading
 	event_data.seek(0, SEEK_SET);
 
 	// If an archive is about to be closed
-	if (event_name == "archive_closing")
+	if (event == archive_closing)
 	{
 		int32_t index = -1;
 		event_data.read(&index, 4);
@@ -1697,7 +1772,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If an archive was closed
-	if (event_name == "archive_closed")
+	if (event == archive_closed)
 	{
 		int32_t index = -1;
 		event_data.read(&index, 4);
@@ -1705,7 +1780,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If an archive was added
-	if (event_name == "archive_added")
+	if (event == archive_added)
 	{
 		int index = App::archiveManager().numArchives() - 1;
 		list_archives_->addItem(index, wxEmptyString);
@@ -1713,7 +1788,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If an archive was opened
-	if (event_name == "archive_opened")
+	if (event == archive_opened)
 	{
 		uint32_t index = -1;
 		event_data.read(&index, 4);
@@ -1721,7 +1796,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If an archive was saved
-	if (event_name == "archive_saved")
+	if (event == archive_saved)
 	{
 		int32_t index = -1;
 		event_data.read(&index, 4);
@@ -1730,7 +1805,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If an archive was modified
-	if (event_name == "archive_modified")
+	if (event == archive_modified)
 	{
 		int32_t index = -1;
 		event_data.read(&index, 4);
@@ -1739,7 +1814,7 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If a texture editor is to be opened
-	if (event_name == "open_tex_editor")
+	if (event == open_tex_editor)
 	{
 		uint32_t index = 0;
 		event_data.read(&index, 4);
@@ -1747,13 +1822,13 @@ void ArchiveManagerPanel::onAnnouncement(Announcer* announcer, string event_name
 	}
 
 	// If the recent files list has changed
-	if (event_name == "recent_files_changed")
+	if (event == recent_files_changed)
 	{
 		refreshRecentFileList();
 	}
 
 	// If the bookmarks list has changed
-	if (event_name == "bookmarks_changed")
+	if (event == bookmarks_changed)
 	{
 		refreshBookmarkList();
 	}
@@ -40,13 +40,20 @@ private:
 		time_t	file_modified;
 	};
 
+	typedef std::unordered_map<string, unsigned, wxStringHash> PathMap;
+
 	wxEvtHandler*			handler_;
 	string					dir_path_;
 	vector<EntryInfo>		entry_info_;
-	vector<string>			removed_files_;
+	PathMap					entry_index_;		// file path -> index in entry_info_
+	PathMap					removed_files_;
+	vector<string>			changed_paths_;		// Changes reported by the archive's watcher
+	bool					full_check_;		// True if the whole folder needs to be rescanned
 	DirArchiveChangeList	change_list_;
 
 	void addChange(DirEntryChange change);
+	void checkAll();
+	void checkChangedPaths();
 };
 
 class WMFileBrowser : public wxGenericDirCtrl
@@ -145,7 +152,7 @@ public:
 	vector<int>	getSelectedBookmarks() const;
 	vector<int>	getSelectedFiles() const;
 
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override;
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 
 	// Event handlers
 	void	onListArchivesChanged(wxListEvent& e);
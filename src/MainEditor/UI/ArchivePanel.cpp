@@ -58,8 +58,10 @@
 #include "General/KeyBind.h"
 #include "General/Misc.h"
 #include "General/UI.h"
+#include "Graphics/GfxConvert.h"
 #include "Graphics/Icons.h"
 #include "Graphics/Palette/PaletteManager.h"
+#include "Graphics/PNGOptimizer.h"
 #include "MainEditor/ArchiveOperations.h"
 #include "MainEditor/Conversions.h"
 #include "MainEditor/EntryOperations.h"
@@ -72,6 +74,7 @@
 #include "Utility/SFileDialog.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "Scripting/ScriptManager.h"
+#include <wx/progdlg.h>
 
 
 /*******************************************************************
@@ -85,9 +88,6 @@ CVAR(String, last_tint_colour, "RGB(255, 0, 0)", CVAR_SAVE)
 CVAR(Int, last_tint_amount, 50, CVAR_SAVE)
 CVAR(Bool, auto_entry_replace, false, CVAR_SAVE)
 CVAR(Bool, archive_build_skip_hidden, true, CVAR_SAVE)
-EXTERN_CVAR(String, path_pngout)
-EXTERN_CVAR(String, path_pngcrush)
-EXTERN_CVAR(String, path_deflopt)
 EXTERN_CVAR(Bool, confirm_entry_revert)
 wxMenu* menu_archive = nullptr;
 wxMenu* menu_entry = nullptr;
@@ -1224,7 +1224,10 @@ bool ArchivePanel::revertEntry()
 	if (selected_entries.size() == 1 &&
 		MainEditor::currentEntryPanel() &&
 		MainEditor::currentEntryPanel()->getEntry() == selected_entries[0])
+	{
+		MainEditor::currentEntryPanel()->closeEntry();
 		MainEditor::currentEntryPanel()->openEntry(selected_entries[0]);
+	}
 
 	// If the entries reverted were the only modified entries in the
 	// archive, the archive is no longer modified.
@@ -1841,34 +1844,43 @@ bool ArchivePanel::gfxConvert()
 	// Show splash window
 	UI::showSplash("Writing converted image data...", true);
 
-	// Begin recording undo level
-	undo_manager->beginRecord("Gfx Format Conversion");
-
-	// Write any changes
-	entry_list->setEntriesAutoUpdate(false);
+	// Encode converted images
+	vector<GfxConvert::Job> jobs(selection.size());
 	for (unsigned a = 0; a < selection.size(); a++)
 	{
-		if (a == selection.size()-1)
-			entry_list->setEntriesAutoUpdate(true);
-
-		// Update splash window
-		UI::setSplashProgressMessage(selection[a]->getName());
-		UI::setSplashProgress((float)a / (float)selection.size());
-
 		// Skip if the image wasn't converted
 		if (!gcd.itemModified(a))
 			continue;
 
-		// Get image and conversion info
-		SImage* image = gcd.getItemImage(a);
-		SIFormat* format = gcd.getItemFormat(a);
+		jobs[a].image.copyImage(gcd.getItemImage(a));
+		jobs[a].format = gcd.getItemFormat(a);
+		jobs[a].pal_save = gcd.getItemPalette(a);
+		jobs[a].convert = false;
+	}
+	GfxConvert::run(jobs, [](unsigned done, unsigned total)
+	{
+		UI::setSplashProgress((float)done / (float)total);
+		return true;
+	});
 
-		// Write converted image back to entry
-		MemChunk mc;
-		format->saveImage(*image, mc, gcd.getItemPalette(a));
-		selection[a]->importMemChunk(mc);
-		EntryType::detectEntryType(selection[a]);
-		selection[a]->setExtensionByType();
+	// Begin recording undo level
+	undo_manager->beginRecord("Gfx Format Conversion");
+
+	// Write any changes
+	entry_list->setEntriesAutoUpdate(false);
+	{
+		Archive::BatchUpdate batch(archive);
+		for (unsigned a = 0; a < selection.size(); a++)
+		{
+			if (!jobs[a].ok)
+				continue;
+
+			// Write converted image back to entry
+			undo_manager->recordUndoStep(new EntryDataUS(selection[a]));
+			selection[a]->importMemChunk(jobs[a].output);
+			EntryType::detectEntryType(selection[a]);
+			selection[a]->setExtensionByType();
+		}
 	}
 	entry_list->setEntriesAutoUpdate(true);
 
@@ -2529,50 +2541,75 @@ bool ArchivePanel::compileACS(bool hexen)
 }
 
 /* ArchivePanel::optimizePNG
- * Compiles any selected text entries as ACS scripts
+ * Losslessly recompresses any selected PNG entries, in parallel
  *******************************************************************/
 bool ArchivePanel::optimizePNG()
 {
-	// Check if the PNG tools path are set up, at least one of them should be
-	string pngpathc = path_pngcrush;
-	string pngpatho = path_pngout;
-	string pngpathd = path_deflopt;
-	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) &&
-	        (pngpatho.IsEmpty() || !wxFileExists(pngpatho)) &&
-	        (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
-	{
-		wxMessageBox("Error: PNG tool paths not defined or invalid, please configure in SLADE preferences", "Error", wxOK|wxCENTRE|wxICON_ERROR);
+	// Get selected PNG entries
+	vector<ArchiveEntry*> selection = entry_list->getSelectedEntries();
+	vector<ArchiveEntry*> pngs;
+	for (unsigned a = 0; a < selection.size(); a++)
+		if (selection[a]->getType()->formatId() == "img_png")
+			pngs.push_back(selection[a]);
+	if (pngs.empty())
 		return false;
-	}
 
-	// Get selected entries
-	vector<ArchiveEntry*> selection = entry_list->getSelectedEntries();
+	// Entry data must be loaded on this thread before handing it off
+	vector<const MemChunk*> in;
+	vector<MemChunk> results(pngs.size());
+	vector<MemChunk*> out;
+	for (unsigned a = 0; a < pngs.size(); a++)
+	{
+		in.push_back(&pngs[a]->getMCData());
+		out.push_back(&results[a]);
+	}
 
-	UI::showSplash("Running external programs, please wait...", true);
+	// Optimize (with cancellable progress)
+	vector<uint8_t> optimized;
+	bool completed;
+	{
+		wxProgressDialog dlg(
+			"Optimize PNG",
+			S_FMT("Optimizing %u PNG entries...", (unsigned)pngs.size()),
+			pngs.size(),
+			this,
+			wxPD_APP_MODAL|wxPD_AUTO_HIDE|wxPD_CAN_ABORT|wxPD_ELAPSED_TIME|wxPD_REMAINING_TIME
+		);
+		completed = PNGOptimizer::optimizeAll(in, out, optimized, [&](unsigned done, unsigned total)
+		{
+			return dlg.Update(done, S_FMT("Optimizing %u of %u PNG entries...", done, total));
+		});
+	}
 
-	// Begin recording undo level
+	// Apply results (entries finished before a cancel are still applied)
 	undo_manager->beginRecord("Optimize PNG");
-
-	// Go through selection
-	entry_list->setEntriesAutoUpdate(false);
-	for (unsigned a = 0; a < selection.size(); a++)
+	size_t before = 0, after = 0;
+	unsigned changed = 0;
 	{
-		if (a == selection.size()-1)
-			entry_list->setEntriesAutoUpdate(true);
-
-		UI::setSplashProgressMessage(selection[a]->getName(true));
-		UI::setSplashProgress(float(a) / float(selection.size()));
-		if (selection[a]->getType()->formatId() == "img_png")
+		Archive::BatchUpdate batch(archive);
+		for (unsigned a = 0; a < pngs.size(); a++)
 		{
-			undo_manager->recordUndoStep(new EntryDataUS(selection[a]));
-			EntryOperations::optimizePNG(selection[a]);
+			if (!optimized[a])
+				continue;
+
+			before += pngs[a]->getSize();
+			undo_manager->recordUndoStep(new EntryDataUS(pngs[a]));
+			pngs[a]->importMemChunk(results[a]);
+			after += pngs[a]->getSize();
+			changed++;
 		}
 	}
-	entry_list->setEntriesAutoUpdate(true);
-	UI::hideSplash();
-
-	// Finish recording undo level
-	undo_manager->endRecord(true);
+	undo_manager->endRecord(changed > 0);
+
+	LOG_MESSAGE(
+		1,
+		"Optimized %u of %u PNG entries%s, %llu => %llu bytes",
+		changed,
+		(unsigned)pngs.size(),
+		completed ? "" : " (cancelled)",
+		(unsigned long long)before,
+		(unsigned long long)after
+	);
 
 	return true;
 }
@@ -3205,17 +3242,24 @@ bool ArchivePanel::handleAction(string id)
 	return true;
 }
 
-/* ArchivePanel::onAnnouncement
+/* ArchivePanel::onAnnouncementEvent
  * Called when an announcement is recieved from the archive that
  * this ArchivePanel is managing
  *******************************************************************/
-void ArchivePanel::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void ArchivePanel::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id saved = Announcement::id("saved");
+	static const Announcement::Id directory_added = Announcement::id("directory_added");
+	static const Announcement::Id entry_removing = Announcement::id("entry_removing");
+
+	if (announcer != archive)
+		return;
+
 	// Reset event data for reading
 	event_data.seek(0, SEEK_SET);
 
 	// If the archive was saved
-	if (announcer == archive && event_name == "saved")
+	if (event == saved)
 	{
 		// Update this tab's name in the parent notebook (if filename was changed)
 		wxAuiNotebook* parent = (wxAuiNotebook*)GetParent();
@@ -3223,7 +3267,7 @@ void ArchivePanel::onAnnouncement(Announcer* announcer, string event_name, MemCh
 	}
 
 	// If a directory was added
-	if (announcer == archive && event_name == "directory_added")
+	if (event == directory_added)
 	{
 		// Show path controls (if they aren't already)
 		wxSizer* sizer = GetSizer();
@@ -3236,7 +3280,7 @@ void ArchivePanel::onAnnouncement(Announcer* announcer, string event_name, MemCh
 	}
 
 	// If an entry was removed
-	if (announcer == archive && event_name == "entry_removing")
+	if (event == entry_removing)
 	{
 		// Get entry pointer
 		wxUIntPtr ptr;
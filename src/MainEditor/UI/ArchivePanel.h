@@ -143,7 +143,7 @@ public:
 	bool	handleAction(string id);
 
 	// Listener
-	virtual void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 
 	// Static functions
 	static EntryPanel*	createPanelForEntry(ArchiveEntry* entry, wxWindow* parent);
@@ -33,6 +33,7 @@
 #include "AudioEntryPanel.h"
 #include "Audio/MIDIPlayer.h"
 #include "Audio/ModMusic.h"
+#include "Audio/PCMStream.h"
 #include "Audio/AudioTags.h"
 #include "Graphics/Icons.h"
 #include "MainEditor/Conversions.h"
@@ -67,12 +68,11 @@ AudioEntryPanel::AudioEntryPanel(wxWindow* parent) : EntryPanel(parent, "audio")
 {
 	// Init variables
 	timer_seek = new wxTimer(this);
-	sound_buffer = nullptr;
 	audio_type = AUTYPE_INVALID;
 	num_tracks = 1;
 	subsong = 0;
 	song_length = 0;
-	sound = new sf::Sound();
+	pcm = new PCMStream();
 	music = new sf::Music();
 	mod = new ModMusic();
 
@@ -142,7 +142,7 @@ AudioEntryPanel::AudioEntryPanel(wxWindow* parent) : EntryPanel(parent, "audio")
 	sizer_gb->Add(slider_volume, wxGBPosition(1, 8));
 
 	// Set volume
-	sound->setVolume(snd_volume);
+	pcm->setVolume(snd_volume);
 	music->setVolume(snd_volume);
 	theMIDIPlayer->setVolume(snd_volume);
 	if (media_ctrl) media_ctrl->SetVolume(snd_volume*0.01);
@@ -177,7 +177,7 @@ AudioEntryPanel::~AudioEntryPanel()
 	resetStream();
 
 	// Clean up
-	delete sound;
+	delete pcm;
 	delete music;
 	delete mod;
 }
@@ -187,16 +187,12 @@ AudioEntryPanel::~AudioEntryPanel()
  *******************************************************************/
 bool AudioEntryPanel::loadEntry(ArchiveEntry* entry)
 {
-	// Are we reopening the same entry? For example having looked at
-	// a text file or image or any other non-audio entry, then
-	// going back to the original audio entry? Then no need to do
-	// abort the current song to restart it.
-	if (this->entry == entry)
-		return true;
-
-	// Stop anything currently playing
+	// Stop anything currently playing. The streams read from the
+	// panel's copy of the entry data, which has just been reloaded,
+	// so this has to be done even when reopening the same entry
 	stopStream();
 	resetStream();
+	pcm->close();
 	opened = false;
 
 	// Enable all playback controls initially
@@ -230,6 +226,21 @@ bool AudioEntryPanel::loadEntry(ArchiveEntry* entry)
 	return true;
 }
 
+/* AudioEntryPanel::closeEntry
+ * Stops playback before the entry data being streamed goes away
+ *******************************************************************/
+void AudioEntryPanel::closeEntry()
+{
+	timer_seek->Stop();
+	stopStream();
+	resetStream();
+	pcm->close();
+	audio_data.clear();
+	opened = false;
+
+	EntryPanel::closeEntry();
+}
+
 /* AudioEntryPanel::saveEntry
  * Saves any changes to the entry (does nothing here)
  *******************************************************************/
@@ -283,6 +294,8 @@ bool AudioEntryPanel::open()
 	// Check if already opened
 	if (opened)
 		return true;
+	if (!entry)
+		return false;
 
 	// Stop if sound currently playing
 	resetStream();
@@ -290,8 +303,10 @@ bool AudioEntryPanel::open()
 	subsong = 0;
 	num_tracks = 1;
 
-	// Get entry data
-	MemChunk& mcdata = entry->getMCData();
+	// Get entry data. This is the panel's own copy of it, made when
+	// the entry was opened, so it can be streamed from directly
+	MemChunk& mcdata = entry_data;
+	audio_data.clear();
 
 	// Setup temp filename
 	wxFileName path(App::path(entry->getName(), App::Dir::Temp));
@@ -299,56 +314,54 @@ bool AudioEntryPanel::open()
 	if (path.GetExt().IsEmpty())
 		path.SetExt(entry->getType()->extension());
 
-	// Convert if necessary, then write to file
-	MemChunk convdata;
-	if (entry->getType()->formatId() == "snd_doom" ||			// Doom Sound -> WAV
-	        entry->getType()->formatId() == "snd_doom_mac")
-		Conversions::doomSndToWav(mcdata, convdata);
-	else if (entry->getType()->formatId() == "snd_speaker")	// Doom PC Speaker Sound -> WAV
+	// Convert if necessary, converted data is kept for streaming
+	string format = entry->getType()->formatId();
+	MemChunk& convdata = audio_data;
+	MemChunk* data = &convdata;
+	if (format == "snd_speaker")							// Doom PC Speaker Sound -> WAV
 		Conversions::spkSndToWav(mcdata, convdata);
-	else if (entry->getType()->formatId() == "snd_audiot")		// AudioT PC Speaker Sound -> WAV
+	else if (format == "snd_audiot")						// AudioT PC Speaker Sound -> WAV
 		Conversions::spkSndToWav(mcdata, convdata, true);
-	else if (entry->getType()->formatId() == "snd_wolf")		// Wolfenstein 3D Sound -> WAV
-		Conversions::wolfSndToWav(mcdata, convdata);
-	else if (entry->getType()->formatId() == "snd_voc")		// Creative Voice File -> WAV
-		Conversions::vocToWav(mcdata, convdata);
-	else if (entry->getType()->formatId() == "snd_jaguar")		// Jaguar Doom Sound -> WAV
-		Conversions::jagSndToWav(mcdata, convdata);
-	else if (entry->getType()->formatId() == "snd_bloodsfx")	// Blood Sound -> WAV
+	else if (format == "snd_bloodsfx")					// Blood Sound -> WAV
 		Conversions::bloodToWav(entry, convdata);
-	else if (entry->getType()->formatId() == "midi_mus")  			// MUS -> MIDI
+	else if (format == "midi_mus")  						// MUS -> MIDI
 	{
 		Conversions::musToMidi(mcdata, convdata);
 		path.SetExt("mid");
 	}
-	else if (entry->getType()->formatId() == "midi_xmi" ||  		// HMI/HMP/XMI -> MIDI
-			 entry->getType()->formatId() == "midi_hmi" || entry->getType()->formatId() == "midi_hmp")
+	else if (format == "midi_xmi" ||  					// HMI/HMP/XMI -> MIDI
+			 format == "midi_hmi" || format == "midi_hmp")
 	{
 		Conversions::zmusToMidi(mcdata, convdata, 0, &num_tracks);
 		path.SetExt("mid");
 	}
-	else if (entry->getType()->formatId() == "midi_gmid")  		// GMID -> MIDI
+	else if (format == "midi_gmid")  						// GMID -> MIDI
 	{
 		Conversions::gmidToMidi(mcdata, convdata);
 		path.SetExt("mid");
 	}
 	else
-		convdata.importMem(mcdata.getData(), mcdata.getSize());
+		data = &mcdata;
+
+	// Raw PCM sound formats (Doom, Wolf3D, Jaguar, VOC, Sun) are
+	// decoded on the fly while playing
+	if (PCMStream::canOpen(format))
+		openPCM(mcdata, format);
 
 	// MIDI format
-	if (entry->getType()->formatId().StartsWith("midi_"))
+	else if (format.StartsWith("midi_"))
 	{
 		audio_type = AUTYPE_MIDI;
-		openMidi(convdata, path.GetFullPath());
+		openMidi(*data, path.GetFullPath());
 	}
 
 	// MOD format
-	else if (entry->getType()->formatId().StartsWith("mod_"))
-		openMod(convdata);
+	else if (format.StartsWith("mod_"))
+		openMod(*data);
 
 	// Other format
 	else
-		openAudio(convdata, path.GetFullPath());
+		openAudio(*data, path.GetFullPath());
 
 	// Keep filename so we can delete it later
 	prevfile = path.GetFullPath();
@@ -375,54 +388,33 @@ bool AudioEntryPanel::openAudio(MemChunk& audio, string filename)
 {
 	// Stop if sound currently playing
 	resetStream();
-
-	// (Re)create sound buffer
-	if (sound_buffer)
-		delete sound_buffer;
-	sound_buffer = new sf::SoundBuffer();
 	audio_type = AUTYPE_INVALID;
 
-	// Load into buffer
-	if (sound_buffer->loadFromMemory((const char*)audio.getData(), audio.getSize()))
-	{
-		LOG_MESSAGE(3, "opened as sound");
-		// Bind to sound
-		sound->setBuffer(*sound_buffer);
-		audio_type = AUTYPE_SOUND;
-
-		// Enable play controls
-#if (SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR < 2)
-		// SFML before 2.2 has a bug where it reports an incorrect value for long sounds, so compute it ourselves then
-		setAudioDuration((sound_buffer->getSampleCount() / sound_buffer->getSampleRate())*(1000/sound_buffer->getChannelCount()));
-#else
-		setAudioDuration(sound_buffer->getDuration().asMilliseconds());
-#endif
-		btn_play->Enable();
-		btn_pause->Enable();
-		btn_stop->Enable();
-
-		return true;
-	}
-	else if (music->openFromMemory((const char*)audio.getData(), audio.getSize()))
+	// sf::Music streams from memory rather than decoding the whole
+	// file up front, [audio] is either the entry data or converted
+	// data owned by the panel, which both stay around while it plays
+	music->stop();
+	if (music->openFromMemory((const char*)audio.getData(), audio.getSize()))
 	{
 		LOG_MESSAGE(3, "opened as music");
-		// Couldn't open the audio as a sf::SoundBuffer, try sf::Music instead
 		audio_type = AUTYPE_MUSIC;
 
 		// Enable play controls
 		setAudioDuration(music->getDuration().asMilliseconds());
 		btn_play->Enable();
+		btn_pause->Enable();
 		btn_stop->Enable();
 
 		return true;
 	}
 	else
 	{
-		// Couldn't open as sound or music, try the wxMediaCtrl
+		// Couldn't open as music, try the wxMediaCtrl
 		LOG_MESSAGE(3, "opened as media");
 
 		// Dump audio to temp file
 		audio.exportFile(filename);
+		audio_data.clear();
 
 		if (openMedia(filename))
 			return true;
@@ -437,6 +429,40 @@ bool AudioEntryPanel::openAudio(MemChunk& audio, string filename)
 	return false;
 }
 
+/* AudioEntryPanel::openPCM
+ * Opens raw PCM based sound [data] of entry format [format] for
+ * streamed playback
+ *******************************************************************/
+bool AudioEntryPanel::openPCM(MemChunk& data, string format)
+{
+	// Stop if sound currently playing
+	resetStream();
+	audio_type = AUTYPE_INVALID;
+
+	if (pcm->openFormat(data, format))
+	{
+		LOG_MESSAGE(3, "opened as pcm stream");
+		audio_type = AUTYPE_PCM;
+
+		// Enable play controls
+		setAudioDuration(pcm->getDuration().asMilliseconds());
+		btn_play->Enable();
+		btn_pause->Enable();
+		btn_stop->Enable();
+
+		return true;
+	}
+
+	// Unable to open sound, disable play controls
+	LOG_MESSAGE(1, "Unable to open sound: %s", Global::error);
+	setAudioDuration(0);
+	btn_play->Enable(false);
+	btn_pause->Enable(false);
+	btn_stop->Enable(false);
+
+	return false;
+}
+
 /* AudioEntryPanel::openMidi
  * Opens a MIDI file for playback
  *******************************************************************/
@@ -531,8 +557,8 @@ void AudioEntryPanel::startStream()
 
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		sound->play(); break;
+	case AUTYPE_PCM:
+		pcm->play(); break;
 	case AUTYPE_MUSIC:
 		music->play(); break;
 	case AUTYPE_MOD:
@@ -551,8 +577,8 @@ void AudioEntryPanel::stopStream()
 {
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		sound->pause(); break;
+	case AUTYPE_PCM:
+		pcm->pause(); break;
 	case AUTYPE_MUSIC:
 		music->pause(); break;
 	case AUTYPE_MOD:
@@ -572,8 +598,8 @@ void AudioEntryPanel::resetStream()
 
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		sound->stop(); break;
+	case AUTYPE_PCM:
+		pcm->stop(); break;
 	case AUTYPE_MUSIC:
 		music->stop(); break;
 	case AUTYPE_MOD:
@@ -595,7 +621,7 @@ bool AudioEntryPanel::updateInfo()
 	MemChunk& mc = entry->getMCData();
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
+	case AUTYPE_PCM:
 	case AUTYPE_MUSIC:
 	case AUTYPE_MEDIA:
 		if (entry->getType() == EntryType::fromId("snd_doom"))
@@ -753,8 +779,8 @@ void AudioEntryPanel::onTimer(wxTimerEvent& e)
 
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		pos = sound->getPlayingOffset().asMilliseconds(); break;
+	case AUTYPE_PCM:
+		pos = pcm->getPlayingOffset().asMilliseconds(); break;
 	case AUTYPE_MUSIC:
 		pos = music->getPlayingOffset().asMilliseconds(); break;
 	case AUTYPE_MOD:
@@ -770,7 +796,7 @@ void AudioEntryPanel::onTimer(wxTimerEvent& e)
 
 	// Stop the timer if playback has reached the end
 	if (pos >= slider_seek->GetMax() ||
-	        (audio_type == AUTYPE_SOUND && sound->getStatus() == sf::Sound::Stopped) ||
+	        (audio_type == AUTYPE_PCM && pcm->getStatus() == sf::Sound::Stopped) ||
 	        (audio_type == AUTYPE_MUSIC && music->getStatus() == sf::Sound::Stopped) ||
 			(audio_type == AUTYPE_MOD && mod->getStatus() == sf::Sound::Stopped) ||
 			(audio_type == AUTYPE_MEDIA && media_ctrl && media_ctrl->GetState() == wxMEDIASTATE_STOPPED) ||
@@ -789,8 +815,8 @@ void AudioEntryPanel::onSliderSeekChanged(wxCommandEvent& e)
 {
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		sound->setPlayingOffset(sf::milliseconds(slider_seek->GetValue())); break;
+	case AUTYPE_PCM:
+		pcm->setPlayingOffset(sf::milliseconds(slider_seek->GetValue())); break;
 	case AUTYPE_MUSIC:
 		music->setPlayingOffset(sf::milliseconds(slider_seek->GetValue())); break;
 	case AUTYPE_MOD:
@@ -811,8 +837,8 @@ void AudioEntryPanel::onSliderVolumeChanged(wxCommandEvent& e)
 
 	switch (audio_type)
 	{
-	case AUTYPE_SOUND:
-		sound->setVolume(snd_volume); break;
+	case AUTYPE_PCM:
+		pcm->setVolume(snd_volume); break;
 	case AUTYPE_MUSIC:
 		music->setVolume(snd_volume); break;
 	case AUTYPE_MIDI:
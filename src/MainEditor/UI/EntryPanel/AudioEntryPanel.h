@@ -6,7 +6,8 @@
 #include "EntryPanel.h"
 
 class ModMusic;
-namespace sf { class SoundBuffer; class Sound; class Music; }
+class PCMStream;
+namespace sf { class Music; }
 class wxMediaCtrl;
 class AudioEntryPanel : public EntryPanel
 {
@@ -31,15 +32,15 @@ private:
 	wxStaticText*	txt_track;
 	wxTextCtrl*		txt_info;
 
-	sf::SoundBuffer*	sound_buffer;
-	sf::Sound*			sound;
+	PCMStream*			pcm;
 	sf::Music*			music;
 	ModMusic*			mod;
+	MemChunk			audio_data;	// Converted audio, kept alive for streaming
 
 	enum
 	{
 		AUTYPE_INVALID,
-		AUTYPE_SOUND,
+		AUTYPE_PCM,
 		AUTYPE_MUSIC,
 		AUTYPE_MIDI,
 		AUTYPE_MEDIA,
@@ -54,11 +55,13 @@ public:
 
 	bool	loadEntry(ArchiveEntry* entry);
 	bool	saveEntry();
+	void	closeEntry() override;
 	string	statusString();
 	void	setAudioDuration(int duration);
 
 	bool	open();
 	bool	openAudio(MemChunk& audio, string filename);
+	bool	openPCM(MemChunk& data, string format);
 	bool	openMidi(MemChunk& data, string filename);
 	bool	openMod(MemChunk& data);
 	bool	openMedia(string filename);
@@ -33,8 +33,6 @@
 #include "Archive/Archive.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
-#include "MapEditor/SLADEMap/MapLine.h"
-#include "MapEditor/SLADEMap/MapVertex.h"
 #include "UI/Canvas/MapPreviewCanvas.h"
 #include "Utility/Parser.h"
 
@@ -132,17 +130,17 @@ bool MapEntryPanel::loadEntry(ArchiveEntry* entry)
 		return false;
 	}
 
-	// Load map into preview canvas
-	if (map_canvas->openMap(thismap))
+	// Load map into preview canvas (in the background)
+	label_stats->SetLabel("Loading map...");
+	map_canvas->openMapAsync(thismap, [this](bool ok)
 	{
-		label_stats->SetLabel(S_FMT("Vertices: %d, Sides: %d, Lines: %d, Sectors: %d, Things: %d, Total Size: %dx%d", map_canvas->nVertices(), map_canvas->nSides(), map_canvas->nLines(), map_canvas->nSectors(), map_canvas->nThings(), map_canvas->getWidth(), map_canvas->getHeight()));
-		return true;
-	}
-	else
-	{
-		label_stats->SetLabel("");
-		return false;
-	}
+		if (ok)
+			label_stats->SetLabel(S_FMT("Vertices: %d, Sides: %d, Lines: %d, Sectors: %d, Things: %d, Total Size: %dx%d", map_canvas->nVertices(), map_canvas->nSides(), map_canvas->nLines(), map_canvas->nSectors(), map_canvas->nThings(), map_canvas->getWidth(), map_canvas->getHeight()));
+		else
+			label_stats->SetLabel("Invalid map");
+	});
+
+	return true;
 }
 
 /* MapEntryPanel::saveEntry
@@ -294,6 +294,18 @@ bool TextEntryPanel::redo()
 	return false;
 }
 
+/* TextEntryPanel::jumpToLine
+ * Moves the caret to the start of [line] and scrolls it into view
+ *******************************************************************/
+void TextEntryPanel::jumpToLine(int line)
+{
+	int pos = text_area_->PositionFromLine(line);
+	text_area_->SetSelection(pos, pos);
+	text_area_->EnsureVisible(line);
+	text_area_->SetFirstVisibleLine(MAX(0, line - 5));
+	text_area_->SetFocus();
+}
+
 /* TextEntryPanel::handleAction
  * Handles the action [id]. Returns true if the action was handled,
  * false otherwise
@@ -22,6 +22,7 @@ public:
 	string	statusString() override;
 	bool	undo() override;
 	bool	redo() override;
+	void	jumpToLine(int line);
 
 	// SAction Handler
 	bool	handleAction(string id) override;
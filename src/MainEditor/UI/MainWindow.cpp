@@ -51,6 +51,7 @@
 #include "ArchiveManagerPanel.h"
 #include "StartPage.h"
 #include "Scripting/ScriptManager.h"
+#include "Dialogs/TextSearchDialog.h"
 #ifdef USE_WEBVIEW_STARTPAGE
 #include "DocsPage.h"
 #endif
@@ -102,6 +103,7 @@ MainWindow::MainWindow()
 	: STopWindow("SLADE", "main")
 {
 	lasttipindex = 0;
+	dlg_text_search = nullptr;
 	custom_menus_begin_ = 2;
 	if (mw_maximized) Maximize();
 	setupLayout();
@@ -302,6 +304,7 @@ void MainWindow::setupLayout()
 
 	// Tools menu
 	wxMenu* tools_menu = new wxMenu("");
+	SAction::fromId("main_findinfiles")->addToMenu(tools_menu);
 	SAction::fromId("main_runscript")->addToMenu(tools_menu);
 	menu->Append(tools_menu, "&Tools");
 
@@ -630,6 +633,15 @@ bool MainWindow::handleAction(string id)
 	if (id == "main_showstartpage")
 		openStartPageTab();
 
+	// Tools->Find in Files
+	if (id == "main_findinfiles")
+	{
+		if (!dlg_text_search)
+			dlg_text_search = new TextSearchDialog(this);
+		dlg_text_search->open();
+		return true;
+	}
+
 	// Tools->Run Script
 	if (id == "main_runscript")
 	{
@@ -12,6 +12,7 @@ class STabCtrl;
 class UndoManagerHistoryPanel;
 class wxAuiManager;
 class SStartPage;
+class TextSearchDialog;
 #ifdef USE_WEBVIEW_STARTPAGE
 class DocsPage;
 #endif
@@ -24,6 +25,7 @@ private:
 	wxAuiManager*				m_mgr;
 	int							lasttipindex;
 	PaletteChooser*				palette_chooser;
+	TextSearchDialog*			dlg_text_search;
 
 	// Start page
 	SStartPage*	start_page;
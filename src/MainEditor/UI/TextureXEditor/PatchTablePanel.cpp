@@ -152,10 +152,10 @@ void PatchTableListView::updateList(bool clear)
 	Refresh();
 }
 
-/* PatchTableListView::onAnnouncement
+/* PatchTableListView::onAnnouncementEvent
  * Handles announcements from the panel's PatchTable
  *******************************************************************/
-void PatchTableListView::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void PatchTableListView::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
 	// Just refresh on any event from the patch table
 	if (announcer == patch_table)
@@ -24,7 +24,7 @@ public:
 	PatchTable*	patchTable() { return patch_table; }
 
 	void		updateList(bool clear = false);
-	void		onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	void		onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 	static bool usageSort(long left, long right);
 	void		sortItems();
 };
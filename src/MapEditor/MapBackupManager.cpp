@@ -112,7 +112,13 @@ bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archi
 			backup_entries.push_back(map_data[a]);
 	}
 
+	// Get content hashes of the entries to back up
+	vector<uint64_t> backup_hashes;
+	for (unsigned a = 0; a < backup_entries.size(); a++)
+		backup_hashes.push_back(backup_entries[a]->getContentHash());
+
 	// Compare with last backup (if any)
+	string backup_id = backup_file + ":" + map_name;
 	ArchiveTreeNode* map_dir = backup.getDir(map_name);
 	if (map_dir && map_dir->nChildren() > 0)
 	{
@@ -122,23 +128,26 @@ bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archi
 			same = false;
 		else
 		{
-			for (unsigned a = 0; a < last_backup->numEntries(); a++)
+			// Use the hashes remembered from writing the last backup if possible,
+			// otherwise the backup entries have to be loaded and hashed
+			auto last = last_backups.find(backup_id);
+			if (last != last_backups.end() && last->second.dir == last_backup->getName())
+				same = (last->second.hashes == backup_hashes);
+			else
 			{
-				ArchiveEntry* e1 = backup_entries[a];
-				ArchiveEntry* e2 = last_backup->entryAt(a);
-				if (e1->getSize() != e2->getSize())
+				for (unsigned a = 0; a < last_backup->numEntries(); a++)
 				{
-					same = false;
-					break;
+					ArchiveEntry* e2 = last_backup->entryAt(a);
+					if (backup_entries[a]->getSize() != e2->getSize() ||
+						backup_hashes[a] != e2->getContentHash())
+					{
+						same = false;
+						break;
+					}
 				}
 
-				uint32_t crc1 = Misc::crc(e1->getData(), e1->getSize());
-				uint32_t crc2 = Misc::crc(e2->getData(), e2->getSize());
-				if (crc1 != crc2)
-				{
-					same = false;
-					break;
-				}
+				if (same)
+					last_backups[backup_id] = { last_backup->getName(), backup_hashes };
 			}
 		}
 
@@ -166,6 +175,10 @@ bool MapBackupManager::writeBackup(vector<ArchiveEntry*>& map_data, string archi
 	bool ok = backup.save();
 	Archive::save_backup = true;
 
+	// Remember content hashes of the new backup
+	if (ok)
+		last_backups[backup_id] = { timestamp, backup_hashes };
+
 	return ok;
 }
 
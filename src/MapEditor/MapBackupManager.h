@@ -7,6 +7,13 @@ class Archive;
 class MapBackupManager
 {
 private:
+	// Content hashes of the entries in the last backup written for a map
+	struct BackupHashes
+	{
+		string				dir;	// Backup directory name (timestamp)
+		vector<uint64_t>	hashes;
+	};
+	std::map<string, BackupHashes>	last_backups;
 
 public:
 	MapBackupManager();
@@ -398,28 +398,13 @@ public:
 				{
 				case TagType::Sector:
 				case TagType::SectorOrBack:
-					{
-						std::vector<MapSector *> foundsectors;
-						map->getSectorsByTag(tag, foundsectors);
-						if (foundsectors.size() > 0)
-							okay = true;
-					}
+					okay = map->tagIndex().sectorTagUsed(tag);
 					break;
 				case TagType::Line:
-					{
-						std::vector<MapLine *> foundlines;
-						map->getLinesById(tag, foundlines);
-						if (foundlines.size() > 0)
-							okay = true;
-					}
+					okay = map->tagIndex().lineIdUsed(tag);
 					break;
 				case TagType::Thing:
-					{
-						std::vector<MapThing *> foundthings;
-						map->getThingsById(tag, foundthings);
-						if (foundthings.size() > 0)
-							okay = true;
-					}
+					okay = map->tagIndex().thingIdUsed(tag);
 					break;
 				default:
 					// Ignore the rest for now...
@@ -794,6 +779,13 @@ public:
 			int max_skill = udmf_zdoom ? 17 : 5;
 			int max_class = udmf_zdoom ? 17 : 4;
 
+			// Build skill/class flag names once rather than per thing pair
+			vector<string> skill_flags, class_flags;
+			for (int s = min_skill; s < max_skill; ++s)
+				skill_flags.push_back(S_FMT("skill%d", s));
+			for (int c = 1; c < max_class; ++c)
+				class_flags.push_back(S_FMT("class%d", c));
+
 			for (unsigned b = a + 1; b < map->nThings(); b++)
 			{
 				MapThing* thing2 = map->getThing(b);
@@ -807,14 +799,13 @@ public:
 				// Check flags
 				// Case #1: different skill levels
 				bool shareflag = false;
-				for (int s = min_skill; s < max_skill; ++s)
+				for (auto& skill : skill_flags)
 				{
-					string skill = S_FMT("skill%d", s);
 					if (Game::configuration().thingBasicFlagSet(skill, thing1, map_format) && 
 						Game::configuration().thingBasicFlagSet(skill, thing2, map_format))
 					{
 						shareflag = true;
-						s = max_skill;
+						break;
 					}
 				}
 				if (!shareflag)
@@ -822,12 +813,12 @@ public:
 
 				// Booleans for single, coop, deathmatch, and teamgame status for each thing
 				bool s1, s2, c1, c2, d1, d2, t1, t2;
-				s1 = Game::configuration().thingBasicFlagSet("single", thing1, map_format);
-				s2 = Game::configuration().thingBasicFlagSet("single", thing2, map_format);
-				c1 = Game::configuration().thingBasicFlagSet("coop", thing1, map_format);
-				c2 = Game::configuration().thingBasicFlagSet("coop", thing2, map_format);
-				d1 = Game::configuration().thingBasicFlagSet("dm", thing1, map_format);
-				d2 = Game::configuration().thingBasicFlagSet("dm", thing2, map_format);
+				s1 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::Single, thing1, map_format);
+				s2 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::Single, thing2, map_format);
+				c1 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::Coop, thing1, map_format);
+				c2 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::Coop, thing2, map_format);
+				d1 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::DM, thing1, map_format);
+				d2 = Game::configuration().thingBasicFlagSet(Game::ThingBasicFlag::DM, thing2, map_format);
 
 				// Player starts
 				// P1 are automatically S and C; P2+ are automatically C;
@@ -872,14 +863,13 @@ public:
 				if (!shareflag && s1 && s2)
 				{
 					// Case #3: things flagged for single player with different class filters
-					for (int c = 1; c < max_class; ++c)
+					for (auto& pclass : class_flags)
 					{
-						string pclass = S_FMT("class%d", c);
 						if (Game::configuration().thingBasicFlagSet(pclass, thing1, map_format) && 
 							Game::configuration().thingBasicFlagSet(pclass, thing2, map_format))
 						{
 							shareflag = true;
-							c = max_class;
+							break;
 						}
 					}
 				}
@@ -1409,7 +1399,7 @@ public:
 			line = map->getLine(a);
 
 			// Skip if line is 2-sided and not blocking
-			if (line->s2() && !Game::configuration().lineBasicFlagSet("blocking", line, map->currentFormat()))
+			if (line->s2() && !Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::Blocking, line, map->currentFormat()))
 				continue;
 
 			check_lines.push_back(line);
@@ -36,6 +36,7 @@
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/Console/Console.h"
+#include "General/Misc.h"
 #include "General/UndoRedo.h"
 #include "MapChecks.h"
 #include "MapEditContext.h"
@@ -87,7 +88,6 @@ namespace
 	};
 }
 CVAR(Bool, info_overlay_3d, true, CVAR_SAVE)
-CVAR(Int, map_bg_ms, 15, CVAR_SAVE)
 CVAR(Bool, hilight_smooth, true, CVAR_SAVE)
 
 
@@ -97,6 +97,9 @@ CVAR(Bool, hilight_smooth, true, CVAR_SAVE)
 //
 // ----------------------------------------------------------------------------
 EXTERN_CVAR(Int, flat_drawtype)
+EXTERN_CVAR(Bool, map_animate_hilight)
+EXTERN_CVAR(Bool, map_animate_selection)
+EXTERN_CVAR(Bool, map_animate_tagged)
 
 
 // ----------------------------------------------------------------------------
@@ -282,17 +285,13 @@ void MapEditContext::lockMouse(bool lock)
 // ----------------------------------------------------------------------------
 // MapEditContext::update
 //
-// Updates the current map editor state (hilight, animations, etc.)
+// Updates the current map editor state (hilight, animations, etc.). Returns
+// true if anything drawn may have changed since the last update
 // ----------------------------------------------------------------------------
 bool MapEditContext::update(long frametime)
 {
-	// Ignore if we aren't ready to update
-	if (frametime < next_frame_length_)
-		return false;
-
-	// Set initial time (ms) until next update
-	// This will be set lower if animations are active
-	next_frame_length_ = overlayActive() ? 2 : map_bg_ms;
+	bool redraw = false;
+	bool camera_moved = false;
 
 	// Get frame time multiplier
 	double mult = (double)frametime / 10.0f;
@@ -302,7 +301,7 @@ bool MapEditContext::update(long frametime)
 	{
 		// Update camera
 		if (input_.updateCamera3d(mult))
-			next_frame_length_ = 2;
+			camera_moved = true;
 
 		// Update status bar
 		auto pos = renderer_.renderer3D().camPosition();
@@ -327,6 +326,7 @@ bool MapEditContext::update(long frametime)
 
 				// Animation
 				renderer_.animateHilightChange(old_hl);
+				redraw = true;
 			}
 		}
 	}
@@ -353,6 +353,7 @@ bool MapEditContext::update(long frametime)
 			// Update info overlay depending on edit mode
 			updateInfoOverlay();
 			info_showing_ = selection_.hasHilight();
+			redraw = true;
 		}
 	}
 
@@ -362,10 +363,45 @@ bool MapEditContext::update(long frametime)
 
 	// Update animations
 	renderer_.updateAnimations(mult);
-	if (renderer_.animationsActive())
-		next_frame_length_ = 2;
 
-	return true;
+	// Check if any map objects were modified, created or deleted
+	if (map_.changeCount() != map_change_count_)
+	{
+		map_change_count_ = map_.changeCount();
+		redraw = true;
+	}
+
+	// Check if the hilight (or objects tagged to/from it) is flashing. The 3d
+	// mode hilight always flashes, in 2d mode it depends on the animation
+	// options (hilight fades are included in animationsActive)
+	bool hilight_flashing = false;
+	if (selection_.hasHilight())
+	{
+		bool tagged =
+			!tagged_sectors_.empty() ||
+			!tagged_lines_.empty() ||
+			!tagged_things_.empty() ||
+			!tagging_lines_.empty() ||
+			!tagging_things_.empty();
+
+		hilight_flashing =
+			edit_mode_ == Mode::Visual ||
+			map_animate_hilight ||
+			(map_animate_tagged && tagged);
+	}
+
+	// Keep updating every frame while anything is moving or fading (the
+	// hilight and selection can flash, and editor messages fade out after 2
+	// seconds)
+	animating_ =
+		camera_moved ||
+		renderer_.animationsActive() ||
+		overlayActive() ||
+		hilight_flashing ||
+		(map_animate_selection && !selection_.empty()) ||
+		(!editor_messages_.empty() && editorMessageTime(editor_messages_.size() - 1) <= 2000);
+
+	return redraw || animating_;
 }
 
 // ----------------------------------------------------------------------------
@@ -1311,9 +1347,6 @@ void MapEditContext::beginUndoRecord(string name, bool mod, bool create, bool de
 	if (undo_deleted_ || undo_created_)
 		us_create_delete_ = new MapEditor::MapObjectCreateDeleteUS();
 
-	// Make sure all modified objects will be picked up
-	wxMilliSleep(5);
-
 	last_undo_level_ = "";
 }
 
@@ -2180,6 +2213,95 @@ CONSOLE_COMMAND(mobj_info, 1, false)
 	}
 }
 
+CONSOLE_COMMAND(m_mem_report, 0, false)
+{
+	SLADEMap& map = MapEditor::editContext().map();
+
+	// Property storage can be shared between objects, backups and
+	// clipboard copies, so only count each once
+	std::set<const void*> counted;
+	size_t total_objects = 0;
+	size_t total_props = 0;
+	size_t total_storage = 0;
+	size_t total_shared = 0;
+	auto report = [&](const char* type, size_t count, size_t obj_size, std::function<MapObject*(unsigned)> get)
+	{
+		size_t props = 0;
+		size_t storage = 0;
+		size_t shared = 0;
+		for (unsigned a = 0; a < count; a++)
+		{
+			auto& list = get(a)->props();
+			props += list.size();
+			if (!list.storageId() || !counted.insert(list.storageId()).second)
+				continue;
+
+			storage += list.storageSize();
+			if (list.isShared())
+				shared += list.storageSize();
+		}
+
+		Log::console(S_FMT(
+			"%s: %d (%s), %d properties (%s, %s shared)",
+			type,
+			(int)count,
+			Misc::sizeAsString(count * obj_size),
+			(int)props,
+			Misc::sizeAsString(storage),
+			Misc::sizeAsString(shared)
+		));
+
+		total_objects += count * obj_size;
+		total_props += props;
+		total_storage += storage;
+		total_shared += shared;
+	};
+
+	Log::console(S_FMT("Map %s memory usage:", map.mapName()));
+	report("Vertices", map.nVertices(), sizeof(MapVertex), [&](unsigned i) { return map.getVertex(i); });
+	report("Lines", map.nLines(), sizeof(MapLine), [&](unsigned i) { return map.getLine(i); });
+	report("Sides", map.nSides(), sizeof(MapSide), [&](unsigned i) { return map.getSide(i); });
+	report("Sectors", map.nSectors(), sizeof(MapSector), [&](unsigned i) { return map.getSector(i); });
+	report("Things", map.nThings(), sizeof(MapThing), [&](unsigned i) { return map.getThing(i); });
+	Log::console(S_FMT(
+		"Total: %s objects, %s properties (%s shared with undo backups/copies), %d property names",
+		Misc::sizeAsString(total_objects),
+		Misc::sizeAsString(total_storage),
+		Misc::sizeAsString(total_shared),
+		(int)MobjPropertyList::nKeys()
+	));
+	Log::console(S_FMT(
+		"(%d properties as separate name/value objects would be %s)",
+		(int)total_props,
+		Misc::sizeAsString(total_props * sizeof(MobjPropertyList::prop_t))
+	));
+	Log::console(S_FMT(
+		"Object arenas: %s allocated (including backups and deleted objects)",
+		Misc::sizeAsString(MapObjectArena::allocatedSize())
+	));
+}
+
+CONSOLE_COMMAND(m_test_geometry, 0, false)
+{
+	long size = 500000;
+	if (args.size() > 0)
+		args[0].ToLong(&size);
+
+	SLADEMap::benchmarkGeometry(MAX(13, size));
+}
+
+CONSOLE_COMMAND(m_test_sectors, 0, false)
+{
+	long size = 100000;
+	long lines = 20;
+	if (args.size() > 0)
+		args[0].ToLong(&size);
+	if (args.size() > 1)
+		args[1].ToLong(&lines);
+
+	SLADEMap::benchmarkCorrectSectors(MAX(12, size), MAX(1, lines));
+}
+
 //CONSOLE_COMMAND(m_test_save, 1, false) {
 //	vector<ArchiveEntry*> entries;
 //	theMapEditor->MapEditContext().getMap().writeDoomMap(entries);
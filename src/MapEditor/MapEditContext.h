@@ -66,6 +66,7 @@ public:
 
 	// General
 	bool	update(long frametime);
+	bool	animating() const { return animating_; }
 
 	// Map loading
 	bool	openMap(Archive::MapDesc map);
@@ -146,7 +147,8 @@ private:
 	SLADEMap			map_;
 	MapCanvas*			canvas_				= nullptr;
 	Archive::MapDesc	map_desc_;
-	long				next_frame_length_	= 0;
+	bool				animating_			= false;
+	unsigned			map_change_count_	= 0;
 
 	// Undo/Redo stuff
 	std::unique_ptr<UndoManager>	undo_manager_		= nullptr;
@@ -0,0 +1,715 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapPreviewData.cpp
+// Description: MapPreviewData class, reads the basic geometry of a map
+//              (vertices, lines and things) for use in map previews and
+//              thumbnails. Parsing is separate from reading the map lumps so
+//              that it can be done off the main thread
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapPreviewData.h"
+#include "Archive/Formats/WadArchive.h"
+#include "General/ColourConfiguration.h"
+#include "Graphics/SImage/SImage.h"
+#include "MapEditor/SLADEMap/MapLine.h"
+#include "MapEditor/SLADEMap/MapThing.h"
+#include "MapEditor/SLADEMap/MapVertex.h"
+#include "Utility/Tokenizer.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// MapPreviewData::ImageColours Struct Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::ImageColours::load
+//
+// Loads the map image colours from the current colour configuration
+// ----------------------------------------------------------------------------
+void MapPreviewData::ImageColours::load()
+{
+	background = ColourConfiguration::getColour("map_image_background");
+	line_1s = ColourConfiguration::getColour("map_image_line_1s");
+	line_2s = ColourConfiguration::getColour("map_image_line_2s");
+	line_special = ColourConfiguration::getColour("map_image_line_special");
+	line_macro = ColourConfiguration::getColour("map_image_line_macro");
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapPreviewData Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::read
+//
+// Copies the lumps needed for the preview of [map] and calculates a hash of
+// the map's content. Returns false if the map is invalid
+// ----------------------------------------------------------------------------
+bool MapPreviewData::read(Archive::MapDesc map)
+{
+	clear();
+
+	// All errors = invalid map
+	Global::error = "Invalid map";
+
+	// Check if this map is a pk3 map
+	std::unique_ptr<WadArchive> temp_archive;
+	if (map.archive)
+	{
+		// Attempt to open entry as wad archive
+		temp_archive.reset(new WadArchive());
+		if (!temp_archive->open(map.head))
+			return false;
+
+		// Detect maps
+		vector<Archive::MapDesc> maps = temp_archive->detectMaps();
+
+		// Set map if there are any in the archive
+		if (maps.size() > 0)
+			map = maps[0];
+		else
+			return false;
+	}
+
+	if (!map.head)
+		return false;
+
+	format_ = map.format;
+	name_ = map.head->getName();
+
+	// Copy map lumps and hash their content
+	hash_ = 14695981039346656037ULL ^ format_;
+	for (ArchiveEntry* entry = map.head; entry; entry = entry->nextEntry())
+	{
+		EntryType* type = entry->getType();
+		if (entry->getSize() > 0)
+		{
+			if (type == EntryType::fromId("udmf_textmap"))
+				textmap_.importMem(entry->getData(), entry->getSize());
+			else if (type == EntryType::fromId("map_vertexes"))
+				vertexes_.importMem(entry->getData(), entry->getSize());
+			else if (type == EntryType::fromId("map_linedefs"))
+				linedefs_.importMem(entry->getData(), entry->getSize());
+			else if (type == EntryType::fromId("map_things"))
+				things_.importMem(entry->getData(), entry->getSize());
+			else if (type == EntryType::fromId("map_sidedefs"))
+				sidedefs_size_ = entry->getSize();
+			else if (type == EntryType::fromId("map_sectors"))
+				sectors_size_ = entry->getSize();
+		}
+
+		hash_ = (hash_ ^ entry->getContentHash()) * 1099511628211ULL;
+
+		// Exit loop if we've reached the end of the map entries
+		if (entry == map.end)
+			break;
+	}
+
+	// Check required lumps are present
+	if (format_ == MAP_UDMF)
+		return textmap_.hasData();
+	else
+		return vertexes_.hasData() && linedefs_.hasData();
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::parse
+//
+// Builds the map geometry from the lumps copied by read(). This can be called
+// from any thread. Returns false if the map is invalid, in which case the
+// reason can be retrieved with error() (nothing is logged here, since that
+// isn't safe from other threads)
+// ----------------------------------------------------------------------------
+bool MapPreviewData::parse()
+{
+	error_.clear();
+	verts.clear();
+	lines.clear();
+	things.clear();
+	n_sides = 0;
+	n_sectors = 0;
+
+	bool ok = true;
+	if (format_ == MAP_UDMF)
+		ok = parseUDMF();
+	else
+	{
+		// Read vertices & linedefs (required)
+		ok = parseVertices() && parseLines();
+
+		// Read things
+		if (ok)
+			parseThings();
+
+		// Read sides & sectors (count only)
+		if (sidedefs_size_ > 0 && sectors_size_ > 0)
+		{
+			// Doom64 map
+			if (format_ != MAP_DOOM64)
+			{
+				n_sides = sidedefs_size_ / 30;
+				n_sectors = sectors_size_ / 26;
+			}
+
+			// Doom/Hexen map
+			else
+			{
+				n_sides = sidedefs_size_ / 12;
+				n_sectors = sectors_size_ / 16;
+			}
+		}
+	}
+
+	// Lump data is no longer needed
+	textmap_.clear();
+	vertexes_.clear();
+	linedefs_.clear();
+	things_.clear();
+
+	if (!ok && error_.empty())
+		error_ = "Invalid map";
+
+	return ok;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::load
+//
+// Reads and parses [map] on the current (main) thread. Returns false if the
+// map is invalid
+// ----------------------------------------------------------------------------
+bool MapPreviewData::load(const Archive::MapDesc& map)
+{
+	if (!read(map))
+		return false;
+
+	if (!parse())
+	{
+		LOG_MESSAGE(1, error_);
+		Global::error = error_;
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::clear
+//
+// Clears all map data
+// ----------------------------------------------------------------------------
+void MapPreviewData::clear()
+{
+	verts.clear();
+	lines.clear();
+	things.clear();
+	n_sides = 0;
+	n_sectors = 0;
+	format_ = MAP_UNKNOWN;
+	textmap_.clear();
+	vertexes_.clear();
+	linedefs_.clear();
+	things_.clear();
+	sidedefs_size_ = 0;
+	sectors_size_ = 0;
+	hash_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::addVertex
+//
+// Adds a vertex to the map data
+// ----------------------------------------------------------------------------
+void MapPreviewData::addVertex(double x, double y)
+{
+	verts.push_back(mep_vertex_t(x, y));
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::addLine
+//
+// Adds a line to the map data
+// ----------------------------------------------------------------------------
+void MapPreviewData::addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro)
+{
+	mep_line_t line(v1, v2);
+	line.twosided = twosided;
+	line.special = special;
+	line.macro = macro;
+	lines.push_back(line);
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::addThing
+//
+// Adds a thing to the map data
+// ----------------------------------------------------------------------------
+void MapPreviewData::addThing(double x, double y)
+{
+	mep_thing_t thing;
+	thing.x = x;
+	thing.y = y;
+	things.push_back(thing);
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::bounds
+//
+// Gets the extents of the map vertices. Returns false if there are none
+// ----------------------------------------------------------------------------
+bool MapPreviewData::bounds(double& min_x, double& min_y, double& max_x, double& max_y) const
+{
+	min_x = min_y = 999999.0;
+	max_x = max_y = -999999.0;
+	for (auto& vertex : verts)
+	{
+		if (vertex.x < min_x) min_x = vertex.x;
+		if (vertex.x > max_x) max_x = vertex.x;
+		if (vertex.y < min_y) min_y = vertex.y;
+		if (vertex.y > max_y) max_y = vertex.y;
+	}
+
+	return !verts.empty();
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::drawImage
+//
+// Draws the map lines into [image] (as RGBA, [width]x[height]) in software.
+// Used for map thumbnails, which are rendered off the main thread
+// ----------------------------------------------------------------------------
+void MapPreviewData::drawImage(SImage& image, int width, int height, const ImageColours& colours) const
+{
+	// Clear to background colour
+	uint8_t* data = new uint8_t[width * height * 4];
+	for (int a = 0; a < width * height; a++)
+	{
+		data[a * 4] = colours.background.r;
+		data[a * 4 + 1] = colours.background.g;
+		data[a * 4 + 2] = colours.background.b;
+		data[a * 4 + 3] = colours.background.a;
+	}
+
+	// Zoom/offset to fit whole map
+	double min_x, min_y, max_x, max_y;
+	if (bounds(min_x, min_y, max_x, max_y))
+	{
+		double mapwidth = MAX(max_x - min_x, 1.0);
+		double mapheight = MAX(max_y - min_y, 1.0);
+		double zoom = MIN((double)width / mapwidth, (double)height / mapheight) * 0.95;
+		double offset_x = (width - mapwidth * zoom) * 0.5 - min_x * zoom;
+		double offset_y = (height - mapheight * zoom) * 0.5 - min_y * zoom;
+
+		// Draw 2s lines first, then 1s lines over them
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (auto& line : lines)
+			{
+				if (line.twosided != (pass == 0))
+					continue;
+
+				// Check ends
+				if (line.v1 >= verts.size() || line.v2 >= verts.size())
+					continue;
+
+				// Set colour
+				const rgba_t* col = &colours.line_1s;
+				if (line.special)
+					col = &colours.line_special;
+				else if (line.macro)
+					col = &colours.line_macro;
+				else if (line.twosided)
+					col = &colours.line_2s;
+
+				// Draw line (Bresenham, y is flipped)
+				int x1 = (int)(verts[line.v1].x * zoom + offset_x);
+				int y1 = height - 1 - (int)(verts[line.v1].y * zoom + offset_y);
+				int x2 = (int)(verts[line.v2].x * zoom + offset_x);
+				int y2 = height - 1 - (int)(verts[line.v2].y * zoom + offset_y);
+				int dx = abs(x2 - x1);
+				int dy = -abs(y2 - y1);
+				int sx = x1 < x2 ? 1 : -1;
+				int sy = y1 < y2 ? 1 : -1;
+				int err = dx + dy;
+				while (true)
+				{
+					if (x1 >= 0 && x1 < width && y1 >= 0 && y1 < height)
+					{
+						uint8_t* pixel = data + (y1 * width + x1) * 4;
+						pixel[0] = col->r;
+						pixel[1] = col->g;
+						pixel[2] = col->b;
+						pixel[3] = col->a;
+					}
+
+					if (x1 == x2 && y1 == y2)
+						break;
+					int e2 = err * 2;
+					if (e2 >= dy) { err += dy; x1 += sx; }
+					if (e2 <= dx) { err += dx; y1 += sy; }
+				}
+			}
+		}
+	}
+
+	image.setImageData(data, width, height, RGBA);
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::parseUDMF
+//
+// Parses vertices, lines and things from the UDMF TEXTMAP lump
+// ----------------------------------------------------------------------------
+bool MapPreviewData::parseUDMF()
+{
+	// Start parsing
+	Tokenizer tz;
+	tz.openMem(textmap_, name_);
+
+	// Get first token
+	string token = tz.getToken();
+	size_t vertcounter = 0, linecounter = 0, thingcounter = 0;
+	while (!token.IsEmpty())
+	{
+		if (!token.CmpNoCase("namespace"))
+		{
+			//  skip till we reach the ';'
+			do { token = tz.getToken(); }
+			while (token.Cmp(";"));
+		}
+		else if (!token.CmpNoCase("vertex"))
+		{
+			// Get X and Y properties
+			bool gotx = false;
+			bool goty = false;
+			double x = 0.;
+			double y = 0.;
+			do
+			{
+				token = tz.getToken();
+				if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
+				{
+					bool isx = !token.CmpNoCase("x");
+					token = tz.getToken();
+					if (token.Cmp("="))
+					{
+						error_ = S_FMT("Bad syntax for vertex %i in UDMF map data", vertcounter);
+						return false;
+					}
+					if (isx) x = tz.getDouble(), gotx = true;
+					else y = tz.getDouble(), goty = true;
+					// skip to end of declaration after each key
+					do { token = tz.getToken(); }
+					while (token.Cmp(";"));
+				}
+			}
+			while (token.Cmp("}"));
+			if (gotx && goty)
+				addVertex(x, y);
+			else
+			{
+				error_ = S_FMT("Wrong vertex %i in UDMF map data", vertcounter);
+				return false;
+			}
+			vertcounter++;
+		}
+		else if (!token.CmpNoCase("linedef"))
+		{
+			bool special = false;
+			bool twosided = false;
+			bool gotv1 = false, gotv2 = false;
+			size_t v1 = 0, v2 = 0;
+			do
+			{
+				token = tz.getToken();
+				if (!token.CmpNoCase("v1") || !token.CmpNoCase("v2"))
+				{
+					bool isv1 = !token.CmpNoCase("v1");
+					token = tz.getToken();
+					if (token.Cmp("="))
+					{
+						error_ = S_FMT("Bad syntax for linedef %i in UDMF map data", linecounter);
+						return false;
+					}
+					if (isv1) v1 = tz.getInteger(), gotv1 = true;
+					else v2 = tz.getInteger(), gotv2 = true;
+					// skip to end of declaration after each key
+					do { token = tz.getToken(); }
+					while (token.Cmp(";"));
+				}
+				else if (!token.CmpNoCase("special"))
+				{
+					special = true;
+					// skip to end of declaration after each key
+					do { token = tz.getToken(); }
+					while (token.Cmp(";"));
+				}
+				else if (!token.CmpNoCase("sideback"))
+				{
+					twosided = true;
+					// skip to end of declaration after each key
+					do { token = tz.getToken(); }
+					while (token.Cmp(";"));
+				}
+			}
+			while (token.Cmp("}"));
+			if (gotv1 && gotv2)
+				addLine(v1, v2, twosided, special);
+			else
+			{
+				error_ = S_FMT("Wrong line %i in UDMF map data", linecounter);
+				return false;
+			}
+			linecounter++;
+		}
+		else if (S_CMPNOCASE(token, "thing"))
+		{
+			// Get X and Y properties
+			bool gotx = false;
+			bool goty = false;
+			double x = 0.;
+			double y = 0.;
+			do
+			{
+				token = tz.getToken();
+				if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
+				{
+					bool isx = !token.CmpNoCase("x");
+					token = tz.getToken();
+					if (token.Cmp("="))
+					{
+						error_ = S_FMT("Bad syntax for thing %i in UDMF map data", thingcounter);
+						return false;
+					}
+					if (isx) x = tz.getDouble(), gotx = true;
+					else y = tz.getDouble(), goty = true;
+					// skip to end of declaration after each key
+					do { token = tz.getToken(); } while (token.Cmp(";"));
+				}
+			} while (token.Cmp("}"));
+			if (gotx && goty)
+				addThing(x, y);
+			else
+			{
+				error_ = S_FMT("Wrong thing %i in UDMF map data", thingcounter);
+				return false;
+			}
+			thingcounter++;
+		}
+		else
+		{
+			// Check for side or sector definition (increase counts)
+			if (S_CMPNOCASE(token, "sidedef"))
+				n_sides++;
+			else if (S_CMPNOCASE(token, "sector"))
+				n_sectors++;
+
+			// map preview ignores sidedefs, sectors, comments,
+			// unknown fields, etc. so skip to end of block
+			do { token = tz.getToken(); }
+			while (token.Cmp("}") && !token.empty());
+		}
+		// Iterate to next token
+		token = tz.getToken();
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::parseVertices
+//
+// Parses non-UDMF vertex data
+// ----------------------------------------------------------------------------
+bool MapPreviewData::parseVertices()
+{
+	// Can't open a map without vertices
+	if (!vertexes_.hasData())
+		return false;
+
+	// Read vertex data
+	MemChunk& mc = vertexes_;
+	mc.seek(0, SEEK_SET);
+
+	if (format_ == MAP_DOOM64)
+	{
+		doom64vertex_t v;
+		while (1)
+		{
+			// Read vertex
+			if (!mc.read(&v, 8))
+				break;
+
+			// Add vertex
+			addVertex((double)v.x/65536, (double)v.y/65536);
+		}
+	}
+	else
+	{
+		doomvertex_t v;
+		while (1)
+		{
+			// Read vertex
+			if (!mc.read(&v, 4))
+				break;
+
+			// Add vertex
+			addVertex((double)v.x, (double)v.y);
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::parseLines
+//
+// Parses non-UDMF line data
+// ----------------------------------------------------------------------------
+bool MapPreviewData::parseLines()
+{
+	// Can't open a map without linedefs
+	if (!linedefs_.hasData())
+		return false;
+
+	// Read line data
+	MemChunk& mc = linedefs_;
+	mc.seek(0, SEEK_SET);
+	if (format_ == MAP_DOOM)
+	{
+		while (1)
+		{
+			// Read line
+			doomline_t l;
+			if (!mc.read(&l, sizeof(doomline_t)))
+				break;
+
+			// Check properties
+			bool special = false;
+			bool twosided = false;
+			if (l.side2 != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+				special = true;
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special);
+		}
+	}
+	else if (format_ == MAP_DOOM64)
+	{
+		while (1)
+		{
+			// Read line
+			doom64line_t l;
+			if (!mc.read(&l, sizeof(doom64line_t)))
+				break;
+
+			// Check properties
+			bool macro = false;
+			bool special = false;
+			bool twosided = false;
+			if (l.side2  != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+			{
+				if (l.type & 0x100)
+					macro = true;
+				else special = true;
+			}
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special, macro);
+		}
+	}
+	else if (format_ == MAP_HEXEN)
+	{
+		while (1)
+		{
+			// Read line
+			hexenline_t l;
+			if (!mc.read(&l, sizeof(hexenline_t)))
+				break;
+
+			// Check properties
+			bool special = false;
+			bool twosided = false;
+			if (l.side2 != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+				special = true;
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special);
+		}
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// MapPreviewData::parseThings
+//
+// Parses non-UDMF thing data
+// ----------------------------------------------------------------------------
+void MapPreviewData::parseThings()
+{
+	// No things
+	if (!things_.hasData())
+		return;
+
+	// Read things data
+	if (format_ == MAP_DOOM)
+	{
+		const doomthing_t* thng_data = (const doomthing_t*)things_.getData();
+		unsigned nt = things_.getSize() / sizeof(doomthing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+	else if (format_ == MAP_DOOM64)
+	{
+		const doom64thing_t* thng_data = (const doom64thing_t*)things_.getData();
+		unsigned nt = things_.getSize() / sizeof(doom64thing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+	else if (format_ == MAP_HEXEN)
+	{
+		const hexenthing_t* thng_data = (const hexenthing_t*)things_.getData();
+		unsigned nt = things_.getSize() / sizeof(hexenthing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+}
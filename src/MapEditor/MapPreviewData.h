@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Archive/Archive.h"
+
+class SImage;
+
+// Structs for basic map features
+struct mep_vertex_t
+{
+	double x;
+	double y;
+	mep_vertex_t(double x, double y) { this->x = x; this->y = y; }
+};
+
+struct mep_line_t
+{
+	unsigned	v1;
+	unsigned	v2;
+	bool		twosided;
+	bool		special;
+	bool		macro;
+	bool		segment;
+	mep_line_t(unsigned v1, unsigned v2) { this->v1 = v1; this->v2 = v2; }
+};
+
+struct mep_thing_t
+{
+	double	x;
+	double	y;
+};
+
+// Basic map geometry used for map previews. Reading is split in two: read()
+// copies the required map lumps (must be done on the main thread), parse()
+// builds the geometry from the copies and can be done on any thread
+class MapPreviewData
+{
+public:
+	typedef std::shared_ptr<MapPreviewData> SPtr;
+
+	struct ImageColours
+	{
+		rgba_t	background;
+		rgba_t	line_1s;
+		rgba_t	line_2s;
+		rgba_t	line_special;
+		rgba_t	line_macro;
+
+		void	load();
+	};
+
+	vector<mep_vertex_t>	verts;
+	vector<mep_line_t>		lines;
+	vector<mep_thing_t>		things;
+	unsigned				n_sides = 0;
+	unsigned				n_sectors = 0;
+
+	bool		read(Archive::MapDesc map);
+	bool		parse();
+	bool		load(const Archive::MapDesc& map);
+	void		clear();
+	uint64_t	contentHash() const { return hash_; }
+	string		error() const { return error_; }
+
+	void		addVertex(double x, double y);
+	void		addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false);
+	void		addThing(double x, double y);
+
+	bool		bounds(double& min_x, double& min_y, double& max_x, double& max_y) const;
+	void		drawImage(SImage& image, int width, int height, const ImageColours& colours) const;
+
+private:
+	uint8_t		format_ = MAP_UNKNOWN;
+	string		name_;
+	MemChunk	vertexes_;
+	MemChunk	linedefs_;
+	MemChunk	things_;
+	MemChunk	textmap_;
+	unsigned	sidedefs_size_ = 0;
+	unsigned	sectors_size_ = 0;
+	uint64_t	hash_ = 0;
+	string		error_;
+
+	bool	parseUDMF();
+	bool	parseVertices();
+	bool	parseLines();
+	void	parseThings();
+};
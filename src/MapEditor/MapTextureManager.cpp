@@ -62,6 +62,7 @@ MapTextureManager::MapTextureManager(Archive* archive)
 	// Init variables
 	this->archive = archive;
 	editor_images_loaded = false;
+	tex_info_outdated = true;
 	palette = new Palette();
 }
 
@@ -104,6 +105,40 @@ Palette* MapTextureManager::getResourcePalette()
 		return theMainWindow->getPaletteChooser()->getSelectedPalette();
 }
 
+/* MapTextureManager::filterType
+ * Returns the GLTexture filter type to use for map textures/flats
+ *******************************************************************/
+int MapTextureManager::filterType()
+{
+	if (map_tex_filter == 0)
+		return GLTexture::NEAREST_LINEAR_MIN;
+	else if (map_tex_filter == 1)
+		return GLTexture::LINEAR;
+	else if (map_tex_filter == 2)
+		return GLTexture::LINEAR_MIPMAP;
+	else if (map_tex_filter == 3)
+		return GLTexture::NEAREST_MIPMAP;
+
+	return 1;
+}
+
+/* MapTextureManager::handleCacheEntry
+ * Returns the entry in [texmap] for the (upper-case) name with
+ * [handle], cached by handle in [cache]. Entries in [texmap] are
+ * never moved, so the cache stays valid until [texmap] is cleared
+ *******************************************************************/
+map_tex_t& MapTextureManager::handleCacheEntry(vector<map_tex_t*>& cache, MapTexHashMap& texmap, MapTextureNames::Handle handle)
+{
+	handle = MapTextureNames::upper(handle);
+	if (handle >= cache.size())
+		cache.resize(MapTextureNames::count(), nullptr);
+
+	if (!cache[handle])
+		cache[handle] = &texmap[MapTextureNames::name(handle)];
+
+	return *cache[handle];
+}
+
 /* MapTextureManager::getTexture
  * Returns the texture matching [name]. Loads it from resources if
  * necessary. If [mixed] is true, flats are also searched if no
@@ -113,24 +148,50 @@ GLTexture* MapTextureManager::getTexture(string name, bool mixed)
 {
 	// Get texture matching name
 	map_tex_t& mtex = textures[name.Upper()];
+	if (loadTexture(mtex, name))
+		return mtex.texture;
 
-	// Get desired filter type
-	int filter = 1;
-	if (map_tex_filter == 0)
-		filter = GLTexture::NEAREST_LINEAR_MIN;
-	else if (map_tex_filter == 1)
-		filter = GLTexture::LINEAR;
-	else if (map_tex_filter == 2)
-		filter = GLTexture::LINEAR_MIPMAP;
-	else if (map_tex_filter == 3)
-		filter = GLTexture::NEAREST_MIPMAP;
+	// Not found
+	if (mixed)
+		return getFlat(name, false);	// Try flats if mixed
+	mtex.texture = &(GLTexture::missingTex());
+	return mtex.texture;
+}
+
+/* MapTextureManager::getTexture
+ * Returns the texture matching the name with [handle]. As above, but
+ * looked up by name handle so no string hashing/comparison is needed
+ * once the texture has been used
+ *******************************************************************/
+GLTexture* MapTextureManager::getTexture(MapTextureNames::Handle handle, bool mixed)
+{
+	// Get texture matching name
+	map_tex_t& mtex = handleCacheEntry(texture_handles, textures, handle);
+	if (loadTexture(mtex, MapTextureNames::name(handle)))
+		return mtex.texture;
+
+	// Not found
+	if (mixed)
+		return getFlat(handle, false);	// Try flats if mixed
+	mtex.texture = &(GLTexture::missingTex());
+	return mtex.texture;
+}
+
+/* MapTextureManager::loadTexture
+ * Loads the texture matching [name] into [mtex] if it isn't already
+ * loaded (with the current filter). Returns false if no matching
+ * texture was found
+ *******************************************************************/
+bool MapTextureManager::loadTexture(map_tex_t& mtex, const string& name)
+{
+	int filter = filterType();
 
 	// If the texture is loaded
 	if (mtex.texture)
 	{
 		// If the texture filter matches the desired one, return it
 		if (mtex.texture->getFilter() == filter)
-			return mtex.texture;
+			return true;
 		else
 		{
 			// Otherwise, reload the texture
@@ -198,19 +259,7 @@ GLTexture* MapTextureManager::getTexture(string name, bool mixed)
 		}
 	}
 
-	// Not found
-	if (!mtex.texture)
-	{
-		// Try flats if mixed
-		if (mixed)
-			return getFlat(name, false);
-
-		// Otherwise use missing texture
-		else
-			mtex.texture = &(GLTexture::missingTex());
-	}
-
-	return mtex.texture;
+	return mtex.texture != nullptr;
 }
 
 /* MapTextureManager::getFlat
@@ -222,24 +271,49 @@ GLTexture* MapTextureManager::getFlat(string name, bool mixed)
 {
 	// Get flat matching name
 	map_tex_t& mtex = flats[name.Upper()];
+	if (loadFlat(mtex, name))
+		return mtex.texture;
 
-	// Get desired filter type
-	int filter = 1;
-	if (map_tex_filter == 0)
-		filter = GLTexture::NEAREST_LINEAR_MIN;
-	else if (map_tex_filter == 1)
-		filter = GLTexture::LINEAR;
-	else if (map_tex_filter == 2)
-		filter = GLTexture::LINEAR_MIPMAP;
-	else if (map_tex_filter == 3)
-		filter = GLTexture::NEAREST_MIPMAP;
+	// Not found
+	if (mixed)
+		return getTexture(name, false);	// Try textures if mixed
+	mtex.texture = &(GLTexture::missingTex());
+	return mtex.texture;
+}
+
+/* MapTextureManager::getFlat
+ * Returns the flat matching the name with [handle]. As above, but
+ * looked up by name handle
+ *******************************************************************/
+GLTexture* MapTextureManager::getFlat(MapTextureNames::Handle handle, bool mixed)
+{
+	// Get flat matching name
+	map_tex_t& mtex = handleCacheEntry(flat_handles, flats, handle);
+	if (loadFlat(mtex, MapTextureNames::name(handle)))
+		return mtex.texture;
+
+	// Not found
+	if (mixed)
+		return getTexture(handle, false);	// Try textures if mixed
+	mtex.texture = &(GLTexture::missingTex());
+	return mtex.texture;
+}
+
+/* MapTextureManager::loadFlat
+ * Loads the flat matching [name] into [mtex] if it isn't already
+ * loaded (with the current filter). Returns false if no matching
+ * flat was found
+ *******************************************************************/
+bool MapTextureManager::loadFlat(map_tex_t& mtex, const string& name)
+{
+	int filter = filterType();
 
 	// If the texture is loaded
 	if (mtex.texture)
 	{
 		// If the texture filter matches the desired one, return it
 		if (mtex.texture->getFilter() == filter)
-			return mtex.texture;
+			return true;
 		else
 		{
 			// Otherwise, reload the texture
@@ -269,19 +343,7 @@ GLTexture* MapTextureManager::getFlat(string name, bool mixed)
 		}
 	}
 
-	// Not found
-	if (!mtex.texture)
-	{
-		// Try textures if mixed
-		if (mixed)
-			return getTexture(name, false);
-
-		// Otherwise use missing texture
-		else
-			mtex.texture = &(GLTexture::missingTex());
-	}
-
-	return mtex.texture;
+	return mtex.texture != nullptr;
 }
 
 /* MapTextureManager::getSprite
@@ -503,10 +565,12 @@ void MapTextureManager::refreshResources()
 	textures.clear();
 	flats.clear();
 	sprites.clear();
+	texture_handles.clear();
+	flat_handles.clear();
 	theMainWindow->getPaletteChooser()->setGlobalFromArchive(archive);
 	MapEditor::forceRefresh(true);
 	palette = getResourcePalette();
-	buildTexInfoList();
+	tex_info_outdated = true;	// Rebuilt when next needed
 	//LOG_MESSAGE(1, "texture manager cleared");
 }
 
@@ -519,6 +583,7 @@ void MapTextureManager::buildTexInfoList()
 	// Clear
 	tex_info.clear();
 	flat_info.clear();
+	tex_info_outdated = false;
 
 	// --- Textures ---
 
@@ -593,11 +658,15 @@ void MapTextureManager::setArchive(Archive* archive)
 	refreshResources();
 }
 
-/* MapTextureManager::onAnnouncement
+/* MapTextureManager::onAnnouncementEvent
  * Handles announcements from any announcers listened to
  *******************************************************************/
-void MapTextureManager::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void MapTextureManager::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id archive_closing = Announcement::id("archive_closing");
+	static const Announcement::Id resources_updated = Announcement::id("resources_updated");
+	static const Announcement::Id main_palette_changed = Announcement::id("main_palette_changed");
+
 	// Only interested in the resource manager,
 	// archive manager and palette chooser.
 	if (announcer != theResourceManager
@@ -607,7 +676,7 @@ void MapTextureManager::onAnnouncement(Announcer* announcer, string event_name,
 
 	// If the map's archive is being closed,
 	// we need to close the map editor
-	if (event_name == "archive_closing")
+	if (event == archive_closing)
 	{
 		event_data.seek(0, SEEK_SET);
 		int32_t ac_index;
@@ -621,9 +690,9 @@ void MapTextureManager::onAnnouncement(Announcer* announcer, string event_name,
 	}
 
 	// If the resources have been updated
-	if (event_name == "resources_updated")
+	if (event == resources_updated)
 		refreshResources();
 
-	if (event_name == "main_palette_changed")
+	if (event == main_palette_changed)
 		refreshResources();
 }
@@ -5,6 +5,7 @@
 #include "common.h"
 #include "OpenGL/GLTexture.h"
 #include "General/ListenerAnnouncer.h"
+#include "SLADEMap/MapTextureNames.h"
 
 struct map_tex_t
 {
@@ -41,12 +42,20 @@ private:
 	Archive*				archive;
 	MapTexHashMap			textures;
 	MapTexHashMap			flats;
+	vector<map_tex_t*>		texture_handles;	// Entries in textures by name handle
+	vector<map_tex_t*>		flat_handles;		// Entries in flats by name handle
 	MapTexHashMap			sprites;
 	MapTexHashMap			editor_images;
 	bool					editor_images_loaded;
 	Palette*			palette;
 	vector<map_texinfo_t>	tex_info;
 	vector<map_texinfo_t>	flat_info;
+	bool					tex_info_outdated;
+
+	static int	filterType();
+	map_tex_t&	handleCacheEntry(vector<map_tex_t*>& cache, MapTexHashMap& texmap, MapTextureNames::Handle handle);
+	bool		loadTexture(map_tex_t& mtex, const string& name);
+	bool		loadFlat(map_tex_t& mtex, const string& name);
 
 public:
 	enum
@@ -70,14 +79,16 @@ public:
 	Palette*	getResourcePalette();
 	GLTexture*		getTexture(string name, bool mixed);
 	GLTexture*		getFlat(string name, bool mixed);
+	GLTexture*		getTexture(MapTextureNames::Handle name, bool mixed);
+	GLTexture*		getFlat(MapTextureNames::Handle name, bool mixed);
 	GLTexture*		getSprite(string name, string translation = "", string palette = "");
 	GLTexture*		getEditorImage(string name);
 	int				getVerticalOffset(string name);
 	
-	vector<map_texinfo_t>&	getAllTexturesInfo() { return tex_info; }
-	vector<map_texinfo_t>&	getAllFlatsInfo() { return flat_info; }
+	vector<map_texinfo_t>&	getAllTexturesInfo() { if (tex_info_outdated) buildTexInfoList(); return tex_info; }
+	vector<map_texinfo_t>&	getAllFlatsInfo() { if (tex_info_outdated) buildTexInfoList(); return flat_info; }
 
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 };
 
 #endif//__MAP_TEXTURE_MANAGER_H__
@@ -0,0 +1,143 @@
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    FrameStats.cpp
+ * Description: MapEditor::FrameStats namespace - keeps the CPU time
+ *              spent in each stage of drawing map editor frames
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "FrameStats.h"
+
+using namespace MapEditor;
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Number of frames to average stats over
+	const unsigned max_frames = 30;
+
+	struct frame_t
+	{
+		double	stages[(int)FrameStats::Stage::Count];	// ms
+		double	interval;								// ms since the previous frame
+	};
+
+	frame_t				frame_current	= {};
+	vector<frame_t>		frames;
+	unsigned			frame_next		= 0;
+	sf::Clock			frame_clock;
+	FrameStats::Timer*	timer_current	= nullptr;
+
+	void addTime(FrameStats::Stage stage, sf::Time time)
+	{
+		frame_current.stages[(int)stage] += time.asMicroseconds() / 1000.0;
+	}
+}
+
+
+/*******************************************************************
+ * FRAMESTATS::TIMER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* FrameStats::Timer::Timer
+ * FrameStats::Timer class constructor
+ *******************************************************************/
+FrameStats::Timer::Timer(Stage stage) :
+	stage_{ stage },
+	parent_{ timer_current }
+{
+	// Stop the outer timer while this one is running
+	if (parent_)
+		addTime(parent_->stage_, parent_->clock_.restart());
+
+	timer_current = this;
+}
+
+/* FrameStats::Timer::~Timer
+ * FrameStats::Timer class destructor
+ *******************************************************************/
+FrameStats::Timer::~Timer()
+{
+	addTime(stage_, clock_.getElapsedTime());
+
+	// Restart the outer timer
+	timer_current = parent_;
+	if (parent_)
+		parent_->clock_.restart();
+}
+
+
+/*******************************************************************
+ * FRAMESTATS NAMESPACE FUNCTIONS
+ *******************************************************************/
+
+/* FrameStats::endFrame
+ * Records the stage times since the previous frame as a frame
+ *******************************************************************/
+void FrameStats::endFrame()
+{
+	frame_current.interval = frame_clock.restart().asMicroseconds() / 1000.0;
+
+	if (frames.size() < max_frames)
+		frames.push_back(frame_current);
+	else
+		frames[frame_next] = frame_current;
+	frame_next = (frame_next + 1) % max_frames;
+
+	frame_current = {};
+}
+
+/* FrameStats::stageTime
+ * Returns the average time (ms) spent in [stage] per frame
+ *******************************************************************/
+double FrameStats::stageTime(Stage stage)
+{
+	if (frames.empty())
+		return 0;
+
+	double total = 0;
+	for (auto& frame : frames)
+		total += frame.stages[(int)stage];
+
+	return total / frames.size();
+}
+
+/* FrameStats::frameInterval
+ * Returns the average time (ms) between frames
+ *******************************************************************/
+double FrameStats::frameInterval()
+{
+	if (frames.empty())
+		return 0;
+
+	double total = 0;
+	for (auto& frame : frames)
+		total += frame.interval;
+
+	return total / frames.size();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace MapEditor
+{
+	// CPU time spent in each stage of map editor frames, averaged over the
+	// last few frames drawn
+	namespace FrameStats
+	{
+		enum class Stage
+		{
+			Update,		// Editor state, hilight and animation updates
+			Visibility,	// Map object visibility checks
+			Upload,		// VBO updates
+			Draw,		// Everything else done while drawing
+			Present,	// Buffer swap and waiting for the GPU to finish (glFinish)
+
+			Count
+		};
+
+		// Adds the time from construction to destruction to [stage]. Time
+		// spent in nested timers is only added to the innermost stage
+		class Timer
+		{
+		public:
+			Timer(Stage stage);
+			~Timer();
+
+		private:
+			Stage		stage_;
+			sf::Clock	clock_;
+			Timer*		parent_;
+		};
+
+		void	endFrame();
+		double	stageTime(Stage stage);
+		double	frameInterval();
+	}
+}
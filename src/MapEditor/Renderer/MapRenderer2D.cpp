@@ -30,6 +30,7 @@
  *******************************************************************/
 #include "Main.h"
 #include "App.h"
+#include "FrameStats.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/ObjectEdit.h"
@@ -1815,14 +1816,14 @@ void MapRenderer2D::renderFlatsImmediate(int type, bool texture, float alpha)
 				if (type <= 1)
 				{
 					tex = MapEditor::textureManager().getFlat(
-						sector->getFloorTex(),
+						sector->floorTexHandle(),
 						Game::configuration().featureSupported(Feature::MixTexFlats)
 					);
 				}
 				else
 				{
 					tex = MapEditor::textureManager().getFlat(
-						sector->getCeilingTex(),
+						sector->ceilingTexHandle(),
 						Game::configuration().featureSupported(Feature::MixTexFlats)
 					);
 				}
@@ -1991,9 +1992,9 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 			{
 				// Get the sector texture
 				if (type <= 1)
-					tex = MapEditor::textureManager().getFlat(sector->getFloorTex(), Game::configuration().featureSupported(Feature::MixTexFlats));
+					tex = MapEditor::textureManager().getFlat(sector->floorTexHandle(), Game::configuration().featureSupported(Feature::MixTexFlats));
 				else
-					tex = MapEditor::textureManager().getFlat(sector->getCeilingTex(), Game::configuration().featureSupported(Feature::MixTexFlats));
+					tex = MapEditor::textureManager().getFlat(sector->ceilingTexHandle(), Game::configuration().featureSupported(Feature::MixTexFlats));
 
 				tex_flats[a] = tex;
 			}
@@ -2060,6 +2061,7 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		// Update polygon VBO data if needed
 		if (poly->vboUpdate() > 0)
 		{
+			MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
 			poly->updateVBOData();
 			update++;
 			if (update > 200)
@@ -2784,6 +2786,8 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
  *******************************************************************/
 void MapRenderer2D::updateVerticesVBO()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
+
 	// Create VBO if needed
 	if (vbo_vertices == 0)
 		glGenBuffers(1, &vbo_vertices);
@@ -2813,6 +2817,8 @@ void MapRenderer2D::updateVerticesVBO()
  *******************************************************************/
 void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
+
 	LOG_MESSAGE(3, "Updating lines VBO");
 
 	// Create VBO if needed
@@ -2885,6 +2891,8 @@ void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
  *******************************************************************/
 void MapRenderer2D::updateFlatsVBO()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
+
 	if (!flats_use_vbo)
 		return;
 
@@ -2925,6 +2933,8 @@ void MapRenderer2D::updateFlatsVBO()
  *******************************************************************/
 void MapRenderer2D::updateVisibility(fpoint2_t view_tl, fpoint2_t view_br)
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Visibility);
+
 	// Sector visibility
 	if (map->nSectors() != vis_s.size())
 	{
@@ -30,6 +30,7 @@
  *******************************************************************/
 #include "Main.h"
 #include "App.h"
+#include "FrameStats.h"
 #include "Game/Configuration.h"
 #include "General/ColourConfiguration.h"
 #include "General/ResourceManager.h"
@@ -877,7 +878,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	MapSector* sector = map->getSector(index);
 	floors[index].sector = sector;
 	floors[index].texture = MapEditor::textureManager().getFlat(
-		sector->getFloorTex(),
+		sector->floorTexHandle(),
 		Game::configuration().featureSupported(Game::Feature::MixTexFlats)
 	);
 	floors[index].colour = sector->getColour(1, true);
@@ -891,6 +892,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	// Update floor VBO
 	if (OpenGL::vboSupport())
 	{
+		MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
 		updateFlatTexCoords(index, true);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_floors);
 		Polygon2D::setupVBOPointers();
@@ -901,7 +903,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	// Update ceiling
 	ceilings[index].sector = sector;
 	ceilings[index].texture = MapEditor::textureManager().getFlat(
-		sector->getCeilingTex(),
+		sector->ceilingTexHandle(),
 		Game::configuration().featureSupported(Game::Feature::MixTexFlats)
 	);
 	ceilings[index].colour = sector->getColour(2, true);
@@ -915,6 +917,7 @@ void MapRenderer3D::updateSector(unsigned index)
 	// Update ceiling VBO
 	if (OpenGL::vboSupport())
 	{
+		MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
 		updateFlatTexCoords(index, false);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_ceilings);
 		Polygon2D::setupVBOPointers();
@@ -1226,8 +1229,8 @@ void MapRenderer3D::updateLine(unsigned index)
 
 	// Get relevant line info
 	int map_format = MapEditor::editContext().mapDesc().format;
-	bool upeg = Game::configuration().lineBasicFlagSet("dontpegtop", line, map_format);
-	bool lpeg = Game::configuration().lineBasicFlagSet("dontpegbottom", line, map_format);
+	bool upeg = Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::DontPegTop, line, map_format);
+	bool lpeg = Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::DontPegBottom, line, map_format);
 	double xoff, yoff, sx, sy;
 	bool mixed = Game::configuration().featureSupported(Feature::MixTexFlats);
 	lines[index].line = line;
@@ -1301,7 +1304,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.colour = colour1;
 		quad.fogcolour = fogcolour1;
 		quad.light = light1;
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexMiddle(), mixed);
+		quad.texture = MapEditor::textureManager().getTexture(line->s1()->texMiddleHandle(), mixed);
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling1, floor1, lpeg, sx, sy);
 
 		// Add middle quad and finish
@@ -1395,7 +1398,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.colour = colour1;
 		quad.fogcolour = fogcolour1;
 		quad.light = light1;
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexLower(), mixed);
+		quad.texture = MapEditor::textureManager().getTexture(line->s1()->texLowerHandle(), mixed);
 		setupQuadTexCoords(&quad, length, xoff, yoff, floor2, floor1, false, sx, sy);
 		// No, the sky hack is only for ceilings!
 		// if (S_CMPNOCASE(sky_flat, line->backSector()->getFloorTex())) quad.flags |= SKY;
@@ -1519,7 +1522,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.colour = colour1;
 		quad.fogcolour = fogcolour1;
 		quad.light = light1;
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexUpper(), mixed);
+		quad.texture = MapEditor::textureManager().getTexture(line->s1()->texUpperHandle(), mixed);
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling1, ceiling2, !upeg, sx, sy);
 		// Sky hack only applies if both sectors have a sky ceiling
 		if (S_CMPNOCASE(sky_flat, line->frontSector()->getCeilingTex()) && S_CMPNOCASE(sky_flat, line->backSector()->getCeilingTex())) quad.flags |= SKY;
@@ -1566,7 +1569,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.colour = colour2;
 		quad.fogcolour = fogcolour2;
 		quad.light = light2;
-		quad.texture = MapEditor::textureManager().getTexture(line->s2()->getTexLower(), mixed);
+		quad.texture = MapEditor::textureManager().getTexture(line->s2()->texLowerHandle(), mixed);
 		setupQuadTexCoords(&quad, length, xoff, yoff, floor1, floor2, false, sx, sy);
 		if (S_CMPNOCASE(sky_flat, line->frontSector()->getFloorTex())) quad.flags |= SKY;
 		quad.flags |= BACK;
@@ -1690,7 +1693,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.colour = colour2;
 		quad.fogcolour = fogcolour2;
 		quad.light = light2;
-		quad.texture = MapEditor::textureManager().getTexture(line->s2()->getTexUpper(), mixed);
+		quad.texture = MapEditor::textureManager().getTexture(line->s2()->texUpperHandle(), mixed);
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling2, ceiling1, !upeg, sx, sy);
 		if (S_CMPNOCASE(sky_flat, line->frontSector()->getCeilingTex())) quad.flags |= SKY;
 		quad.flags |= BACK;
@@ -2322,6 +2325,8 @@ void MapRenderer3D::renderThingSelection(const ItemSelection& selection, float a
  *******************************************************************/
 void MapRenderer3D::updateFlatsVBO()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Upload);
+
 	if (!flats_use_vbo)
 		return;
 
@@ -2406,6 +2411,8 @@ void MapRenderer3D::updateWallsVBO()
  *******************************************************************/
 void MapRenderer3D::quickVisDiscard()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Visibility);
+
 	// Create sector distance array if needed
 	if (dist_sectors.size() != map->nSectors())
 		dist_sectors.resize(map->nSectors());
@@ -2489,6 +2496,8 @@ float MapRenderer3D::calcDistFade(double distance, double max)
  *******************************************************************/
 void MapRenderer3D::checkVisibleQuads()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Visibility);
+
 	// Create quads array if empty
 	if (!quads)
 		quads = (quad_3d_t**)malloc(sizeof(quad_3d_t*) * map->nLines() * 4);
@@ -2573,6 +2582,8 @@ void MapRenderer3D::checkVisibleQuads()
  *******************************************************************/
 void MapRenderer3D::checkVisibleFlats()
 {
+	MapEditor::FrameStats::Timer timer(MapEditor::FrameStats::Stage::Visibility);
+
 	// Create flats array if empty
 	if (!flats)
 		flats = (flat_3d_t**)malloc(sizeof(flat_3d_t*) * map->nSectors() * 2);
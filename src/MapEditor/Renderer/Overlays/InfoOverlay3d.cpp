@@ -115,11 +115,11 @@ void InfoOverlay3D::update(int item_index, MapEditor::ItemType item_type, SLADEM
 
 		// Relevant flags
 		string flags = "";
-		if (Game::configuration().lineBasicFlagSet("dontpegtop", line, map_format))
+		if (Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::DontPegTop, line, map_format))
 			flags += "Upper Unpegged, ";
-		if (Game::configuration().lineBasicFlagSet("dontpegbottom", line, map_format))
+		if (Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::DontPegBottom, line, map_format))
 			flags += "Lower Unpegged, ";
-		if (Game::configuration().lineBasicFlagSet("blocking", line, map_format))
+		if (Game::configuration().lineBasicFlagSet(Game::LineBasicFlag::Blocking, line, map_format))
 			flags += "Blocking, ";
 		if (!flags.IsEmpty())
 			flags.RemoveLast(2);
@@ -30,6 +30,7 @@
  *******************************************************************/
 #include "Main.h"
 #include "App.h"
+#include "FrameStats.h"
 #include "Game/Configuration.h"
 #include "General/Clipboard.h"
 #include "General/ColourConfiguration.h"
@@ -545,6 +546,27 @@ void Renderer::drawEditorMessages() const
 	Drawing::enableTextStateReset(true);
 }
 
+/* Renderer::drawFrameStats
+ * Draws the frame rate and the average CPU time spent in each stage
+ * of recent frames
+ *******************************************************************/
+void Renderer::drawFrameStats() const
+{
+	double interval = FrameStats::frameInterval();
+	int fps = interval > 0 ? MathStuff::round(1000.0 / interval) : 0;
+
+	glEnable(GL_TEXTURE_2D);
+	Drawing::drawText(S_FMT(
+		"FPS: %d  Update: %1.2fms  Visibility: %1.2fms  Upload: %1.2fms  Draw: %1.2fms  Swap/Finish: %1.2fms",
+		fps,
+		FrameStats::stageTime(FrameStats::Stage::Update),
+		FrameStats::stageTime(FrameStats::Stage::Visibility),
+		FrameStats::stageTime(FrameStats::Stage::Upload),
+		FrameStats::stageTime(FrameStats::Stage::Draw),
+		FrameStats::stageTime(FrameStats::Stage::Present)
+	));
+}
+
 /* Renderer::drawFeatureHelpText
  * Draws any feature help text currently showing
  *******************************************************************/
@@ -1314,22 +1336,9 @@ void Renderer::draw()
 		}
 	}
 
-	// FPS counter
-	/*if (map_showfps)
-	{
-		glEnable(GL_TEXTURE_2D);
-		if (frametime_last > 0)
-		{
-			int fps = MathStuff::round(1.0 / (frametime_last / 1000.0));
-			fps_avg.push_back(fps);
-			if (fps_avg.size() > 20) fps_avg.erase(fps_avg.begin());
-		}
-		int afps = 0;
-		for (unsigned a = 0; a < fps_avg.size(); a++)
-			afps += fps_avg[a];
-		if (fps_avg.size() > 0) afps /= fps_avg.size();
-		Drawing::drawText(S_FMT("FPS: %d", afps));
-	}*/
+	// FPS counter and frame time stats
+	if (map_showfps)
+		drawFrameStats();
 
 	// test
 	//Drawing::drawText(S_FMT("Render distance: %1.2f", (double)render_max_dist), 0, 100);
@@ -74,6 +74,7 @@ namespace MapEditor
 		// Drawing
 		void	drawGrid() const;
 		void	drawEditorMessages() const;
+		void	drawFrameStats() const;
 		void	drawFeatureHelpText() const;
 		void	drawSelectionNumbers() const;
 		void	drawThingQuickAngleLines() const;
@@ -0,0 +1,531 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapGeometry.cpp
+// Description: MapGeometry class, keeps contiguous arrays of the map's vertex
+//              positions, line segments/indices, side sectors and sector
+//              bounding boxes for fast whole-map passes, and a grid of
+//              lines for searches limited to an area
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapGeometry.h"
+#include "SLADEMap.h"
+#include "Utility/MathStuff.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// Past this many changed objects it's quicker to just rebuild
+	const unsigned max_changed = 4096;
+
+	// Line grid cells are at least this size (in map units), and there are
+	// at most this many cells per line
+	const double	grid_min_cell_size = 64;
+	const unsigned	grid_max_cells_per_line = 2;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapGeometry Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapGeometry::objectChanged
+//
+// Marks [object] as changed, it will be updated the next time the arrays are
+// used. This is called before the object is modified
+// ----------------------------------------------------------------------------
+void MapGeometry::objectChanged(MapObject* object)
+{
+	if (!addChanged(object))
+		return;
+
+	// A side changing sector also changes the bounding box of the sector it
+	// is currently in
+	if (object->getObjType() == MOBJ_SIDE && ((MapSide*)object)->getSector())
+		addChanged(((MapSide*)object)->getSector());
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::objectAdded
+//
+// Marks [object] as created, it will be added the next time the arrays are
+// used. This is called from the MapObject constructor, so only the base
+// MapObject is valid at this point
+// ----------------------------------------------------------------------------
+void MapGeometry::objectAdded(MapObject* object)
+{
+	addChanged(object);
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::invalidate
+//
+// Marks the arrays as invalid, they will be fully rebuilt the next time they
+// are used
+// ----------------------------------------------------------------------------
+void MapGeometry::invalidate()
+{
+	valid_ = false;
+	changed_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::update
+//
+// Updates the arrays for all changed objects, or rebuilds them if they aren't
+// valid
+// ----------------------------------------------------------------------------
+void MapGeometry::update()
+{
+	if (!valid_)
+	{
+		rebuild();
+		return;
+	}
+
+	if (changed_.empty())
+		return;
+
+	// Objects may have been created since the last update (removing objects
+	// invalidates the arrays, so they can only grow here)
+	if (vertex_pos_.size() != map_.nVertices() || line_seg_.size() != map_.nLines())
+		line_version_++;
+	vertex_pos_.resize(map_.nVertices());
+	line_seg_.resize(map_.nLines());
+	line_index_.resize(map_.nLines());
+	line_cells_.resize(map_.nLines(), { -1, -1, -1, -1 });
+	side_sector_.resize(map_.nSides());
+	sector_bbox_.resize(map_.nSectors());
+
+	// Vertices first, a moved vertex also changes its lines (and their
+	// sectors' bounding boxes)
+	vector<MapLine*> lines;
+	vector<MapSector*> sectors;
+	for (auto object : changed_)
+	{
+		unsigned index = object->getIndex();
+		switch (object->getObjType())
+		{
+		case MOBJ_VERTEX:
+		{
+			auto vertex = (MapVertex*)object;
+			if (index >= vertex_pos_.size() || map_.vertices()[index] != vertex)
+				continue;
+
+			fpoint2_t pos = vertex->point();
+			if (pos.x != vertex_pos_[index].x || pos.y != vertex_pos_[index].y)
+				line_version_++;
+			vertex_pos_[index] = pos;
+			for (auto line : vertex->connectedLines())
+				lines.push_back(line);
+			break;
+		}
+		case MOBJ_LINE:
+			if (index < line_seg_.size() && map_.lines()[index] == object)
+				lines.push_back((MapLine*)object);
+			break;
+		case MOBJ_SIDE:
+		{
+			auto side = (MapSide*)object;
+			if (index >= side_sector_.size() || map_.sides()[index] != side)
+				continue;
+
+			updateSide(side);
+			if (side->getSector())
+				sectors.push_back(side->getSector());
+			break;
+		}
+		case MOBJ_SECTOR:
+			if (index < sector_bbox_.size() && map_.sectors()[index] == object)
+				sectors.push_back((MapSector*)object);
+			break;
+		default:
+			break;
+		}
+	}
+	changed_.clear();
+
+	for (auto line : lines)
+	{
+		if (updateLine(line))
+			line_version_++;
+		if (line->frontSector())
+			sectors.push_back(line->frontSector());
+		if (line->backSector())
+			sectors.push_back(line->backSector());
+	}
+	for (auto sector : sectors)
+		if (sector->getIndex() < sector_bbox_.size() && map_.sectors()[sector->getIndex()] == sector)
+			updateSector(sector);
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::addChanged
+//
+// Adds [object] to the changed list if it is part of the arrays. Returns
+// false if it wasn't added
+// ----------------------------------------------------------------------------
+bool MapGeometry::addChanged(MapObject* object)
+{
+	// Everything is rebuilt anyway if the arrays aren't valid
+	if (!valid_ || object->getObjType() == MOBJ_THING)
+		return false;
+
+	if (changed_.size() >= max_changed)
+	{
+		invalidate();
+		return false;
+	}
+
+	changed_.push_back(object);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::rebuild
+//
+// Rebuilds all arrays from the map's objects
+// ----------------------------------------------------------------------------
+void MapGeometry::rebuild()
+{
+	auto& vertices = map_.vertices();
+	vertex_pos_.resize(vertices.size());
+	for (unsigned a = 0; a < vertices.size(); a++)
+		vertex_pos_[a] = vertices[a]->point();
+
+	line_seg_.resize(map_.nLines());
+	line_index_.resize(map_.nLines());
+	setupGrid();
+	for (auto line : map_.lines())
+		updateLine(line);
+
+	side_sector_.resize(map_.nSides());
+	for (auto side : map_.sides())
+		updateSide(side);
+
+	sector_bbox_.resize(map_.nSectors());
+	for (auto sector : map_.sectors())
+		updateSector(sector);
+
+	valid_ = true;
+	changed_.clear();
+	line_version_++;
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::setupGrid
+//
+// Clears the line grid and sets its size to cover all vertices, with roughly
+// as many cells as there are lines
+// ----------------------------------------------------------------------------
+void MapGeometry::setupGrid()
+{
+	// (not using bbox_t::extend, which restarts at a vertex on 0,0)
+	bbox_t bounds;
+	if (!vertex_pos_.empty())
+		bounds.min = bounds.max = vertex_pos_[0];
+	for (auto& pos : vertex_pos_)
+	{
+		bounds.min.set(MIN(bounds.min.x, pos.x), MIN(bounds.min.y, pos.y));
+		bounds.max.set(MAX(bounds.max.x, pos.x), MAX(bounds.max.y, pos.y));
+	}
+
+	double width = MAX(bounds.max.x - bounds.min.x, 1.0);
+	double height = MAX(bounds.max.y - bounds.min.y, 1.0);
+	double max_cells = MAX(1.0, (double)line_seg_.size() * grid_max_cells_per_line);
+	grid_cell_size_ = MAX(grid_min_cell_size, sqrt(width * height / max_cells));
+	grid_origin_ = bounds.min;
+	grid_cols_ = (int)MIN(width / grid_cell_size_ + 1, 65536.0);
+	grid_rows_ = (int)MIN(height / grid_cell_size_ + 1, 65536.0);
+
+	grid_cells_.clear();
+	grid_cells_.resize((size_t)grid_cols_ * grid_rows_);
+	line_cells_.assign(line_seg_.size(), { -1, -1, -1, -1 });
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::gridCells
+//
+// Gets the range of line grid cells overlapping the box [x1,y1]-[x2,y2], as
+// [cells]. Anything outside the grid is clamped to the cells on its edges
+// ----------------------------------------------------------------------------
+void MapGeometry::gridCells(double x1, double y1, double x2, double y2, CellRange& cells) const
+{
+	auto clamp = [](double value, int max) { return (int)MAX(0.0, MIN(value, (double)max - 1)); };
+	cells.x1 = clamp(floor((MIN(x1, x2) - grid_origin_.x) / grid_cell_size_), grid_cols_);
+	cells.x2 = clamp(floor((MAX(x1, x2) - grid_origin_.x) / grid_cell_size_), grid_cols_);
+	cells.y1 = clamp(floor((MIN(y1, y2) - grid_origin_.y) / grid_cell_size_), grid_rows_);
+	cells.y2 = clamp(floor((MAX(y1, y2) - grid_origin_.y) / grid_cell_size_), grid_rows_);
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::forEachLineCell
+//
+// Calls [func] with the index of each grid cell [seg] passes through, found
+// with an Amanatides-Woo grid traversal (both cells are used where the segment
+// passes exactly through a cell corner). [cells] is the segment's bounding box
+// cell range - segments that aren't entirely within the grid (created since
+// the last rebuild) use all cells in it instead, so they are in the cells on
+// the grid edges nearest to them
+// ----------------------------------------------------------------------------
+template<class F>
+void MapGeometry::forEachLineCell(const fseg2_t& seg, const CellRange& cells, F func) const
+{
+	// Get segment in grid cell units
+	double x1 = (seg.x1() - grid_origin_.x) / grid_cell_size_;
+	double y1 = (seg.y1() - grid_origin_.y) / grid_cell_size_;
+	double x2 = (seg.x2() - grid_origin_.x) / grid_cell_size_;
+	double y2 = (seg.y2() - grid_origin_.y) / grid_cell_size_;
+	int cx = (int)floor(x1);
+	int cy = (int)floor(y1);
+	int ex = (int)floor(x2);
+	int ey = (int)floor(y2);
+
+	// Outside the grid, use the (clamped) bounding box cells
+	if (MIN(x1, x2) < 0 || MIN(y1, y2) < 0 ||
+		MAX(cx, ex) >= grid_cols_ || MAX(cy, ey) >= grid_rows_)
+	{
+		for (int y = cells.y1; y <= cells.y2; y++)
+			for (int x = cells.x1; x <= cells.x2; x++)
+				func(y * grid_cols_ + x);
+		return;
+	}
+
+	// Setup traversal: t (0-1 along the segment) of the next vertical and
+	// horizontal cell boundaries crossed, and the t between boundaries
+	double dx = x2 - x1;
+	double dy = y2 - y1;
+	int step_x = dx > 0 ? 1 : -1;
+	int step_y = dy > 0 ? 1 : -1;
+	double t_delta_x = dx != 0 ? fabs(1.0 / dx) : 0;
+	double t_delta_y = dy != 0 ? fabs(1.0 / dy) : 0;
+	double t_max_x = dx > 0 ? (cx + 1 - x1) / dx : dx < 0 ? (x1 - cx) / -dx : 0;
+	double t_max_y = dy > 0 ? (cy + 1 - y1) / dy : dy < 0 ? (y1 - cy) / -dy : 0;
+
+	// Step through the cells until the end cell is reached (never going past
+	// it in either direction, in case of rounding errors)
+	func(cy * grid_cols_ + cx);
+	while (cx != ex || cy != ey)
+	{
+		bool move_x = cy == ey || (cx != ex && t_max_x <= t_max_y);
+		bool move_y = cx == ex || (cy != ey && t_max_y <= t_max_x);
+
+		// Exactly through a corner, add the cells on both sides
+		if (move_x && move_y)
+		{
+			func(cy * grid_cols_ + cx + step_x);
+			func((cy + step_y) * grid_cols_ + cx);
+		}
+
+		if (move_x)
+		{
+			cx += step_x;
+			t_max_x += t_delta_x;
+		}
+		if (move_y)
+		{
+			cy += step_y;
+			t_max_y += t_delta_y;
+		}
+
+		func(cy * grid_cols_ + cx);
+	}
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::updateLine
+//
+// Updates the segment and indices of [line], and moves it to the grid cells
+// its new segment passes through. Returns true if the line's vertices changed
+// ----------------------------------------------------------------------------
+bool MapGeometry::updateLine(MapLine* line)
+{
+	unsigned index = line->getIndex();
+
+	// Remove from previous grid cells (the segment hasn't been updated yet,
+	// so gives the same cells it was added to)
+	CellRange& cells = line_cells_[index];
+	if (cells.x1 >= 0)
+	{
+		forEachLineCell(line_seg_[index], cells, [&](int cell_index)
+		{
+			auto& cell = grid_cells_[cell_index];
+			auto i = std::find(cell.begin(), cell.end(), (int)index);
+			if (i != cell.end())
+			{
+				*i = cell.back();
+				cell.pop_back();
+			}
+		});
+	}
+
+	LineIndices& indices = line_index_[index];
+	int v1 = indices.v1;
+	int v2 = indices.v2;
+	indices.v1 = line->v1() ? line->v1()->getIndex() : -1;
+	indices.v2 = line->v2() ? line->v2()->getIndex() : -1;
+	indices.s1 = line->s1() ? line->s1()->getIndex() : -1;
+	indices.s2 = line->s2() ? line->s2()->getIndex() : -1;
+
+	if (indices.v1 >= 0 && indices.v2 >= 0)
+		line_seg_[index] = fseg2_t(vertex_pos_[indices.v1], vertex_pos_[indices.v2]);
+	else
+		line_seg_[index] = fseg2_t();
+
+	// Add to new grid cells
+	const fseg2_t& seg = line_seg_[index];
+	gridCells(seg.tl.x, seg.tl.y, seg.br.x, seg.br.y, cells);
+	forEachLineCell(seg, cells, [&](int cell_index) { grid_cells_[cell_index].push_back(index); });
+
+	return indices.v1 != v1 || indices.v2 != v2;
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::gridBounds
+//
+// Returns the area covered by the line grid. Lines outside it (created since
+// the last rebuild) are in the cells on its edges
+// ----------------------------------------------------------------------------
+bbox_t MapGeometry::gridBounds() const
+{
+	bbox_t bounds;
+	bounds.min = grid_origin_;
+	bounds.max.set(
+		grid_origin_.x + grid_cols_ * grid_cell_size_,
+		grid_origin_.y + grid_rows_ * grid_cell_size_
+	);
+	return bounds;
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::linesInBox
+//
+// Adds the indices of all lines in the grid cells overlapping the box
+// [x1,y1]-[x2,y2] to [lines] (each only once). This can include lines near
+// but outside the box, so anything using it still needs to check the lines
+// ----------------------------------------------------------------------------
+void MapGeometry::linesInBox(double x1, double y1, double x2, double y2, vector<int>& lines) const
+{
+	if (grid_cells_.empty())
+		return;
+
+	CellRange cells;
+	gridCells(x1, y1, x2, y2, cells);
+	size_t start = lines.size();
+	for (int y = cells.y1; y <= cells.y2; y++)
+		for (int x = cells.x1; x <= cells.x2; x++)
+		{
+			auto& cell = grid_cells_[y * grid_cols_ + x];
+			lines.insert(lines.end(), cell.begin(), cell.end());
+		}
+
+	// Lines can be in multiple cells
+	if (cells.x1 != cells.x2 || cells.y1 != cells.y2)
+	{
+		std::sort(lines.begin() + start, lines.end());
+		lines.erase(std::unique(lines.begin() + start, lines.end()), lines.end());
+	}
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::updateSide
+//
+// Updates the sector index of [side]
+// ----------------------------------------------------------------------------
+void MapGeometry::updateSide(MapSide* side)
+{
+	side_sector_[side->getIndex()] = side->getSector() ? side->getSector()->getIndex() : -1;
+}
+
+// ----------------------------------------------------------------------------
+// MapGeometry::updateSector
+//
+// Updates the bounding box of [sector], from the segments of its lines (the
+// same as MapSector::updateBBox)
+// ----------------------------------------------------------------------------
+void MapGeometry::updateSector(MapSector* sector)
+{
+	bbox_t bbox;
+	for (auto side : sector->connectedSides())
+	{
+		MapLine* line = side->getParentLine();
+		if (!line)
+			continue;
+
+		const fseg2_t& seg = line_seg_[line->getIndex()];
+		bbox.extend(seg.tl.x, seg.tl.y);
+		bbox.extend(seg.br.x, seg.br.y);
+	}
+
+	sector_bbox_[sector->getIndex()] = bbox;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapGeometry Static Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapGeometry::distanceToLine
+//
+// Returns the minimum distance from [point] to the line segment [seg] (the
+// same as MapLine::distanceTo)
+// ----------------------------------------------------------------------------
+double MapGeometry::distanceToLine(const fseg2_t& seg, fpoint2_t point)
+{
+	double dx = seg.br.x - seg.tl.x;
+	double dy = seg.br.y - seg.tl.y;
+	double length = sqrt(dx * dx + dy * dy);
+	if (length == 0)
+		return MathStuff::distance(seg.tl, point);
+
+	// Calculate intersection point, clipped to the line (but not exactly on
+	// the endpoints)
+	double ca = dx / length;
+	double sa = dy / length;
+	double mx = (point.x - seg.tl.x) * ca + (point.y - seg.tl.y) * sa;
+	if (mx <= 0)
+		mx = 0.00001;
+	else if (mx >= length)
+		mx = length - 0.00001;
+	double ix = seg.tl.x + mx * ca;
+	double iy = seg.tl.y + mx * sa;
+
+	return sqrt((ix - point.x) * (ix - point.x) + (iy - point.y) * (iy - point.y));
+}
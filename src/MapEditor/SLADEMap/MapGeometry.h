@@ -0,0 +1,88 @@
+#pragma once
+
+class SLADEMap;
+class MapObject;
+class MapVertex;
+class MapLine;
+class MapSide;
+class MapSector;
+
+// Keeps the map's hot geometry data (vertex positions, line segments and
+// vertex/side indices, side sectors and sector bounding boxes) in contiguous
+// arrays indexed by object index, so whole-map passes don't have to follow
+// pointers to every object. Lines are also kept in a uniform grid, for
+// searches limited to an area. Changed and created objects are updated the
+// next time the arrays are used, everything is rebuilt after objects are
+// deleted or reindexed
+class MapGeometry
+{
+public:
+	struct LineIndices
+	{
+		int	v1;
+		int	v2;
+		int	s1;	// -1 if none
+		int	s2;	// -1 if none
+	};
+
+	MapGeometry(SLADEMap& map) : map_(map) {}
+
+	void	objectChanged(MapObject* object);
+	void	objectAdded(MapObject* object);
+	void	invalidate();
+	void	update();
+
+	const vector<fpoint2_t>&	vertexPositions() const { return vertex_pos_; }
+	const vector<fseg2_t>&		lineSegs() const { return line_seg_; }
+	const vector<LineIndices>&	lineIndices() const { return line_index_; }
+	const vector<int>&			sideSectors() const { return side_sector_; }
+	const vector<bbox_t>&		sectorBBoxes() const { return sector_bbox_; }
+
+	// Line grid
+	double	gridCellSize() const { return grid_cell_size_; }
+	bbox_t	gridBounds() const;
+	void	linesInBox(double x1, double y1, double x2, double y2, vector<int>& lines) const;
+
+	// Incremented whenever any vertex position or line's vertices change (or
+	// vertices/lines are created or deleted), but not for other changes
+	unsigned	lineVersion() const { return line_version_; }
+
+	static double	distanceToLine(const fseg2_t& seg, fpoint2_t point);
+
+private:
+	SLADEMap&				map_;
+	bool					valid_	= false;
+	vector<MapObject*>		changed_;
+
+	vector<fpoint2_t>		vertex_pos_;
+	vector<fseg2_t>			line_seg_;
+	vector<LineIndices>		line_index_;
+	vector<int>				side_sector_;
+	vector<bbox_t>			sector_bbox_;
+	unsigned				line_version_	= 0;
+
+	// Line grid
+	struct CellRange
+	{
+		int	x1;	// -1 if not in the grid
+		int	y1;
+		int	x2;
+		int	y2;
+	};
+	double					grid_cell_size_	= 0;
+	fpoint2_t				grid_origin_;
+	int						grid_cols_		= 0;
+	int						grid_rows_		= 0;
+	vector<vector<int>>		grid_cells_;
+	vector<CellRange>		line_cells_;	// Bounding box cells of each line's segment
+
+	bool	addChanged(MapObject* object);
+	void	rebuild();
+	void	setupGrid();
+	void	gridCells(double x1, double y1, double x2, double y2, CellRange& cells) const;
+	template<class F>
+	void	forEachLineCell(const fseg2_t& seg, const CellRange& cells, F func) const;
+	bool	updateLine(MapLine* line);
+	void	updateSide(MapSide* side);
+	void	updateSector(MapSector* sector);
+};
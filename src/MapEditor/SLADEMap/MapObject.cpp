@@ -39,6 +39,8 @@
  * VARIABLES
  *******************************************************************/
 long prop_backup_time = -1;
+unsigned prop_backup_journal = 0;
+vector<MapObject*> prop_backup_objects;
 
 
 /*******************************************************************
@@ -59,6 +61,9 @@ MapObject::MapObject(int type, SLADEMap* parent)
 	this->id = 0;
 	this->obj_backup = nullptr;
 
+	// Objects created while recording undo have nothing to back up
+	this->backup_journal = prop_backup_journal;
+
 	if (parent)
 		parent->addMapObject(this);
 }
@@ -110,14 +115,21 @@ string MapObject::getTypeName()
  *******************************************************************/
 void MapObject::setModified()
 {
-	// Backup current properties if required
-	if (modified_time < prop_backup_time)
+	// Backup current properties if required (only the first time the
+	// object is modified since property backup began)
+	if (prop_backup_time >= 0 && backup_journal != prop_backup_journal)
 	{
 		if (obj_backup) delete obj_backup;
 		obj_backup = new mobj_backup_t();
 		backup(obj_backup);
+		backup_journal = prop_backup_journal;
+		prop_backup_objects.push_back(this);
 	}
 
+	// Object will need reindexing
+	if (parent_map)
+		parent_map->objectChanged(this);
+
 	modified_time = App::runTimer();
 }
 
@@ -151,8 +163,9 @@ void MapObject::copy(MapObject* c)
 bool MapObject::boolProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getBoolValue();
+	Property value;
+	if (properties.get(key, value))
+		return value.getBoolValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -171,8 +184,9 @@ bool MapObject::boolProperty(const string& key)
 int MapObject::intProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getIntValue();
+	Property value;
+	if (properties.get(key, value))
+		return value.getIntValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -191,8 +205,9 @@ int MapObject::intProperty(const string& key)
 double MapObject::floatProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getFloatValue();
+	Property value;
+	if (properties.get(key, value))
+		return value.getFloatValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -211,8 +226,9 @@ double MapObject::floatProperty(const string& key)
 string MapObject::stringProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getStringValue();
+	Property value;
+	if (properties.get(key, value))
+		return value.getStringValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -345,11 +361,19 @@ long MapObject::propBackupTime()
 
 /* MapObject::beginPropBackup
  * Begins property backup, any time a MapObject property is changed
- * it's properties will be backed up before changing (only once)
+ * it's properties will be backed up before changing (only once).
+ * Backed up objects are added to the property backup journal, which
+ * is cleared here. A [current_time] of -1 ends property backup but
+ * keeps the journal
  *******************************************************************/
 void MapObject::beginPropBackup(long current_time)
 {
 	prop_backup_time = current_time;
+	if (current_time < 0)
+		return;
+
+	prop_backup_journal++;
+	prop_backup_objects.clear();
 }
 
 /* MapObject::endPropBackup
@@ -360,6 +384,16 @@ void MapObject::endPropBackup()
 	prop_backup_time = -1;
 }
 
+/* MapObject::takePropBackupJournal
+ * Moves all objects backed up since property backup began into
+ * [list], and clears the journal
+ *******************************************************************/
+void MapObject::takePropBackupJournal(vector<MapObject*>& list)
+{
+	list.clear();
+	list.swap(prop_backup_objects);
+}
+
 
 /* MapObject::multiBoolProperty
  * Checks the boolean property [prop] on all objects in [objects].
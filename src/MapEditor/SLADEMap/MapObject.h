@@ -7,6 +7,7 @@
 #endif
 
 #include "MobjPropertyList.h"
+#include "MapObjectArena.h"
 
 class SLADEMap;
 
@@ -48,10 +49,16 @@ protected:
 	long				modified_time;
 	unsigned			id;
 	mobj_backup_t*		obj_backup;
+	unsigned			backup_journal;
 
 public:
 	MapObject(int type = MOBJ_UNKNOWN, SLADEMap* parent = nullptr);
 	virtual ~MapObject();
+
+	// Allocate from the map object arena (see MapObjectArena.h)
+	static void*	operator new(size_t size) { return MapObjectArena::allocate(size); }
+	static void		operator delete(void* ptr, size_t size) { MapObjectArena::release(ptr, size); }
+
 	bool operator< (const MapObject& right) const { return (index < right.index); }
 	bool operator> (const MapObject& right) const { return (index > right.index); }
 
@@ -65,7 +72,7 @@ public:
 	void		setModified();
 
 	MobjPropertyList&	props()						{ return properties; }
-	bool				hasProp(const string& key)	{ return properties[key].hasValue(); }
+	bool				hasProp(const string& key)	{ Property value; return properties.get(key, value); }
 
 	// Generic property modification
 	virtual bool	boolProperty(const string& key);
@@ -95,6 +102,7 @@ public:
 	static long propBackupTime();
 	static void beginPropBackup(long current_time);
 	static void endPropBackup();
+	static void takePropBackupJournal(vector<MapObject*>& list);
 
 	static bool	multiBoolProperty(vector<MapObject*>& objects, string prop, bool& value);
 	static bool multiIntProperty(vector<MapObject*>& objects, string prop, int& value);
@@ -0,0 +1,197 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapObjectArena.cpp
+// Description: Block allocator for map objects, see MapObjectArena.h
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapObjectArena.h"
+#include <map>
+#include <set>
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	const unsigned	objects_per_block = 1024;
+	const size_t	alignment = 16;
+
+	struct Block
+	{
+		unsigned	used		= 0;		// Number of objects used from the start of the block
+		unsigned	live		= 0;
+		void*		free_list	= nullptr;	// Deleted objects, linked through their first bytes
+	};
+
+	struct Pool
+	{
+		size_t					size = 0;
+		std::map<char*, Block>	blocks;		// By start address
+		std::set<char*>			available;	// Blocks with space for more objects
+	};
+
+	// Never destroyed, since map objects can be deleted during static
+	// destruction (eg. by a global map)
+	vector<Pool>& pools()
+	{
+		static auto pools = new vector<Pool>();
+		return *pools;
+	}
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// ------------------------------------------------------------------------
+	// getPool
+	//
+	// Returns the pool for objects of [size] (already rounded up)
+	// ------------------------------------------------------------------------
+	Pool& getPool(size_t size)
+	{
+		for (auto& pool : pools())
+			if (pool.size == size)
+				return pool;
+
+		pools().emplace_back();
+		pools().back().size = size;
+		return pools().back();
+	}
+
+	// ------------------------------------------------------------------------
+	// poolSize
+	//
+	// Returns [size] rounded up to the pool alignment
+	// ------------------------------------------------------------------------
+	size_t poolSize(size_t size)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapObjectArena Namespace Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapObjectArena::allocate
+//
+// Allocates memory for an object of [size]. Objects are allocated from the
+// lowest-addressed block with space, to keep objects close together
+// ----------------------------------------------------------------------------
+void* MapObjectArena::allocate(size_t size)
+{
+	Pool& pool = getPool(poolSize(size));
+
+	// Add a new block if all are full
+	if (pool.available.empty())
+	{
+		char* data = (char*)::operator new(pool.size * objects_per_block);
+		pool.blocks[data] = Block();
+		pool.available.insert(data);
+	}
+
+	char* data = *pool.available.begin();
+	Block& block = pool.blocks[data];
+	block.live++;
+
+	// Reuse a deleted object if possible, otherwise use the next unused one
+	void* ptr;
+	if (block.free_list)
+	{
+		ptr = block.free_list;
+		block.free_list = *(void**)ptr;
+	}
+	else
+		ptr = data + pool.size * block.used++;
+
+	if (!block.free_list && block.used == objects_per_block)
+		pool.available.erase(data);
+
+	return ptr;
+}
+
+// ----------------------------------------------------------------------------
+// MapObjectArena::release
+//
+// Frees memory at [ptr] allocated for an object of [size]
+// ----------------------------------------------------------------------------
+void MapObjectArena::release(void* ptr, size_t size)
+{
+	if (!ptr)
+		return;
+
+	Pool& pool = getPool(poolSize(size));
+
+	// Find the block containing [ptr] (the last one starting at or before it)
+	auto i = pool.blocks.upper_bound((char*)ptr);
+	if (i == pool.blocks.begin())
+		return;
+	--i;
+	char* data = i->first;
+	Block& block = i->second;
+
+	// Free the block once nothing in it is in use (eg. the map was closed)
+	if (--block.live == 0)
+	{
+		::operator delete(data);
+		pool.available.erase(data);
+		pool.blocks.erase(i);
+		return;
+	}
+
+	*(void**)ptr = block.free_list;
+	block.free_list = ptr;
+	pool.available.insert(data);
+}
+
+// ----------------------------------------------------------------------------
+// MapObjectArena::allocatedSize
+//
+// Returns the total size of all blocks allocated, in bytes
+// ----------------------------------------------------------------------------
+size_t MapObjectArena::allocatedSize()
+{
+	size_t size = 0;
+	for (auto& pool : pools())
+		size += pool.blocks.size() * pool.size * objects_per_block;
+
+	return size;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Allocator for map objects. Objects are allocated from large blocks (one
+// pool per object size, so in practice per object type), so that objects
+// created together, eg. when a map is loaded, are contiguous in memory rather
+// than scattered across the heap. Each block is freed as soon as all objects
+// in it have been deleted, so objects that outlive their map (eg. clipboard or
+// undo copies) only keep their own blocks alive. Not thread-safe, map objects
+// should only be created and deleted on the main thread
+namespace MapObjectArena
+{
+	void*	allocate(size_t size);
+	void	release(void* ptr, size_t size);
+	size_t	allocatedSize();
+}
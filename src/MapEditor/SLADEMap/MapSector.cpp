@@ -51,6 +51,8 @@ const double TAU = M_PI * 2;
 MapSector::MapSector(SLADEMap* parent) : MapObject(MOBJ_SECTOR, parent)
 {
 	// Init variables
+	this->f_tex = 0;
+	this->c_tex = 0;
 	this->special = 0;
 	this->tag = 0;
 	plane_floor.set(0, 0, 1, 0);
@@ -65,8 +67,8 @@ MapSector::MapSector(SLADEMap* parent) : MapObject(MOBJ_SECTOR, parent)
 MapSector::MapSector(string f_tex, string c_tex, SLADEMap* parent) : MapObject(MOBJ_SECTOR, parent)
 {
 	// Init variables
-	this->f_tex = f_tex;
-	this->c_tex = c_tex;
+	this->f_tex = MapTextureNames::intern(f_tex);
+	this->c_tex = MapTextureNames::intern(c_tex);
 	this->special = 0;
 	this->tag = 0;
 	plane_floor.set(0, 0, 1, 0);
@@ -137,9 +139,9 @@ void MapSector::setGeometryUpdated()
 string MapSector::stringProperty(const string& key)
 {
 	if (key == "texturefloor")
-		return f_tex;
+		return MapTextureNames::name(f_tex);
 	else if (key == "textureceiling")
-		return c_tex;
+		return MapTextureNames::name(c_tex);
 	else
 		return MapObject::stringProperty(key);
 }
@@ -174,13 +176,13 @@ void MapSector::setStringProperty(const string& key, const string& value)
 	if (key == "texturefloor")
 	{
 		if (parent_map) parent_map->updateFlatUsage(f_tex, -1);
-		f_tex = value;
+		f_tex = MapTextureNames::intern(value);
 		if (parent_map) parent_map->updateFlatUsage(f_tex, 1);
 	}
 	else if (key == "textureceiling")
 	{
 		if (parent_map) parent_map->updateFlatUsage(c_tex, -1);
-		c_tex = value;
+		c_tex = MapTextureNames::intern(value);
 		if (parent_map) parent_map->updateFlatUsage(c_tex, 1);
 	}
 	else
@@ -721,8 +723,8 @@ void MapSector::disconnectSide(MapSide* side)
  *******************************************************************/
 void MapSector::writeBackup(mobj_backup_t* backup)
 {
-	backup->props_internal["texturefloor"] = f_tex;
-	backup->props_internal["textureceiling"] = c_tex;
+	backup->props_internal["texturefloor"] = MapTextureNames::name(f_tex);
+	backup->props_internal["textureceiling"] = MapTextureNames::name(c_tex);
 	backup->props_internal["heightfloor"] = f_height;
 	backup->props_internal["heightceiling"] = c_height;
 	backup->props_internal["lightlevel"] = light;
@@ -739,8 +741,8 @@ void MapSector::readBackup(mobj_backup_t* backup)
 	parent_map->updateFlatUsage(f_tex, -1);
 	parent_map->updateFlatUsage(c_tex, -1);
 
-	f_tex = backup->props_internal["texturefloor"].getStringValue();
-	c_tex = backup->props_internal["textureceiling"].getStringValue();
+	f_tex = MapTextureNames::intern(backup->props_internal["texturefloor"].getStringValue());
+	c_tex = MapTextureNames::intern(backup->props_internal["textureceiling"].getStringValue());
 	f_height = backup->props_internal["heightfloor"].getIntValue();
 	c_height = backup->props_internal["heightceiling"].getIntValue();
 	plane_floor.set(0, 0, 1, f_height);
@@ -3,6 +3,7 @@
 #define __MAPSECTOR_H__
 
 #include "MapObject.h"
+#include "MapTextureNames.h"
 #include "Utility/Polygon2D.h"
 
 class MapSide;
@@ -44,8 +45,8 @@ class MapSector : public MapObject
 	friend class MapSide;
 private:
 	// Basic data
-	string		f_tex;
-	string		c_tex;
+	MapTextureNames::Handle	f_tex;
+	MapTextureNames::Handle	c_tex;
 	short		f_height;
 	short		c_height;
 	short		light;
@@ -71,8 +72,10 @@ public:
 
 	void	copy(MapObject* copy) override;
 
-	string		getFloorTex() const { return f_tex; }
-	string		getCeilingTex() const { return c_tex; }
+	const string&	getFloorTex() const { return MapTextureNames::name(f_tex); }
+	const string&	getCeilingTex() const { return MapTextureNames::name(c_tex); }
+	MapTextureNames::Handle	floorTexHandle() const { return f_tex; }
+	MapTextureNames::Handle	ceilingTexHandle() const { return c_tex; }
 	short		getFloorHeight() const { return f_height; }
 	short		getCeilingHeight() const { return c_height; }
 	short		getLightLevel() const { return light; }
@@ -46,6 +46,9 @@ MapSide::MapSide(MapSector* sector, SLADEMap* parent) : MapObject(MOBJ_SIDE, par
 	// Init variables
 	this->sector = sector;
 	this->parent = nullptr;
+	this->tex_upper = 0;
+	this->tex_middle = 0;
+	this->tex_lower = 0;
 	this->offset_x = 0;
 	this->offset_y = 0;
 
@@ -61,6 +64,9 @@ MapSide::MapSide(SLADEMap* parent) : MapObject(MOBJ_SIDE, parent)
 	// Init variables
 	this->sector = nullptr;
 	this->parent = nullptr;
+	this->tex_upper = 0;
+	this->tex_middle = 0;
+	this->tex_lower = 0;
 	this->offset_x = 0;
 	this->offset_y = 0;
 }
@@ -208,11 +214,11 @@ void MapSide::setIntProperty(const string& key, int value)
 string MapSide::stringProperty(const string& key)
 {
 	if (key == "texturetop")
-		return tex_upper;
+		return MapTextureNames::name(tex_upper);
 	else if (key == "texturemiddle")
-		return tex_middle;
+		return MapTextureNames::name(tex_middle);
 	else if (key == "texturebottom")
-		return tex_lower;
+		return MapTextureNames::name(tex_lower);
 	else
 		return MapObject::stringProperty(key);
 }
@@ -228,19 +234,19 @@ void MapSide::setStringProperty(const string& key, const string& value)
 	if (key == "texturetop")
 	{
 		if (parent_map) parent_map->updateTexUsage(tex_upper, -1);
-		tex_upper = value;
+		tex_upper = MapTextureNames::intern(value);
 		if (parent_map) parent_map->updateTexUsage(tex_upper, 1);
 	}
 	else if (key == "texturemiddle")
 	{
 		if (parent_map) parent_map->updateTexUsage(tex_middle, -1);
-		tex_middle = value;
+		tex_middle = MapTextureNames::intern(value);
 		if (parent_map) parent_map->updateTexUsage(tex_middle, 1);
 	}
 	else if (key == "texturebottom")
 	{
 		if (parent_map) parent_map->updateTexUsage(tex_lower, -1);
-		tex_lower = value;
+		tex_lower = MapTextureNames::intern(value);
 		if (parent_map) parent_map->updateTexUsage(tex_lower, 1);
 	}
 	else
@@ -270,9 +276,9 @@ void MapSide::writeBackup(mobj_backup_t* backup)
 		backup->props_internal["sector"] = 0;
 
 	// Textures
-	backup->props_internal["texturetop"] = tex_upper;
-	backup->props_internal["texturemiddle"] = tex_middle;
-	backup->props_internal["texturebottom"] = tex_lower;
+	backup->props_internal["texturetop"] = MapTextureNames::name(tex_upper);
+	backup->props_internal["texturemiddle"] = MapTextureNames::name(tex_middle);
+	backup->props_internal["texturebottom"] = MapTextureNames::name(tex_lower);
 
 	// Offsets
 	backup->props_internal["offsetx"] = offset_x;
@@ -308,9 +314,9 @@ void MapSide::readBackup(mobj_backup_t* backup)
 	parent_map->updateTexUsage(tex_lower, -1);
 
 	// Textures
-	tex_upper = backup->props_internal["texturetop"].getStringValue();
-	tex_middle = backup->props_internal["texturemiddle"].getStringValue();
-	tex_lower = backup->props_internal["texturebottom"].getStringValue();
+	tex_upper = MapTextureNames::intern(backup->props_internal["texturetop"].getStringValue());
+	tex_middle = MapTextureNames::intern(backup->props_internal["texturemiddle"].getStringValue());
+	tex_lower = MapTextureNames::intern(backup->props_internal["texturebottom"].getStringValue());
 
 	// Update texture counts (increment new)
 	parent_map->updateTexUsage(tex_upper, 1);
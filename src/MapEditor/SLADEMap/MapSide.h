@@ -3,6 +3,7 @@
 #define __MAPSIDE_H__
 
 #include "MapObject.h"
+#include "MapTextureNames.h"
 
 class MapSector;
 class MapLine;
@@ -42,9 +43,12 @@ public:
 
 	MapSector*	getSector() const { return sector; }
 	MapLine*	getParentLine() const { return parent; }
-	string		getTexUpper() const { return tex_upper; }
-	string		getTexMiddle() const { return tex_middle; }
-	string		getTexLower() const { return tex_lower; }
+	const string&	getTexUpper() const { return MapTextureNames::name(tex_upper); }
+	const string&	getTexMiddle() const { return MapTextureNames::name(tex_middle); }
+	const string&	getTexLower() const { return MapTextureNames::name(tex_lower); }
+	MapTextureNames::Handle	texUpperHandle() const { return tex_upper; }
+	MapTextureNames::Handle	texMiddleHandle() const { return tex_middle; }
+	MapTextureNames::Handle	texLowerHandle() const { return tex_lower; }
 	short		getOffsetX() const { return offset_x; }
 	short		getOffsetY() const { return offset_y; }
 	uint8_t		getLight();
@@ -65,9 +69,9 @@ private:
 	// Basic data
 	MapSector*	sector;
 	MapLine*	parent;
-	string		tex_upper;
-	string		tex_middle;
-	string		tex_lower;
+	MapTextureNames::Handle	tex_upper;
+	MapTextureNames::Handle	tex_middle;
+	MapTextureNames::Handle	tex_lower;
 	short		offset_x;
 	short		offset_y;
 };
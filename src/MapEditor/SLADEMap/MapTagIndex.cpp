@@ -0,0 +1,354 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapTagIndex.cpp
+// Description: MapTagIndex class, indexes map objects by tag/id and by the
+//              values of their special arguments, so that tagged/tagging
+//              object lookups don't need to check every object in the map
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapTagIndex.h"
+#include "SLADEMap.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	const char* arg_names[] = { "arg0", "arg1", "arg2", "arg3", "arg4" };
+
+	// ------------------------------------------------------------------------
+	// argValues
+	//
+	// Gets the distinct values [args] are indexed under. A negative first arg
+	// is also indexed by its absolute value (for negative line id specials)
+	// ------------------------------------------------------------------------
+	unsigned argValues(const int* args, int* values)
+	{
+		unsigned count = 0;
+		auto add = [&](int value)
+		{
+			if (value == 0)
+				return;
+			for (unsigned a = 0; a < count; a++)
+				if (values[a] == value)
+					return;
+			values[count++] = value;
+		};
+
+		for (unsigned a = 0; a < 5; a++)
+			add(args[a]);
+		if (args[0] < 0)
+			add(-args[0]);
+
+		return count;
+	}
+
+	// ------------------------------------------------------------------------
+	// eraseEntry
+	//
+	// Removes the entry for [object] with [key] from [index]
+	// ------------------------------------------------------------------------
+	void eraseEntry(std::unordered_multimap<int, MapObject*>& index, int key, MapObject* object)
+	{
+		auto range = index.equal_range(key);
+		for (auto i = range.first; i != range.second; ++i)
+			if (i->second == object)
+			{
+				index.erase(i);
+				return;
+			}
+	}
+
+	// ------------------------------------------------------------------------
+	// appendObjects
+	//
+	// Adds all objects in [index] with [key] to [list], in map index order
+	// ------------------------------------------------------------------------
+	template<class T> void appendObjects(
+		const std::unordered_multimap<int, MapObject*>& index,
+		int key,
+		vector<T*>& list)
+	{
+		size_t start = list.size();
+		auto range = index.equal_range(key);
+		for (auto i = range.first; i != range.second; ++i)
+			list.push_back((T*)i->second);
+
+		std::sort(list.begin() + start, list.end(), [](T* left, T* right)
+		{
+			return left->getIndex() < right->getIndex();
+		});
+	}
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapTagIndex Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::objectChanged
+//
+// Marks [object] as changed (modified, created or removed), it will be
+// reindexed the next time the index is used
+// ----------------------------------------------------------------------------
+void MapTagIndex::objectChanged(MapObject* object)
+{
+	// Everything is reindexed anyway if the index isn't valid
+	if (!valid_)
+		return;
+
+	uint8_t type = object->getObjType();
+	if (type == MOBJ_SECTOR || type == MOBJ_LINE || type == MOBJ_THING)
+		changed_.insert(object);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::invalidate
+//
+// Clears the index, it will be fully rebuilt the next time it is used
+// ----------------------------------------------------------------------------
+void MapTagIndex::invalidate()
+{
+	valid_ = false;
+	sector_tags_.clear();
+	line_ids_.clear();
+	thing_ids_.clear();
+	arg_refs_.clear();
+	keys_.clear();
+	changed_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::sectorsWithTag
+//
+// Adds all sectors with [tag] to [list]
+// ----------------------------------------------------------------------------
+void MapTagIndex::sectorsWithTag(int tag, vector<MapSector*>& list)
+{
+	update();
+	appendObjects(sector_tags_, tag, list);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::linesWithId
+//
+// Adds all lines with [id] to [list]
+// ----------------------------------------------------------------------------
+void MapTagIndex::linesWithId(int id, vector<MapLine*>& list)
+{
+	update();
+	appendObjects(line_ids_, id, list);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::thingsWithId
+//
+// Adds all things with TID [id] to [list]
+// ----------------------------------------------------------------------------
+void MapTagIndex::thingsWithId(int id, vector<MapThing*>& list)
+{
+	update();
+	appendObjects(thing_ids_, id, list);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::argReferences
+//
+// Adds all lines (with a special) and things that have an argument with
+// [value] to [list]
+// ----------------------------------------------------------------------------
+void MapTagIndex::argReferences(int value, vector<MapObject*>& list)
+{
+	update();
+	appendObjects(arg_refs_, value, list);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::sectorTagUsed
+//
+// Returns true if any sector has [tag]
+// ----------------------------------------------------------------------------
+bool MapTagIndex::sectorTagUsed(int tag)
+{
+	update();
+	return sector_tags_.count(tag) > 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::lineIdUsed
+//
+// Returns true if any line has [id]
+// ----------------------------------------------------------------------------
+bool MapTagIndex::lineIdUsed(int id)
+{
+	update();
+	return line_ids_.count(id) > 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::thingIdUsed
+//
+// Returns true if any thing has TID [id]
+// ----------------------------------------------------------------------------
+bool MapTagIndex::thingIdUsed(int id)
+{
+	update();
+	return thing_ids_.count(id) > 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::update
+//
+// Reindexes all changed objects, or rebuilds the index if it isn't valid
+// ----------------------------------------------------------------------------
+void MapTagIndex::update()
+{
+	if (!valid_)
+	{
+		rebuild();
+		return;
+	}
+
+	for (auto object : changed_)
+	{
+		removeObject(object);
+		if (inMap(object))
+			addObject(object);
+	}
+	changed_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::rebuild
+//
+// Rebuilds the index from all sectors, lines and things in the map
+// ----------------------------------------------------------------------------
+void MapTagIndex::rebuild()
+{
+	invalidate();
+
+	for (auto sector : map_.sectors())
+		addObject(sector);
+	for (auto line : map_.lines())
+		addObject(line);
+	for (auto thing : map_.things())
+		addObject(thing);
+
+	valid_ = true;
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::inMap
+//
+// Returns true if [object] is currently part of the map (ie. not deleted)
+// ----------------------------------------------------------------------------
+bool MapTagIndex::inMap(MapObject* object) const
+{
+	unsigned index = object->getIndex();
+	switch (object->getObjType())
+	{
+	case MOBJ_SECTOR:	return index < map_.sectors().size() && map_.sectors()[index] == object;
+	case MOBJ_LINE:		return index < map_.lines().size() && map_.lines()[index] == object;
+	case MOBJ_THING:	return index < map_.things().size() && map_.things()[index] == object;
+	default:			return false;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::addObject
+//
+// Adds [object] to the index with its current tag/id and args
+// ----------------------------------------------------------------------------
+void MapTagIndex::addObject(MapObject* object)
+{
+	Keys keys;
+	keys.id = object->intProperty("id");
+
+	// Lines only reference anything via args if they have a special, things
+	// can also reference by args depending on their type
+	uint8_t type = object->getObjType();
+	if (type == MOBJ_THING || (type == MOBJ_LINE && ((MapLine*)object)->getSpecial() != 0))
+	{
+		for (unsigned a = 0; a < 5; a++)
+			keys.args[a] = object->intProperty(arg_names[a]);
+	}
+
+	// Add to indexes
+	if (keys.id != 0)
+		idIndex(object)->emplace(keys.id, object);
+	int values[6];
+	unsigned n_values = argValues(keys.args, values);
+	for (unsigned a = 0; a < n_values; a++)
+		arg_refs_.emplace(values[a], object);
+
+	keys_[object] = keys;
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::removeObject
+//
+// Removes all index entries for [object]
+// ----------------------------------------------------------------------------
+void MapTagIndex::removeObject(MapObject* object)
+{
+	auto i = keys_.find(object);
+	if (i == keys_.end())
+		return;
+
+	const Keys& keys = i->second;
+	if (keys.id != 0)
+		eraseEntry(*idIndex(object), keys.id, object);
+	int values[6];
+	unsigned n_values = argValues(keys.args, values);
+	for (unsigned a = 0; a < n_values; a++)
+		eraseEntry(arg_refs_, values[a], object);
+
+	keys_.erase(i);
+}
+
+// ----------------------------------------------------------------------------
+// MapTagIndex::idIndex
+//
+// Returns the tag/id index for [object]'s type
+// ----------------------------------------------------------------------------
+MapTagIndex::Index* MapTagIndex::idIndex(MapObject* object)
+{
+	switch (object->getObjType())
+	{
+	case MOBJ_SECTOR:	return &sector_tags_;
+	case MOBJ_LINE:		return &line_ids_;
+	default:			return &thing_ids_;
+	}
+}
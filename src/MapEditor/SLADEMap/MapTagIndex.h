@@ -0,0 +1,57 @@
+#pragma once
+
+#include <unordered_set>
+
+class SLADEMap;
+class MapObject;
+class MapLine;
+class MapSector;
+class MapThing;
+
+// Keeps indexes from sector tag, line id and thing id (TID) to the objects
+// using them, and from special argument values to the lines/things with
+// those arguments. Objects are marked as changed when modified, created or
+// deleted, and only those are reindexed the next time the index is queried
+class MapTagIndex
+{
+public:
+	MapTagIndex(SLADEMap& map) : map_(map) {}
+
+	void	objectChanged(MapObject* object);
+	void	invalidate();
+
+	void	sectorsWithTag(int tag, vector<MapSector*>& list);
+	void	linesWithId(int id, vector<MapLine*>& list);
+	void	thingsWithId(int id, vector<MapThing*>& list);
+	void	argReferences(int value, vector<MapObject*>& list);
+
+	bool	sectorTagUsed(int tag);
+	bool	lineIdUsed(int id);
+	bool	thingIdUsed(int id);
+
+private:
+	typedef std::unordered_multimap<int, MapObject*> Index;
+
+	// Keys an object is currently indexed under
+	struct Keys
+	{
+		int	id = 0;
+		int	args[5] = { 0, 0, 0, 0, 0 };
+	};
+
+	SLADEMap&									map_;
+	bool										valid_	= false;
+	Index										sector_tags_;
+	Index										line_ids_;
+	Index										thing_ids_;
+	Index										arg_refs_;
+	std::unordered_map<MapObject*, Keys>		keys_;
+	std::unordered_set<MapObject*>				changed_;
+
+	void	update();
+	void	rebuild();
+	bool	inMap(MapObject* object) const;
+	void	addObject(MapObject* object);
+	void	removeObject(MapObject* object);
+	Index*	idIndex(MapObject* object);
+};
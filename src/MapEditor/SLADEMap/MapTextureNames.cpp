@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapTextureNames.cpp
+// Description: Table of interned map texture/flat names, see
+//              MapTextureNames.h
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapTextureNames.h"
+#include <deque>
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	typedef MapTextureNames::Handle Handle;
+
+	// Names are never removed, handles (and references to names, since this
+	// is a deque) stay valid for the whole session
+	std::deque<string>									names = { "" };
+	vector<Handle>										uppers = { 0 };
+	std::unordered_map<string, Handle, wxStringHash>	lookup = { { "", 0 } };
+
+	// Handles of 8-character names from binary map lumps, by the names'
+	// characters packed into an integer
+	std::unordered_map<uint64_t, Handle>				lump_lookup;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// MapTextureNames Namespace Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::intern
+//
+// Returns the handle for [name], adding it to the table if needed. Names are
+// case-sensitive (so they are written back out exactly as read), use upper()
+// to get the handle of the upper-case version of a name
+// ----------------------------------------------------------------------------
+MapTextureNames::Handle MapTextureNames::intern(const string& name)
+{
+	auto i = lookup.find(name);
+	if (i != lookup.end())
+		return i->second;
+
+	// Add new name
+	Handle handle = names.size();
+	names.push_back(name);
+	uppers.push_back(handle);
+	lookup[name] = handle;
+
+	// Get upper-case handle (may add it too)
+	string name_upper = name.Upper();
+	if (name_upper != name)
+		uppers[handle] = intern(name_upper);
+
+	return handle;
+}
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::internLump
+//
+// Returns the handle for the 8-character (not necessarily null-terminated)
+// name [name] from a binary map lump. Only converted to a string and interned
+// the first time each distinct name is seen, since there are usually far
+// fewer distinct names than sides/sectors using them
+// ----------------------------------------------------------------------------
+MapTextureNames::Handle MapTextureNames::internLump(const char* name)
+{
+	uint64_t key;
+	memcpy(&key, name, 8);
+
+	auto i = lump_lookup.find(key);
+	if (i != lump_lookup.end())
+		return i->second;
+
+	Handle handle = intern(wxString::FromAscii(name, 8));
+	lump_lookup[key] = handle;
+	return handle;
+}
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::find
+//
+// Returns the handle for [name] if it has been interned, or 0 (the empty
+// name) if not. Unlike intern(), never adds [name] to the table
+// ----------------------------------------------------------------------------
+MapTextureNames::Handle MapTextureNames::find(const string& name)
+{
+	auto i = lookup.find(name);
+	return i != lookup.end() ? i->second : 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::name
+//
+// Returns the name for [handle]
+// ----------------------------------------------------------------------------
+const string& MapTextureNames::name(Handle handle)
+{
+	return handle < names.size() ? names[handle] : names[0];
+}
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::upper
+//
+// Returns the handle of the upper-case version of the name for [handle]
+// ----------------------------------------------------------------------------
+MapTextureNames::Handle MapTextureNames::upper(Handle handle)
+{
+	return handle < uppers.size() ? uppers[handle] : 0;
+}
+
+// ----------------------------------------------------------------------------
+// MapTextureNames::count
+//
+// Returns the number of names in the table
+// ----------------------------------------------------------------------------
+unsigned MapTextureNames::count()
+{
+	return names.size();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Table of interned texture/flat names, shared by all maps. Map sides and
+// sectors store a small integer handle per texture instead of a string, and
+// anything looking textures up by name (usage counts, the renderer's texture
+// cache) can index by handle instead of hashing the name every time.
+// Handle 0 is always the empty name. Not thread-safe, names should only be
+// interned from the main thread
+namespace MapTextureNames
+{
+	typedef uint32_t Handle;
+
+	Handle			intern(const string& name);
+	Handle			internLump(const char* name);
+	Handle			find(const string& name);
+	const string&	name(Handle handle);
+	Handle			upper(Handle handle);
+	unsigned		count();
+}
@@ -5,8 +5,10 @@
  * Email:       sirjuddington@gmail.com
  * Web:         http://slade.mancubus.net
  * Filename:    MobjPropertyList.cpp
- * Description: A special version of the PropertyList class that
- *              uses a vector rather than a map to store properties
+ * Description: A special version of the PropertyList class for
+ *              map objects. Properties are stored as compact typed
+ *              entries keyed by interned property name, in storage
+ *              that is shared between copies until modified
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -29,6 +31,18 @@
  *******************************************************************/
 #include "Main.h"
 #include "MobjPropertyList.h"
+#include <deque>
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Property key names, shared by all lists. Keys are never removed
+	std::deque<string>										key_names;
+	std::unordered_map<string, MobjPropertyList::Key, wxStringHash>	key_ids;
+}
 
 
 /*******************************************************************
@@ -49,34 +63,50 @@ MobjPropertyList::~MobjPropertyList()
 {
 }
 
+/* MobjPropertyList::allProperties
+ * Returns a list of all properties (names and values)
+ *******************************************************************/
+vector<MobjPropertyList::prop_t> MobjPropertyList::allProperties() const
+{
+	vector<prop_t> props;
+	if (!storage_)
+		return props;
+
+	props.reserve(storage_->entries.size());
+	for (auto& entry : storage_->entries)
+		props.push_back(prop_t(keyName(entry.key), entryValue(entry)));
+
+	return props;
+}
+
 /* MobjPropertyList::propertyExists
  * Returns true if a property with the given name exists, false
  * otherwise
  *******************************************************************/
-bool MobjPropertyList::propertyExists(string key)
+bool MobjPropertyList::propertyExists(const string& key) const
 {
-	for (unsigned a = 0; a < properties.size(); ++a)
-	{
-		if (properties[a].name == key)
-			return true;
-	}
-
-	return false;
+	auto i = key_ids.find(key);
+	return i != key_ids.end() && findEntry(i->second);
 }
 
 /* MobjPropertyList::removeProperty
  * Removes a property value, returns true if [key] was removed
  * or false if key didn't exist
  *******************************************************************/
-bool MobjPropertyList::removeProperty(string key)
+bool MobjPropertyList::removeProperty(const string& key)
 {
-	//return properties.erase(key) > 0;
-	for (unsigned a = 0; a < properties.size(); ++a)
+	auto i = key_ids.find(key);
+	if (i == key_ids.end() || !findEntry(i->second))
+		return false;
+
+	storage_t& storage = mutableStorage();
+	for (unsigned a = 0; a < storage.entries.size(); ++a)
 	{
-		if (properties[a].name == key)
+		if (storage.entries[a].key == i->second)
 		{
-			properties[a] = properties.back();
-			properties.pop_back();
+			removeString(storage, storage.entries[a]);
+			storage.entries[a] = storage.entries.back();
+			storage.entries.pop_back();
 			return true;
 		}
 	}
@@ -85,45 +115,135 @@ bool MobjPropertyList::removeProperty(string key)
 }
 
 /* MobjPropertyList::copyTo
- * Copies all properties to [list]
+ * Copies all properties to [list]. The property storage is shared
+ * until either list is modified
  *******************************************************************/
-void MobjPropertyList::copyTo(MobjPropertyList& list)
+void MobjPropertyList::copyTo(MobjPropertyList& list) const
 {
-	// Clear given list
-	list.clear();
-
-	for (unsigned a = 0; a < properties.size(); ++a)
-		list.properties.push_back(prop_t(properties[a].name, properties[a].value));
+	list.storage_ = storage_;
 }
 
 /* MobjPropertyList::addFlag
  * Adds a 'flag' property [key]
  *******************************************************************/
-void MobjPropertyList::addFlag(string key)
+void MobjPropertyList::addFlag(const string& key)
 {
-	Property flag;
-	properties.push_back(prop_t(key, flag));
+	entry_t flag;
+	flag.key = internKey(key);
+	flag.type = PROP_BOOL;
+	flag.has_value = false;
+	flag.value.Boolean = false;
+	mutableStorage().entries.push_back(flag);
+}
+
+/* MobjPropertyList::get
+ * Returns the value of the property [key], or a property with no
+ * value if it doesn't exist
+ *******************************************************************/
+Property MobjPropertyList::get(Key key) const
+{
+	auto entry = findEntry(key);
+	return entry ? entryValue(*entry) : Property();
+}
+
+/* MobjPropertyList::get
+ * Sets [value] to the value of the property [key]. Returns false if
+ * the property doesn't exist or has no value
+ *******************************************************************/
+bool MobjPropertyList::get(const string& key, Property& value) const
+{
+	auto i = key_ids.find(key);
+	if (i == key_ids.end())
+		return false;
+
+	auto entry = findEntry(i->second);
+	if (!entry || !entry->has_value)
+		return false;
+
+	value = entryValue(*entry);
+	return true;
+}
+
+/* MobjPropertyList::hasValue
+ * Returns true if the property [key] exists and has a value
+ *******************************************************************/
+bool MobjPropertyList::hasValue(Key key) const
+{
+	auto entry = findEntry(key);
+	return entry && entry->has_value;
+}
+
+/* MobjPropertyList::set
+ * Sets the property [key] to [value], adding it if it doesn't exist
+ *******************************************************************/
+void MobjPropertyList::set(Key key, const Property& value)
+{
+	storage_t& storage = mutableStorage();
+
+	// Find existing entry or add new one
+	entry_t* entry = nullptr;
+	for (auto& e : storage.entries)
+		if (e.key == key)
+		{
+			entry = &e;
+			break;
+		}
+	if (!entry)
+	{
+		storage.entries.push_back(entry_t());
+		entry = &storage.entries.back();
+		entry->key = key;
+		entry->type = PROP_BOOL;
+	}
+
+	// Strings are kept separately, reuse the existing string if any
+	if (value.getType() == PROP_STRING)
+	{
+		if (entry->type == PROP_STRING)
+			storage.strings[entry->value.Unsigned] = value.getStringValue();
+		else
+		{
+			entry->value.Unsigned = storage.strings.size();
+			storage.strings.push_back(value.getStringValue());
+		}
+	}
+	else
+	{
+		removeString(storage, *entry);
+		switch (value.getType())
+		{
+		case PROP_INT:		entry->value.Integer = value.getIntValue(); break;
+		case PROP_FLOAT:	entry->value.Floating = value.getFloatValue(); break;
+		case PROP_UINT:		entry->value.Unsigned = value.getUnsignedValue(); break;
+		default:			entry->value.Boolean = value.getBoolValue(); break;
+		}
+	}
+
+	entry->type = value.getType();
+	entry->has_value = value.hasValue();
 }
 
 /* MobjPropertyList::toString
  * Returns a string representation of the property list
  *******************************************************************/
-string MobjPropertyList::toString(bool condensed)
+string MobjPropertyList::toString(bool condensed) const
 {
 	// Init return string
 	string ret = wxEmptyString;
+	if (!storage_)
+		return ret;
 
-	for (unsigned a = 0; a < properties.size(); ++a)
+	for (auto& entry : storage_->entries)
 	{
 		// Skip if no value
-		if (!properties[a].value.hasValue())
+		if (!entry.has_value)
 			continue;
 
 		// Add "key = value;\n" to the return string
-		string key = properties[a].name;
-		string val = properties[a].value.getStringValue();
+		const string& key = keyName(entry.key);
+		string val = entryValue(entry).getStringValue();
 
-		if (properties[a].value.getType() == PROP_STRING)
+		if (entry.type == PROP_STRING)
 			val = "\"" + val + "\"";
 
 		if (condensed)
@@ -134,3 +254,125 @@ string MobjPropertyList::toString(bool condensed)
 
 	return ret;
 }
+
+/* MobjPropertyList::storageSize
+ * Returns the (approximate) memory used by the list's property
+ * storage in bytes. Lists sharing storage return the same size
+ *******************************************************************/
+size_t MobjPropertyList::storageSize() const
+{
+	if (!storage_)
+		return 0;
+
+	size_t size = sizeof(storage_t);
+	size += storage_->entries.capacity() * sizeof(entry_t);
+	size += storage_->strings.capacity() * sizeof(string);
+	for (auto& str : storage_->strings)
+		size += (str.length() + 1) * sizeof(wxChar);
+
+	return size;
+}
+
+/* MobjPropertyList::internKey
+ * Returns the key for property name [name], adding it if needed
+ *******************************************************************/
+MobjPropertyList::Key MobjPropertyList::internKey(const string& name)
+{
+	auto i = key_ids.find(name);
+	if (i != key_ids.end())
+		return i->second;
+
+	Key key = key_names.size();
+	key_names.push_back(name);
+	key_ids[name] = key;
+	return key;
+}
+
+/* MobjPropertyList::keyName
+ * Returns the property name for [key]
+ *******************************************************************/
+const string& MobjPropertyList::keyName(Key key)
+{
+	static string invalid;
+	return key < key_names.size() ? key_names[key] : invalid;
+}
+
+/* MobjPropertyList::nKeys
+ * Returns the number of interned property names
+ *******************************************************************/
+unsigned MobjPropertyList::nKeys()
+{
+	return key_names.size();
+}
+
+/* MobjPropertyList::findEntry
+ * Returns the entry for the property [key], or null if it doesn't
+ * exist
+ *******************************************************************/
+const MobjPropertyList::entry_t* MobjPropertyList::findEntry(Key key) const
+{
+	if (!storage_)
+		return nullptr;
+
+	for (auto& entry : storage_->entries)
+		if (entry.key == key)
+			return &entry;
+
+	return nullptr;
+}
+
+/* MobjPropertyList::mutableStorage
+ * Returns the list's storage for modification, creating it if it
+ * doesn't exist or copying it if it is shared with another list
+ *******************************************************************/
+MobjPropertyList::storage_t& MobjPropertyList::mutableStorage()
+{
+	if (!storage_)
+		storage_ = std::make_shared<storage_t>();
+	else if (storage_.use_count() > 1)
+		storage_ = std::make_shared<storage_t>(*storage_);
+
+	return *storage_;
+}
+
+/* MobjPropertyList::entryValue
+ * Returns the value of [entry] as a Property
+ *******************************************************************/
+Property MobjPropertyList::entryValue(const entry_t& entry) const
+{
+	if (!entry.has_value)
+		return Property(entry.type);
+
+	switch (entry.type)
+	{
+	case PROP_INT:		return Property(entry.value.Integer);
+	case PROP_FLOAT:	return Property(entry.value.Floating);
+	case PROP_STRING:	return Property(storage_->strings[entry.value.Unsigned]);
+	case PROP_UINT:		return Property(entry.value.Unsigned);
+	case PROP_FLAG:
+	{
+		Property flag(entry.type);
+		flag.setHasValue(true);
+		return flag;
+	}
+	default:			return Property(entry.value.Boolean);
+	}
+}
+
+/* MobjPropertyList::removeString
+ * Removes the string value of [entry] (if it has one) from [storage]
+ *******************************************************************/
+void MobjPropertyList::removeString(storage_t& storage, entry_t& entry)
+{
+	if (entry.type != PROP_STRING)
+		return;
+
+	unsigned index = entry.value.Unsigned;
+	storage.strings.erase(storage.strings.begin() + index);
+	for (auto& e : storage.entries)
+		if (e.type == PROP_STRING && e.value.Unsigned > index)
+			e.value.Unsigned--;
+
+	entry.type = PROP_BOOL;
+	entry.value.Boolean = false;
+}
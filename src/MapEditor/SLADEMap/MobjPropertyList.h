@@ -4,9 +4,16 @@
 
 #include "Utility/PropertyList/Property.h"
 
+// Property list for map objects. Property names are interned to integer
+// keys, values are stored as small typed entries (strings separately) and
+// the storage is shared between copies (eg. undo backups) until one of them
+// is modified. Keys are shared by all lists and should only be interned from
+// the main thread
 class MobjPropertyList
 {
 public:
+	typedef uint32_t Key;
+
 	struct prop_t
 	{
 		string		name;
@@ -20,35 +27,99 @@ public:
 		}
 	};
 
+	// Reference to a property in a list, so that properties can be read
+	// and assigned via list[key] as if the list was a map of Property
+	class PropertyRef
+	{
+	public:
+		PropertyRef(MobjPropertyList& list, Key key) : list_(list), key_(key) {}
+
+		Property	value() const { return list_.get(key_); }
+		uint8_t		getType() const { return value().getType(); }
+		bool		hasValue() const { return list_.hasValue(key_); }
+
+		bool		getBoolValue() const { return value().getBoolValue(); }
+		int			getIntValue() const { return value().getIntValue(); }
+		double		getFloatValue() const { return value().getFloatValue(); }
+		string		getStringValue() const { return value().getStringValue(); }
+		unsigned	getUnsignedValue() const { return value().getUnsignedValue(); }
+
+		inline operator bool () const { return getBoolValue(); }
+		inline operator int () const { return getIntValue(); }
+		inline operator float () const { return (float)getFloatValue(); }
+		inline operator double () const { return getFloatValue(); }
+		inline operator string () const { return getStringValue(); }
+		inline operator unsigned () const { return getUnsignedValue(); }
+
+		inline bool operator= (bool val) { list_.set(key_, Property(val)); return val; }
+		inline int operator= (int val) { list_.set(key_, Property(val)); return val; }
+		inline float operator= (float val) { list_.set(key_, Property((double)val)); return val; }
+		inline double operator= (double val) { list_.set(key_, Property(val)); return val; }
+		inline string operator= (string val) { list_.set(key_, Property(val)); return val; }
+		inline unsigned operator= (unsigned val) { list_.set(key_, Property(val)); return val; }
+		inline void operator= (const Property& val) { list_.set(key_, val); }
+		inline void operator= (const PropertyRef& ref) { list_.set(key_, ref.value()); }
+
+	private:
+		MobjPropertyList&	list_;
+		Key					key_;
+	};
+
 	MobjPropertyList();
 	~MobjPropertyList();
 
-	// Operator for direct access to hash map
-	Property& operator[](string key)
-	{
-		for (unsigned a = 0; a < properties.size(); ++a)
-		{
-			if (properties[a].name == key)
-				return properties[a].value;
-		}
+	// Operator for direct access to properties
+	PropertyRef	operator[](const string& key) { return PropertyRef(*this, internKey(key)); }
+	PropertyRef	operator[](Key key) { return PropertyRef(*this, key); }
+
+	vector<prop_t>	allProperties() const;
+
+	void		clear() { storage_.reset(); }
+	bool		propertyExists(const string& key) const;
+	bool		removeProperty(const string& key);
+	void		copyTo(MobjPropertyList& list) const;
+	void		addFlag(const string& key);
+	bool		isEmpty() const { return !storage_ || storage_->entries.empty(); }
+	unsigned	size() const { return storage_ ? storage_->entries.size() : 0; }
 
-		properties.push_back(prop_t(key));
-		return properties.back().value;
-	}
+	Property	get(Key key) const;
+	bool		get(const string& key, Property& value) const;
+	bool		hasValue(Key key) const;
+	void		set(Key key, const Property& value);
 
-	vector<prop_t>&	allProperties() { return properties; }
+	string	toString(bool condensed = false) const;
 
-	void	clear() { properties.clear(); }
-	bool	propertyExists(string key);
-	bool	removeProperty(string key);
-	void	copyTo(MobjPropertyList& list);
-	void	addFlag(string key);
-	bool	isEmpty() { return properties.empty(); }
+	// Memory usage
+	const void*	storageId() const { return storage_.get(); }
+	bool		isShared() const { return storage_ && storage_.use_count() > 1; }
+	size_t		storageSize() const;
 
-	string	toString(bool condensed = false);
+	// Keys
+	static Key				internKey(const string& name);
+	static const string&	keyName(Key key);
+	static unsigned			nKeys();
 
 private:
-	vector<prop_t>	properties;
+	struct entry_t
+	{
+		Key			key;
+		uint8_t		type;
+		bool		has_value;
+		prop_value	value;		// For PROP_STRING, the index in strings
+	};
+
+	struct storage_t
+	{
+		vector<entry_t>	entries;
+		vector<string>	strings;
+	};
+
+	std::shared_ptr<storage_t>	storage_;
+
+	const entry_t*	findEntry(Key key) const;
+	storage_t&		mutableStorage();
+	Property		entryValue(const entry_t& entry) const;
+	void			removeString(storage_t& storage, entry_t& entry);
 };
 
 #endif//__MOBJ_PROPERTY_LIST_H__
@@ -32,11 +32,13 @@
 #include "Archive/Archive.h"
 #include "Archive/Formats/WadArchive.h"
 #include "Game/Configuration.h"
+#include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "General/UI.h"
 #include "MapEditor/SectorBuilder.h"
 #include "SLADEMap.h"
 #include "Utility/MathStuff.h"
+#include "Utility/Parallel.h"
 #include "Utility/Parser.h"
 
 #define IDEQ(x) (((x) != 0) && ((x) == id))
@@ -47,6 +49,111 @@
  *******************************************************************/
 CVAR(Bool, map_split_auto_offset, true, CVAR_SAVE)
 
+// Binary map lump records are decoded (across threads) in chunks of this
+// many, and splash progress is updated once per chunk
+static const unsigned READ_CHUNK_SIZE = 4096;
+
+
+/*******************************************************************
+ * SLADEMAP HELPER FUNCTIONS
+ *******************************************************************/
+
+/* binary_prop_keys_t
+ * Keys of the properties set when reading binary format maps, so
+ * they are only interned once rather than for every object read
+ *******************************************************************/
+struct binary_prop_keys_t
+{
+	typedef MobjPropertyList::Key Key;
+	Key	arg[5];
+	Key	id;
+	Key	flags;
+	Key	special;
+	Key	height;
+	Key	macro;
+	Key	extraflags;
+	Key	color[5];
+
+	binary_prop_keys_t()
+	{
+		for (unsigned a = 0; a < 5; a++)
+			arg[a] = MobjPropertyList::internKey(S_FMT("arg%d", a));
+		id = MobjPropertyList::internKey("id");
+		flags = MobjPropertyList::internKey("flags");
+		special = MobjPropertyList::internKey("special");
+		height = MobjPropertyList::internKey("height");
+		macro = MobjPropertyList::internKey("macro");
+		extraflags = MobjPropertyList::internKey("extraflags");
+		color[0] = MobjPropertyList::internKey("color_things");
+		color[1] = MobjPropertyList::internKey("color_floor");
+		color[2] = MobjPropertyList::internKey("color_ceiling");
+		color[3] = MobjPropertyList::internKey("color_upper");
+		color[4] = MobjPropertyList::internKey("color_lower");
+	}
+};
+static const binary_prop_keys_t& binaryPropKeys()
+{
+	static binary_prop_keys_t keys;
+	return keys;
+}
+
+/* updateReadProgress
+ * Updates the splash progress for reading record [index] of [count]
+ * from [start], once per chunk of records (updating the splash
+ * window for every record is slower than reading it)
+ *******************************************************************/
+static void updateReadProgress(float start, unsigned index, unsigned count)
+{
+	if (index % READ_CHUNK_SIZE == 0)
+		UI::setSplashProgress(start + ((float)index / count) * 0.2f);
+}
+
+/* decodeRecords
+ * Decodes the [count] binary map lump records in [data] into [defs]
+ * by calling [decode] for each one. The records are decoded in
+ * chunks of READ_CHUNK_SIZE, spread across worker threads, so
+ * [decode] must not modify anything but the def it is given
+ *******************************************************************/
+template<typename Record, typename Def, typename Decode>
+static void decodeRecords(const Record* data, unsigned count, vector<Def>& defs, Decode decode)
+{
+	defs.resize(count);
+	unsigned n_chunks = (count + READ_CHUNK_SIZE - 1) / READ_CHUNK_SIZE;
+	Parallel::forEach(n_chunks, [&](unsigned chunk)
+	{
+		unsigned end = MIN((chunk + 1) * READ_CHUNK_SIZE, count);
+		for (unsigned a = chunk * READ_CHUNK_SIZE; a < end; a++)
+			decode(data[a], defs[a]);
+	});
+}
+
+/* sectorIndex
+ * Returns binary format sidedef sector [index] if it is one of the
+ * [n_sectors] sectors read, or -1 if not
+ *******************************************************************/
+static int sectorIndex(short index, unsigned n_sectors)
+{
+	return (unsigned)index < n_sectors ? index : -1;
+}
+
+typedef std::map<uint64_t, MapTextureNames::Handle> doom64_names_t;
+
+/* internDoom64Name
+ * Returns the handle for the Doom 64 texture name with [hash],
+ * looked up via [names] so each distinct hash in a lump is only
+ * converted to a name and interned once
+ *******************************************************************/
+static MapTextureNames::Handle internDoom64Name(uint64_t hash, doom64_names_t& names)
+{
+	auto i = names.find(hash);
+	if (i != names.end())
+		return i->second;
+
+	auto handle = MapTextureNames::intern(theResourceManager->getTextureName((uint16_t)hash));
+	names[hash] = handle;
+	return handle;
+}
+
 
 /*******************************************************************
  * SLADEMAP CLASS FUNCTIONS
@@ -55,11 +162,14 @@ CVAR(Bool, map_split_auto_offset, true, CVAR_SAVE)
 /* SLADEMap::SLADEMap
  * SLADEMap class constructor
  *******************************************************************/
-SLADEMap::SLADEMap()
+SLADEMap::SLADEMap() : tag_index_(*this), geometry_(*this)
 {
 	// Init variables
 	this->geometry_updated_ = 0;
 	this->position_frac_ = false;
+	this->obj_journal_active_ = false;
+	for (unsigned a = 0; a <= MOBJ_THING; a++)
+		obj_journal_taken_[a] = false;
 
 	// Object id 0 is always null
 	all_objects_.push_back(mobj_holder_t(nullptr, false));
@@ -193,6 +303,8 @@ void SLADEMap::refreshIndices()
 	// Thing indices
 	for (unsigned a = 0; a < things_.size(); a++)
 		things_[a]->index = a;
+
+	geometry_.invalidate();
 }
 
 /* SLADEMap::addMapObject
@@ -200,9 +312,15 @@ void SLADEMap::refreshIndices()
  *******************************************************************/
 void SLADEMap::addMapObject(MapObject* object)
 {
+	if (obj_journal_active_)
+		journalObjectType(object->getObjType());
+
 	all_objects_.push_back(mobj_holder_t(object, true));
 	object->id = all_objects_.size() - 1;
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, true));
+	tag_index_.objectChanged(object);
+	geometry_.objectAdded(object);
+	change_count_++;
 }
 
 /* SLADEMap::removeMapObject
@@ -211,8 +329,24 @@ void SLADEMap::addMapObject(MapObject* object)
  *******************************************************************/
 void SLADEMap::removeMapObject(MapObject* object)
 {
+	if (obj_journal_active_)
+		journalObjectType(object->getObjType());
+
 	all_objects_[object->id].in_map = false;
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, false));
+	tag_index_.objectChanged(object);
+	geometry_.invalidate();
+	change_count_++;
+}
+
+/* SLADEMap::objectChanged
+ * Called when [object] is modified (before the modification is made)
+ *******************************************************************/
+void SLADEMap::objectChanged(MapObject* object)
+{
+	tag_index_.objectChanged(object);
+	geometry_.objectChanged(object);
+	change_count_++;
 }
 
 /* SLADEMap::getObjectIdList
@@ -253,6 +387,10 @@ void SLADEMap::getObjectIdList(uint8_t type, vector<unsigned>& list)
  *******************************************************************/
 void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
 {
+	tag_index_.invalidate();
+	geometry_.invalidate();
+	change_count_++;
+
 	if (type == MOBJ_VERTEX)
 	{
 		// Clear
@@ -330,6 +468,61 @@ void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
 	}
 }
 
+/* SLADEMap::beginObjectJournal
+ * Begins journaling object creation/deletion (used for undo/redo).
+ * The first time an object of a type is created or deleted, the ids
+ * of all objects of that type are recorded, so that the list only
+ * has to be built for types that actually change
+ *******************************************************************/
+void SLADEMap::beginObjectJournal()
+{
+	obj_journal_active_ = true;
+	for (unsigned a = 0; a <= MOBJ_THING; a++)
+	{
+		obj_journal_taken_[a] = false;
+		obj_journal_ids_[a].clear();
+	}
+}
+
+/* SLADEMap::endObjectJournal
+ * Stops journaling object creation/deletion
+ *******************************************************************/
+void SLADEMap::endObjectJournal()
+{
+	obj_journal_active_ = false;
+}
+
+/* SLADEMap::takeObjectJournal
+ * Moves the object ids of [type] recorded by the journal into [list].
+ * Returns false if no objects of [type] were created or deleted
+ * since the journal began
+ *******************************************************************/
+bool SLADEMap::takeObjectJournal(uint8_t type, vector<unsigned>& list)
+{
+	if (type > MOBJ_THING || !obj_journal_taken_[type])
+		return false;
+
+	list.clear();
+	list.swap(obj_journal_ids_[type]);
+	obj_journal_taken_[type] = false;
+
+	return true;
+}
+
+/* SLADEMap::journalObjectType
+ * Records the ids of all objects of [type] in the journal, if they
+ * haven't been already. Must be called before objects are added to
+ * or removed from the map
+ *******************************************************************/
+void SLADEMap::journalObjectType(uint8_t type)
+{
+	if (type > MOBJ_THING || obj_journal_taken_[type])
+		return;
+
+	getObjectIdList(type, obj_journal_ids_[type]);
+	obj_journal_taken_[type] = true;
+}
+
 /* SLADEMap::readMap
  * Reads map data using info in [map]
  *******************************************************************/
@@ -392,209 +585,155 @@ bool SLADEMap::readMap(Archive::MapDesc map)
 }
 
 /* SLADEMap::addVertex
- * Adds a vertex to the map from a doom vertex definition [v]
+ * Adds a vertex to the map from a decoded binary format vertex [v]
  *******************************************************************/
-bool SLADEMap::addVertex(doomvertex_t& v)
+bool SLADEMap::addVertex(const vertex_def_t& v)
 {
 	MapVertex* nv = new MapVertex(v.x, v.y, this);
 	vertices_.push_back(nv);
 	return true;
 }
 
-/* SLADEMap::addVertex
- * Adds a vertex to the map from a doom64 vertex definition [v]
- *******************************************************************/
-bool SLADEMap::addVertex(doom64vertex_t& v)
-{
-	MapVertex* nv = new MapVertex((double)v.x/65536, (double)v.y/65536, this);
-	vertices_.push_back(nv);
-	return true;
-}
-
 /* SLADEMap::addSide
- * Adds a side to the map from a doom sidedef definition [s]
+ * Adds a side to the map from a decoded binary format sidedef [s],
+ * with its texture names already interned
  *******************************************************************/
-bool SLADEMap::addSide(doomside_t& s)
+bool SLADEMap::addSide(const side_def_t& s)
 {
 	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
+	MapSide* ns = new MapSide(s.sector >= 0 ? sectors_[s.sector] : nullptr, this);
 
 	// Setup side properties
-	ns->tex_upper = wxString::FromAscii(s.tex_upper, 8);
-	ns->tex_lower = wxString::FromAscii(s.tex_lower, 8);
-	ns->tex_middle = wxString::FromAscii(s.tex_middle, 8);
-	ns->offset_x = s.x_offset;
-	ns->offset_y = s.y_offset;
+	ns->tex_upper = s.tex[0];
+	ns->tex_lower = s.tex[1];
+	ns->tex_middle = s.tex[2];
+	ns->offset_x = s.offset_x;
+	ns->offset_y = s.offset_y;
 
 	// Update texture counts
-	usage_tex_[ns->tex_upper.Upper()] += 1;
-	usage_tex_[ns->tex_middle.Upper()] += 1;
-	usage_tex_[ns->tex_lower.Upper()] += 1;
+	updateTexUsage(ns->tex_upper, 1);
+	updateTexUsage(ns->tex_middle, 1);
+	updateTexUsage(ns->tex_lower, 1);
 
 	// Add side
 	sides_.push_back(ns);
 	return true;
 }
 
-/* SLADEMap::addSide
- * Adds a side to the map from a doom64 sidedef definition [s]
+/* SLADEMap::line_refs_t::resolve
+ * Sets the vertex and side indices from binary format line vertex
+ * indices [v1],[v2] and side indices [s1],[s2]. Indices not within
+ * [n_vertices]/[n_sides] (eg. 65535 for no side) are set to -1
  *******************************************************************/
-bool SLADEMap::addSide(doom64side_t& s)
+void SLADEMap::line_refs_t::resolve(unsigned v1, unsigned v2, unsigned s1, unsigned s2, unsigned n_vertices, unsigned n_sides)
 {
-	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
-
-	// Setup side properties
-	ns->tex_upper = theResourceManager->getTextureName(s.tex_upper);
-	ns->tex_lower = theResourceManager->getTextureName(s.tex_lower);
-	ns->tex_middle = theResourceManager->getTextureName(s.tex_middle);
-	ns->offset_x = s.x_offset;
-	ns->offset_y = s.y_offset;
-
-	// Update texture counts
-	usage_tex_[ns->tex_upper.Upper()] += 1;
-	usage_tex_[ns->tex_middle.Upper()] += 1;
-	usage_tex_[ns->tex_lower.Upper()] += 1;
-
-	// Add side
-	sides_.push_back(ns);
-	return true;
+	this->v1 = v1 < n_vertices ? v1 : -1;
+	this->v2 = v2 < n_vertices ? v2 : -1;
+	this->s1 = s1 < n_sides && s1 != 65535 ? s1 : -1;
+	this->s2 = s2 < n_sides && s2 != 65535 ? s2 : -1;
 }
 
 /* SLADEMap::addLine
- * Adds a line to the map from a doom linedef definition [l]
+ * Creates a line from resolved binary format line [refs] and adds
+ * it to the map. Sides already used by a previous line are
+ * duplicated. Returns the new line, or NULL if it has an invalid
+ * vertex
  *******************************************************************/
-bool SLADEMap::addLine(doomline_t& l)
+MapLine* SLADEMap::addLine(const line_refs_t& refs)
 {
-	// Get relevant sides
-	MapSide* s1 = nullptr;
-	MapSide* s2 = nullptr;
-	if (sides_.size() > 32767)
-	{
-		// Support for > 32768 sides
-		if (l.side1 != 65535) s1 = getSide(static_cast<unsigned short>(l.side1));
-		if (l.side2 != 65535) s2 = getSide(static_cast<unsigned short>(l.side2));
-	}
-	else
-	{
-		s1 = getSide(l.side1);
-		s2 = getSide(l.side2);
-	}
-
-	// Get relevant vertices
-	MapVertex* v1 = getVertex(l.vertex1);
-	MapVertex* v2 = getVertex(l.vertex2);
-
 	// Check everything is valid
-	if (!v1 || !v2)
-		return false;
-
-	// Check if side1 already belongs to a line
-	if (s1 && s1->parent)
-	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
-		ns->copy(s1);
-		s1 = ns;
-		sides_.push_back(s1);
-	}
+	if (refs.v1 < 0 || refs.v2 < 0)
+		return nullptr;
 
-	// Check if side2 already belongs to a line
-	if (s2 && s2->parent)
+	// Get relevant sides, duplicating any that already belong to a line
+	MapSide* sides[2] = {
+		refs.s1 >= 0 ? sides_[refs.s1] : nullptr,
+		refs.s2 >= 0 ? sides_[refs.s2] : nullptr
+	};
+	for (auto& side : sides)
 	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
-		ns->copy(s2);
-		s2 = ns;
-		sides_.push_back(s2);
+		if (side && side->parent)
+		{
+			MapSide* ns = new MapSide(side->sector, this);
+			ns->copy(side);
+			side = ns;
+			sides_.push_back(side);
+		}
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
-
-	// Setup line properties
-	nl->properties["arg0"] = l.sector_tag;
-	nl->properties["id"] = l.sector_tag;
-	nl->special = l.type;
-	nl->properties["flags"] = l.flags;
-
-	// Add line
+	MapLine* nl = new MapLine(vertices_[refs.v1], vertices_[refs.v2], sides[0], sides[1], this);
 	lines_.push_back(nl);
-	return true;
+
+	return nl;
 }
 
 /* SLADEMap::addLine
- * Adds a line to the map from a doom64 linedef definition [l]
+ * Adds a line to the map from a decoded binary format linedef [l]
+ * read from a [format] map
  *******************************************************************/
-bool SLADEMap::addLine(doom64line_t& l)
+bool SLADEMap::addLine(const line_def_t& l, int format)
 {
-	// Get relevant sides
-	MapSide* s1 = nullptr;
-	MapSide* s2 = nullptr;
-	if (sides_.size() > 32767)
-	{
-		// Support for > 32768 sides
-		if (l.side1 != 65535) s1 = getSide(static_cast<unsigned short>(l.side1));
-		if (l.side2 != 65535) s2 = getSide(static_cast<unsigned short>(l.side2));
-	}
-	else
-	{
-		s1 = getSide(l.side1);
-		s2 = getSide(l.side2);
-	}
-
-	// Get relevant vertices
-	MapVertex* v1 = getVertex(l.vertex1);
-	MapVertex* v2 = getVertex(l.vertex2);
-
-	// Check everything is valid
-	if (!v1 || !v2)
+	// Create line
+	MapLine* nl = addLine(l.refs);
+	if (!nl)
 		return false;
 
-	// Check if side1 already belongs to a line
-	if (s1 && s1->parent)
+	// Setup line properties
+	auto& keys = binaryPropKeys();
+	if (format == MAP_HEXEN)
 	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
-		ns->copy(s1);
-		s1 = ns;
-		sides_.push_back(s1);
-	}
+		for (unsigned a = 0; a < 5; a++)
+			nl->properties[keys.arg[a]] = l.args[a];
+		nl->special = l.special;
+		nl->properties[keys.flags] = l.flags;
 
-	// Check if side2 already belongs to a line
-	if (s2 && s2->parent)
+		// Handle some special cases
+		if (l.special)
+		{
+			switch (Game::configuration().actionSpecial(l.special).needsTag())
+			{
+			case Game::TagType::LineId:
+			case Game::TagType::LineId1Line2:
+				nl->properties[keys.id] = l.args[0]; break;
+			case Game::TagType::LineIdHi5:
+				nl->properties[keys.id] = (l.args[0] + (l.args[4] << 8)); break;
+			default:
+				break;
+			}
+		}
+	}
+	else if (format == MAP_DOOM64)
 	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
-		ns->copy(s2);
-		s2 = ns;
-		sides_.push_back(s2);
+		nl->properties[keys.arg[0]] = l.args[0];
+		if (l.macro >= 0)
+			nl->properties[keys.macro] = l.macro;
+		else
+			nl->special = l.special;
+		nl->properties[keys.flags] = l.flags;
+		nl->properties[keys.extraflags] = l.extraflags;
 	}
-
-	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
-
-	// Setup line properties
-	nl->properties["arg0"] = l.sector_tag;
-	if (l.type & 0x100)
-		nl->properties["macro"] = l.type & 0xFF;
 	else
-		nl->special = l.type & 0xFF;
-	nl->properties["flags"] = (int)l.flags;
-	nl->properties["extraflags"] = l.type >> 9;
+	{
+		nl->properties[keys.arg[0]] = l.args[0];
+		nl->properties[keys.id] = l.args[0];
+		nl->special = l.special;
+		nl->properties[keys.flags] = l.flags;
+	}
 
-	// Add line
-	lines_.push_back(nl);
 	return true;
 }
 
 /* SLADEMap::addSector
- * Adds a sector to the map from a doom sector definition [s]
+ * Adds a sector to the map from a decoded binary format sector [s]
+ * read from a [format] map, with its flat names already interned
  *******************************************************************/
-bool SLADEMap::addSector(doomsector_t& s)
+bool SLADEMap::addSector(const sector_def_t& s, int format)
 {
 	// Create sector
-	MapSector* ns = new MapSector(wxString::FromAscii(s.f_tex, 8), wxString::FromAscii(s.c_tex, 8), this);
+	MapSector* ns = new MapSector(this);
+	ns->f_tex = s.f_tex;
+	ns->c_tex = s.c_tex;
 
 	// Setup sector properties
 	ns->setFloorHeight(s.f_height);
@@ -602,42 +741,17 @@ bool SLADEMap::addSector(doomsector_t& s)
 	ns->light = s.light;
 	ns->special = s.special;
 	ns->tag = s.tag;
+	if (format == MAP_DOOM64)
+	{
+		auto& keys = binaryPropKeys();
+		ns->properties[keys.flags] = s.flags;
+		for (unsigned a = 0; a < 5; a++)
+			ns->properties[keys.color[a]] = s.color[a];
+	}
 
 	// Update texture counts
-	usage_flat_[ns->f_tex.Upper()] += 1;
-	usage_flat_[ns->c_tex.Upper()] += 1;
-
-	// Add sector
-	sectors_.push_back(ns);
-	return true;
-}
-
-/* SLADEMap::addSector
- * Adds a sector to the map from a doom64 sector definition [s]
- *******************************************************************/
-bool SLADEMap::addSector(doom64sector_t& s)
-{
-	// Create sector
-	// We need to retrieve the texture name from the hash value
-	MapSector* ns = new MapSector(theResourceManager->getTextureName(s.f_tex),
-								  theResourceManager->getTextureName(s.c_tex), this);
-
-	// Setup sector properties
-	ns->setFloorHeight(s.f_height);
-	ns->setCeilingHeight(s.c_height);
-	ns->light = 255;
-	ns->special = s.special;
-	ns->tag = s.tag;
-	ns->properties["flags"] = s.flags;
-	ns->properties["color_things"] = s.color[0];
-	ns->properties["color_floor"] = s.color[1];
-	ns->properties["color_ceiling"] = s.color[2];
-	ns->properties["color_upper"] = s.color[3];
-	ns->properties["color_lower"] = s.color[4];
-
-	// Update texture counts
-	usage_flat_[ns->f_tex.Upper()] += 1;
-	usage_flat_[ns->c_tex.Upper()] += 1;
+	updateFlatUsage(ns->f_tex, 1);
+	updateFlatUsage(ns->c_tex, 1);
 
 	// Add sector
 	sectors_.push_back(ns);
@@ -645,35 +759,34 @@ bool SLADEMap::addSector(doom64sector_t& s)
 }
 
 /* SLADEMap::addThing
- * Adds a thing to the map from a doom thing definition [t]
- *******************************************************************/
-bool SLADEMap::addThing(doomthing_t& t)
-{
-	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
-
-	// Setup thing properties
-	nt->angle = t.angle;
-	nt->properties["flags"] = t.flags;
-
-	// Add thing
-	things_.push_back(nt);
-	return true;
-}
-
-/* SLADEMap::addThing
- * Adds a thing to the map from a doom64 thing definition [t]
+ * Adds a thing to the map from a decoded binary format thing [t]
+ * read from a [format] map
  *******************************************************************/
-bool SLADEMap::addThing(doom64thing_t& t)
+bool SLADEMap::addThing(const thing_def_t& t, int format)
 {
 	// Create thing
 	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
 
 	// Setup thing properties
+	auto& keys = binaryPropKeys();
 	nt->angle = t.angle;
-	nt->properties["height"] = (double)t.z;
-	nt->properties["flags"] = t.flags;
-	nt->properties["id"] = t.tid;
+	if (format == MAP_HEXEN)
+	{
+		nt->properties[keys.height] = (double)t.z;
+		nt->properties[keys.special] = t.special;
+		nt->properties[keys.flags] = t.flags;
+		nt->properties[keys.id] = t.tid;
+		for (unsigned a = 0; a < 5; a++)
+			nt->properties[keys.arg[a]] = t.args[a];
+	}
+	else if (format == MAP_DOOM64)
+	{
+		nt->properties[keys.height] = (double)t.z;
+		nt->properties[keys.flags] = t.flags;
+		nt->properties[keys.id] = t.tid;
+	}
+	else
+		nt->properties[keys.flags] = t.flags;
 
 	// Add thing
 	things_.push_back(nt);
@@ -701,11 +814,22 @@ bool SLADEMap::readDoomVertexes(ArchiveEntry* entry)
 
 	doomvertex_t* vert_data = (doomvertex_t*)entry->getData(true);
 	unsigned nv = entry->getSize() / sizeof(doomvertex_t);
+
+	// Decode vertices
+	vector<vertex_def_t> defs;
+	decodeRecords(vert_data, nv, defs, [](const doomvertex_t& v, vertex_def_t& def)
+	{
+		def.x = v.x;
+		def.y = v.y;
+	});
+
+	// Create vertices
+	vertices_.reserve(vertices_.size() + nv);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nv; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nv) * 0.2f);
-		addVertex(vert_data[a]);
+		updateReadProgress(p, a, nv);
+		addVertex(defs[a]);
 	}
 
 	LOG_MESSAGE(3, "Read %lu vertices", vertices_.size());
@@ -734,11 +858,30 @@ bool SLADEMap::readDoomSidedefs(ArchiveEntry* entry)
 
 	doomside_t* side_data = (doomside_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomside_t);
+
+	// Decode sidedefs
+	vector<side_def_t> defs;
+	unsigned n_sectors = sectors_.size();
+	decodeRecords(side_data, ns, defs, [n_sectors](const doomside_t& s, side_def_t& def)
+	{
+		memcpy(&def.tex_key[0], s.tex_upper, 8);
+		memcpy(&def.tex_key[1], s.tex_lower, 8);
+		memcpy(&def.tex_key[2], s.tex_middle, 8);
+		def.sector = sectorIndex(s.sector, n_sectors);
+		def.offset_x = s.x_offset;
+		def.offset_y = s.y_offset;
+	});
+
+	// Create sides
+	sides_.reserve(sides_.size() + ns);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < ns; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		addSide(side_data[a]);
+		updateReadProgress(p, a, ns);
+		auto& def = defs[a];
+		for (unsigned t = 0; t < 3; t++)
+			def.tex[t] = MapTextureNames::internLump((const char*)&def.tex_key[t]);
+		addSide(def);
 	}
 
 	LOG_MESSAGE(3, "Read %lu sides", sides_.size());
@@ -767,11 +910,26 @@ bool SLADEMap::readDoomLinedefs(ArchiveEntry* entry)
 
 	doomline_t* line_data = (doomline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(doomline_t);
+
+	// Decode linedefs, resolving vertex and side indices
+	vector<line_def_t> defs;
+	unsigned n_vertices = vertices_.size();
+	unsigned n_sides = sides_.size();
+	decodeRecords(line_data, nl, defs, [n_vertices, n_sides](const doomline_t& l, line_def_t& def)
+	{
+		def.refs.resolve(l.vertex1, l.vertex2, l.side1, l.side2, n_vertices, n_sides);
+		def.special = l.type;
+		def.flags = l.flags;
+		def.args[0] = l.sector_tag;
+	});
+
+	// Create lines
+	lines_.reserve(lines_.size() + nl);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nl; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nl) * 0.2f);
-		if (!addLine(line_data[a]))
+		updateReadProgress(p, a, nl);
+		if (!addLine(defs[a], MAP_DOOM))
 			LOG_MESSAGE(2, "Line %lu invalid, not added", a);
 	}
 
@@ -801,11 +959,30 @@ bool SLADEMap::readDoomSectors(ArchiveEntry* entry)
 
 	doomsector_t* sect_data = (doomsector_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomsector_t);
+
+	// Decode sectors
+	vector<sector_def_t> defs;
+	decodeRecords(sect_data, ns, defs, [](const doomsector_t& s, sector_def_t& def)
+	{
+		memcpy(&def.f_key, s.f_tex, 8);
+		memcpy(&def.c_key, s.c_tex, 8);
+		def.f_height = s.f_height;
+		def.c_height = s.c_height;
+		def.light = s.light;
+		def.special = s.special;
+		def.tag = s.tag;
+	});
+
+	// Create sectors
+	sectors_.reserve(sectors_.size() + ns);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < ns; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		addSector(sect_data[a]);
+		updateReadProgress(p, a, ns);
+		auto& def = defs[a];
+		def.f_tex = MapTextureNames::internLump((const char*)&def.f_key);
+		def.c_tex = MapTextureNames::internLump((const char*)&def.c_key);
+		addSector(def, MAP_DOOM);
 	}
 
 	LOG_MESSAGE(3, "Read %lu sectors", sectors_.size());
@@ -834,11 +1011,25 @@ bool SLADEMap::readDoomThings(ArchiveEntry* entry)
 
 	doomthing_t* thng_data = (doomthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(doomthing_t);
+
+	// Decode things
+	vector<thing_def_t> defs;
+	decodeRecords(thng_data, nt, defs, [](const doomthing_t& t, thing_def_t& def)
+	{
+		def.x = t.x;
+		def.y = t.y;
+		def.angle = t.angle;
+		def.type = t.type;
+		def.flags = t.flags;
+	});
+
+	// Create things
+	things_.reserve(things_.size() + nt);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nt; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nt) * 0.2f);
-		addThing(thng_data[a]);
+		updateReadProgress(p, a, nt);
+		addThing(defs[a], MAP_DOOM);
 	}
 
 	LOG_MESSAGE(3, "Read %lu things", things_.size());
@@ -926,111 +1117,6 @@ bool SLADEMap::readDoomMap(Archive::MapDesc map)
 	return true;
 }
 
-/* SLADEMap::addLine
- * Adds a line to the map from a hexen linedef definition [l]
- *******************************************************************/
-bool SLADEMap::addLine(hexenline_t& l)
-{
-	// Get relevant sides
-	MapSide* s1 = nullptr;
-	MapSide* s2 = nullptr;
-	if (sides_.size() > 32767)
-	{
-		// Support for > 32768 sides
-		if (l.side1 != 65535) s1 = getSide(static_cast<unsigned short>(l.side1));
-		if (l.side2 != 65535) s2 = getSide(static_cast<unsigned short>(l.side2));
-	}
-	else
-	{
-		s1 = getSide(l.side1);
-		s2 = getSide(l.side2);
-	}
-
-	// Get relevant vertices
-	MapVertex* v1 = getVertex(l.vertex1);
-	MapVertex* v2 = getVertex(l.vertex2);
-
-	// Check everything is valid
-	if (!v1 || !v2)
-		return false;
-
-	// Check if side1 already belongs to a line
-	if (s1 && s1->parent)
-	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
-		ns->copy(s1);
-		s1 = ns;
-		sides_.push_back(s1);
-	}
-
-	// Check if side2 already belongs to a line
-	if (s2 && s2->parent)
-	{
-		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
-		ns->copy(s2);
-		s2 = ns;
-		sides_.push_back(s2);
-	}
-
-	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
-
-	// Setup line properties
-	nl->properties["arg0"] = l.args[0];
-	nl->properties["arg1"] = l.args[1];
-	nl->properties["arg2"] = l.args[2];
-	nl->properties["arg3"] = l.args[3];
-	nl->properties["arg4"] = l.args[4];
-	nl->special = l.type;
-	nl->properties["flags"] = l.flags;
-
-	// Handle some special cases
-	if (l.type)
-	{
-		switch (Game::configuration().actionSpecial(l.type).needsTag())
-		{
-		case Game::TagType::LineId:
-		case Game::TagType::LineId1Line2:
-			nl->properties["id"] = l.args[0]; break;
-		case Game::TagType::LineIdHi5:
-			nl->properties["id"] = (l.args[0] + (l.args[4] << 8)); break;
-		default:
-			break;
-		}
-	}
-
-	// Add line
-	lines_.push_back(nl);
-	return true;
-}
-
-/* SLADEMap::addThing
- * Adds a thing to the map from a hexen thing definition [t]
- *******************************************************************/
-bool SLADEMap::addThing(hexenthing_t& t)
-{
-	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
-
-	// Setup thing properties
-	nt->angle = t.angle;
-	nt->properties["height"] = (double)t.z;
-	nt->properties["special"] = t.special;
-	nt->properties["flags"] = t.flags;
-	nt->properties["id"] = t.tid;
-	nt->properties["arg0"] = t.args[0];
-	nt->properties["arg1"] = t.args[1];
-	nt->properties["arg2"] = t.args[2];
-	nt->properties["arg3"] = t.args[3];
-	nt->properties["arg4"] = t.args[4];
-
-	// Add thing
-	things_.push_back(nt);
-	return true;
-}
-
 /* SLADEMap::readHexenLinedefs
  * Reads in hexen format linedef definitions from [entry]
  *******************************************************************/
@@ -1051,11 +1137,27 @@ bool SLADEMap::readHexenLinedefs(ArchiveEntry* entry)
 
 	hexenline_t* line_data = (hexenline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(hexenline_t);
+
+	// Decode linedefs, resolving vertex and side indices
+	vector<line_def_t> defs;
+	unsigned n_vertices = vertices_.size();
+	unsigned n_sides = sides_.size();
+	decodeRecords(line_data, nl, defs, [n_vertices, n_sides](const hexenline_t& l, line_def_t& def)
+	{
+		def.refs.resolve(l.vertex1, l.vertex2, l.side1, l.side2, n_vertices, n_sides);
+		def.special = l.type;
+		def.flags = l.flags;
+		for (unsigned a = 0; a < 5; a++)
+			def.args[a] = l.args[a];
+	});
+
+	// Create lines
+	lines_.reserve(lines_.size() + nl);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nl; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nl) * 0.2f);
-		addLine(line_data[a]);
+		updateReadProgress(p, a, nl);
+		addLine(defs[a], MAP_HEXEN);
 	}
 
 	LOG_MESSAGE(3, "Read %lu lines", lines_.size());
@@ -1083,11 +1185,30 @@ bool SLADEMap::readHexenThings(ArchiveEntry* entry)
 
 	hexenthing_t* thng_data = (hexenthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(hexenthing_t);
+
+	// Decode things
+	vector<thing_def_t> defs;
+	decodeRecords(thng_data, nt, defs, [](const hexenthing_t& t, thing_def_t& def)
+	{
+		def.x = t.x;
+		def.y = t.y;
+		def.z = t.z;
+		def.angle = t.angle;
+		def.type = t.type;
+		def.flags = t.flags;
+		def.tid = t.tid;
+		def.special = t.special;
+		for (unsigned a = 0; a < 5; a++)
+			def.args[a] = t.args[a];
+	});
+
+	// Create things
+	things_.reserve(things_.size() + nt);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < nt; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nt) * 0.2f);
-		addThing(thng_data[a]);
+		updateReadProgress(p, a, nt);
+		addThing(defs[a], MAP_HEXEN);
 	}
 
 	LOG_MESSAGE(3, "Read %lu things", things_.size());
@@ -1192,11 +1313,22 @@ bool SLADEMap::readDoom64Vertexes(ArchiveEntry* entry)
 
 	doom64vertex_t* vert_data = (doom64vertex_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64vertex_t);
+
+	// Decode vertices (from fixed point)
+	vector<vertex_def_t> defs;
+	decodeRecords(vert_data, n, defs, [](const doom64vertex_t& v, vertex_def_t& def)
+	{
+		def.x = (double)v.x/65536;
+		def.y = (double)v.y/65536;
+	});
+
+	// Create vertices
+	vertices_.reserve(vertices_.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / n) * 0.2f);
-		addVertex(vert_data[a]);
+		updateReadProgress(p, a, n);
+		addVertex(defs[a]);
 	}
 
 	LOG_MESSAGE(3, "Read %lu vertices", vertices_.size());
@@ -1224,11 +1356,31 @@ bool SLADEMap::readDoom64Sidedefs(ArchiveEntry* entry)
 
 	doom64side_t* side_data = (doom64side_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64side_t);
+
+	// Decode sidedefs
+	vector<side_def_t> defs;
+	unsigned n_sectors = sectors_.size();
+	decodeRecords(side_data, n, defs, [n_sectors](const doom64side_t& s, side_def_t& def)
+	{
+		def.tex_key[0] = s.tex_upper;
+		def.tex_key[1] = s.tex_lower;
+		def.tex_key[2] = s.tex_middle;
+		def.sector = sectorIndex(s.sector, n_sectors);
+		def.offset_x = s.x_offset;
+		def.offset_y = s.y_offset;
+	});
+
+	// Create sides
+	sides_.reserve(sides_.size() + n);
+	doom64_names_t names;
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / n) * 0.2f);
-		addSide(side_data[a]);
+		updateReadProgress(p, a, n);
+		auto& def = defs[a];
+		for (unsigned t = 0; t < 3; t++)
+			def.tex[t] = internDoom64Name(def.tex_key[t], names);
+		addSide(def);
 	}
 
 	LOG_MESSAGE(3, "Read %lu sides", sides_.size());
@@ -1256,11 +1408,28 @@ bool SLADEMap::readDoom64Linedefs(ArchiveEntry* entry)
 
 	doom64line_t* line_data = (doom64line_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64line_t);
+
+	// Decode linedefs, resolving vertex and side indices
+	vector<line_def_t> defs;
+	unsigned n_vertices = vertices_.size();
+	unsigned n_sides = sides_.size();
+	decodeRecords(line_data, n, defs, [n_vertices, n_sides](const doom64line_t& l, line_def_t& def)
+	{
+		def.refs.resolve(l.vertex1, l.vertex2, l.side1, l.side2, n_vertices, n_sides);
+		def.special = l.type & 0xFF;
+		def.macro = (l.type & 0x100) ? l.type & 0xFF : -1;
+		def.flags = (int)l.flags;
+		def.extraflags = l.type >> 9;
+		def.args[0] = l.sector_tag;
+	});
+
+	// Create lines
+	lines_.reserve(lines_.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / n) * 0.2f);
-		addLine(line_data[a]);
+		updateReadProgress(p, a, n);
+		addLine(defs[a], MAP_DOOM64);
 	}
 
 	LOG_MESSAGE(3, "Read %lu lines", lines_.size());
@@ -1288,11 +1457,34 @@ bool SLADEMap::readDoom64Sectors(ArchiveEntry* entry)
 
 	doom64sector_t* sect_data = (doom64sector_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64sector_t);
+
+	// Decode sectors
+	vector<sector_def_t> defs;
+	decodeRecords(sect_data, n, defs, [](const doom64sector_t& s, sector_def_t& def)
+	{
+		def.f_key = s.f_tex;
+		def.c_key = s.c_tex;
+		def.f_height = s.f_height;
+		def.c_height = s.c_height;
+		def.light = 255;
+		def.special = s.special;
+		def.tag = s.tag;
+		def.flags = s.flags;
+		for (unsigned a = 0; a < 5; a++)
+			def.color[a] = s.color[a];
+	});
+
+	// Create sectors
+	sectors_.reserve(sectors_.size() + n);
+	doom64_names_t names;
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / n) * 0.2f);
-		addSector(sect_data[a]);
+		updateReadProgress(p, a, n);
+		auto& def = defs[a];
+		def.f_tex = internDoom64Name(def.f_key, names);
+		def.c_tex = internDoom64Name(def.c_key, names);
+		addSector(def, MAP_DOOM64);
 	}
 
 	LOG_MESSAGE(3, "Read %lu sectors", sectors_.size());
@@ -1320,11 +1512,27 @@ bool SLADEMap::readDoom64Things(ArchiveEntry* entry)
 
 	doom64thing_t* thng_data = (doom64thing_t*)entry->getData(true);
 	unsigned n = entry->getSize() / sizeof(doom64thing_t);
+
+	// Decode things
+	vector<thing_def_t> defs;
+	decodeRecords(thng_data, n, defs, [](const doom64thing_t& t, thing_def_t& def)
+	{
+		def.x = t.x;
+		def.y = t.y;
+		def.z = t.z;
+		def.angle = t.angle;
+		def.type = t.type;
+		def.flags = t.flags;
+		def.tid = t.tid;
+	});
+
+	// Create things
+	things_.reserve(things_.size() + n);
 	float p = UI::getSplashProgress();
 	for (size_t a = 0; a < n; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / n) * 0.2f);
-		addThing(thng_data[a]);
+		updateReadProgress(p, a, n);
+		addThing(defs[a], MAP_DOOM64);
 	}
 
 	LOG_MESSAGE(3, "Read %lu things", things_.size());
@@ -1463,9 +1671,9 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 	// Set defaults
 	ns->offset_x = 0;
 	ns->offset_y = 0;
-	ns->tex_upper = "-";
-	ns->tex_middle = "-";
-	ns->tex_lower = "-";
+	ns->tex_upper = MapTextureNames::intern("-");
+	ns->tex_middle = MapTextureNames::intern("-");
+	ns->tex_lower = MapTextureNames::intern("-");
 
 	// Add extra side info
 	ParseTreeNode* prop = nullptr;
@@ -1478,11 +1686,11 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 			continue;
 
 		if (S_CMPNOCASE(prop->getName(), "texturetop"))
-			ns->tex_upper = prop->stringValue();
+			ns->tex_upper = MapTextureNames::intern(prop->stringValue());
 		else if (S_CMPNOCASE(prop->getName(), "texturemiddle"))
-			ns->tex_middle = prop->stringValue();
+			ns->tex_middle = MapTextureNames::intern(prop->stringValue());
 		else if (S_CMPNOCASE(prop->getName(), "texturebottom"))
-			ns->tex_lower = prop->stringValue();
+			ns->tex_lower = MapTextureNames::intern(prop->stringValue());
 		else if (S_CMPNOCASE(prop->getName(), "offsetx"))
 			ns->offset_x = prop->intValue();
 		else if (S_CMPNOCASE(prop->getName(), "offsety"))
@@ -1493,9 +1701,9 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 	}
 
 	// Update texture counts
-	usage_tex_[ns->tex_upper.Upper()] += 1;
-	usage_tex_[ns->tex_middle.Upper()] += 1;
-	usage_tex_[ns->tex_lower.Upper()] += 1;
+	updateTexUsage(ns->tex_upper, 1);
+	updateTexUsage(ns->tex_middle, 1);
+	updateTexUsage(ns->tex_lower, 1);
 
 	// Add side to map
 	sides_.push_back(ns);
@@ -1575,8 +1783,8 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 
 	// Create new sector
 	MapSector* ns = new MapSector(prop_ftex->stringValue(), prop_ctex->stringValue(), this);
-	usage_flat_[ns->f_tex.Upper()] += 1;
-	usage_flat_[ns->c_tex.Upper()] += 1;
+	updateFlatUsage(ns->f_tex, 1);
+	updateFlatUsage(ns->c_tex, 1);
 
 	// Set defaults
 	ns->setFloorHeight(0);
@@ -1835,9 +2043,9 @@ bool SLADEMap::writeDoomSidedefs(ArchiveEntry* entry)
 		if (sides_[a]->sector) side.sector = sides_[a]->sector->getIndex();
 
 		// Textures
-		t_m = sides_[a]->tex_middle;
-		t_u = sides_[a]->tex_upper;
-		t_l = sides_[a]->tex_lower;
+		t_m = sides_[a]->getTexMiddle();
+		t_u = sides_[a]->getTexUpper();
+		t_l = sides_[a]->getTexLower();
 		memcpy(side.tex_middle, CHR(t_m), t_m.Length());
 		memcpy(side.tex_upper, CHR(t_u), t_u.Length());
 		memcpy(side.tex_lower, CHR(t_l), t_l.Length());
@@ -1912,8 +2120,8 @@ bool SLADEMap::writeDoomSectors(ArchiveEntry* entry)
 		sector.c_height = sectors_[a]->c_height;
 
 		// Textures
-		memcpy(sector.f_tex, CHR(sectors_[a]->f_tex), sectors_[a]->f_tex.Length());
-		memcpy(sector.c_tex, CHR(sectors_[a]->c_tex), sectors_[a]->c_tex.Length());
+		memcpy(sector.f_tex, CHR(sectors_[a]->getFloorTex()), sectors_[a]->getFloorTex().Length());
+		memcpy(sector.c_tex, CHR(sectors_[a]->getCeilingTex()), sectors_[a]->getCeilingTex().Length());
 
 		// Properties
 		sector.light = sectors_[a]->light;
@@ -2169,9 +2377,9 @@ bool SLADEMap::writeDoom64Sidedefs(ArchiveEntry* entry)
 		if (sides_[a]->sector) side.sector = sides_[a]->sector->getIndex();
 
 		// Textures
-		side.tex_middle	= theResourceManager->getTextureHash(sides_[a]->tex_middle);
-		side.tex_upper	= theResourceManager->getTextureHash(sides_[a]->tex_upper);
-		side.tex_lower	= theResourceManager->getTextureHash(sides_[a]->tex_lower);
+		side.tex_middle	= theResourceManager->getTextureHash(sides_[a]->getTexMiddle());
+		side.tex_upper	= theResourceManager->getTextureHash(sides_[a]->getTexUpper());
+		side.tex_lower	= theResourceManager->getTextureHash(sides_[a]->getTexLower());
 
 		entry->write(&side, sizeof(doom64side_t));
 	}
@@ -2421,12 +2629,12 @@ bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
 
 		// Basic properties
 		object_def += S_FMT("sector=%u;\n", sides_[a]->sector->getIndex());
-		if (sides_[a]->tex_upper != "-")
-			object_def += S_FMT("texturetop=\"%s\";\n", sides_[a]->tex_upper);
-		if (sides_[a]->tex_middle != "-")
-			object_def += S_FMT("texturemiddle=\"%s\";\n", sides_[a]->tex_middle);
-		if (sides_[a]->tex_lower != "-")
-			object_def += S_FMT("texturebottom=\"%s\";\n", sides_[a]->tex_lower);
+		if (sides_[a]->getTexUpper() != "-")
+			object_def += S_FMT("texturetop=\"%s\";\n", sides_[a]->getTexUpper());
+		if (sides_[a]->getTexMiddle() != "-")
+			object_def += S_FMT("texturemiddle=\"%s\";\n", sides_[a]->getTexMiddle());
+		if (sides_[a]->getTexLower() != "-")
+			object_def += S_FMT("texturebottom=\"%s\";\n", sides_[a]->getTexLower());
 		if (sides_[a]->offset_x != 0)
 			object_def += S_FMT("offsetx=%d;\n", sides_[a]->offset_x);
 		if (sides_[a]->offset_y != 0)
@@ -2472,7 +2680,7 @@ bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
 		object_def = S_FMT("sector//#%u\n{\n", a);
 
 		// Basic properties
-		object_def += S_FMT("texturefloor=\"%s\";\ntextureceiling=\"%s\";\n", sectors_[a]->f_tex, sectors_[a]->c_tex);
+		object_def += S_FMT("texturefloor=\"%s\";\ntextureceiling=\"%s\";\n", sectors_[a]->getFloorTex(), sectors_[a]->getCeilingTex());
 		if (sectors_[a]->f_height != 0) object_def += S_FMT("heightfloor=%d;\n", sectors_[a]->f_height);
 		if (sectors_[a]->c_height != 0) object_def += S_FMT("heightceiling=%d;\n", sectors_[a]->c_height);
 		if (sectors_[a]->light != 160) object_def += S_FMT("lightlevel=%d;\n", sectors_[a]->light);
@@ -2514,6 +2722,18 @@ void SLADEMap::clearMap()
 	sectors_.clear();
 	things_.clear();
 
+	tag_index_.invalidate();
+	geometry_.invalidate();
+	change_count_++;
+
+	// Object ids in the journal are no longer valid
+	obj_journal_active_ = false;
+	for (unsigned a = 0; a <= MOBJ_THING; a++)
+	{
+		obj_journal_taken_[a] = false;
+		obj_journal_ids_[a].clear();
+	}
+
 	// Clear map objects
 	for (unsigned a = 0; a < all_objects_.size(); a++)
 	{
@@ -2723,9 +2943,9 @@ bool SLADEMap::removeSide(unsigned index, bool remove_from_line)
 	}
 
 	// Update texture usage
-	usage_tex_[sides_[index]->tex_lower.Upper()] -= 1;
-	usage_tex_[sides_[index]->tex_middle.Upper()] -= 1;
-	usage_tex_[sides_[index]->tex_upper.Upper()] -= 1;
+	updateTexUsage(sides_[index]->tex_lower, -1);
+	updateTexUsage(sides_[index]->tex_middle, -1);
+	updateTexUsage(sides_[index]->tex_upper, -1);
 
 	// Remove the side
 	removeMapObject(sides_[index]);
@@ -2763,8 +2983,8 @@ bool SLADEMap::removeSector(unsigned index)
 	//	sectors[index]->connected_sides[a]->sector = NULL;
 
 	// Update texture usage
-	usage_flat_[sectors_[index]->f_tex.Upper()] -= 1;
-	usage_flat_[sectors_[index]->c_tex.Upper()] -= 1;
+	updateFlatUsage(sectors_[index]->f_tex, -1);
+	updateFlatUsage(sectors_[index]->c_tex, -1);
 
 	// Remove the sector
 	removeMapObject(sectors_[index]);
@@ -2815,17 +3035,15 @@ bool SLADEMap::removeThing(unsigned index)
  *******************************************************************/
 int SLADEMap::nearestVertex(fpoint2_t point, double min)
 {
-	// Go through vertices
+	// Go through vertex positions
+	auto& positions = geometry().vertexPositions();
 	double min_dist = 999999999;
-	MapVertex* v = nullptr;
 	double dist = 0;
 	int index = -1;
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	for (unsigned a = 0; a < positions.size(); a++)
 	{
-		v = vertices_[a];
-
 		// Get 'quick' distance (no need to get real distance)
-		dist = point.taxicab_distance_to(v->point());
+		dist = point.taxicab_distance_to(positions[a]);
 
 		// Check if it's nearer than the previous nearest
 		if (dist < min_dist)
@@ -2839,8 +3057,7 @@ int SLADEMap::nearestVertex(fpoint2_t point, double min)
 	// to check for minimum hilight distance
 	if (index >= 0)
 	{
-		v = vertices_[index];
-		double rdist = MathStuff::distance(v->point(), point);
+		double rdist = MathStuff::distance(positions[index], point);
 		if (rdist > min)
 			return -1;
 	}
@@ -2854,23 +3071,21 @@ int SLADEMap::nearestVertex(fpoint2_t point, double min)
  *******************************************************************/
 int SLADEMap::nearestLine(fpoint2_t point, double mindist)
 {
-	// Go through lines
+	// Go through line segments
+	auto& segs = geometry().lineSegs();
 	double min_dist = mindist;
 	double dist = 0;
 	int index = -1;
-	MapLine* l;
-	for (unsigned a = 0; a < lines_.size(); a++)
+	for (unsigned a = 0; a < segs.size(); a++)
 	{
-		l = lines_[a];
-
 		// Check with line bounding box first (since we have a minimum distance)
-		fseg2_t bbox = l->seg();
+		fseg2_t bbox = segs[a];
 		bbox.expand(mindist, mindist);
 		if (! bbox.contains(point))
 			continue;
 
 		// Calculate distance to line
-		dist = l->distanceTo(point);
+		dist = MapGeometry::distanceToLine(segs[a], point);
 
 		// Check if it's nearer than the previous nearest
 		if (dist < min_dist && dist < mindist)
@@ -2961,8 +3176,13 @@ vector<int> SLADEMap::nearestThingMulti(fpoint2_t point)
 int SLADEMap::sectorAt(fpoint2_t point)
 {
 	// Go through sectors
+	auto& bboxes = geometry().sectorBBoxes();
 	for (unsigned a = 0; a < sectors_.size(); a++)
 	{
+		// Check with sector bounding box first
+		if (!bboxes[a].point_within(point.x, point.y))
+			continue;
+
 		// Check if point is within sector
 		if (sectors_[a]->isWithin(point))
 			return a;
@@ -2983,13 +3203,13 @@ bbox_t SLADEMap::getMapBBox()
 	if (sectors_.size() == 0)
 		return bbox;
 
-	// Go through sectors
-	// This is quicker than generating it from vertices,
-	// but relies on sector bboxes being up-to-date (which they should be)
-	bbox = sectors_[0]->boundingBox();
-	for (unsigned a = 1; a < sectors_.size(); a++)
+	// Go through sector bounding boxes
+	// This is quicker than generating it from vertices
+	auto& bboxes = geometry().sectorBBoxes();
+	bbox = bboxes[0];
+	for (unsigned a = 1; a < bboxes.size(); a++)
 	{
-		bbox_t sbb = sectors_[a]->boundingBox();
+		const bbox_t& sbb = bboxes[a];
 		if (sbb.min.x < bbox.min.x)
 			bbox.min.x = sbb.min.x;
 		if (sbb.min.y < bbox.min.y)
@@ -3008,10 +3228,11 @@ bbox_t SLADEMap::getMapBBox()
  *******************************************************************/
 MapVertex* SLADEMap::vertexAt(double x, double y)
 {
-	// Go through all vertices
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	// Go through all vertex positions
+	auto& positions = geometry().vertexPositions();
+	for (unsigned a = 0; a < positions.size(); a++)
 	{
-		if (vertices_[a]->x == x && vertices_[a]->y == y)
+		if (positions[a].x == x && positions[a].y == y)
 			return vertices_[a];
 	}
 
@@ -3308,12 +3529,7 @@ void SLADEMap::getSectorsByTag(int tag, vector<MapSector*>& list)
 	if (tag == 0)
 		return;
 
-	// Find sectors with matching tag
-	for (unsigned a = 0; a < sectors_.size(); a++)
-	{
-		if (sectors_[a]->tag == tag)
-			list.push_back(sectors_[a]);
-	}
+	tag_index_.sectorsWithTag(tag, list);
 }
 
 /* SLADEMap::getThingsById
@@ -3326,10 +3542,12 @@ void SLADEMap::getThingsById(int id, vector<MapThing*>& list, unsigned start, in
 		return;
 
 	// Find things with matching id
-	for (unsigned a = start; a < things_.size(); a++)
+	vector<MapThing*> found;
+	tag_index_.thingsWithId(id, found);
+	for (unsigned a = 0; a < found.size(); a++)
 	{
-		if (things_[a]->intProperty("id") == id && (type == 0 || things_[a]->type == type))
-			list.push_back(things_[a]);
+		if (found[a]->index >= start && (type == 0 || found[a]->type == type))
+			list.push_back(found[a]);
 	}
 }
 
@@ -3342,11 +3560,13 @@ MapThing* SLADEMap::getFirstThingWithId(int id)
 		return nullptr;
 
 	// Find things with matching id, but ignore dragons, we don't want them!
-	for (unsigned a = 0; a < things_.size(); a++)
+	vector<MapThing*> found;
+	tag_index_.thingsWithId(id, found);
+	for (unsigned a = 0; a < found.size(); a++)
 	{
-		auto& tt = Game::configuration().thingType(things_[a]->getType());
-		if (things_[a]->intProperty("id") == id && !(tt.flags() & Game::ThingType::FLAG_DRAGON))
-			return things_[a];
+		auto& tt = Game::configuration().thingType(found[a]->getType());
+		if (!(tt.flags() & Game::ThingType::FLAG_DRAGON))
+			return found[a];
 	}
 	return nullptr;
 }
@@ -3360,16 +3580,24 @@ void SLADEMap::getThingsByIdInSectorTag(int id, int tag, vector<MapThing*>& list
 	if (id==0 && tag==0)
 		return;
 
-	// Find things with matching id contained in sector with matching tag
-	for (unsigned a = 0; a < things_.size(); a++)
+	// Get things with matching id (things without an id aren't indexed)
+	vector<MapThing*> things;
+	if (id != 0)
+		tag_index_.thingsWithId(id, things);
+	else
+	{
+		for (unsigned a = 0; a < things_.size(); a++)
+			if (things_[a]->intProperty("id") == 0)
+				things.push_back(things_[a]);
+	}
+
+	// Find things contained in sector with matching tag
+	for (unsigned a = 0; a < things.size(); a++)
 	{
-		if (things_[a]->intProperty("id") == id)
+		int si = sectorAt(things[a]->point());
+		if (si > -1 && (unsigned)si < sectors_.size() && sectors_[si]->tag == tag)
 		{
-			int si = sectorAt(things_[a]->point());
-			if (si > -1 && (unsigned)si < sectors_.size() && sectors_[si]->tag == tag)
-			{
-				list.push_back(things_[a]);
-			}
+			list.push_back(things[a]);
 		}
 	}
 }
@@ -3422,12 +3650,7 @@ void SLADEMap::getLinesById(int id, vector<MapLine*>& list)
 	if (id == 0)
 		return;
 
-	// Find lines with matching id
-	for (unsigned a = 0; a < lines_.size(); a++)
-	{
-		if (lines_[a]->line_id == id)
-			list.push_back(lines_[a]);
-	}
+	tag_index_.linesWithId(id, list);
 }
 
 /* SLADEMap::getTaggingThingsById
@@ -3437,18 +3660,33 @@ void SLADEMap::getTaggingThingsById(int id, int type, vector<MapThing*>& list, i
 {
 	using Game::TagType;
 
+	if (id == 0)
+		return;
+
+	// Get things that could reference the id (by arg or, for path
+	// things, by their own id)
+	vector<MapObject*> refs;
+	tag_index_.argReferences(id, refs);
+	vector<MapThing*> things;
+	for (unsigned a = 0; a < refs.size(); a++)
+		if (refs[a]->getObjType() == MOBJ_THING)
+			things.push_back((MapThing*)refs[a]);
+	tag_index_.thingsWithId(id, things);
+	std::sort(things.begin(), things.end(), [](MapThing* left, MapThing* right) { return left->index < right->index; });
+	things.erase(std::unique(things.begin(), things.end()), things.end());
+
 	// Find things with special affecting matching id
 	int tag, arg2, arg3, arg4, arg5, tid;
-	for (unsigned a = 0; a < things_.size(); a++)
+	for (unsigned a = 0; a < things.size(); a++)
 	{
-		auto& tt = Game::configuration().thingType(things_[a]->getType());
+		auto& tt = Game::configuration().thingType(things[a]->getType());
 		auto needs_tag = tt.needsTag();
 		if (needs_tag != TagType::None ||
-			(things_[a]->intProperty("special") && !(tt.flags() & Game::ThingType::FLAG_SCRIPT)))
+			(things[a]->intProperty("special") && !(tt.flags() & Game::ThingType::FLAG_SCRIPT)))
 		{
 			if (needs_tag == TagType::None)
-				needs_tag = Game::configuration().actionSpecial(things_[a]->intProperty("special")).needsTag();
-			tag = things_[a]->intProperty("arg0");
+				needs_tag = Game::configuration().actionSpecial(things[a]->intProperty("special")).needsTag();
+			tag = things[a]->intProperty("arg0");
 			bool fits = false;
 			int path_type;
 			switch (needs_tag)
@@ -3467,65 +3705,65 @@ void SLADEMap::getTaggingThingsById(int id, int type, vector<MapThing*>& list, i
 				fits = (IDEQ(tag) && type == THINGS);
 				break;
 			case TagType::Thing1Sector2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == THINGS ? IDEQ(tag) : (IDEQ(arg2) && type == SECTORS));
 				break;
 			case TagType::Thing1Sector3:
-				arg3 = things_[a]->intProperty("arg2");
+				arg3 = things[a]->intProperty("arg2");
 				fits = (type == THINGS ? IDEQ(tag) : (IDEQ(arg3) && type == SECTORS));
 				break;
 			case TagType::Thing1Thing2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg2)));
 				break;
 			case TagType::Thing1Thing4:
-				arg4 = things_[a]->intProperty("arg3");
+				arg4 = things[a]->intProperty("arg3");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg4)));
 				break;
 			case TagType::Thing1Thing2Thing3:
-				arg2 = things_[a]->intProperty("arg1");
-				arg3 = things_[a]->intProperty("arg2");
+				arg2 = things[a]->intProperty("arg1");
+				arg3 = things[a]->intProperty("arg2");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg2) || IDEQ(arg3)));
 				break;
 			case TagType::Sector1Thing2Thing3Thing5:
-				arg2 = things_[a]->intProperty("arg1");
-				arg3 = things_[a]->intProperty("arg2");
-				arg5 = things_[a]->intProperty("arg4");
+				arg2 = things[a]->intProperty("arg1");
+				arg3 = things[a]->intProperty("arg2");
+				arg5 = things[a]->intProperty("arg4");
 				fits = (type == SECTORS ? (IDEQ(tag)) : (type == THINGS &&
 						(IDEQ(arg2) || IDEQ(arg3) || IDEQ(arg5))));
 				break;
 			case TagType::LineId1Line2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == LINEDEFS && IDEQ(arg2));
 				break;
 			case TagType::Thing4:
-				arg4 = things_[a]->intProperty("arg3");
+				arg4 = things[a]->intProperty("arg3");
 				fits = (type == THINGS && IDEQ(arg4));
 				break;
 			case TagType::Thing5:
-				arg5 = things_[a]->intProperty("arg4");
+				arg5 = things[a]->intProperty("arg4");
 				fits = (type == THINGS && IDEQ(arg5));
 				break;
 			case TagType::Line1Sector2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == LINEDEFS ? (IDEQ(tag)) : (IDEQ(arg2) && type == SECTORS));
 				break;
 			case TagType::Sector1Sector2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == SECTORS && (IDEQ(tag) || IDEQ(arg2)));
 				break;
 			case TagType::Sector1Sector2Sector3Sector4:
-				arg2 = things_[a]->intProperty("arg1");
-				arg3 = things_[a]->intProperty("arg2");
-				arg4 = things_[a]->intProperty("arg3");
+				arg2 = things[a]->intProperty("arg1");
+				arg3 = things[a]->intProperty("arg2");
+				arg4 = things[a]->intProperty("arg3");
 				fits = (type == SECTORS && (IDEQ(tag) || IDEQ(arg2) || IDEQ(arg3) || IDEQ(arg4)));
 				break;
 			case TagType::Sector2Is3Line:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (IDEQ(tag) && (arg2 == 3 ? type == LINEDEFS : type == SECTORS));
 				break;
 			case TagType::Sector1Thing2:
-				arg2 = things_[a]->intProperty("arg1");
+				arg2 = things[a]->intProperty("arg1");
 				fits = (type == SECTORS ? (IDEQ(tag)) : (IDEQ(arg2) && type == THINGS));
 				break;
 			case TagType::Patrol:
@@ -3533,12 +3771,12 @@ void SLADEMap::getTaggingThingsById(int id, int type, vector<MapThing*>& list, i
 			case TagType::Interpolation:
 				path_type = 9075;
 
-				tid = things_[a]->intProperty("id");
-				auto& tt = Game::configuration().thingType(things_[a]->getType());
+				tid = things[a]->intProperty("id");
+				auto& tt = Game::configuration().thingType(things[a]->getType());
 				fits = ((path_type == ttype) && (IDEQ(tid)) && (tt.needsTag() == needs_tag));
 				break;
 			}
-			if (fits) list.push_back(things_[a]);
+			if (fits) list.push_back(things[a]);
 		}
 	}
 }
@@ -3550,16 +3788,27 @@ void SLADEMap::getTaggingLinesById(int id, int type, vector<MapLine*>& list)
 {
 	using Game::TagType;
 
+	if (id == 0)
+		return;
+
+	// Get lines that could reference the id
+	vector<MapObject*> refs;
+	tag_index_.argReferences(id, refs);
+	vector<MapLine*> lines;
+	for (unsigned a = 0; a < refs.size(); a++)
+		if (refs[a]->getObjType() == MOBJ_LINE)
+			lines.push_back((MapLine*)refs[a]);
+
 	// Find lines with special affecting matching id
 	int tag, arg2, arg3, arg4, arg5;
-	for (unsigned a = 0; a < lines_.size(); a++)
+	for (unsigned a = 0; a < lines.size(); a++)
 	{
-		int special = lines_[a]->special;
+		int special = lines[a]->special;
 		if (special)
 		{
-			tag = lines_[a]->intProperty("arg0");
+			tag = lines[a]->intProperty("arg0");
 			bool fits = false;
-			switch (Game::configuration().actionSpecial(lines_[a]->special).needsTag())
+			switch (Game::configuration().actionSpecial(lines[a]->special).needsTag())
 			{
 			case TagType::Sector:
 			case TagType::SectorOrBack:
@@ -3575,71 +3824,71 @@ void SLADEMap::getTaggingLinesById(int id, int type, vector<MapLine*>& list)
 				fits = (IDEQ(tag) && type == THINGS);
 				break;
 			case TagType::Thing1Sector2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == THINGS ? IDEQ(tag) : (IDEQ(arg2) && type == SECTORS));
 				break;
 			case TagType::Thing1Sector3:
-				arg3 = lines_[a]->intProperty("arg2");
+				arg3 = lines[a]->intProperty("arg2");
 				fits = (type == THINGS ? IDEQ(tag) : (IDEQ(arg3) && type == SECTORS));
 				break;
 			case TagType::Thing1Thing2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg2)));
 				break;
 			case TagType::Thing1Thing4:
-				arg4 = lines_[a]->intProperty("arg3");
+				arg4 = lines[a]->intProperty("arg3");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg4)));
 				break;
 			case TagType::Thing1Thing2Thing3:
-				arg2 = lines_[a]->intProperty("arg1");
-				arg3 = lines_[a]->intProperty("arg2");
+				arg2 = lines[a]->intProperty("arg1");
+				arg3 = lines[a]->intProperty("arg2");
 				fits = (type == THINGS && (IDEQ(tag) || IDEQ(arg2) || IDEQ(arg3)));
 				break;
 			case TagType::Sector1Thing2Thing3Thing5:
-				arg2 = lines_[a]->intProperty("arg1");
-				arg3 = lines_[a]->intProperty("arg2");
-				arg5 = lines_[a]->intProperty("arg4");
+				arg2 = lines[a]->intProperty("arg1");
+				arg3 = lines[a]->intProperty("arg2");
+				arg5 = lines[a]->intProperty("arg4");
 				fits = (type == SECTORS ? (IDEQ(tag)) : (type == THINGS &&
 						(IDEQ(arg2) || IDEQ(arg3) || IDEQ(arg5))));
 				break;
 			case TagType::LineId1Line2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == LINEDEFS && IDEQ(arg2));
 				break;
 			case TagType::Thing4:
-				arg4 = lines_[a]->intProperty("arg3");
+				arg4 = lines[a]->intProperty("arg3");
 				fits = (type == THINGS && IDEQ(arg4));
 				break;
 			case TagType::Thing5:
-				arg5 = lines_[a]->intProperty("arg4");
+				arg5 = lines[a]->intProperty("arg4");
 				fits = (type == THINGS && IDEQ(arg5));
 				break;
 			case TagType::Line1Sector2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == LINEDEFS ? (IDEQ(tag)) : (IDEQ(arg2) && type == SECTORS));
 				break;
 			case TagType::Sector1Sector2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == SECTORS && (IDEQ(tag) || IDEQ(arg2)));
 				break;
 			case TagType::Sector1Sector2Sector3Sector4:
-				arg2 = lines_[a]->intProperty("arg1");
-				arg3 = lines_[a]->intProperty("arg2");
-				arg4 = lines_[a]->intProperty("arg3");
+				arg2 = lines[a]->intProperty("arg1");
+				arg3 = lines[a]->intProperty("arg2");
+				arg4 = lines[a]->intProperty("arg3");
 				fits = (type == SECTORS && (IDEQ(tag) || IDEQ(arg2) || IDEQ(arg3) || IDEQ(arg4)));
 				break;
 			case TagType::Sector2Is3Line:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (IDEQ(tag) && (arg2 == 3 ? type == LINEDEFS : type == SECTORS));
 				break;
 			case TagType::Sector1Thing2:
-				arg2 = lines_[a]->intProperty("arg1");
+				arg2 = lines[a]->intProperty("arg1");
 				fits = (type == SECTORS ? (IDEQ(tag)) : (IDEQ(arg2) && type == THINGS));
 				break;
 			default:
 				break;
 			}
-			if (fits) list.push_back(lines_[a]);
+			if (fits) list.push_back(lines[a]);
 		}
 	}
 }
@@ -3650,14 +3899,8 @@ void SLADEMap::getTaggingLinesById(int id, int type, vector<MapLine*>& list)
 int SLADEMap::findUnusedSectorTag()
 {
 	int tag = 1;
-	for (unsigned a = 0; a < sectors_.size(); a++)
-	{
-		if (sectors_[a]->tag == tag)
-		{
-			tag++;
-			a = 0;
-		}
-	}
+	while (tag_index_.sectorTagUsed(tag))
+		tag++;
 
 	return tag;
 }
@@ -3668,14 +3911,8 @@ int SLADEMap::findUnusedSectorTag()
 int SLADEMap::findUnusedThingId()
 {
 	int tag = 1;
-	for (unsigned a = 0; a < things_.size(); a++)
-	{
-		if (things_[a]->intProperty("id") == tag)
-		{
-			tag++;
-			a = 0;
-		}
-	}
+	while (tag_index_.thingIdUsed(tag))
+		tag++;
 
 	return tag;
 }
@@ -3690,14 +3927,8 @@ int SLADEMap::findUnusedLineId()
 	// UDMF (id property)
 	if (current_format_ == MAP_UDMF)
 	{
-		for (unsigned a = 0; a < lines_.size(); a++)
-		{
-			if (lines_[a]->line_id == tag)
-			{
-				tag++;
-				a = 0;
-			}
-		}
+		while (tag_index_.lineIdUsed(tag))
+			tag++;
 	}
 
 	// Hexen (special 121 arg0)
@@ -4229,10 +4460,10 @@ MapSide* SLADEMap::createSide(MapSector* sector)
 
 	// Setup initial values
 	side->index = sides_.size();
-	side->tex_middle = "-";
-	side->tex_upper = "-";
-	side->tex_lower = "-";
-	usage_tex_["-"] += 3;
+	side->tex_middle = MapTextureNames::intern("-");
+	side->tex_upper = MapTextureNames::intern("-");
+	side->tex_lower = MapTextureNames::intern("-");
+	updateTexUsage(side->tex_middle, 3);
 
 	// Add to sides
 	sides_.push_back(side);
@@ -4387,9 +4618,9 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 		sides_.push_back(s1);
 
 		// Update texture counts
-		usage_tex_[s1->tex_upper.Upper()] += 1;
-		usage_tex_[s1->tex_middle.Upper()] += 1;
-		usage_tex_[s1->tex_lower.Upper()] += 1;
+		updateTexUsage(s1->tex_upper, 1);
+		updateTexUsage(s1->tex_middle, 1);
+		updateTexUsage(s1->tex_lower, 1);
 	}
 	if (l->side2)
 	{
@@ -4408,9 +4639,9 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 		sides_.push_back(s2);
 
 		// Update texture counts
-		usage_tex_[s2->tex_upper.Upper()] += 1;
-		usage_tex_[s2->tex_middle.Upper()] += 1;
-		usage_tex_[s2->tex_lower.Upper()] += 1;
+		updateTexUsage(s2->tex_upper, 1);
+		updateTexUsage(s2->tex_middle, 1);
+		updateTexUsage(s2->tex_lower, 1);
 	}
 
 	// Create and add new line
@@ -5393,6 +5624,7 @@ void SLADEMap::rebuildConnectedSides()
 		if (sides_[a]->sector)
 			sides_[a]->sector->connected_sides.push_back(sides_[a]);
 	}
+	geometry_.invalidate();
 }
 
 /* SLADEMap::updateTexUsage
@@ -5400,7 +5632,19 @@ void SLADEMap::rebuildConnectedSides()
  *******************************************************************/
 void SLADEMap::updateTexUsage(string tex, int adjust)
 {
-	usage_tex_[tex.Upper()] += adjust;
+	updateTexUsage(MapTextureNames::intern(tex), adjust);
+}
+
+/* SLADEMap::updateTexUsage
+ * Adjusts the usage count for the texture with name handle [tex] by
+ * [adjust]
+ *******************************************************************/
+void SLADEMap::updateTexUsage(MapTextureNames::Handle tex, int adjust)
+{
+	tex = MapTextureNames::upper(tex);
+	if (tex >= usage_tex_.size())
+		usage_tex_.resize(MapTextureNames::count(), 0);
+	usage_tex_[tex] += adjust;
 }
 
 /* SLADEMap::updateFlatUsage
@@ -5408,7 +5652,19 @@ void SLADEMap::updateTexUsage(string tex, int adjust)
  *******************************************************************/
 void SLADEMap::updateFlatUsage(string flat, int adjust)
 {
-	usage_flat_[flat.Upper()] += adjust;
+	updateFlatUsage(MapTextureNames::intern(flat), adjust);
+}
+
+/* SLADEMap::updateFlatUsage
+ * Adjusts the usage count for the flat with name handle [flat] by
+ * [adjust]
+ *******************************************************************/
+void SLADEMap::updateFlatUsage(MapTextureNames::Handle flat, int adjust)
+{
+	flat = MapTextureNames::upper(flat);
+	if (flat >= usage_flat_.size())
+		usage_flat_.resize(MapTextureNames::count(), 0);
+	usage_flat_[flat] += adjust;
 }
 
 /* SLADEMap::updateThingTypeUsage
@@ -5424,7 +5680,22 @@ void SLADEMap::updateThingTypeUsage(int type, int adjust)
  *******************************************************************/
 int SLADEMap::texUsageCount(string tex)
 {
-	return usage_tex_[tex.Upper()];
+	// A name that was never interned can't be used by anything (and looking
+	// it up shouldn't add it to the table)
+	auto handle = MapTextureNames::find(tex.Upper());
+	if (!handle && !tex.IsEmpty())
+		return 0;
+
+	return texUsageCount(handle);
+}
+
+/* SLADEMap::texUsageCount
+ * Returns the usage count for the texture with name handle [tex]
+ *******************************************************************/
+int SLADEMap::texUsageCount(MapTextureNames::Handle tex)
+{
+	tex = MapTextureNames::upper(tex);
+	return tex < usage_tex_.size() ? usage_tex_[tex] : 0;
 }
 
 /* SLADEMap::flatUsageCount
@@ -5432,7 +5703,21 @@ int SLADEMap::texUsageCount(string tex)
  *******************************************************************/
 int SLADEMap::flatUsageCount(string tex)
 {
-	return usage_flat_[tex.Upper()];
+	// See texUsageCount
+	auto handle = MapTextureNames::find(tex.Upper());
+	if (!handle && !tex.IsEmpty())
+		return 0;
+
+	return flatUsageCount(handle);
+}
+
+/* SLADEMap::flatUsageCount
+ * Returns the usage count for the flat with name handle [tex]
+ *******************************************************************/
+int SLADEMap::flatUsageCount(MapTextureNames::Handle tex)
+{
+	tex = MapTextureNames::upper(tex);
+	return tex < usage_flat_.size() ? usage_flat_[tex] : 0;
 }
 
 /* SLADEMap::thingTypeUsageCount
@@ -5442,3 +5727,279 @@ int SLADEMap::thingTypeUsageCount(int type)
 {
 	return usage_thing_type_[type];
 }
+
+/* SLADEMap::benchmarkGeometry
+ * Logs timings for creating a synthetic map of about [size] objects,
+ * whole-map passes over it (comparing the object pointer loops used
+ * before geometry was kept in contiguous arrays with the current
+ * functions) and clearing it
+ *******************************************************************/
+void SLADEMap::benchmarkGeometry(unsigned size)
+{
+	// Each grid cell is a separate square sector (4 vertices, 4 lines,
+	// 4 sides and a sector)
+	unsigned grid = MAX(1, (unsigned)sqrt(size / 13.0));
+	SLADEMap map;
+
+	wxStopWatch sw;
+	auto report = [&sw](const char* test, unsigned calls)
+	{
+		double us = sw.TimeInMicro().ToDouble() / calls;
+		Log::console(S_FMT("%-42s %10.1fus/call", test, us));
+	};
+
+	// Create map
+	sw.Start();
+	for (unsigned y = 0; y < grid; y++)
+	{
+		for (unsigned x = 0; x < grid; x++)
+		{
+			double left = x * 80;
+			double top = y * 80;
+			MapVertex* verts[4] =
+			{
+				new MapVertex(left, top, &map),
+				new MapVertex(left + 64, top, &map),
+				new MapVertex(left + 64, top + 64, &map),
+				new MapVertex(left, top + 64, &map)
+			};
+			MapSector* sector = new MapSector(&map);
+			map.sectors_.push_back(sector);
+			for (unsigned a = 0; a < 4; a++)
+			{
+				map.vertices_.push_back(verts[a]);
+
+				MapSide* side = new MapSide(sector, &map);
+				map.sides_.push_back(side);
+				map.lines_.push_back(new MapLine(verts[a], verts[(a + 1) % 4], side, nullptr, &map));
+			}
+		}
+	}
+	map.refreshIndices();
+	for (auto sector : map.sectors_)
+		sector->updateBBox();
+	report("create map", 1);
+	Log::console(S_FMT(
+		"%d vertices, %d lines, %d sides, %d sectors (%s allocated)",
+		(int)map.vertices_.size(),
+		(int)map.lines_.size(),
+		(int)map.sides_.size(),
+		(int)map.sectors_.size(),
+		Misc::sizeAsString(MapObjectArena::allocatedSize())
+	));
+
+	// Query points spread over the map
+	vector<fpoint2_t> points;
+	unsigned seed = 1;
+	for (unsigned a = 0; a < 100; a++)
+	{
+		seed = seed * 1103515245 + 12345;
+		double x = (seed >> 8) % (grid * 80);
+		seed = seed * 1103515245 + 12345;
+		double y = (seed >> 8) % (grid * 80);
+		points.push_back(fpoint2_t(x, y));
+	}
+	double result = 0;
+
+	// Initial geometry arrays build
+	sw.Start();
+	map.geometry();
+	report("build geometry arrays", 1);
+
+	// Nearest vertex: vertex pointers (old) vs. positions array
+	auto old_nearest_vertex = [&](fpoint2_t point)
+	{
+		double min_dist = 999999999;
+		int index = -1;
+		for (unsigned a = 0; a < map.vertices_.size(); a++)
+		{
+			double dist = point.taxicab_distance_to(map.vertices_[a]->point());
+			if (dist < min_dist)
+			{
+				index = a;
+				min_dist = dist;
+			}
+		}
+		return index;
+	};
+	sw.Start();
+	for (auto& point : points)
+		result += old_nearest_vertex(point);
+	report("nearest vertex (objects, old)", points.size());
+	sw.Start();
+	for (auto& point : points)
+		result += map.nearestVertex(point, 999999);
+	report("nearest vertex", points.size());
+
+	// Nearest line: line pointers (old) vs. segments array
+	auto old_nearest_line = [&](fpoint2_t point, double mindist)
+	{
+		double min_dist = mindist;
+		int index = -1;
+		for (unsigned a = 0; a < map.lines_.size(); a++)
+		{
+			MapLine* l = map.lines_[a];
+			fseg2_t bbox = l->seg();
+			bbox.expand(mindist, mindist);
+			if (!bbox.contains(point))
+				continue;
+
+			double dist = l->distanceTo(point);
+			if (dist < min_dist)
+			{
+				index = a;
+				min_dist = dist;
+			}
+		}
+		return index;
+	};
+	sw.Start();
+	for (auto& point : points)
+		result += old_nearest_line(point, 64);
+	report("nearest line (objects, old)", points.size());
+	sw.Start();
+	for (auto& point : points)
+		result += map.nearestLine(point, 64);
+	report("nearest line", points.size());
+
+	// Map bounding box: sector bboxes (old) vs. bboxes array
+	sw.Start();
+	for (unsigned a = 0; a < 10; a++)
+	{
+		bbox_t bbox = map.sectors_[0]->boundingBox();
+		for (auto sector : map.sectors_)
+		{
+			bbox_t sbb = sector->boundingBox();
+			bbox.extend(sbb.min.x, sbb.min.y);
+			bbox.extend(sbb.max.x, sbb.max.y);
+		}
+		result += bbox.width();
+	}
+	report("map bbox (objects, old)", 10);
+	sw.Start();
+	for (unsigned a = 0; a < 10; a++)
+		result += map.getMapBBox().width();
+	report("map bbox", 10);
+
+	// Incremental update after moving a vertex
+	sw.Start();
+	for (unsigned a = 0; a < points.size(); a++)
+	{
+		map.moveVertex(a, map.vertices_[a]->xPos() + 1, map.vertices_[a]->yPos());
+		result += map.nearestVertex(points[a], 999999);
+	}
+	report("move vertex + nearest vertex", points.size());
+
+	// Clear map
+	sw.Start();
+	map.clearMap();
+	report("clear map", 1);
+
+	Log::debug(2, S_FMT("benchmarkGeometry: checksum %1.0f", result));
+}
+
+/* SLADEMap::benchmarkCorrectSectors
+ * Logs timings for drawing [lines] separate lines into a single
+ * large sector (a room of about [size] objects, full of square
+ * pillars) and correcting sectors after each
+ *******************************************************************/
+void SLADEMap::benchmarkCorrectSectors(unsigned size, unsigned lines)
+{
+	// Each pillar is 4 vertices, 4 lines and 4 sides
+	unsigned grid = MAX(1, (unsigned)sqrt(size / 12.0));
+	double room = grid * 80;
+	SLADEMap map;
+
+	wxStopWatch sw;
+	auto report = [&sw](const char* test, unsigned calls)
+	{
+		double us = sw.TimeInMicro().ToDouble() / calls;
+		Log::console(S_FMT("%-42s %10.1fus/call", test, us));
+	};
+
+	// Adds a closed loop of lines through [points] with front sides in [sector]
+	auto add_loop = [&map](const fpoint2_t* points, MapSector* sector)
+	{
+		MapVertex* verts[4];
+		for (unsigned a = 0; a < 4; a++)
+		{
+			verts[a] = new MapVertex(points[a].x, points[a].y, &map);
+			map.vertices_.push_back(verts[a]);
+		}
+		for (unsigned a = 0; a < 4; a++)
+		{
+			MapSide* side = new MapSide(sector, &map);
+			map.sides_.push_back(side);
+			map.lines_.push_back(new MapLine(verts[a], verts[(a + 1) % 4], side, nullptr, &map));
+		}
+	};
+
+	// Create room (clockwise, facing in) and pillars (anticlockwise, facing out)
+	sw.Start();
+	MapSector* sector = new MapSector(&map);
+	map.sectors_.push_back(sector);
+	fpoint2_t walls[4] = { { -16, -16 }, { -16, room }, { room, room }, { room, -16 } };
+	add_loop(walls, sector);
+	for (unsigned y = 0; y < grid; y++)
+	{
+		for (unsigned x = 0; x < grid; x++)
+		{
+			double left = x * 80;
+			double top = y * 80;
+			fpoint2_t pillar[4] =
+			{
+				{ left, top },
+				{ left + 64, top },
+				{ left + 64, top + 64 },
+				{ left, top + 64 }
+			};
+			add_loop(pillar, sector);
+		}
+	}
+	map.refreshIndices();
+	sector->updateBBox();
+	report("create map", 1);
+	Log::console(S_FMT(
+		"%d vertices, %d lines, %d sides, 1 sector",
+		(int)map.vertices_.size(),
+		(int)map.lines_.size(),
+		(int)map.sides_.size()
+	));
+
+	// Trace the sector once from a wall, as a baseline
+	map.geometry();
+	sw.Start();
+	SectorBuilder builder;
+	bool ok = builder.traceSector(&map, map.lines_[0], true);
+	report("trace sector", 1);
+	Log::console(S_FMT("%s, %d edges", ok ? "Traced" : "Trace failed", (int)builder.nEdges()));
+
+	// Draw lines in the gaps between pillars spread over the room,
+	// correcting sectors after each like line drawing does
+	unsigned step = MAX(1, grid * grid / MAX(1, lines));
+	double draw_time = 0;
+	double correct_time = 0;
+	for (unsigned a = 0; a < lines; a++)
+	{
+		unsigned cell = (a * step) % (grid * grid);
+		double x = (cell % grid) * 80 + 68;
+		double y = (cell / grid) * 80 + 16 + (a / (grid * grid)) % 48;
+
+		sw.Start();
+		unsigned nl_start = map.nLines();
+		map.createLine(x, y, x + 8, y, 1);
+		draw_time += sw.TimeInMicro().ToDouble();
+
+		sw.Start();
+		vector<MapLine*> new_lines;
+		for (unsigned l = nl_start; l < map.nLines(); l++)
+			new_lines.push_back(map.lines_[l]);
+		map.correctSectors(new_lines);
+		correct_time += sw.TimeInMicro().ToDouble();
+	}
+	Log::console(S_FMT("%-42s %10.1fus/call", "draw line", draw_time / lines));
+	Log::console(S_FMT("%-42s %10.1fus/call", "correct sectors", correct_time / lines));
+	Log::console(S_FMT("%d sectors after drawing", (int)map.sectors_.size()));
+
+	map.clearMap();
+}
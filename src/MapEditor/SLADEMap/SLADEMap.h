@@ -7,6 +7,8 @@
 #include "MapSector.h"
 #include "MapVertex.h"
 #include "MapThing.h"
+#include "MapTagIndex.h"
+#include "MapGeometry.h"
 #include "Archive/Archive.h"
 #include "Utility/PropertyList/PropertyList.h"
 #include "MapEditor/MapSpecials.h"
@@ -63,6 +65,7 @@ public:
 	int			currentFormat() const { return current_format_; }
 	long		geometryUpdated() const { return geometry_updated_; }
 	long		thingsUpdated() const { return things_updated_; }
+	unsigned	changeCount() const { return change_count_; }
 	void		setGeometryUpdated();
 	void		setThingsUpdated();
 
@@ -87,12 +90,19 @@ public:
 
 	vector<ArchiveEntry*>&	udmfExtraEntries() { return udmf_extra_entries_; }
 
+	// Geometry arrays (updated if needed)
+	const MapGeometry&	geometry() { geometry_.update(); return geometry_; }
+
 	// MapObject id stuff (used for undo/redo)
 	void		addMapObject(MapObject* object);
 	void		removeMapObject(MapObject* object);
 	MapObject*	getObjectById(unsigned id) { return all_objects_[id].mobj; }
 	void		getObjectIdList(uint8_t type, vector<unsigned>& list);
 	void		restoreObjectIdList(uint8_t type, vector<unsigned>& list);
+	void		objectChanged(MapObject* object);
+	void		beginObjectJournal();
+	void		endObjectJournal();
+	bool		takeObjectJournal(uint8_t type, vector<unsigned>& list);
 
 	void	refreshIndices();
 	bool	readMap(Archive::MapDesc map);
@@ -142,6 +152,7 @@ public:
 	MapLine*			lineVectorIntersect(MapLine* line, bool front, double& hit_x, double& hit_y);
 
 	// Tags/Ids
+	MapTagIndex&	tagIndex() { return tag_index_; }
 	MapThing* getFirstThingWithId(int id);
 	void	getSectorsByTag(int tag, vector<MapSector*>& list);
 	void	getThingsById(int id, vector<MapThing*>& list, unsigned start = 0, int type = 0);
@@ -212,12 +223,20 @@ public:
 	void	clearFlatUsage() { usage_flat_.clear(); }
 	void	clearThingTypeUsage() { usage_thing_type_.clear(); }
 	void	updateTexUsage(string tex, int adjust);
+	void	updateTexUsage(MapTextureNames::Handle tex, int adjust);
 	void	updateFlatUsage(string flat, int adjust);
+	void	updateFlatUsage(MapTextureNames::Handle flat, int adjust);
 	void	updateThingTypeUsage(int type, int adjust);
 	int		texUsageCount(string tex);
+	int		texUsageCount(MapTextureNames::Handle tex);
 	int		flatUsageCount(string tex);
+	int		flatUsageCount(MapTextureNames::Handle tex);
 	int		thingTypeUsageCount(int type);
 
+	// Benchmarks
+	static void	benchmarkGeometry(unsigned size);
+	static void	benchmarkCorrectSectors(unsigned size, unsigned lines);
+
 private:
 	vector<MapLine*>	lines_;
 	vector<MapSide*>	sides_;
@@ -242,21 +261,101 @@ private:
 	vector<unsigned>		created_objects_;
 	vector<mobj_cd_t>		created_deleted_objects_;
 
+	// Object ids of each type from before the first object of that type was
+	// created or deleted while the journal is active
+	bool				obj_journal_active_;
+	bool				obj_journal_taken_[MOBJ_THING + 1];
+	vector<unsigned>	obj_journal_ids_[MOBJ_THING + 1];
+
+	void	journalObjectType(uint8_t type);
+
+	// Tag/id index
+	MapTagIndex	tag_index_;
+
+	// Geometry arrays
+	MapGeometry	geometry_;
+
 	long	geometry_updated_;	// The last time the map geometry was updated
 	long	things_updated_;	// The last time the thing list was modified
+	unsigned	change_count_	= 0;	// Incremented whenever any object is modified, created or deleted
 
 	// Usage counts
-	std::map<string, int>	usage_tex_;
-	std::map<string, int>	usage_flat_;
+	vector<int>				usage_tex_;		// Indexed by upper-case name handle
+	vector<int>				usage_flat_;	// Indexed by upper-case name handle
 	std::map<int, int>		usage_thing_type_;
 
-	// Doom format
-	bool	addVertex(doomvertex_t& v);
-	bool	addSide(doomside_t& s);
-	bool	addLine(doomline_t& l);
-	bool	addSector(doomsector_t& s);
-	bool	addThing(doomthing_t& t);
+	// Binary formats
+	struct line_refs_t
+	{
+		// Indices of the line's vertices and sides (-1 if none or invalid)
+		int	v1;
+		int	v2;
+		int	s1;
+		int	s2;
+
+		void	resolve(unsigned v1, unsigned v2, unsigned s1, unsigned s2, unsigned n_vertices, unsigned n_sides);
+	};
 
+	// Binary format records decoded to plain values. Lumps are decoded
+	// into these across worker threads, the objects are then created from
+	// them (and names interned) on the main thread
+	struct vertex_def_t
+	{
+		double	x;
+		double	y;
+	};
+	struct side_def_t
+	{
+		uint64_t				tex_key[3];	// Upper, lower, middle: 8-char lump name bytes (Doom 64: name hash)
+		MapTextureNames::Handle	tex[3];		// Interned from tex_key on the main thread
+		int						sector;		// -1 if invalid
+		short					offset_x;
+		short					offset_y;
+	};
+	struct line_def_t
+	{
+		line_refs_t	refs;
+		int			special;
+		int			flags;
+		int			args[5];	// Doom/Doom 64: only arg0 (sector tag)
+		int			macro;		// Doom 64 only, -1 if none
+		int			extraflags;	// Doom 64 only
+	};
+	struct sector_def_t
+	{
+		uint64_t				f_key;	// 8-char lump name bytes (Doom 64: name hash)
+		uint64_t				c_key;
+		MapTextureNames::Handle	f_tex;	// Interned from f_key/c_key on the main thread
+		MapTextureNames::Handle	c_tex;
+		short					f_height;
+		short					c_height;
+		short					light;
+		short					special;
+		short					tag;
+		int						flags;		// Doom 64 only
+		int						color[5];	// Doom 64 only
+	};
+	struct thing_def_t
+	{
+		short	x;
+		short	y;
+		short	z;			// Hexen/Doom 64 only
+		short	angle;
+		short	type;
+		int		flags;
+		int		tid;		// Hexen/Doom 64 only
+		int		special;	// Hexen only
+		int		args[5];	// Hexen only
+	};
+
+	MapLine*	addLine(const line_refs_t& refs);
+	bool		addVertex(const vertex_def_t& v);
+	bool		addSide(const side_def_t& s);
+	bool		addLine(const line_def_t& l, int format);
+	bool		addSector(const sector_def_t& s, int format);
+	bool		addThing(const thing_def_t& t, int format);
+
+	// Doom format
 	bool	readDoomVertexes(ArchiveEntry* entry);
 	bool	readDoomSidedefs(ArchiveEntry* entry);
 	bool	readDoomLinedefs(ArchiveEntry* entry);
@@ -270,9 +369,6 @@ private:
 	bool	writeDoomThings(ArchiveEntry* entry);
 
 	// Hexen format
-	bool	addLine(hexenline_t& l);
-	bool	addThing(hexenthing_t& t);
-
 	bool	readHexenLinedefs(ArchiveEntry* entry);
 	bool	readHexenThings(ArchiveEntry* entry);
 
@@ -280,12 +376,6 @@ private:
 	bool	writeHexenThings(ArchiveEntry* entry);
 
 	// Doom 64 format
-	bool	addVertex(doom64vertex_t& v);
-	bool	addSide(doom64side_t& s);
-	bool	addLine(doom64line_t& l);
-	bool	addSector(doom64sector_t& s);
-	bool	addThing(doom64thing_t& t);
-
 	bool	readDoom64Vertexes(ArchiveEntry* entry);
 	bool	readDoom64Sidedefs(ArchiveEntry* entry);
 	bool	readDoom64Linedefs(ArchiveEntry* entry);
@@ -37,6 +37,17 @@
 #include "OpenGL/OpenGL.h"
 
 
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Outlines with fewer edges than this are searched directly for
+	// the nearest edge, rather than through the map's line grid
+	const unsigned grid_min_edges = 32;
+}
+
+
 /*******************************************************************
  * SECTORBUILDER CLASS FUNCTIONS
  *******************************************************************/
@@ -49,6 +60,10 @@ SectorBuilder::SectorBuilder()
 	// Init variables
 	vertex_right = NULL;
 	map = NULL;
+	geometry = NULL;
+	cache_map = NULL;
+	cache_version = 0;
+	vertex_order_pos = 0;
 }
 
 /* SectorBuilder::~SectorBuilder
@@ -170,6 +185,52 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 	if (!line)
 		return false;
 
+	// Clear previous outline from the line lookup
+	for (unsigned a = 0; a < o_edges.size(); a++)
+	{
+		if (o_edges[a].line->getIndex() < o_line_edge.size())
+			o_line_edge[o_edges[a].line->getIndex()] = -1;
+	}
+
+	// Check if the outline was already traced from this edge
+	unsigned key = line->getIndex() * 2 + (front ? 0 : 1);
+	auto cached = outline_cache.find(key);
+	if (cached != outline_cache.end())
+	{
+		outline_t& outline = cached->second;
+		o_edges = outline.edges;
+		o_clockwise = outline.clockwise;
+		o_bbox = outline.bbox;
+		vertex_right = outline.vertex_right;
+		for (unsigned a = 0; a < outline.discarded.size(); a++)
+			vertex_valid[outline.discarded[a]] = false;
+	}
+	else
+	{
+		traceNewOutline(line, front, outline_cache[key]);
+	}
+
+	// Add outline edges to sector edge list and line lookup
+	for (unsigned a = 0; a < o_edges.size(); a++)
+	{
+		sector_edges.push_back(o_edges[a]);
+
+		unsigned index = o_edges[a].line->getIndex();
+		if (index < o_line_edge.size() && o_line_edge[index] < 0)
+			o_line_edge[index] = a;
+	}
+
+	// Trace complete
+	return true;
+}
+
+/* SectorBuilder::traceNewOutline
+ * Traces the sector outline from lines beginning at [line], on
+ * either the front or back side ([front]), and records it in
+ * [outline]
+ *******************************************************************/
+void SectorBuilder::traceNewOutline(MapLine* line, bool front, outline_t& outline)
+{
 	// Init outline
 	o_edges.clear();
 	o_bbox.reset();
@@ -177,6 +238,7 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 	o_edges.push_back(edge);
 	double edge_sum = 0;
 	MapLineSet visited_lines;
+	outline.discarded.clear();
 
 	// Begin tracing
 	vertex_right = edge.line->v1();
@@ -209,6 +271,8 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 		// Discard edge vertices
 		vertex_valid[edge_next.line->v1Index()] = false;
 		vertex_valid[edge_next.line->v2Index()] = false;
+		outline.discarded.push_back(edge_next.line->v1Index());
+		outline.discarded.push_back(edge_next.line->v2Index());
 
 		// Check if we're back to the start
 		if (edge_next.line == o_edges[0].line &&
@@ -229,12 +293,11 @@ bool SectorBuilder::traceOutline(MapLine* line, bool front)
 	else
 		o_clockwise = false;
 
-	// Add outline edges to sector edge list
-	for (unsigned a = 0; a < o_edges.size(); a++)
-		sector_edges.push_back(o_edges[a]);
-
-	// Trace complete
-	return true;
+	// Record outline
+	outline.edges = o_edges;
+	outline.clockwise = o_clockwise;
+	outline.bbox = o_bbox;
+	outline.vertex_right = vertex_right;
 }
 
 /* SectorBuilder::nearestEdge
@@ -248,6 +311,43 @@ int SectorBuilder::nearestEdge(double x, double y)
 	double min_dist = 99999999;
 	int nearest = -1;
 
+	// For large outlines, search the map's line grid in a growing box
+	// around the point until an edge is found within the box
+	if (geometry && o_edges.size() >= grid_min_edges)
+	{
+		auto& segs = geometry->lineSegs();
+		bbox_t bounds = geometry->gridBounds();
+		vector<int> lines;
+		for (double radius = geometry->gridCellSize(); ; radius *= 2)
+		{
+			lines.clear();
+			geometry->linesInBox(x - radius, y - radius, x + radius, y + radius, lines);
+			for (unsigned a = 0; a < lines.size(); a++)
+			{
+				// Ignore if not part of the outline
+				int edge = lines[a] < (int)o_line_edge.size() ? o_line_edge[lines[a]] : -1;
+				if (edge < 0)
+					continue;
+
+				// Check if minimum (the first edge wins a tie, as below)
+				double dist = MathStuff::distanceToLineFast(point, segs[lines[a]]);
+				if (dist < min_dist || (dist == min_dist && edge < nearest))
+				{
+					min_dist = dist;
+					nearest = edge;
+				}
+			}
+
+			// Done if the nearest edge is within the box (the 'fast'
+			// distance is squared), or the box covers the whole grid
+			if (nearest >= 0 && min_dist <= radius * radius)
+				return nearest;
+			if (x - radius <= bounds.min.x && x + radius >= bounds.max.x &&
+				y - radius <= bounds.min.y && y + radius >= bounds.max.y)
+				return nearest;
+		}
+	}
+
 	// Go through edges
 	double dist;
 	for (unsigned a = 0; a < o_edges.size(); a++)
@@ -311,6 +411,33 @@ bool SectorBuilder::pointWithinOutline(double x, double y)
  *******************************************************************/
 void SectorBuilder::discardOutsideVertices()
 {
+	auto& positions = geometry->vertexPositions();
+
+	// A point outside the bbox of an anticlockwise outline is always
+	// within it, so only vertices within the bbox need checking
+	if (!o_clockwise)
+	{
+		// Get the vertices within the bbox horizontally
+		sortVertices();
+		auto first = std::lower_bound(vertex_order.begin(), vertex_order.end(), o_bbox.max.x,
+			[&](unsigned v, double x) { return positions[v].x > x; });
+		auto last = std::lower_bound(first, vertex_order.end(), o_bbox.min.x,
+			[&](unsigned v, double x) { return positions[v].x >= x; });
+
+		for (auto v = first; v != last; ++v)
+		{
+			// Skip if already discarded or outside the bbox vertically
+			if (!vertex_valid[*v] || positions[*v].y < o_bbox.min.y || positions[*v].y > o_bbox.max.y)
+				continue;
+
+			// Discard if outside the current outline
+			if (!pointWithinOutline(positions[*v].x, positions[*v].y))
+				vertex_valid[*v] = false;
+		}
+
+		return;
+	}
+
 	// Go through valid vertices list
 	for (unsigned a = 0; a < vertex_valid.size(); a++)
 	{
@@ -319,7 +446,7 @@ void SectorBuilder::discardOutsideVertices()
 			continue;
 
 		// Discard if outside the current outline
-		if (!pointWithinOutline(map->getVertex(a)->xPos(), map->getVertex(a)->yPos()))
+		if (!pointWithinOutline(positions[a].x, positions[a].y))
 			vertex_valid[a] = false;
 	}
 }
@@ -342,52 +469,77 @@ SectorBuilder::edge_t SectorBuilder::findOuterEdge()
 
 	//LOG_DEBUG("Finding outer edge from vertex", vertex_right, "at", vertex_right->point());
 
-	// Fire a ray east from the vertex and find the first line it crosses
-	MapLine* line = NULL;
-	for (unsigned a = 0; a < map->nLines(); a++)
+	// Fire a ray east from the vertex and find the first line it crosses,
+	// going through the map's line grid one cell at a time
+	auto& segs = geometry->lineSegs();
+	bbox_t bounds = geometry->gridBounds();
+	double cell_size = geometry->gridCellSize();
+	double cell_x = vr_x;
+	vector<int> lines;
+	while (true)
 	{
-		line = map->getLine(a);
+		// Get lines in the cell
+		lines.clear();
+		geometry->linesInBox(cell_x, vr_y, cell_x, vr_y, lines);
 
-		// Ignore if the line is completely left of the vertex
-		if (line->x1() <= vr_x && line->x2() <= vr_x)
-			continue;
+		for (unsigned a = 0; a < lines.size(); a++)
+		{
+			const fseg2_t& seg = segs[lines[a]];
 
-		// Ignore horizontal lines
-		if (line->y1() == line->y2())
-			continue;
+			// Ignore if the line is completely left of the vertex
+			if (seg.x1() <= vr_x && seg.x2() <= vr_x)
+				continue;
 
-		// Ignore if the line doesn't intersect the y value
-		if ((line->y1() < vr_y && line->y2() < vr_y) ||
-		        (line->y1() > vr_y && line->y2() > vr_y))
-			continue;
+			// Ignore horizontal lines
+			if (seg.y1() == seg.y2())
+				continue;
 
-		// Get x intercept
-		double int_frac = (vr_y - line->y1()) / (line->y2() - line->y1());
-		double int_x = line->x1() + ((line->x2() - line->x1()) * int_frac);
-		double dist = fabs(int_x - vr_x);
+			// Ignore if the line doesn't intersect the y value
+			if ((seg.y1() < vr_y && seg.y2() < vr_y) ||
+			        (seg.y1() > vr_y && seg.y2() > vr_y))
+				continue;
 
-		// Check if closest
-		if (!nearest || dist < min_dist)
-		{
-			min_dist = dist;
-			nearest = line;
-		}
-		else if (fabs(dist - min_dist) < 0.001)
-		{
-			// In the case of a tie, use the distance to each line as a
-			// tiebreaker -- this fixes cases where the ray hits a vertex
-			// shared by two lines.  Choosing the further line would mean
-			// choosing an inner edge, which is clearly wrong.
-			double line_dist = MathStuff::distanceToLineFast(
-				vertex_right->point(), line->seg());
-			double nearest_dist = MathStuff::distanceToLineFast(
-				vertex_right->point(), nearest->seg());
-			if (line_dist < nearest_dist)
+			// Get x intercept
+			double int_frac = (vr_y - seg.y1()) / (seg.y2() - seg.y1());
+			double int_x = seg.x1() + ((seg.x2() - seg.x1()) * int_frac);
+			double dist = fabs(int_x - vr_x);
+
+			// Check if closest
+			MapLine* line = map->getLine(lines[a]);
+			if (!nearest || dist < min_dist)
 			{
 				min_dist = dist;
 				nearest = line;
 			}
+			else if (line != nearest && fabs(dist - min_dist) < 0.001)
+			{
+				// In the case of a tie, use the distance to each line as a
+				// tiebreaker -- this fixes cases where the ray hits a vertex
+				// shared by two lines.  Choosing the further line would mean
+				// choosing an inner edge, which is clearly wrong.
+				double line_dist = MathStuff::distanceToLineFast(
+					vertex_right->point(), seg);
+				double nearest_dist = MathStuff::distanceToLineFast(
+					vertex_right->point(), nearest->seg());
+				if (line_dist < nearest_dist)
+				{
+					min_dist = dist;
+					nearest = line;
+				}
+			}
 		}
+
+		// Get the right edge of the cell, done if there are no more cells
+		// or any line further right can't be closer than the nearest
+		if (cell_size <= 0)
+			break;
+		int column = (int)floor((cell_x - bounds.min.x) / cell_size);
+		double cell_right = bounds.min.x + (MAX(column, 0) + 1) * cell_size;
+		if (cell_right >= bounds.max.x)
+			break;
+		if (nearest && vr_x + min_dist + 0.001 < cell_right)
+			break;
+		cell_x = cell_right;
 	}
 
 	// Check for valid line
@@ -410,25 +562,14 @@ SectorBuilder::edge_t SectorBuilder::findOuterEdge()
  *******************************************************************/
 SectorBuilder::edge_t SectorBuilder::findInnerEdge()
 {
-	// Find rightmost non-discarded vertex
+	// Find rightmost non-discarded vertex (vertices are only ever
+	// discarded while tracing, so skipped ones never need checking again)
+	sortVertices();
 	vertex_right = NULL;
-	for (unsigned a = 0; a < vertex_valid.size(); a++)
-	{
-		// Ignore if discarded
-		if (!vertex_valid[a])
-			continue;
-
-		// Set rightmost if no current rightmost vertex
-		if (!vertex_right)
-		{
-			vertex_right = map->getVertex(a);
-			continue;
-		}
-
-		// Check if the vertex is rightmost
-		if (map->getVertex(a)->xPos() > vertex_right->xPos())
-			vertex_right = map->getVertex(a);
-	}
+	while (vertex_order_pos < vertex_order.size() && !vertex_valid[vertex_order[vertex_order_pos]])
+		vertex_order_pos++;
+	if (vertex_order_pos < vertex_order.size())
+		vertex_right = map->getVertex(vertex_order[vertex_order_pos]);
 
 	// If no vertex was found, we're done
 	if (!vertex_right)
@@ -604,13 +745,16 @@ bool SectorBuilder::traceSector(SLADEMap* map, MapLine* line, bool front)
 
 	// Init
 	this->map = map;
+	geometry = &map->geometry();
+	updateCache();
 	sector_edges.clear();
+	o_edges.clear();
+	o_line_edge.assign(map->nLines(), -1);
+	vertex_order_pos = 0;
 	error = "Unknown error";
 
 	// Create valid vertices list
-	vertex_valid.clear();
-	for (unsigned a = 0; a < map->nVertices(); a++)
-		vertex_valid.push_back(true);
+	vertex_valid.assign(map->nVertices(), true);
 
 	// Find outmost outline
 	for (unsigned a = 0; a < 10000; a++)
@@ -678,6 +822,40 @@ bool SectorBuilder::traceSector(SLADEMap* map, MapLine* line, bool front)
 	return true;
 }
 
+/* SectorBuilder::updateCache
+ * Clears cached outlines and vertex order if the map or its lines
+ * have changed since they were cached
+ *******************************************************************/
+void SectorBuilder::updateCache()
+{
+	if (cache_map == map && cache_version == geometry->lineVersion())
+		return;
+
+	outline_cache.clear();
+	vertex_order.clear();
+	cache_map = map;
+	cache_version = geometry->lineVersion();
+}
+
+/* SectorBuilder::sortVertices
+ * Sorts the map's vertex indices rightmost first (ties go to the
+ * lowest index), if not already sorted since the map last changed
+ *******************************************************************/
+void SectorBuilder::sortVertices()
+{
+	if (!vertex_order.empty())
+		return;
+
+	auto& positions = geometry->vertexPositions();
+	vertex_order.resize(positions.size());
+	for (unsigned a = 0; a < positions.size(); a++)
+		vertex_order[a] = a;
+	std::stable_sort(vertex_order.begin(), vertex_order.end(), [&](unsigned a, unsigned b)
+	{
+		return positions[a].x > positions[b].x;
+	});
+}
+
 /* SectorBuilder::createSector
  * Sets all traced edges to [sector], or creates a new sector using
  * properties from [sector_copy] if none given
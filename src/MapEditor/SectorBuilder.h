@@ -10,6 +10,7 @@ class MapVertex;
 class MapSector;
 class MapSide;
 class SLADEMap;
+class MapGeometry;
 
 WX_DECLARE_HASH_MAP(MapLine*, int, wxPointerHash, wxPointerEqual, MapLineSet);
 
@@ -30,16 +31,39 @@ private:
 		}
 	};
 
-	vector<bool>	vertex_valid;
-	SLADEMap*		map;
-	vector<edge_t>	sector_edges;
-	string			error;
+	// A traced outline, cached by the edge it was traced from
+	struct outline_t
+	{
+		vector<edge_t>		edges;
+		bool				clockwise;
+		bbox_t				bbox;
+		MapVertex*			vertex_right;
+		vector<unsigned>	discarded;	// Vertices discarded while tracing
+	};
+
+	vector<bool>		vertex_valid;
+	SLADEMap*			map;
+	const MapGeometry*	geometry;
+	vector<edge_t>		sector_edges;
+	string				error;
 
 	// Current outline
 	vector<edge_t>	o_edges;
 	bool			o_clockwise;
 	bbox_t			o_bbox;
 	MapVertex*		vertex_right;
+	vector<int>		o_line_edge;	// First outline edge of each map line, -1 if none
+
+	// Cached outlines and vertex order, valid until the map's lines change
+	SLADEMap*								cache_map;
+	unsigned								cache_version;
+	std::unordered_map<unsigned, outline_t>	outline_cache;
+	vector<unsigned>						vertex_order;		// Rightmost first
+	unsigned								vertex_order_pos;
+
+	void	updateCache();
+	void	sortVertices();
+	void	traceNewOutline(MapLine* line, bool front, outline_t& outline);
 
 public:
 	SectorBuilder();
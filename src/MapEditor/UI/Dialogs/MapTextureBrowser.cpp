@@ -154,6 +154,10 @@ MapTextureBrowser::MapTextureBrowser(wxWindow* parent, int type, string texture,
 	{
 		addGlobalItem(new MapTexBrowserItem("-", 0, 0));
 
+		// Look up name filters in the composite/stand-alone texture names
+		canvas->addNameIndex(&theResourceManager->textureNames());
+		canvas->addNameIndex(&theResourceManager->saTextureNames());
+
 		vector<map_texinfo_t>& textures = MapEditor::textureManager().getAllTexturesInfo();
 		for (unsigned a = 0; a < textures.size(); a++)
 		{
@@ -166,6 +170,10 @@ MapTextureBrowser::MapTextureBrowser(wxWindow* parent, int type, string texture,
 	// Flats
 	if (type == 1 || Game::configuration().featureSupported(Game::Feature::MixTexFlats))
 	{
+		// Look up name filters in the flat names (and TEXTURES-defined flats)
+		canvas->addNameIndex(&theResourceManager->flatNames());
+		canvas->addNameIndex(&theResourceManager->textureNames());
+
 		vector<map_texinfo_t>& flats = MapEditor::textureManager().getAllFlatsInfo();
 		for (unsigned a = 0; a < flats.size(); a++)
 		{
@@ -31,6 +31,7 @@
 #include "Main.h"
 #include "App.h"
 #include "MapCanvas.h"
+#include "MapEditor/Renderer/FrameStats.h"
 #include "MapEditor/Renderer/Overlays/MCOverlay.h"
 #include "MapEditor/SectorBuilder.h"
 #include "OpenGL/Drawing.h"
@@ -39,6 +40,13 @@
 using MapEditor::Mode;
 
 
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+CVAR(Int, map_max_fps, 0, CVAR_SAVE)	// 0 = display refresh rate
+CVAR(Int, map_idle_ms, 100, CVAR_SAVE)
+
+
 /*******************************************************************
  * MAPCANVAS CLASS FUNCTIONS
  *******************************************************************/
@@ -84,7 +92,8 @@ MapCanvas::MapCanvas(wxWindow* parent, int id, MapEditContext* context) :
 	Bind(wxEVT_IDLE, &MapCanvas::onIdle, this);
 #endif
 
-	timer.Start(10, true);
+	updateFrameInterval();
+	timer.Start(frame_interval_, true);
 }
 
 /* MapCanvas::~MapCanvas
@@ -102,11 +111,91 @@ void MapCanvas::draw()
 	if (!IsEnabled())
 		return;
 
-	context_->renderer().draw();
+	{
+		MapEditor::FrameStats::Timer stats_timer(MapEditor::FrameStats::Stage::Draw);
+		context_->renderer().draw();
+	}
+
+	{
+		MapEditor::FrameStats::Timer stats_timer(MapEditor::FrameStats::Stage::Present);
+
+		SwapBuffers();
+
+		glFinish();
+	}
+
+	MapEditor::FrameStats::endFrame();
+}
+
+/* MapCanvas::requestFrame
+ * Requests a redraw as soon as the next frame is due, whether or
+ * not the editor state changed
+ *******************************************************************/
+void MapCanvas::requestFrame()
+{
+	frame_requested_ = true;
+
+	long wait = frame_interval_ - (sf_clock_.getElapsedTime().asMilliseconds() - last_time);
+	timer.Start(MAX(1, wait), true);
+}
+
+/* MapCanvas::updateFrameInterval
+ * Sets the minimum time between frames from the map_max_fps cvar,
+ * or the refresh rate of the display the canvas is on
+ *******************************************************************/
+void MapCanvas::updateFrameInterval()
+{
+	int fps = map_max_fps;
+	if (fps <= 0)
+	{
+		int display = wxDisplay::GetFromWindow(this);
+		fps = wxDisplay(display == wxNOT_FOUND ? 0 : display).GetCurrentMode().refresh;
+	}
+	if (fps <= 0)
+		fps = 60;
+
+	frame_interval_ = MAX(1, 1000 / fps);
+}
+
+/* MapCanvas::updateFrame
+ * Updates the editor state and redraws if anything changed (or a
+ * frame was requested), then schedules the next update: at the
+ * frame rate while anything is animating, otherwise only every
+ * [map_idle_ms] to check for changes made outside the canvas
+ *******************************************************************/
+void MapCanvas::updateFrame()
+{
+	// Handle 3d mode mouselook
+	if (mouseLook3d())
+		frame_requested_ = true;
+
+	// Wait if the next frame isn't due yet
+	long now = sf_clock_.getElapsedTime().asMilliseconds();
+	long frametime = now - last_time;
+	if (frametime < frame_interval_)
+	{
+		timer.Start(frame_interval_ - frametime, true);
+		return;
+	}
+
+	// Don't let animations jump ahead by however long the editor was idle
+	if (!context_->animating())
+		frametime = frame_interval_;
+
+	bool redraw;
+	{
+		MapEditor::FrameStats::Timer stats_timer(MapEditor::FrameStats::Stage::Update);
+		redraw = context_->update(frametime);
+	}
 
-	SwapBuffers();
+	if (redraw || frame_requested_)
+	{
+		frame_requested_ = false;
+		last_time = now;
+		Refresh();
+	}
 
-	glFinish();
+	timer.Start(context_->animating() ? frame_interval_ : MAX(frame_interval_, (long)map_idle_ms), true);
 }
 
 /* MapCanvas::mouseToCenter
@@ -150,9 +239,9 @@ void MapCanvas::lockMouse(bool lock)
 }
 
 /* MapCanvas::mouseLook3d
- * Handles 3d mode mouselook
+ * Handles 3d mode mouselook. Returns true if the camera was moved
  *******************************************************************/
-void MapCanvas::mouseLook3d()
+bool MapCanvas::mouseLook3d()
 {
 	// Check for 3d mode
 	if (context_->editMode() == Mode::Visual && context_->mouseLocked())
@@ -180,9 +269,12 @@ void MapCanvas::mouseLook3d()
 			{
 				context_->renderer().renderer3D().cameraLook(xrel, yrel);
 				mouseToCenter();
+				return true;
 			}
 		}
 	}
+
+	return false;
 }
 
 /* MapCanvas::onKeyBindPress
@@ -242,6 +334,10 @@ void MapCanvas::onSize(wxSizeEvent& e)
 	// Update screen limits
 	context_->renderer().setViewSize(GetSize().x, GetSize().y);
 
+	// The canvas may have moved to a different display
+	updateFrameInterval();
+	requestFrame();
+
 	e.Skip();
 }
 
@@ -253,6 +349,7 @@ void MapCanvas::onKeyDown(wxKeyEvent& e)
 	// Send to editor
 	context_->input().updateKeyModifiersWx(e.GetModifiers());
 	context_->input().keyDown(KeyBind::keyName(e.GetKeyCode()));
+	requestFrame();
 
 	// Testing
 	if (Global::debug)
@@ -340,6 +437,7 @@ void MapCanvas::onKeyUp(wxKeyEvent& e)
 	// Send to editor
 	context_->input().updateKeyModifiersWx(e.GetModifiers());
 	context_->input().keyUp(KeyBind::keyName(e.GetKeyCode()));
+	requestFrame();
 
 	e.Skip();
 }
@@ -374,6 +472,7 @@ void MapCanvas::onMouseDown(wxMouseEvent& e)
 		skip = context_->input().mouseDown(Input::MouseButton::Mouse5);
 	else if (e.Aux2DClick())
 		skip = context_->input().mouseDown(Input::MouseButton::Mouse5, true);
+	requestFrame();
 
 	if (skip)
 	{
@@ -404,6 +503,7 @@ void MapCanvas::onMouseUp(wxMouseEvent& e)
 		skip = context_->input().mouseUp(Input::MouseButton::Mouse4);
 	else if (e.Aux2Up())
 		skip = context_->input().mouseUp(Input::MouseButton::Mouse5);
+	requestFrame();
 
 	if (skip)
 		e.Skip();
@@ -423,7 +523,9 @@ void MapCanvas::onMouseMotion(wxMouseEvent& e)
 	}
 
 	// Update mouse variables
-	if (!context_->input().mouseMove(e.GetX(), e.GetY()))
+	bool skip = context_->input().mouseMove(e.GetX(), e.GetY());
+	requestFrame();
+	if (!skip)
 		return;
 
 	e.Skip();
@@ -446,6 +548,7 @@ void MapCanvas::onMouseWheel(wxMouseEvent& e)
 		return;
 
 	context_->input().mouseWheel(e.GetWheelRotation() > 0, mwheel_rotation);
+	requestFrame();
 }
 
 /* MapCanvas::onMouseLeave
@@ -454,6 +557,7 @@ void MapCanvas::onMouseWheel(wxMouseEvent& e)
 void MapCanvas::onMouseLeave(wxMouseEvent& e)
 {
 	context_->input().mouseLeave();
+	requestFrame();
 
 	e.Skip();
 }
@@ -474,17 +578,7 @@ void MapCanvas::onMouseEnter(wxMouseEvent& e)
  *******************************************************************/
 void MapCanvas::onIdle(wxIdleEvent& e)
 {
-	// Handle 3d mode mouselook
-	mouseLook3d();
-
-	// Get time since last redraw
-	long frametime = (sf_clock_.getElapsedTime().asMilliseconds()) - last_time;
-
-	if (context_->update(frametime))
-	{
-		last_time = (sf_clock_.getElapsedTime().asMilliseconds());
-		Refresh();
-	}
+	updateFrame();
 }
 
 /* MapCanvas::onRTimer
@@ -492,19 +586,7 @@ void MapCanvas::onIdle(wxIdleEvent& e)
  *******************************************************************/
 void MapCanvas::onRTimer(wxTimerEvent& e)
 {
-	// Handle 3d mode mouselook
-	mouseLook3d();
-
-	// Get time since last redraw
-	long frametime = (sf_clock_.getElapsedTime().asMilliseconds()) - last_time;
-
-	if (context_->update(frametime))
-	{
-		last_time = (sf_clock_.getElapsedTime().asMilliseconds());
-		Refresh();
-	}
-
-	timer.Start(-1, true);
+	updateFrame();
 }
 
 /* MapCanvas::onFocus
@@ -519,4 +601,6 @@ void MapCanvas::onFocus(wxFocusEvent& e)
 	}
 	else if (e.GetEventType() == wxEVT_KILL_FOCUS)
 		lockMouse(false);
+
+	requestFrame();
 }
@@ -15,20 +15,25 @@ public:
 
 	// Drawing
 	void	draw() override;
+	void	requestFrame();
 
 	// Mouse
 	void	mouseToCenter();
 	void	lockMouse(bool lock);
-	void	mouseLook3d();
+	bool	mouseLook3d();
 
 	// Keybind handling
 	void	onKeyBindPress(string name) override;
 
 private:
-	MapEditContext*	context_	= nullptr;
-	bool			mouse_warp_ = false;
-	vector<int>		fps_avg_;
+	MapEditContext*	context_			= nullptr;
+	bool			mouse_warp_			= false;
 	sf::Clock		sf_clock_;
+	bool			frame_requested_	= false;
+	long			frame_interval_		= 16;	// Minimum ms between frames
+
+	void	updateFrameInterval();
+	void	updateFrame();
 
 	// Events
 	void	onSize(wxSizeEvent& e);
@@ -44,12 +44,8 @@ bool PropertyChangeUS::doRedo()
 
 MapObjectCreateDeleteUS::MapObjectCreateDeleteUS()
 {
-	SLADEMap* map = UndoRedo::currentMap();
-	map->getObjectIdList(MOBJ_VERTEX, vertices);
-	map->getObjectIdList(MOBJ_LINE, lines);
-	map->getObjectIdList(MOBJ_SIDE, sides);
-	map->getObjectIdList(MOBJ_SECTOR, sectors);
-	map->getObjectIdList(MOBJ_THING, things);
+	// Object id lists are recorded by the map as objects are created/deleted
+	UndoRedo::currentMap()->beginObjectJournal();
 }
 
 void MapObjectCreateDeleteUS::swapLists()
@@ -112,100 +108,34 @@ bool MapObjectCreateDeleteUS::doRedo()
 void MapObjectCreateDeleteUS::checkChanges()
 {
 	SLADEMap* map = UndoRedo::currentMap();
+	map->endObjectJournal();
 
-	// Check vertices changed
-	bool vertices_changed = false;
-	if (map->nVertices() != vertices.size())
-		vertices_changed = true;
-	else
-		for (unsigned a = 0; a < map->nVertices(); a++)
-			if (map->getVertex(a)->getId() != vertices[a])
-			{
-				vertices_changed = true;
-				break;
-			}
-	if (!vertices_changed)
-	{
-		// No change, clear
-		vertices.clear();
-		vertices.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No vertices added/deleted");
-	}
-
-	// Check lines changed
-	bool lines_changed = false;
-	if (map->nLines() != lines.size())
-		lines_changed = true;
-	else
-		for (unsigned a = 0; a < map->nLines(); a++)
-			if (map->getLine(a)->getId() != lines[a])
-			{
-				lines_changed = true;
-				break;
-			}
-	if (!lines_changed)
-	{
-		// No change, clear
-		lines.clear();
-		lines.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No lines added/deleted");
-	}
+	checkListChanges(map, MOBJ_VERTEX, vertices, "vertices");
+	checkListChanges(map, MOBJ_LINE, lines, "lines");
+	checkListChanges(map, MOBJ_SIDE, sides, "sides");
+	checkListChanges(map, MOBJ_SECTOR, sectors, "sectors");
+	checkListChanges(map, MOBJ_THING, things, "things");
+}
 
-	// Check sides changed
-	bool sides_changed = false;
-	if (map->nSides() != sides.size())
-		sides_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSides(); a++)
-			if (map->getSide(a)->getId() != sides[a])
-			{
-				sides_changed = true;
-				break;
-			}
-	if (!sides_changed)
-	{
-		// No change, clear
-		sides.clear();
-		sides.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No sides added/deleted");
-	}
+void MapObjectCreateDeleteUS::checkListChanges(SLADEMap* map, uint8_t type, vector<unsigned>& list, const char* name)
+{
+	// Get the ids from before any objects of [type] were added/deleted
+	bool changed = map->takeObjectJournal(type, list);
 
-	// Check sectors changed
-	bool sectors_changed = false;
-	if (map->nSectors() != sectors.size())
-		sectors_changed = true;
-	else
-		for (unsigned a = 0; a < map->nSectors(); a++)
-			if (map->getSector(a)->getId() != sectors[a])
-			{
-				sectors_changed = true;
-				break;
-			}
-	if (!sectors_changed)
+	// Check the objects actually changed (eg. not added then deleted again)
+	if (changed)
 	{
-		// No change, clear
-		sectors.clear();
-		sectors.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No sectors added/deleted");
+		vector<unsigned> current;
+		map->getObjectIdList(type, current);
+		changed = (current != list);
 	}
 
-	// Check things changed
-	bool things_changed = false;
-	if (map->nThings() != things.size())
-		things_changed = true;
-	else
-		for (unsigned a = 0; a < map->nThings(); a++)
-			if (map->getThing(a)->getId() != things[a])
-			{
-				things_changed = true;
-				break;
-			}
-	if (!things_changed)
+	if (!changed)
 	{
 		// No change, clear
-		things.clear();
-		things.push_back(0);
-		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No things added/deleted");
+		list.clear();
+		list.push_back(0);
+		LOG_MESSAGE(3, "MapObjectCreateDeleteUS: No %s added/deleted", name);
 	}
 }
 
@@ -226,8 +156,9 @@ bool MapObjectCreateDeleteUS::isOk()
 
 MultiMapObjectPropertyChangeUS::MultiMapObjectPropertyChangeUS()
 {
-	// Get backups of recently modified map objects
-	vector<MapObject*> objects = UndoRedo::currentMap()->getAllModifiedObjects(MapObject::propBackupTime());
+	// Get backups of map objects modified while recording
+	vector<MapObject*> objects;
+	MapObject::takePropBackupJournal(objects);
 	for (unsigned a = 0; a < objects.size(); a++)
 	{
 		mobj_backup_t* bak = objects[a]->getBackup(true);
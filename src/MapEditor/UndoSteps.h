@@ -3,6 +3,7 @@
 #include "General/UndoRedo.h"
 
 class MapObject;
+class SLADEMap;
 struct mobj_backup_t;
 
 namespace MapEditor
@@ -37,6 +38,8 @@ namespace MapEditor
 		bool isOk();
 
 	private:
+		void checkListChanges(SLADEMap* map, uint8_t type, vector<unsigned>& list, const char* name);
+
 		vector<unsigned>	vertices;
 		vector<unsigned>	lines;
 		vector<unsigned>	sides;
@@ -64,7 +64,8 @@ Lexer::Lexer() :
 	re_int3_{ "^0x[0-9A-Fa-f]+$", wxRE_DEFAULT|wxRE_NOSUB },
 	re_float_{ "^[-+]?[0-9]*.?[0-9]+([eE][-+]?[0-9]+)?$", wxRE_DEFAULT|wxRE_NOSUB },
 	fold_comments_{ false },
-	fold_preprocessor_{ false }
+	fold_preprocessor_{ false },
+	preprocessor_char_{ 0 }
 {
 	// Default word characters
 	setWordChars("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
@@ -82,6 +83,12 @@ void Lexer::loadLanguage(TextLanguage* language)
 {
 	this->language_ = language;
 	clearWords();
+	fold_words_.clear();
+	pp_fold_words_.clear();
+	comment_begin_ = comment_end_ = comment_doc_ = comment_line_ = "";
+	block_begin_ = block_end_ = "";
+	preprocessor_.clear();
+	preprocessor_char_ = 0;
 
 	if (!language)
 		return;
@@ -98,16 +105,35 @@ void Lexer::loadLanguage(TextLanguage* language)
 	for (auto word : language->wordListSorted(TextLanguage::WordType::Keyword))
 		addWord(word, Lexer::Style::Keyword);
 
+	// Load folding words (block begin takes precedence if a word is in both)
+	for (auto& word : language->wordBlockBegin())
+		fold_words_.emplace(word.ToStdString(), 1);
+	for (auto& word : language->wordBlockEnd())
+		fold_words_.emplace(word.ToStdString(), -1);
+	for (auto& word : language->ppBlockBegin())
+		pp_fold_words_.emplace(word.ToStdString(), 1);
+	for (auto& word : language->ppBlockEnd())
+		pp_fold_words_.emplace(word.ToStdString(), -1);
+
 	// Load language info
-	preprocessor_char_ = language->preprocessor().empty() ? 0 : preprocessor_char_ = language->preprocessor()[0];
+	comment_begin_ = language->commentBegin();
+	comment_end_ = language->commentEnd();
+	comment_doc_ = language->docComment();
+	comment_line_ = language->lineComment();
+	block_begin_ = language->blockBegin();
+	block_end_ = language->blockEnd();
+	preprocessor_ = language->preprocessor().ToStdString();
+	preprocessor_char_ = preprocessor_.empty() ? 0 : (char)preprocessor_[0];
 }
 
 // ----------------------------------------------------------------------------
 // Lexer::doStyling
 //
-// Performs text styling on [editor], for characters from [start] to [end].
-// Returns true if the next line needs to be styled (eg. for multi-line
-// comments)
+// Performs text styling on [editor], for characters from [start] to [end],
+// which should be a single line. Returns true if the next line needs to be
+// (re)styled, ie. if this line's end state changed since it was last styled
+// (eg. a block comment was opened or closed), or the next line hasn't been
+// styled yet
 // ----------------------------------------------------------------------------
 bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 {
@@ -115,12 +141,13 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 		start = 0;
 
 	int line = editor->LineFromPosition(start);
+	bool commented = line > 0 && lineInfo(editor, line - 1).commented;
 	LexerState state
 	{
 		start,
 		end,
 		line,
-		lines_[line].commented ? State::Comment : State::Unknown,
+		commented ? State::Comment : State::Unknown,
 		0,
 		0,
 		false,
@@ -153,13 +180,17 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 		}
 	}
 
-	// Set current & next line's info
-	lines_[line].fold_increment = state.fold_increment;
-	lines_[line].has_word = state.has_word;
-	lines_[line+1].commented = (state.state == State::Comment);
-
-	// Return true if we are still inside a comment
-	return (state.state == State::Comment);
+	// Update cached line info
+	LineInfo prev = lineInfo(editor, line);
+	LineInfo info;
+	info.styled = true;
+	info.commented = (state.state == State::Comment);
+	info.has_word = state.has_word;
+	info.fold_increment = state.fold_increment;
+	if (info.packed() != prev.packed())
+		editor->SetLineState(line, info.packed());
+
+	return !prev.styled || prev.commented != info.commented || !lineInfo(editor, line + 1).styled;
 }
 
 // ----------------------------------------------------------------------------
@@ -169,7 +200,7 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 // ----------------------------------------------------------------------------
 void Lexer::addWord(string word, int style)
 {
-	word_list_[language_->caseSensitive() ? word : word.Lower()].style = style;
+	word_list_[wordKey(word.ToStdString())] = style;
 }
 
 // ----------------------------------------------------------------------------
@@ -178,25 +209,61 @@ void Lexer::addWord(string word, int style)
 // Applies a style to [word] in [editor], depending on if it is in the word
 // list, a number or begins with the preprocessor character
 // ----------------------------------------------------------------------------
-void Lexer::styleWord(LexerState& state, string word)
+void Lexer::styleWord(LexerState& state, const std::string& word)
 {
-	if (!language_->caseSensitive())
-		word = word.Lower();
+	char style = wordStyle(word);
 
-	if (word_list_[word].style > 0)
-		state.editor->SetStyling(word.length(), word_list_[word].style);
-	else if (word.StartsWith(language_->preprocessor()))
+	if (style > 0)
+		state.editor->SetStyling(word.length(), style);
+	else if (word.compare(0, preprocessor_.length(), preprocessor_) == 0)
 		state.editor->SetStyling(word.length(), Style::Preprocessor);
 	else
 	{
-		// Check for number
-		if (re_int2_.Matches(word) || re_int1_.Matches(word) || re_float_.Matches(word) || re_int3_.Matches(word))
+		// Check for number (can only be one if it starts with a digit, sign or .)
+		char first = word[0];
+		string word_string;
+		if ((first >= '0' && first <= '9') || first == '-' || first == '+' || first == '.')
+			word_string = wxString::FromAscii(word.c_str());
+		if (!word_string.empty() &&
+			(re_int2_.Matches(word_string) ||
+			re_int1_.Matches(word_string) ||
+			re_float_.Matches(word_string) ||
+			re_int3_.Matches(word_string)))
 			state.editor->SetStyling(word.length(), Style::Number);
 		else
 			state.editor->SetStyling(word.length(), Style::Default);
 	}
 }
 
+// ----------------------------------------------------------------------------
+// Lexer::wordKey
+//
+// Returns the word list key for [word] (lower case if the current language
+// isn't case sensitive)
+// ----------------------------------------------------------------------------
+std::string Lexer::wordKey(const std::string& word) const
+{
+	if (!language_ || language_->caseSensitive())
+		return word;
+
+	std::string lower{ word };
+	for (auto& c : lower)
+		c = tolower((unsigned char)c);
+
+	return lower;
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::wordStyle
+//
+// Returns the style defined for [word], or 0 if it isn't in the word list
+// ----------------------------------------------------------------------------
+char Lexer::wordStyle(const std::string& word) const
+{
+	auto i = word_list_.find(wordKey(word));
+	return i == word_list_.end() ? 0 : i->second;
+}
+
 // ----------------------------------------------------------------------------
 // Lexer::setWordChars
 //
@@ -232,27 +299,6 @@ bool Lexer::processUnknown(LexerState& state)
 	int u_length = 0;
 	bool end = false;
 	bool pp = false;
-	string comment_begin;
-	string comment_doc;
-	string comment_line;
-	string block_begin;
-	string block_end;
-
-	if (language_)
-	{
-		comment_begin = language_->commentBegin();
-		comment_doc = language_->docComment();
-		comment_line = language_->lineComment();
-		block_begin = language_->blockBegin();
-		block_end = language_->blockEnd();
-	}
-	else {
-		comment_begin = "";
-		comment_doc = "";
-		comment_line = "";
-		block_begin = "";
-		block_end = "";
-	}
 
 	while (true)
 	{
@@ -294,7 +340,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Start of doc line comment
-		else if (checkToken(state, state.position, comment_doc))
+		else if (checkToken(state, state.position, comment_doc_))
 		{
 			// Format as comment to end of line
 			state.editor->SetStyling(u_length, Style::Default);
@@ -303,7 +349,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Start of line comment
-		else if (checkToken(state, state.position, comment_line))
+		else if (checkToken(state, state.position, comment_line_))
 		{
 			// Format as comment to end of line
 			state.editor->SetStyling(u_length, Style::Default);
@@ -312,11 +358,11 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Start of block comment
-		else if (checkToken(state, state.position, comment_begin))
+		else if (checkToken(state, state.position, comment_begin_))
 		{
 			state.state = State::Comment;
-			state.position += comment_begin.size();
-			state.length = comment_begin.size();
+			state.position += comment_begin_.size();
+			state.length = comment_begin_.size();
 			if (fold_comments_)
 			{
 				state.fold_increment++;
@@ -335,7 +381,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Preprocessor
-		else if (c == language_->preprocessor()[0])
+		else if (c == preprocessor_char_ && preprocessor_char_)
 		{
 			pp = true;
 			u_length++;
@@ -370,11 +416,11 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Block begin
-		else if (checkToken(state, state.position, block_begin))
+		else if (checkToken(state, state.position, block_begin_))
 			state.fold_increment++;
 
 		// Block end
-		else if (checkToken(state, state.position, block_end))
+		else if (checkToken(state, state.position, block_end_))
 			state.fold_increment--;
 
 		//LOG_MESSAGE(4, "unknown char '%c' (%d)", c, c);
@@ -398,7 +444,6 @@ bool Lexer::processUnknown(LexerState& state)
 bool Lexer::processComment(LexerState& state)
 {
 	bool end = false;
-	string comment_block_end = language_ ? language_->commentEnd() : "";
 
 	while (true)
 	{
@@ -410,10 +455,10 @@ bool Lexer::processComment(LexerState& state)
 		}
 
 		// End of comment
-		if (checkToken(state, state.position, comment_block_end))
+		if (checkToken(state, state.position, comment_end_))
 		{
-			state.length += comment_block_end.size();
-			state.position += comment_block_end.size();
+			state.length += comment_end_.size();
+			state.position += comment_end_.size();
 			state.state = State::Unknown;
 			if (fold_comments_)
 				state.fold_increment--;
@@ -440,7 +485,7 @@ bool Lexer::processComment(LexerState& state)
 // ----------------------------------------------------------------------------
 bool Lexer::processWord(LexerState& state)
 {
-	vector<char> word;
+	std::string word;
 	bool end = false;
 
 	// Add first letter
@@ -468,31 +513,31 @@ bool Lexer::processWord(LexerState& state)
 		}
 	}
 
-	// Get word as string
-	string word_string = wxString::FromAscii(&word[0], word.size());
-
-	// Check for preprocessor folding word
-	if (fold_preprocessor_ && word_string.StartsWith(preprocessor_char_))
-	{
-		string word_lower = word_string.Lower().After(preprocessor_char_);
-		if (VECTOR_EXISTS(language_->ppBlockBegin(), word_lower))
-			state.fold_increment++;
-		else if (VECTOR_EXISTS(language_->ppBlockEnd(), word_lower))
-			state.fold_increment--;
-	}
-	else
+	// Check for folding word
+	if (!fold_words_.empty() || !pp_fold_words_.empty())
 	{
-		string word_lower = word_string.Lower();
-		if (VECTOR_EXISTS(language_->wordBlockBegin(), word_lower))
-			state.fold_increment++;
-		else if (VECTOR_EXISTS(language_->wordBlockEnd(), word_lower))
-			state.fold_increment--;
+		std::string word_lower{ word };
+		for (auto& c : word_lower)
+			c = tolower((unsigned char)c);
+
+		if (fold_preprocessor_ && preprocessor_char_ && word[0] == preprocessor_char_)
+		{
+			auto i = pp_fold_words_.find(word_lower.substr(1));
+			if (i != pp_fold_words_.end())
+				state.fold_increment += i->second;
+		}
+		else
+		{
+			auto i = fold_words_.find(word_lower);
+			if (i != fold_words_.end())
+				state.fold_increment += i->second;
+		}
 	}
 
 	if (debug_lexer)
-		Log::debug(S_FMT("word:%s", word_string));
+		Log::debug(S_FMT("word:%s", word));
 
-	styleWord(state, word_string);
+	styleWord(state, word);
 
 	return end;
 }
@@ -664,7 +709,7 @@ bool Lexer::processWhitespace(LexerState& state)
 //
 // Checks if the text in [editor] starting from [pos] matches [token]
 // ----------------------------------------------------------------------------
-bool Lexer::checkToken(LexerState& state, int pos, string& token)
+bool Lexer::checkToken(LexerState& state, int pos, const string& token)
 {
 	if (!token.empty())
 	{
@@ -682,39 +727,69 @@ bool Lexer::checkToken(LexerState& state, int pos, string& token)
 // ----------------------------------------------------------------------------
 // Lexer::updateFolding
 //
-// Updates code folding levels in [editor], starting from line [line_start]
+// Updates code folding levels in [editor] for lines [line_start] to
+// [line_end], continuing past [line_end] until the fold levels match what
+// was already set
 // ----------------------------------------------------------------------------
-void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
+void Lexer::updateFolding(TextEditorCtrl* editor, int line_start, int line_end)
 {
-	int fold_level = editor->GetFoldLevel(line_start) & wxSTC_FOLDLEVELNUMBERMASK;
+	auto set_level = [editor](int line, int level)
+	{
+		if (line >= 0 && editor->GetFoldLevel(line) != level)
+			editor->SetFoldLevel(line, level);
+	};
 
-	for (int l = line_start; l < editor->GetLineCount(); l++)
+	int fold_level = editor->GetFoldLevel(line_start) & wxSTC_FOLDLEVELNUMBERMASK;
+	int line_count = editor->GetLineCount();
+	for (int l = line_start; l < line_count; l++)
 	{
+		LineInfo info = lineInfo(editor, l);
+
+		// Past the updated lines, nothing further changes once a line's level
+		// is already correct (as long as it won't move a fold header up)
+		if (l > line_end &&
+			(editor->GetFoldLevel(l) & wxSTC_FOLDLEVELNUMBERMASK) == fold_level &&
+			(info.has_word || info.fold_increment <= 0))
+			break;
+
 		// Determine next line's fold level
-		int next_level = fold_level + lines_[l].fold_increment;
+		int next_level = fold_level + info.fold_increment;
 		if (next_level < wxSTC_FOLDLEVELBASE)
 			next_level = wxSTC_FOLDLEVELBASE;
 
 		// Check if we are going up a fold level
 		if (next_level > fold_level)
 		{
-			if (!lines_[l].has_word)
+			if (!info.has_word)
 			{
 				// Line doesn't have any words (eg. only has an opening brace),
 				// move the fold header up a line
-				editor->SetFoldLevel(l - 1, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
-				editor->SetFoldLevel(l, next_level);
+				set_level(l - 1, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
+				set_level(l, next_level);
 			}
 			else
-				editor->SetFoldLevel(l, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
+				set_level(l, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
 		}
 		else
-			editor->SetFoldLevel(l, fold_level);
+			set_level(l, fold_level);
 
 		fold_level = next_level;
 	}
 }
 
+// ----------------------------------------------------------------------------
+// Lexer::lineInfo
+//
+// Returns the cached lexer info for [line] in [editor]
+// ----------------------------------------------------------------------------
+Lexer::LineInfo Lexer::lineInfo(TextEditorCtrl* editor, int line) const
+{
+	if (line < 0 || line >= editor->GetLineCount())
+		return LineInfo();
+
+	return LineInfo(editor->GetLineState(line));
+}
+
 // ----------------------------------------------------------------------------
 // Lexer::isFunction
 //
@@ -724,7 +799,42 @@ void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
 bool Lexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos)
 {
 	string word = editor->GetTextRange(start_pos, end_pos);
-	return word_list_[language_->caseSensitive() ? word : word.MakeLower()].style == (int)Style::Function;
+	return wordStyle(word.ToStdString()) == (char)Style::Function;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// Lexer::LineInfo Struct Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// Lexer::LineInfo::LineInfo
+//
+// LineInfo struct constructor, unpacks info from a line [state] value
+// ----------------------------------------------------------------------------
+Lexer::LineInfo::LineInfo(int state) :
+	styled{ (state & 1) != 0 },
+	commented{ (state & 2) != 0 },
+	has_word{ (state & 4) != 0 },
+	fold_increment{ (int16_t)((state >> 8) & 0xFFFF) }
+{
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::LineInfo::packed
+//
+// Returns the info packed into a single line state value
+// ----------------------------------------------------------------------------
+int Lexer::LineInfo::packed() const
+{
+	return
+		(styled ? 1 : 0) |
+		(commented ? 2 : 0) |
+		(has_word ? 4 : 0) |
+		((fold_increment & 0xFFFF) << 8);
 }
 
 
@@ -744,7 +854,7 @@ bool Lexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos)
 void ZScriptLexer::addWord(string word, int style)
 {
 	if (style == Style::Function)
-		functions_.push_back(language_->caseSensitive() ? word : word.Lower());
+		functions_.insert(wordKey(word.ToStdString()));
 	else
 		Lexer::addWord(word, style);
 }
@@ -754,7 +864,7 @@ void ZScriptLexer::addWord(string word, int style)
 //
 // ZScript version of Lexer::styleWord - functions require a following '('
 // ----------------------------------------------------------------------------
-void ZScriptLexer::styleWord(LexerState& state, string word)
+void ZScriptLexer::styleWord(LexerState& state, const std::string& word)
 {
 	// Skip whitespace after word
 	auto index = state.position;
@@ -768,10 +878,7 @@ void ZScriptLexer::styleWord(LexerState& state, string word)
 	// Check for '(' (possible function)
 	if (state.editor->GetCharAt(index) == '(')
 	{
-		if (!language_->caseSensitive())
-			word = word.Lower();
-
-		if (VECTOR_EXISTS(functions_, word))
+		if (functions_.count(wordKey(word)) > 0)
 		{
 			state.editor->SetStyling(word.length(), Style::Function);
 			return;
@@ -816,5 +923,5 @@ bool ZScriptLexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos
 
 	// Check if word is a function name
 	string word = editor->GetTextRange(start_pos, end_pos);
-	return VECTOR_EXISTS(functions_, language_->caseSensitive() ? word : word.Lower());
+	return functions_.count(wordKey(word.ToStdString())) > 0;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_set>
+
 class TextEditorCtrl;
 class TextLanguage;
 class Lexer
@@ -36,7 +38,7 @@ public:
 	void	setWordChars(string chars);
 	void	setOperatorChars(string chars);
 
-	void	updateFolding(TextEditorCtrl* editor, int line_start);
+	void	updateFolding(TextEditorCtrl* editor, int line_start, int line_end);
 	void	foldComments(bool fold) { fold_comments_ = fold; }
 	void	foldPreprocessor(bool fold) { fold_preprocessor_ = fold; }
 
@@ -67,21 +69,37 @@ protected:
 	bool			fold_preprocessor_;
 	char			preprocessor_char_;
 
-	struct WLIndex
-	{
-		char style;
-		WLIndex() : style(0) {}
-	};
-	std::map<string, WLIndex>	word_list_;
-
+	// Language tokens, cached from language_ in loadLanguage
+	string	comment_begin_;
+	string	comment_end_;
+	string	comment_doc_;
+	string	comment_line_;
+	string	block_begin_;
+	string	block_end_;
+	std::string	preprocessor_;
+
+	// Word lookups are keyed by (lowercased if case insensitive) ascii word
+	std::unordered_map<std::string, char>	word_list_;
+	std::unordered_map<std::string, int>	fold_words_;
+	std::unordered_map<std::string, int>	pp_fold_words_;
+
+	// Lexer info for each line is kept in the editor's line state (which
+	// scintilla keeps in sync with inserted/deleted lines), packed as:
+	// bit 0:		line has been styled
+	// bit 1:		line ends inside a block comment
+	// bit 2:		line has a word (for fold header placement)
+	// bits 8-23:	fold level increment (signed)
 	struct LineInfo
 	{
+		bool	styled;
 		bool	commented;
-		int		fold_increment;
 		bool	has_word;
-		LineInfo() : commented{ false }, fold_increment{ 0 }, has_word{ false } {}
+		int		fold_increment;
+
+		LineInfo(int state = 0);
+		int packed() const;
 	};
-	std::map<int, LineInfo>	lines_;
+	LineInfo	lineInfo(TextEditorCtrl* editor, int line) const;
 
 	struct LexerState
 	{
@@ -102,8 +120,10 @@ protected:
 	bool	processOperator(LexerState& state);
 	bool	processWhitespace(LexerState& state);
 
-	virtual void	styleWord(LexerState& state, string word);
-	bool			checkToken(LexerState& state, int pos, string& token);
+	virtual void	styleWord(LexerState& state, const std::string& word);
+	bool			checkToken(LexerState& state, int pos, const string& token);
+	std::string		wordKey(const std::string& word) const;
+	char			wordStyle(const std::string& word) const;
 };
 
 class ZScriptLexer : public Lexer
@@ -114,10 +134,10 @@ public:
 
 protected:
 	void addWord(string word, int style) override;
-	void styleWord(LexerState& state, string word) override;
+	void styleWord(LexerState& state, const std::string& word) override;
 	void clearWords() override;
 	bool isFunction(TextEditorCtrl* editor, int start_pos, int end_pos) override;
 
 private:
-	vector<string>	functions_;
+	std::unordered_set<std::string>	functions_;
 };
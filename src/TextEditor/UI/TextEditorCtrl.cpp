@@ -69,6 +69,7 @@ CVAR(Int, txed_hilight_current_line, 2, CVAR_SAVE)
 CVAR(Int, txed_line_extra_height, 0, CVAR_SAVE)
 CVAR(Bool, txed_tab_spaces, false, CVAR_SAVE)
 CVAR(Int, txed_show_whitespace, 0, CVAR_SAVE)
+CVAR(Int, txed_style_time_slice, 10, CVAR_SECRET)
 
 wxDEFINE_EVENT(wxEVT_COMMAND_JTCALCULATOR_COMPLETED, wxThreadEvent);
 wxDEFINE_EVENT(wxEVT_TEXT_CHANGED, wxCommandEvent);
@@ -185,6 +186,7 @@ TextEditorCtrl::TextEditorCtrl(wxWindow* parent, int id) :
 	jump_to_calculator_ = nullptr;
 	update_jump_to_ = false;
 	update_word_match_ = false;
+	style_pending_ = false;
 	last_modified_ = App::runTimer();
 
 	// Line numbers by default
@@ -227,6 +229,7 @@ TextEditorCtrl::TextEditorCtrl(wxWindow* parent, int id) :
 	Bind(wxEVT_STC_CHANGE, &TextEditorCtrl::onModified, this);
 	Bind(wxEVT_TIMER, &TextEditorCtrl::onUpdateTimer, this);
 	Bind(wxEVT_STC_STYLENEEDED, &TextEditorCtrl::onStyleNeeded, this);
+	Bind(wxEVT_IDLE, &TextEditorCtrl::onIdle, this);
 }
 
 // ----------------------------------------------------------------------------
@@ -1137,6 +1140,48 @@ void TextEditorCtrl::setupFolding()
 	}
 }
 
+// ----------------------------------------------------------------------------
+// TextEditorCtrl::styleLines
+//
+// Styles lines [line_start] to [line_end] and updates folding for them.
+// Styling continues past [line_end] for as long as the lexer reports that the
+// following line needs restyling (eg. a block comment was opened), but only
+// for up to txed_style_time_slice ms - the remaining lines are then styled
+// in the background when idle
+// ----------------------------------------------------------------------------
+void TextEditorCtrl::styleLines(int line_start, int line_end)
+{
+	long time_start = App::runTimer();
+	int line_count = GetLineCount();
+	int l = line_start;
+	bool style_next = true;
+	style_pending_ = false;
+	while (l < line_count && (l <= line_end || style_next))
+	{
+		// Out of time, leave the rest for later
+		if (l > line_end && App::runTimer() - time_start >= txed_style_time_slice)
+		{
+			// Clear the next line's cached state so that it is always
+			// restyled (along with the lines following it) when reached
+			SetLineState(l, 0);
+			style_pending_ = true;
+			break;
+		}
+
+		int start = PositionFromLine(l);
+		int end = ((l < line_count - 1) ? PositionFromLine(l + 1) : GetLength()) - 1;
+		style_next = lexer_->doStyling(this, start, end);
+		l++;
+	}
+
+	if (txed_fold_enable && l > line_start)
+	{
+		auto modified = last_modified_;
+		lexer_->updateFolding(this, line_start, l - 1);
+		last_modified_ = modified;
+	}
+}
+
 // ----------------------------------------------------------------------------
 // TextEditorCtrl::lineComment
 //
@@ -1886,25 +1931,23 @@ void TextEditorCtrl::onStyleNeeded(wxStyledTextEvent& e)
 	int line_start = LineFromPosition(GetEndStyled());
 	int line_end = LineFromPosition(e.GetPosition());
 
-	// Lex until done (end of lines, end of file or end of block comment)
-	int l = line_start;
-	bool force_next = false;
-	while (l <= GetNumberOfLines() && (l <= line_end || force_next))
-	{
-		int end = GetLineEndPosition(l) - 1;
-		int start = end - GetLineLength(l) + 1;
-
-		if (start > end)
-			end = start;
-
-		force_next = lexer_->doStyling(this, start, end);
-		l++;
-	}
+	styleLines(line_start, line_end);
+}
 
-	if (txed_fold_enable)
+// ----------------------------------------------------------------------------
+// TextEditorCtrl::onIdle
+//
+// Called when the application is idle, continues styling any lines past
+// what was last requested a time slice at a time
+// ----------------------------------------------------------------------------
+void TextEditorCtrl::onIdle(wxIdleEvent& e)
+{
+	if (style_pending_)
 	{
-		auto modified = last_modified_;
-		lexer_->updateFolding(this, line_start);
-		last_modified_ = modified;
+		styleLines(LineFromPosition(GetEndStyled()), -1);
+		if (style_pending_)
+			e.RequestMore();
 	}
+
+	e.Skip();
 }
@@ -79,6 +79,7 @@ public:
 	// Folding
 	void	foldAll(bool fold = true);
 	void	setupFolding();
+	void	styleLines(int line_start, int line_end);
 
 	// Comments
 	void	lineComment();
@@ -105,6 +106,7 @@ private:
 	wxTimer	timer_update_;
 	bool	update_jump_to_;
 	bool	update_word_match_;
+	bool	style_pending_;
 
 	// Calltip stuff
 	TLFunction*	ct_function_;
@@ -129,4 +131,5 @@ private:
 	void	onModified(wxStyledTextEvent& e);
 	void	onUpdateTimer(wxTimerEvent& e);
 	void	onStyleNeeded(wxStyledTextEvent& e);
+	void	onIdle(wxIdleEvent& e);
 };
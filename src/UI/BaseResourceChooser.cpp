@@ -94,21 +94,25 @@ void BaseResourceChooser::populateChoices()
 	SetSelection(base_resource + 1);
 }
 
-/* BaseResourceChooser::onAnnouncement
+/* BaseResourceChooser::onAnnouncementEvent
  * Called when an announcement is received from the ArchiveManager
  *******************************************************************/
-void BaseResourceChooser::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void BaseResourceChooser::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
+	static const Announcement::Id base_resource_changed = Announcement::id("base_resource_changed");
+	static const Announcement::Id base_resource_path_added = Announcement::id("base_resource_path_added");
+	static const Announcement::Id base_resource_path_removed = Announcement::id("base_resource_path_removed");
+
 	// Check the announcer
 	if (announcer != &App::archiveManager())
 		return;
 
 	// Base resource archive changed
-	if (event_name == "base_resource_changed")
+	if (event == base_resource_changed)
 		SetSelection(base_resource + 1);
 
 	// Base resource path list changed
-	if (event_name == "base_resource_path_added" || event_name == "base_resource_path_removed")
+	if (event == base_resource_path_added || event == base_resource_path_removed)
 		populateChoices();
 }
 
@@ -15,7 +15,7 @@ public:
 	~BaseResourceChooser();
 
 	void	populateChoices();
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data);
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 
 	// Events
 	void onChoiceChanged(wxCommandEvent& e);
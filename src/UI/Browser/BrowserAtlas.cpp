@@ -0,0 +1,290 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    BrowserAtlas.cpp
+// Description: BrowserAtlas class, keeps browser item thumbnails in a set of
+//              shared OpenGL textures so they can be drawn in batches
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "BrowserAtlas.h"
+#include "BrowserItem.h"
+#include "OpenGL/GLTexture.h"
+#include "OpenGL/OpenGL.h"
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+CVAR(Int, browser_atlas_size, 64, CVAR_SAVE)	// Texture memory to use for browser thumbnails (MB)
+
+
+// ----------------------------------------------------------------------------
+//
+// BrowserAtlas Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::BrowserAtlas
+//
+// BrowserAtlas class constructor
+// ----------------------------------------------------------------------------
+BrowserAtlas::BrowserAtlas()
+{
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::~BrowserAtlas
+//
+// BrowserAtlas class destructor
+// ----------------------------------------------------------------------------
+BrowserAtlas::~BrowserAtlas()
+{
+	clear();
+	if (fbo_)
+		glDeleteFramebuffersEXT(1, &fbo_);
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::isSupported
+//
+// Returns true if thumbnails can be rendered to the atlas (requires framebuffer
+// object support) and the atlas is enabled
+// ----------------------------------------------------------------------------
+bool BrowserAtlas::isSupported()
+{
+	return browser_atlas_size > 0 && OpenGL::isInitialised() && GLEW_EXT_framebuffer_object;
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::setCellSize
+//
+// Sets the size of each thumbnail cell to [size]. Clears the atlas if the
+// size has changed
+// ----------------------------------------------------------------------------
+void BrowserAtlas::setCellSize(int size)
+{
+	if (size == cell_size_)
+		return;
+
+	clear();
+	cell_size_ = size;
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::cell
+//
+// Returns the atlas cell containing the thumbnail for [item], or null if it
+// isn't in the atlas. Marks the cell as used in [frame]
+// ----------------------------------------------------------------------------
+BrowserAtlas::Cell* BrowserAtlas::cell(BrowserItem* item, long frame)
+{
+	auto i = lookup_.find(item);
+	if (i == lookup_.end())
+		return nullptr;
+
+	auto& cell = cells_[i->second];
+	cell.last_used = frame;
+	return &cell;
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::add
+//
+// Renders [image] into a free cell as the thumbnail for [item], replacing the
+// least recently used thumbnail if the atlas is full. Returns the cell, or
+// null if there was no room (all cells were used in [frame]) or the atlas
+// isn't supported
+// ----------------------------------------------------------------------------
+BrowserAtlas::Cell* BrowserAtlas::add(BrowserItem* item, GLTexture* image, long frame)
+{
+	if (!image || !image->isLoaded() || cell_size_ <= 0 || !isSupported())
+		return nullptr;
+
+	// Check if already added
+	auto existing = cell(item, frame);
+	if (existing)
+		return existing;
+
+	// Get a free cell
+	int index = freeCell(frame);
+	if (index < 0)
+		return nullptr;
+	auto& cell = cells_[index];
+	if (cell.item)
+		lookup_.erase(cell.item);
+
+	// Determine thumbnail size
+	double width = image->getWidth();
+	double height = image->getHeight();
+	BrowserItem::fitImage(cell_size_, width, height);
+	cell.item = item;
+	cell.width = MAX(1, MIN(cell_size_, (int)ceil(width)));
+	cell.height = MAX(1, MIN(cell_size_, (int)ceil(height)));
+	cell.img_width = image->getWidth();
+	cell.img_height = image->getHeight();
+	cell.last_used = frame;
+	lookup_[item] = index;
+
+	// Setup rendering to the page texture
+	glPushAttrib(GL_ENABLE_BIT | GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, 1, 1, 0, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, pages_[cell.page], 0);
+
+	// Clear the cell
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(cell.x, cell.y, cell_size_, cell_size_);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+
+	// Draw the image scaled to the thumbnail size (the top of the image ends
+	// up at the top of the thumbnail area in texture coordinates)
+	glViewport(cell.x, cell.y, cell.width, cell.height);
+	glDisable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	image->bind();
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0f, 0.0f);	glVertex2d(0, 0);
+	glTexCoord2f(0.0f, 1.0f);	glVertex2d(0, 1);
+	glTexCoord2f(1.0f, 1.0f);	glVertex2d(1, 1);
+	glTexCoord2f(1.0f, 0.0f);	glVertex2d(1, 0);
+	glEnd();
+
+	// Restore
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+
+	return &cell;
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::clear
+//
+// Removes all thumbnails and frees the page textures
+// ----------------------------------------------------------------------------
+void BrowserAtlas::clear()
+{
+	if (!pages_.empty())
+		glDeleteTextures(pages_.size(), pages_.data());
+	pages_.clear();
+	cells_.clear();
+	lookup_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::addPage
+//
+// Creates a new page texture and adds its cells. Returns false if the page
+// couldn't be created, or the memory limit (browser_atlas_size) is reached
+// ----------------------------------------------------------------------------
+bool BrowserAtlas::addPage()
+{
+	// Determine page size
+	if (page_size_ == 0)
+		page_size_ = MIN(2048u, OpenGL::maxTextureSize());
+	if (cell_size_ <= 0 || (unsigned)cell_size_ > page_size_)
+		return false;
+
+	// Check memory limit (always allow at least one page)
+	unsigned page_bytes = page_size_ * page_size_ * 4;
+	unsigned max_pages = MAX(1u, (unsigned)browser_atlas_size * 1024 * 1024 / page_bytes);
+	if (pages_.size() >= max_pages)
+		return false;
+
+	// Create framebuffer if needed
+	if (!fbo_)
+		glGenFramebuffersEXT(1, &fbo_);
+
+	// Create texture
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, page_size_, page_size_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	pages_.push_back(id);
+
+	// Add cells
+	unsigned per_row = page_size_ / cell_size_;
+	for (unsigned y = 0; y < per_row; y++)
+		for (unsigned x = 0; x < per_row; x++)
+		{
+			Cell cell;
+			cell.page = pages_.size() - 1;
+			cell.x = x * cell_size_;
+			cell.y = y * cell_size_;
+			cells_.push_back(cell);
+		}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// BrowserAtlas::freeCell
+//
+// Returns the index of a cell that can be used for a new thumbnail: an empty
+// one if possible, otherwise the least recently used one that wasn't used in
+// [frame]. Returns -1 if there are none
+// ----------------------------------------------------------------------------
+int BrowserAtlas::freeCell(long frame)
+{
+	// Look for an empty cell, or the least recently used one
+	int lru = -1;
+	for (unsigned a = 0; a < cells_.size(); a++)
+	{
+		if (!cells_[a].item)
+			return a;
+		if (cells_[a].last_used < frame && (lru < 0 || cells_[a].last_used < cells_[lru].last_used))
+			lru = a;
+	}
+
+	// Add a new page if there's room
+	unsigned first_new = cells_.size();
+	if (addPage())
+		return first_new;
+
+	return lru;
+}
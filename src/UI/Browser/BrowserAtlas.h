@@ -0,0 +1,51 @@
+#pragma once
+
+class BrowserItem;
+class GLTexture;
+
+// A set of shared OpenGL textures ('pages') that browser item thumbnails are
+// copied into, so that all visible items can be drawn with one texture bind
+// per page. Uses a fixed amount of texture memory, least recently drawn
+// thumbnails are replaced when full
+class BrowserAtlas
+{
+public:
+	struct Cell
+	{
+		BrowserItem*	item		= nullptr;
+		unsigned		page		= 0;
+		int				x			= 0;
+		int				y			= 0;
+		int				width		= 0;	// Size of the thumbnail within the cell
+		int				height		= 0;
+		int				img_width	= 0;	// Size of the original item image
+		int				img_height	= 0;
+		long			last_used	= 0;
+	};
+
+	BrowserAtlas();
+	~BrowserAtlas();
+
+	static bool	isSupported();
+
+	int			cellSize() const { return cell_size_; }
+	unsigned	pageSize() const { return page_size_; }
+	unsigned	pageTexture(unsigned page) const { return page < pages_.size() ? pages_[page] : 0; }
+	unsigned	nPages() const { return pages_.size(); }
+
+	void		setCellSize(int size);
+	Cell*		cell(BrowserItem* item, long frame);
+	Cell*		add(BrowserItem* item, GLTexture* image, long frame);
+	void		clear();
+
+private:
+	int									cell_size_	= 0;
+	unsigned							page_size_	= 0;
+	vector<unsigned>					pages_;
+	vector<Cell>						cells_;
+	std::unordered_map<BrowserItem*, int>	lookup_;
+	unsigned							fbo_		= 0;
+
+	bool	addPage();
+	int		freeCell(long frame);
+};
@@ -30,8 +30,11 @@
  * INCLUDES
  *******************************************************************/
 #include "Main.h"
+#include "App.h"
 #include "BrowserCanvas.h"
+#include "General/ResourceManager.h"
 #include "OpenGL/Drawing.h"
+#include "Utility/StringUtils.h"
 
 
 
@@ -40,6 +43,9 @@
  *******************************************************************/
 CVAR(Int, browser_bg_type, false, CVAR_SAVE)
 CVAR(Int, browser_item_size, 96, CVAR_SAVE)
+CVAR(Int, browser_load_time, 15, CVAR_SAVE)		// Max time (ms) to spend loading item images per frame
+CVAR(Int, browser_prefetch_rows, 4, CVAR_SAVE)	// Rows of items to load ahead of the scroll direction
+CVAR(Int, browser_filter_async_min, 5000, CVAR_SAVE)
 DEFINE_EVENT_TYPE(wxEVT_BROWSERCANVAS_SELECTION_CHANGED)
 
 
@@ -63,6 +69,14 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
 	item_type = ITEMS_NORMAL;
 	longest_text = -1;
 	num_cols = -1;
+	atlas_reset = false;
+	frame = 0;
+	last_yoff = 0;
+	scroll_dir = 1;
+	filter_generation = 0;
+	filter_pending = false;
+	show_selected_pending = false;
+	filter_token = std::make_shared<bool>(true);
 
 	// Bind events
 	Bind(wxEVT_SIZE, &BrowserCanvas::onSize, this);
@@ -70,6 +84,7 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
 	Bind(wxEVT_LEFT_DOWN, &BrowserCanvas::onMouseEvent, this);
 	Bind(wxEVT_KEY_DOWN, &BrowserCanvas::onKeyDown, this);
 	//Bind(wxEVT_CHAR, &BrowserCanvas::onKeyChar, this);
+	timer_load.Bind(wxEVT_TIMER, [&](wxTimerEvent&) { Refresh(); });
 }
 
 /* BrowserCanvas::~BrowserCanvas
@@ -77,6 +92,7 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
  *******************************************************************/
 BrowserCanvas::~BrowserCanvas()
 {
+	timer_load.Stop();
 }
 
 /* BrowserCanvas::getViewedIndex
@@ -107,6 +123,7 @@ int BrowserCanvas::getViewedIndex()
 void BrowserCanvas::addItem(BrowserItem* item)
 {
 	items.push_back(item);
+	item_names.reset();
 	longest_text = -1;
 }
 
@@ -116,9 +133,21 @@ void BrowserCanvas::addItem(BrowserItem* item)
 void BrowserCanvas::clearItems()
 {
 	items.clear();
+	item_names.reset();
 	longest_text = -1;
 }
 
+/* BrowserCanvas::clearAtlas
+ * Clears all item thumbnails from the atlas, they will be recreated
+ * from the item images when next drawn
+ *******************************************************************/
+void BrowserCanvas::clearAtlas()
+{
+	// Cleared on the next draw, when the gl context is active
+	atlas_reset = true;
+	Refresh();
+}
+
 /* BrowserCanvas::fullItemSizeX
  * Returns the 'full' (including border) width of each item
  *******************************************************************/
@@ -208,54 +237,79 @@ void BrowserCanvas::draw()
 	if (browser_bg_type == 0)
 		drawCheckeredBackground();
 
+	// Determine visible items
+	int cols = MAX(num_cols, 1);
+	int size = (item_size > 0) ? item_size : browser_item_size;
+	int row_height = fullItemSizeY();
+	int col_width = GetSize().x / cols;
+	int xgap = (col_width - fullItemSizeX()) * 0.5;
+	int first_row = MAX(yoff, 0) / row_height;
+	int last_row = (yoff + GetSize().y) / row_height;
+	int first = MIN(first_row * cols, (int)items_filter.size());
+	int last = MIN((last_row + 1) * cols, (int)items_filter.size());
+	top_index = (first < last) ? first : -1;
+	top_y = item_border + (first_row * row_height) - yoff;
+
+	// Update the thumbnail atlas
+	frame++;
+	if (atlas_reset)
+	{
+		atlas.clear();
+		atlas_reset = false;
+	}
+	bool use_atlas = BrowserAtlas::isSupported();
+	if (use_atlas)
+		atlas.setCellSize(size);
+
+	// Load images for visible items, then the next few rows in the direction
+	// being scrolled, until the time limit for this frame is reached. If there
+	// is more to load, continue next frame
+	if (yoff != last_yoff)
+		scroll_dir = (yoff > last_yoff) ? 1 : -1;
+	last_yoff = yoff;
+	long start = App::runTimer();
+	int loaded = 0;
+	bool more = loadItemImages(first, last, start, loaded);
+	if (!more)
+	{
+		int prefetch = MAX((int)browser_prefetch_rows, 0) * cols;
+		if (scroll_dir > 0)
+			more = loadItemImages(last, MIN(last + prefetch, (int)items_filter.size()), start, loaded);
+		else
+			more = loadItemImages(MAX(first - prefetch, 0), first, start, loaded);
+	}
+	if (more && !timer_load.IsRunning())
+		timer_load.Start(1, wxTIMER_ONE_SHOT);
+
 	// Init for texture drawing
 	glEnable(GL_TEXTURE_2D);
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 	glLineWidth(2.0f);
 
-	// Draw items
-	int x = item_border;
-	int y = item_border;
-	int col_width = GetSize().x / num_cols;
-	int col = 0;
-	top_index = -1;
-	for (unsigned a = 0; a < items_filter.size(); a++)
+	// Draw items (thumbnails in the atlas are drawn afterwards, batched by page)
+	struct AtlasQuad
 	{
-		// If we're not yet into the viewable area, skip
-		if (y < yoff - fullItemSizeY())
-		{
-			col++;
-			if (col >= num_cols)
-			{
-				col = 0;
-				y += fullItemSizeY();
-
-				// Canvas is filled, stop drawing
-				if (y > yoff + GetSize().y)
-					break;
-			}
-			continue;
-		}
-
-		// If we're drawing the first non-hidden item, save it
-		if (top_index < 0)
-		{
-			top_index = a;
-			top_y = y - yoff;
-		}
+		unsigned	page;
+		double		left, top, right, bottom;
+		float		u1, v1, u2, v2;
+	};
+	vector<AtlasQuad> quads;
+	for (int a = first; a < last; a++)
+	{
+		BrowserItem* item = items[items_filter[a]];
 
-		// Determine current x position
-		int xgap = (col_width - fullItemSizeX()) * 0.5;
-		x = item_border + xgap + (col * col_width);
+		// Determine item position
+		int x = item_border + xgap + ((a % cols) * col_width);
+		int y = item_border + ((a / cols) * row_height) - yoff;
 
 		// Draw selection box if selected
-		if (item_selected == items[items_filter[a]])
+		if (item_selected == item)
 		{
 			// Setup
 			glDisable(GL_TEXTURE_2D);
 			glColor4f(0.3f, 0.5f, 1.0f, 0.3f);
 			glPushMatrix();
-			glTranslated(x, y - yoff, 0);
+			glTranslated(x, y, 0);
 			glTranslated(-item_border, -item_border, 0);
 
 			// Selection background
@@ -281,22 +335,69 @@ void BrowserCanvas::draw()
 			glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 		}
 
-		// Draw item
-		if (item_size <= 0)
-			items[items_filter[a]]->draw(browser_item_size, x, y - yoff, font, show_names, item_type, col_text, text_shadow);
+		// Draw item name
+		item->drawText(size, x, y, font, show_names, item_type, col_text, text_shadow);
+		if (item->isBlank())
+			continue;
+
+		// Use thumbnail in the atlas if it's there
+		BrowserAtlas::Cell* cell = use_atlas ? atlas.cell(item, frame) : nullptr;
+		if (cell)
+		{
+			double width = cell->img_width;
+			double height = cell->img_height;
+			BrowserItem::fitImage(size, width, height);
+
+			AtlasQuad quad;
+			float page_size = atlas.pageSize();
+			quad.page = cell->page;
+			quad.left = x + ((double)size * 0.5) - (width * 0.5);
+			quad.top = y + ((double)size * 0.5) - (height * 0.5);
+			quad.right = quad.left + width;
+			quad.bottom = quad.top + height;
+			quad.u1 = cell->x / page_size;
+			quad.u2 = (cell->x + cell->width) / page_size;
+			quad.v1 = (cell->y + cell->height) / page_size;	// Top of the thumbnail
+			quad.v2 = cell->y / page_size;
+			quads.push_back(quad);
+		}
+
+		// Otherwise draw the item image directly (or the 'invalid' box if it
+		// failed to load), or a placeholder if it isn't loaded yet
+		else if (item->imageLoaded() || item->imageFailed())
+			item->drawImage(size, x, y);
 		else
-			items[items_filter[a]]->draw(item_size, x, y - yoff, font, show_names, item_type, col_text, text_shadow);
+			item->drawPlaceholder(size, x, y, col_text);
+	}
 
-		// Move over for next item
-		col++;
-		if (col >= num_cols)
+	// Draw atlas thumbnails, one batch per page
+	if (!quads.empty())
+	{
+		glEnable(GL_TEXTURE_2D);
+		glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+		for (unsigned page = 0; page < atlas.nPages(); page++)
 		{
-			col = 0;
-			y += fullItemSizeY();
+			bool bound = false;
+			for (auto& quad : quads)
+			{
+				if (quad.page != page)
+					continue;
+
+				if (!bound)
+				{
+					glBindTexture(GL_TEXTURE_2D, atlas.pageTexture(page));
+					glBegin(GL_QUADS);
+					bound = true;
+				}
+
+				glTexCoord2f(quad.u1, quad.v1);	glVertex2d(quad.left, quad.top);
+				glTexCoord2f(quad.u1, quad.v2);	glVertex2d(quad.left, quad.bottom);
+				glTexCoord2f(quad.u2, quad.v2);	glVertex2d(quad.right, quad.bottom);
+				glTexCoord2f(quad.u2, quad.v1);	glVertex2d(quad.right, quad.top);
+			}
 
-			// Canvas is filled, stop drawing
-			if (y > yoff + GetSize().y)
-				break;
+			if (bound)
+				glEnd();
 		}
 	}
 
@@ -304,6 +405,45 @@ void BrowserCanvas::draw()
 	SwapBuffers();
 }
 
+/* BrowserCanvas::loadItemImages
+ * Loads images for filtered items [from] to [to] (exclusive) that
+ * aren't already loaded, and adds them to the thumbnail atlas.
+ * Stops when more than browser_load_time ms have passed since
+ * [start], though at least one image is loaded per frame ([loaded]
+ * is the number loaded so far). Returns true if there are more
+ * images still to load
+ *******************************************************************/
+bool BrowserCanvas::loadItemImages(int from, int to, long start, int& loaded)
+{
+	bool use_atlas = BrowserAtlas::isSupported();
+	for (int a = from; a < to; a++)
+	{
+		BrowserItem* item = items[items_filter[a]];
+		if (item->isBlank() || item->imageFailed())
+			continue;
+
+		// Already done
+		if (use_atlas && atlas.cell(item, frame))
+			continue;
+		if (!use_atlas && item->imageLoaded())
+			continue;
+
+		// Check time limit
+		if (loaded > 0 && App::runTimer() - start >= browser_load_time)
+			return true;
+
+		// Load image and copy to atlas (if the atlas is full the image is
+		// drawn directly instead)
+		bool work = !item->imageLoaded();
+		if (item->tryLoadImage() && use_atlas && atlas.add(item, item->getImage(), frame))
+			work = true;
+		if (work)
+			loaded++;
+	}
+
+	return false;
+}
+
 /* BrowserCanvas::setScrollBar
  * Sets this canvas' associated vertical scrollbar
  *******************************************************************/
@@ -446,39 +586,229 @@ void BrowserCanvas::selectItem(int index)
 }
 
 /* BrowserCanvas::filterItems
- * Filters the visible items by [filter], by name
+ * Filters the visible items by [filter], by name. Filters without
+ * wildcards are looked up in the resource name indices if any were
+ * given. Otherwise if there are more than browser_filter_async_min
+ * items the filtering is done in the background, and the canvas is
+ * updated when it is finished
  *******************************************************************/
 void BrowserCanvas::filterItems(string filter)
 {
-	// Find the currently-viewed item before we change the item list
-	int viewed_index = getViewedIndex();
-
-	// Clear current filter list
-	items_filter.clear();
+	// Cancel any background filter in progress
+	this->filter = filter;
+	filter_generation++;
+	filter_pending = false;
 
 	// If the filter is empty, just add all items to the filter
 	if (filter.IsEmpty())
 	{
+		vector<int> all(items.size());
 		for (unsigned a = 0; a < items.size(); a++)
-			items_filter.push_back(a);
+			all[a] = a;
+		filterFinished(all);
+		return;
 	}
-	else
+
+	// Plain (prefix) filters can be looked up in the resource name indices
+	// rather than checking every item
+	if (!name_indices.empty() && !filter.Contains("*") && !filter.Contains("?"))
+	{
+		filterFinished(lookupFilter(filter));
+		return;
+	}
+
+	// Update item names if needed
+	updateItemNames();
+
+	// Setup filter string
+	std::wstring pattern = filter.Lower().ToStdWstring();
+	auto match = [](const vector<std::wstring>& names, const std::wstring& pattern)
+	{
+		vector<int> result;
+		for (unsigned a = 0; a < names.size(); a++)
+			if (StringUtils::matchesWildcard(names[a], pattern, true))
+				result.push_back(a);
+		return result;
+	};
+
+	// Filter in the background if there are a lot of items
+	if (browser_filter_async_min > 0 && items.size() >= (unsigned)browser_filter_async_min)
 	{
-		// Setup filter string
-		filter.MakeLower();
-		filter += "*";
+		filter_pending = true;
+
+		auto canvas = this;
+		auto names = item_names;
+		auto generation = filter_generation;
+		std::weak_ptr<bool> token = filter_token;
+		filter_worker.queue([=]()
+		{
+			auto result = std::make_shared<vector<int>>(match(*names, pattern));
+			if (!wxTheApp)
+				return;
+
+			wxTheApp->CallAfter([=]()
+			{
+				// Ignore if the canvas was destroyed or the filter has changed since
+				if (token.expired() || generation != canvas->filter_generation)
+					return;
+
+				// Filter again if the items changed while filtering
+				if (names != canvas->item_names)
+				{
+					canvas->filterItems(canvas->filter);
+					return;
+				}
+
+				canvas->filter_pending = false;
+				canvas->filterFinished(*result);
+			});
+		});
+
+		return;
+	}
+
+	filterFinished(match(*item_names, pattern));
+}
+
+/* BrowserCanvas::addNameIndex
+ * Adds a resource name [index] to look up plain (non-wildcard)
+ * filters in. Items with names that aren't in any of the indices are
+ * still checked individually
+ *******************************************************************/
+void BrowserCanvas::addNameIndex(ResourceNameIndex* index)
+{
+	if (std::find(name_indices.begin(), name_indices.end(), index) == name_indices.end())
+		name_indices.push_back(index);
+	indexed_names.reset();
+}
 
-		// Go through items
+/* BrowserCanvas::updateItemNames
+ * Rebuilds the lowercase item names used for filtering, if the items
+ * have changed since they were last built
+ *******************************************************************/
+void BrowserCanvas::updateItemNames()
+{
+	if (item_names)
+		return;
+
+	auto names = std::make_shared<vector<std::wstring>>(items.size());
+	for (unsigned a = 0; a < items.size(); a++)
+		(*names)[a] = items[a]->getName().Lower().ToStdWstring();
+	item_names = names;
+}
+
+/* BrowserCanvas::lookupFilter
+ * Returns the indices of all items with names beginning with
+ * [filter] (which can't contain wildcards), using the resource name
+ * indices to find them. If nothing matches, the items with names
+ * best fuzzy-matching [filter] are returned instead, best first
+ *******************************************************************/
+vector<int> BrowserCanvas::lookupFilter(const string& filter)
+{
+	// Sort items by name if the items have changed
+	updateItemNames();
+	if (indexed_names != item_names)
+	{
+		indexed_items.clear();
+		unindexed_items.clear();
 		for (unsigned a = 0; a < items.size(); a++)
 		{
-			// Add to filter list if name matches
-			if (items[a]->getName().Lower().Matches(filter))
-				items_filter.push_back(a);
+			string name = items[a]->getName().Upper();
+			bool indexed = false;
+			for (auto index : name_indices)
+				if (index->contains(name))
+				{
+					indexed = true;
+					break;
+				}
+
+			if (indexed)
+				indexed_items[name].push_back(a);
+			else
+				unindexed_items.push_back(a);
 		}
+		indexed_names = item_names;
+	}
+
+	// Get items with indexed names beginning with the filter
+	string upper = filter.Upper();
+	vector<string> names;
+	for (auto index : name_indices)
+		index->namesWithPrefix(upper, names);
+
+	vector<int> result;
+	for (auto& name : names)
+	{
+		auto i = indexed_items.find(name);
+		if (i != indexed_items.end())
+			result.insert(result.end(), i->second.begin(), i->second.end());
 	}
 
+	// Check any other items by name
+	std::wstring pattern = filter.Lower().ToStdWstring();
+	for (int index : unindexed_items)
+		if (StringUtils::matchesWildcard((*item_names)[index], pattern, true))
+			result.push_back(index);
+
+	// Keep the current item order (a name can be in more than one index)
+	if (!result.empty())
+	{
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	// Nothing matched, show the closest fuzzy matches from all indices
+	names.clear();
+	for (auto index : name_indices)
+		index->fuzzyMatch(upper, names, 50);
+
+	vector<std::pair<int, const string*>> matches;
+	for (auto& name : names)
+		matches.push_back({ ResourceNameIndex::fuzzyScore(upper, name), &name });
+	std::stable_sort(matches.begin(), matches.end(), [](const std::pair<int, const string*>& left, const std::pair<int, const string*>& right)
+	{
+		return left.first > right.first;
+	});
+
+	vector<bool> added(items.size(), false);
+	for (auto& match : matches)
+	{
+		auto i = indexed_items.find(*match.second);
+		if (i == indexed_items.end())
+			continue;
+
+		for (int index : i->second)
+			if (!added[index])
+			{
+				result.push_back(index);
+				added[index] = true;
+			}
+	}
+
+	return result;
+}
+
+/* BrowserCanvas::filterFinished
+ * Called when item filtering has finished, with the filtered item
+ * indices in [result]. Updates the scrollbar and refreshes
+ *******************************************************************/
+void BrowserCanvas::filterFinished(const vector<int>& result)
+{
+	// Find the currently-viewed item before we change the item list
+	int viewed_index = getViewedIndex();
+
+	items_filter = result;
+
 	// Update scrollbar and refresh
 	updateLayout(viewed_index);
+
+	// Show the selected item if it was requested while filtering
+	if (show_selected_pending)
+	{
+		show_selected_pending = false;
+		showSelectedItem();
+	}
 }
 
 /* BrowserCanvas::showItem
@@ -529,6 +859,13 @@ void BrowserCanvas::showItem(int item, int where)
  *******************************************************************/
 void BrowserCanvas::showSelectedItem()
 {
+	// Wait until filtering is finished if it's running in the background
+	if (filter_pending)
+	{
+		show_selected_pending = true;
+		return;
+	}
+
 	showItem(itemIndex(item_selected), 1);
 }
 
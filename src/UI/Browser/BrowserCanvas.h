@@ -4,8 +4,11 @@
 
 #include "UI/Canvas/OGLCanvas.h"
 #include "BrowserItem.h"
+#include "BrowserAtlas.h"
+#include "Utility/Parallel.h"
 
 class wxScrollBar;
+class ResourceNameIndex;
 class BrowserCanvas : public OGLCanvas
 {
 private:
@@ -27,6 +30,35 @@ private:
 	int	longest_text;
 	int	num_cols;
 
+	// Image loading
+	BrowserAtlas	atlas;
+	bool			atlas_reset;
+	long			frame;
+	int				last_yoff;
+	int				scroll_dir;
+	wxTimer			timer_load;
+
+	// Filtering
+	typedef std::shared_ptr<const vector<std::wstring>> NameList;
+	NameList				item_names;		// Lowercase item names (null if out of date)
+	string					filter;
+	unsigned				filter_generation;
+	bool					filter_pending;
+	bool					show_selected_pending;
+	std::shared_ptr<bool>	filter_token;	// Expires with the canvas, for background filtering
+	Parallel::Worker		filter_worker;
+
+	// Resource name indices to look up filters in
+	vector<ResourceNameIndex*>		name_indices;
+	std::map<string, vector<int>>	indexed_items;		// Items by (uppercase) name, if in any index
+	vector<int>						unindexed_items;
+	NameList						indexed_names;		// Item names the above were built from
+
+	bool		loadItemImages(int from, int to, long start, int& loaded);
+	void		updateItemNames();
+	vector<int>	lookupFilter(const string& filter);
+	void		filterFinished(const vector<int>& result);
+
 public:
 	BrowserCanvas(wxWindow* parent);
 	~BrowserCanvas();
@@ -41,10 +73,12 @@ public:
 	    NAMES_NONE,
 	};
 
-	vector<BrowserItem*>&	itemList() { return items; }
+	vector<BrowserItem*>&	itemList() { item_names.reset(); return items; }
 	int						getViewedIndex();
 	void					addItem(BrowserItem* item);
 	void					clearItems();
+	void					clearAtlas();
+	void					addNameIndex(ResourceNameIndex* index);
 	int						fullItemSizeX();
 	int						fullItemSizeY();
 	void					draw();
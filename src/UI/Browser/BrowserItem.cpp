@@ -51,6 +51,7 @@ BrowserItem::BrowserItem(string name, unsigned index, string type)
 	this->image = nullptr;
 	this->blank = false;
 	this->text_box = nullptr;
+	this->image_failed = false;
 }
 
 /* BrowserItem::~BrowserItem
@@ -71,11 +72,49 @@ bool BrowserItem::loadImage()
 	return false;
 }
 
+/* BrowserItem::tryLoadImage
+ * Loads the item image if it isn't already loaded. If loading fails
+ * it isn't attempted again until the image is cleared. Returns true
+ * if the image is loaded
+ *******************************************************************/
+bool BrowserItem::tryLoadImage()
+{
+	if (imageLoaded())
+		return true;
+	if (image_failed)
+		return false;
+
+	if (!loadImage() || !imageLoaded())
+		image_failed = true;
+
+	return !image_failed;
+}
+
 /* BrowserItem::draw
  * Draws the item in a [size]x[size] box, keeping the correct aspect
  * ratio of it's image
  *******************************************************************/
 void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewtype, rgba_t colour, bool text_shadow)
+{
+	// Item name
+	drawText(size, x, y, font, nametype, viewtype, colour, text_shadow);
+
+	// If the item is blank don't bother with the image
+	if (blank)
+		return;
+
+	// Try to load image if it isn't already
+	tryLoadImage();
+
+	// Image
+	drawImage(size, x, y);
+}
+
+/* BrowserItem::drawText
+ * Draws the item name (or index) for an item drawn in a [size]x[size]
+ * box at [x],[y]
+ *******************************************************************/
+void BrowserItem::drawText(int size, int x, int y, int font, int nametype, int viewtype, rgba_t colour, bool text_shadow)
 {
 	// Determine item name string (for normal viewtype)
 	string draw_name = "";
@@ -110,17 +149,16 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 			text_box->draw(x + size + 9, top + 1, COL_BLACK);
 		text_box->draw(x + size + 8, top, colour);
 	}
+}
 
-	// If the item is blank don't bother with the image
-	if (blank)
-		return;
-
-	// Try to load image if it isn't already
-	if (!image || (image && !image->isLoaded()))
-		loadImage();
-
-	// If it still isn't just draw a red box with an X
-	if (!image || (image && !image->isLoaded()))
+/* BrowserItem::drawImage
+ * Draws the item image in a [size]x[size] box at [x],[y], or a red
+ * box with an X if the image isn't loaded
+ *******************************************************************/
+void BrowserItem::drawImage(int size, int x, int y)
+{
+	// If the image isn't loaded just draw a red box with an X
+	if (!imageLoaded())
 	{
 		glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT);
 
@@ -151,7 +189,60 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 	// Determine texture dimensions
 	double width = image->getWidth();
 	double height = image->getHeight();
+	fitImage(size, width, height);
+
+	// Determine draw coords
+	double top = y + ((double)size * 0.5) - (height * 0.5);
+	double left = x + ((double)size * 0.5) - (width * 0.5);
+
+	// Draw
+	image->bind();
+	OpenGL::setColour(COL_WHITE, false);
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0f, 0.0f);	glVertex2d(left, top);
+	glTexCoord2f(0.0f, 1.0f);	glVertex2d(left, top + height);
+	glTexCoord2f(1.0f, 1.0f);	glVertex2d(left + width, top + height);
+	glTexCoord2f(1.0f, 0.0f);	glVertex2d(left + width, top);
+	glEnd();
+}
+
+/* BrowserItem::drawPlaceholder
+ * Draws a faint outline in a [size]x[size] box at [x],[y], for an
+ * item whose image hasn't been loaded yet
+ *******************************************************************/
+void BrowserItem::drawPlaceholder(int size, int x, int y, rgba_t colour)
+{
+	glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT);
+
+	glDisable(GL_TEXTURE_2D);
+	glColor4ub(colour.r, colour.g, colour.b, 64);
 
+	glBegin(GL_LINE_LOOP);
+	glVertex2i(x + size/4, y + size/4);
+	glVertex2i(x + size/4, y + size - size/4);
+	glVertex2i(x + size - size/4, y + size - size/4);
+	glVertex2i(x + size - size/4, y + size/4);
+	glEnd();
+
+	glPopAttrib();
+}
+
+/* BrowserItem::clearImage
+ * Clears the item image
+ *******************************************************************/
+void BrowserItem::clearImage()
+{
+	if (image) image->clear();
+	image_failed = false;
+}
+
+/* BrowserItem::fitImage
+ * Scales [width] and [height] of an item image to the size it is
+ * drawn at in a [size]x[size] box, keeping the aspect ratio
+ *******************************************************************/
+void BrowserItem::fitImage(int size, double& width, double& height)
+{
 	// Scale up if size > 128
 	if (size > 128)
 	{
@@ -180,27 +271,4 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 			height *= scale;
 		}
 	}
-
-	// Determine draw coords
-	double top = y + ((double)size * 0.5) - (height * 0.5);
-	double left = x + ((double)size * 0.5) - (width * 0.5);
-
-	// Draw
-	image->bind();
-	OpenGL::setColour(COL_WHITE, false);
-
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0f, 0.0f);	glVertex2d(left, top);
-	glTexCoord2f(0.0f, 1.0f);	glVertex2d(left, top + height);
-	glTexCoord2f(1.0f, 1.0f);	glVertex2d(left + width, top + height);
-	glTexCoord2f(1.0f, 0.0f);	glVertex2d(left + width, top);
-	glEnd();
-}
-
-/* BrowserItem::clearImage
- * Clears the item image
- *******************************************************************/
-void BrowserItem::clearImage()
-{
-	if (image) image->clear();
 }
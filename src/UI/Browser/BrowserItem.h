@@ -17,6 +17,7 @@ protected:
 	BrowserWindow*	parent;
 	bool			blank;
 	TextBox*		text_box;
+	bool			image_failed;
 
 public:
 	BrowserItem(string name, unsigned index = 0, string type = "item");
@@ -25,10 +26,21 @@ public:
 	string		getName() { return name; }
 	unsigned	getIndex() { return index; }
 
+	bool			isBlank() { return blank; }
+	GLTexture*		getImage() { return image; }
+	bool			imageLoaded() { return image && image->isLoaded(); }
+	bool			imageFailed() { return image_failed; }
+
 	virtual bool	loadImage();
+	bool			tryLoadImage();
 	void			draw(int size, int x, int y, int font, int nametype = 0, int viewtype = 0, rgba_t colour = COL_WHITE, bool text_shadow = true);
+	void			drawText(int size, int x, int y, int font, int nametype = 0, int viewtype = 0, rgba_t colour = COL_WHITE, bool text_shadow = true);
+	void			drawImage(int size, int x, int y);
+	void			drawPlaceholder(int size, int x, int y, rgba_t colour);
 	void			clearImage();
 	virtual string	itemInfo() { return ""; }
+
+	static void		fitImage(int size, double& width, double& height);
 };
 
 #endif//__BROWSER_ITEM_H__
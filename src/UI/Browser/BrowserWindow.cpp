@@ -275,7 +275,10 @@ void BrowserWindow::clearItems(BrowserTreeNode* node)
 {
 	// Check node was given to begin clear
 	if (!node)
+	{
 		node = items_root;
+		canvas->clearAtlas();
+	}
 
 	// Clear all items from node
 	node->clearItems();
@@ -298,7 +301,10 @@ void BrowserWindow::reloadItems(BrowserTreeNode* node)
 {
 	// Check node was given to begin reload
 	if (!node)
+	{
 		node = items_root;
+		canvas->clearAtlas();
+	}
 
 	// Go through items in this node
 	for (unsigned a = 0; a < node->nItems(); a++)
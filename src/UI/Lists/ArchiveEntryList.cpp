@@ -35,6 +35,10 @@
 #include "Graphics/Icons.h"
 #include "General/ColourConfiguration.h"
 #include "General/UndoRedo.h"
+#include "Graphics/SImage/SImage.h"
+#include "Graphics/ThumbnailCache.h"
+#include "MainEditor/MainEditor.h"
+#include "Utility/StringUtils.h"
 
 
 // ----------------------------------------------------------------------------
@@ -56,6 +60,9 @@ CVAR(Bool, elist_type_bgcol, false, CVAR_SAVE)
 CVAR(Float, elist_type_bgcol_intensity, 0.18, CVAR_SAVE)
 CVAR(Bool, elist_name_monospace, false, CVAR_SAVE)
 CVAR(Bool, elist_alt_row_colour, false, CVAR_SAVE)
+CVAR(Bool, elist_thumbnails, false, CVAR_SAVE)
+CVAR(Int, elist_thumbnails_max, 1024, CVAR_SAVE)
+CVAR(Int, elist_filter_async_min, 50000, CVAR_SAVE)
 wxDEFINE_EVENT(EVT_AEL_DIR_CHANGED, wxCommandEvent);
 
 
@@ -67,6 +74,117 @@ wxDEFINE_EVENT(EVT_AEL_DIR_CHANGED, wxCommandEvent);
 EXTERN_CVAR(Bool, list_font_monospace)
 
 
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// ------------------------------------------------------------------------
+	// filterTerms
+	//
+	// Splits [filter] into lowercase terms, separated by commas
+	// ------------------------------------------------------------------------
+	vector<std::wstring> filterTerms(const string& filter)
+	{
+		vector<std::wstring> terms;
+		for (auto term : wxSplit(filter, ','))
+		{
+			term.Replace(" ", "");
+			if (!term.IsEmpty())
+				terms.push_back(term.Lower().ToStdWstring());
+		}
+
+		return terms;
+	}
+
+	// ------------------------------------------------------------------------
+	// isNarrowerFilter
+	//
+	// Returns true if everything matching [terms] is guaranteed to also match
+	// [previous], ie. each term extends one of the previous terms
+	// ------------------------------------------------------------------------
+	bool isNarrowerFilter(const vector<std::wstring>& terms, const vector<std::wstring>& previous)
+	{
+		if (previous.empty())
+			return true;
+		if (terms.empty())
+			return false;
+
+		for (auto& term : terms)
+		{
+			bool extends = false;
+			for (auto& prev : previous)
+				if (term.compare(0, prev.size(), prev) == 0)
+				{
+					extends = true;
+					break;
+				}
+
+			if (!extends)
+				return false;
+		}
+
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// filterItems
+	//
+	// Returns the item indices from [source] whose [keys] match the given
+	// filter [terms] and [category]. This only uses [keys] so it can be run
+	// from any thread
+	// ------------------------------------------------------------------------
+	template<typename Key> vector<long> filterItems(
+		const vector<Key>& keys,
+		const vector<long>& source,
+		const vector<std::wstring>& terms,
+		const std::wstring& category,
+		bool filter_dirs)
+	{
+		vector<long> result;
+		result.reserve(source.size());
+		for (long index : source)
+		{
+			if (index < 0 || (unsigned)index >= keys.size())
+				continue;
+			auto& key = keys[index];
+
+			// The 'up folder' item is always shown
+			if (key.dir_back)
+			{
+				result.push_back(index);
+				continue;
+			}
+
+			// Check category (folders always match)
+			if (!category.empty() && !key.folder && key.category != category)
+				continue;
+
+			// Check name (folders always match unless elist_filter_dirs is set)
+			if (!terms.empty() && (!key.folder || filter_dirs))
+			{
+				bool match = false;
+				for (auto& term : terms)
+					if (StringUtils::matchesWildcard(key.name, term, true))
+					{
+						match = true;
+						break;
+					}
+
+				if (!match)
+					continue;
+			}
+
+			result.push_back(index);
+		}
+
+		return result;
+	}
+}
+
+
 // ----------------------------------------------------------------------------
 //
 // ArchiveEntryList Class Functions
@@ -88,6 +206,20 @@ EXTERN_CVAR(Bool, list_font_monospace)
 	show_dir_back = false;
 	undo_manager = nullptr;
 	entries_update = true;
+	thumb_maps_valid = false;
+	thumb_next_slot = 0;
+	sorted_column = -1;
+	sorted_descend = false;
+	sorted_valid = false;
+	filtered_dirs = false;
+	filtered_valid = false;
+	filter_generation = 0;
+	filter_pending = false;
+	filter_token = std::make_shared<bool>(true);
+	keys_reindexed = false;
+	key_removing = nullptr;
+	filter_focus = nullptr;
+	filter_restore = false;
 
 	// Create dummy 'up folder' entry
 	entry_dir_back = new ArchiveEntry();
@@ -109,6 +241,7 @@ EXTERN_CVAR(Bool, list_font_monospace)
 	}
 
 	SetImageList(image_list, wxIMAGE_LIST_SMALL);
+	n_type_icons = image_list->GetImageCount();
 
 	// Bind events
 	Bind(wxEVT_LIST_COL_RIGHT_CLICK, &ArchiveEntryList::onColumnHeaderRightClick, this);
@@ -127,6 +260,9 @@ EXTERN_CVAR(Bool, list_font_monospace)
 // ----------------------------------------------------------------------------
 ArchiveEntryList::~ArchiveEntryList()
 {
+	for (auto& thumb : thumbnails)
+		ThumbnailCache::cancel(thumb.second.ticket);
+
 	delete entry_dir_back;
 }
 
@@ -204,6 +340,14 @@ int ArchiveEntryList::getItemIcon(long item, long column, long index) const
 	if (!entry)
 		return -1;
 
+	// Use thumbnail if enabled and available
+	if (elist_thumbnails && entry != entry_dir_back)
+	{
+		int icon = thumbnailIcon(entry);
+		if (icon >= 0)
+			return icon;
+	}
+
 	return entry->getType()->index();
 }
 
@@ -283,6 +427,9 @@ void ArchiveEntryList::setArchive(Archive* archive)
 	if (this->archive)
 		stopListening(this->archive);
 
+	clearThumbnails();
+	invalidateKeys();
+
 	// Set archive (allow null)
 	this->archive = archive;
 
@@ -407,121 +554,152 @@ void ArchiveEntryList::filterList(string filter, string category)
 	filter_text = filter;
 	filter_category = category;
 
-	// Save current selection
-	vector<ArchiveEntry*> selection = getSelectedEntries();
-	ArchiveEntry* focus = getFocusedEntry();
+	// Save current selection, to be restored once the filter is applied (if
+	// a background filter is still running, the selection was already saved)
+	if (!filter_pending)
+	{
+		filter_selection = getSelectedEntries();
+		filter_focus = getFocusedEntry();
+	}
+	filter_restore = true;
 
 	// Apply the filter
 	clearSelection();
 	applyFilter();
-
-	// Restore selection (if selected entries aren't filtered)
-	ArchiveEntry* entry = nullptr;
-	for (int a = 0; a < GetItemCount(); a++)
-	{
-		entry = getEntry(a, false);
-		for (unsigned b = 0; b < selection.size(); b++)
-		{
-			if (entry == selection[b])
-			{
-				selectItem(a);
-				break;
-			}
-		}
-
-		if (entry == focus)
-		{
-			focusItem(a);
-			EnsureVisible(a);
-		}
-	}
 }
 
 // ----------------------------------------------------------------------------
 // ArchiveEntryList::applyFilter
 //
-// Applies the current filter(s) to the list
+// Applies the current filter(s) to the list.
+// If the filter only narrows down the previous one (eg. more characters were
+// typed), only the currently shown items are checked. Items are taken from
+// the cached sort order so the result never needs re-sorting, and if there
+// are more than elist_filter_async_min items to check the filter is run in
+// the background, the list is updated when it finishes
 // ----------------------------------------------------------------------------
 void ArchiveEntryList::applyFilter()
 {
-	// Clear current filter list
-	items.clear();
+	// Cancel any background filter in progress
+	filter_generation++;
+	filter_pending = false;
 
-	// Check if any filters were given
-	if (filter_text.IsEmpty() && filter_category.IsEmpty())
+	if (!current_dir)
 	{
-		// No filter, just refresh the list
-		unsigned count = current_dir->numEntries() + current_dir->nChildren();
-		for (unsigned a = 0; a < count; a++)
-			items.push_back(a);
+		items.clear();
 		updateList();
+		return;
+	}
 
+	// Update cached keys and sort order if needed
+	bool keys_updated = !item_keys || keys_reindexed;
+	keys_reindexed = false;
+	updateKeys();
+	if (!sorted_valid || sorted_column != sort_column || sorted_descend != sort_descend)
+		updateSortOrder();
+
+	vector<std::wstring> terms = filterTerms(filter_text);
+	std::wstring category = filter_category.Lower().ToStdWstring();
+	bool filter_dirs = elist_filter_dirs;
+
+	// Check if any filters were given
+	if (terms.empty() && category.empty())
+	{
+		// No filter, just show everything
+		items = sorted_all;
+		filterFinished(items, terms, category, filter_dirs);
 		return;
 	}
 
-	// Filter by category
-	unsigned index = 0;
-	ArchiveEntry* entry = getEntry(index, false);
-	while (entry)
+	// Check if we can filter the currently shown items rather than everything
+	const vector<long>* source = &sorted_all;
+	if (filtered_valid &&
+		category == filtered_category &&
+		filter_dirs == filtered_dirs &&
+		isNarrowerFilter(terms, filtered_terms))
+		source = &items;
+
+	// Filter in the background if there are a lot of items to check
+	// (not if the keys were just updated or items added/removed, since the
+	// items currently shown may no longer be valid)
+	if (!keys_updated && elist_filter_async_min > 0 && source->size() >= (unsigned)elist_filter_async_min)
 	{
-		if (filter_category.IsEmpty() || entry->getType() == EntryType::folderType())
-			items.push_back(index);	// If no category specified, just add all entries to the filter
-		else
+		filter_pending = true;
+
+		auto list = this;
+		auto keys = item_keys;
+		auto generation = filter_generation;
+		std::weak_ptr<bool> token = filter_token;
+		vector<long> source_items = *source;
+		filter_worker.queue([=]()
 		{
-			// Check for category match
-			if (S_CMPNOCASE(entry->getType()->category(), filter_category))
-				items.push_back(index);
-		}
+			auto result = std::make_shared<vector<long>>(filterItems(*keys, source_items, terms, category, filter_dirs));
+			if (!wxTheApp)
+				return;
 
-		entry = getEntry(++index, false);
-	}
+			wxTheApp->CallAfter([=]()
+			{
+				// Ignore if the list was destroyed or the filter has changed since
+				if (token.expired() || generation != list->filter_generation)
+					return;
 
-	// Now filter by name if needed
-	if (!filter_text.IsEmpty())
-	{
-		// Split filter by ,
-		wxArrayString terms = wxSplit(filter_text, ',');
+				list->filter_pending = false;
+				list->filterFinished(*result, terms, category, filter_dirs);
+			});
+		});
 
-		// Process filter strings
-		for (unsigned a = 0; a < terms.size(); a++)
-		{
-			// Remove spaces
-			terms[a].Replace(" ", "");
+		return;
+	}
 
-			// Set to lowercase and add * to the end
-			if (!terms[a].IsEmpty()) terms[a] = terms[a].Lower() + "*";
-		}
+	auto result = filterItems(*item_keys, *source, terms, category, filter_dirs);
+	filterFinished(result, terms, category, filter_dirs);
+}
 
-		// Go through filtered list
-		for (unsigned a = 0; a < items.size(); a++)
-		{
-			entry = getEntry(items[a], false);
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::filterFinished
+//
+// Called when the current filter has been applied, with the filtered item
+// indices in [result]. Updates the list and restores the previous selection
+// if needed
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::filterFinished(
+	vector<long>& result,
+	const vector<std::wstring>& terms,
+	const std::wstring& category,
+	bool filter_dirs)
+{
+	if (&result != &items)
+		items.swap(result);
+	filtered_terms = terms;
+	filtered_category = category;
+	filtered_dirs = filter_dirs;
+	filtered_valid = true;
 
-			// Don't filter folders if !elist_filter_dirs
-			if (!elist_filter_dirs && entry->getType() == EntryType::folderType())
-				continue;
+	// Update the list
+	updateList();
 
-			// Check for name match with filter
-			bool match = false;
-			for (unsigned b = 0; b < terms.size(); b++)
-			{
-				if (entry == entry_dir_back || entry->getName().Lower().Matches(terms[b]))
-				{
-					match = true;
-					continue;
-				}
-			}
-			if (match)
-				continue;
+	if (!filter_restore)
+		return;
+	filter_restore = false;
 
-			// No match, remove from filtered list
-			items.erase(items.begin() + a);
-			a--;
+	// Restore selection (if selected entries aren't filtered)
+	std::sort(filter_selection.begin(), filter_selection.end());
+	ArchiveEntry* entry = nullptr;
+	for (int a = 0; a < GetItemCount(); a++)
+	{
+		entry = getEntry(a);
+		if (std::binary_search(filter_selection.begin(), filter_selection.end(), entry))
+			selectItem(a);
+
+		if (entry == filter_focus)
+		{
+			focusItem(a);
+			EnsureVisible(a);
 		}
 	}
 
-	// Update the list
-	updateList();
+	filter_selection.clear();
+	filter_focus = nullptr;
 }
 
 // ----------------------------------------------------------------------------
@@ -537,16 +715,14 @@ bool ArchiveEntryList::setDir(ArchiveTreeNode* dir)
 
 	// Set current dir
 	current_dir = dir;
+	invalidateKeys();
 
 	// Clear current selection
 	clearSelection();
 
-	// Update filter
+	// Update filter (also updates the list)
 	applyFilter();
 
-	// Update list
-	updateList();
-
 	// Fire event
 	wxCommandEvent evt(EVT_AEL_DIR_CHANGED, GetId());
 	ProcessWindowEvent(evt);
@@ -586,6 +762,246 @@ int ArchiveEntryList::entrySize(long index)
 		return entry->getSize();
 }
 
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::thumbnailIcon
+//
+// Returns the image list index of the thumbnail for [entry], or -1 if it has
+// none. If the thumbnail hasn't been generated yet it is requested from the
+// ThumbnailCache, and the list is refreshed when it is ready
+// ----------------------------------------------------------------------------
+int ArchiveEntryList::thumbnailIcon(ArchiveEntry* entry) const
+{
+	bool is_map = entry->getType() == EntryType::mapMarkerType();
+	if (!is_map && !entry->getType()->extraProps().propertyExists("image"))
+		return -1;
+
+	// Check for existing thumbnail (image thumbnails are redone if the entry
+	// data has changed)
+	uint64_t hash = is_map ? 0 : entry->getContentHash(false);
+	auto existing = thumbnails.find(entry);
+	if (existing != thumbnails.end())
+	{
+		if (existing->second.hash == hash)
+			return existing->second.icon;
+		removeThumbnail(entry);
+	}
+
+	Thumbnail& thumb = thumbnails[entry];
+	thumb.icon = -1;
+	thumb.ticket = 0;
+	thumb.map = is_map;
+
+	// Request thumbnail
+	auto list = const_cast<ArchiveEntryList*>(this);
+	auto callback = [list, entry](SImage& image, bool ok) { list->addThumbnail(entry, image, ok); };
+	unsigned ticket = 0;
+	if (is_map)
+	{
+		// Find map for the marker entry
+		if (!thumb_maps_valid && archive)
+		{
+			thumb_maps = archive->detectMaps();
+			thumb_maps_valid = true;
+		}
+		for (auto& map : thumb_maps)
+			if (map.head == entry)
+			{
+				ticket = ThumbnailCache::requestMapImage(map, 16, callback);
+				break;
+			}
+	}
+	else
+		ticket = ThumbnailCache::requestImage(entry, 16, MainEditor::currentPalette(entry), callback);
+
+	// The request calculates the content hash if it wasn't already
+	Thumbnail& requested = thumbnails[entry];
+	requested.ticket = ticket;
+	requested.hash = is_map ? 0 : entry->getContentHash(false);
+
+	return requested.icon;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::addThumbnail
+//
+// Called when the thumbnail [image] for [entry] is ready. The thumbnail is
+// added to the image list in a free slot if there is one, otherwise in a new
+// slot or replacing the oldest thumbnail if the maximum number of thumbnails
+// is reached
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::addThumbnail(ArchiveEntry* entry, SImage& image, bool ok)
+{
+	auto thumb = thumbnails.find(entry);
+	if (thumb == thumbnails.end())
+		return;
+
+	thumb->second.ticket = 0;
+	if (!ok)
+		return;
+
+	// Convert to wxBitmap
+	MemChunk rgba;
+	if (!image.getRGBAData(rgba))
+		return;
+	wxImage wx_image(image.getWidth(), image.getHeight(), false);
+	wx_image.InitAlpha();
+	const uint8_t* pixel = rgba.getData();
+	for (int y = 0; y < image.getHeight(); y++)
+		for (int x = 0; x < image.getWidth(); x++, pixel += 4)
+		{
+			wx_image.SetRGB(x, y, pixel[0], pixel[1], pixel[2]);
+			wx_image.SetAlpha(x, y, pixel[3]);
+		}
+	wxBitmap bitmap(wx_image);
+
+	// Add to image list
+	wxImageList* image_list = GetImageList(wxIMAGE_LIST_SMALL);
+	unsigned max = MAX((int)elist_thumbnails_max, 1);
+	int icon;
+	if (!thumb_free_slots.empty())
+	{
+		// Reuse a slot freed by a removed thumbnail
+		unsigned slot = thumb_free_slots.back();
+		thumb_free_slots.pop_back();
+		icon = n_type_icons + slot;
+		image_list->Replace(icon, bitmap);
+		thumb_slots[slot] = entry;
+	}
+	else if (thumb_slots.size() < max)
+	{
+		icon = image_list->Add(bitmap);
+		thumb_slots.push_back(entry);
+	}
+	else
+	{
+		// Reuse the oldest slot
+		unsigned slot = thumb_next_slot;
+		thumb_next_slot = (thumb_next_slot + 1) % thumb_slots.size();
+		icon = n_type_icons + slot;
+		image_list->Replace(icon, bitmap);
+
+		auto old = thumbnails.find(thumb_slots[slot]);
+		if (old != thumbnails.end() && old->second.icon == icon)
+			thumbnails.erase(old);
+		thumb_slots[slot] = entry;
+	}
+	thumb->second.icon = icon;
+
+	// Refresh visible items
+	if (GetItemCount() > 0)
+		RefreshItems(GetTopItem(), MIN(GetTopItem() + GetCountPerPage(), GetItemCount() - 1));
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::removeThumbnail
+//
+// Removes the thumbnail for [entry] (if any), cancelling its request and
+// freeing its image list slot for reuse
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::removeThumbnail(ArchiveEntry* entry) const
+{
+	auto thumb = thumbnails.find(entry);
+	if (thumb == thumbnails.end())
+		return;
+
+	ThumbnailCache::cancel(thumb->second.ticket);
+
+	int slot = thumb->second.icon - n_type_icons;
+	if (thumb->second.icon >= 0 && slot >= 0 && slot < (int)thumb_slots.size() && thumb_slots[slot] == entry)
+	{
+		thumb_slots[slot] = nullptr;
+		thumb_free_slots.push_back(slot);
+	}
+
+	thumbnails.erase(thumb);
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::invalidateThumbnail
+//
+// Removes the thumbnail for [entry] and for the map it is part of (if any).
+// If [structure_changed] is true, [entry] was added, removed or renamed, so
+// the detected maps need to be updated
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::invalidateThumbnail(ArchiveEntry* entry, bool structure_changed)
+{
+	removeThumbnail(entry);
+
+	// Find any map thumbnails containing the entry (or the one before it, in
+	// case a lump was added to the end of a map)
+	bool have_maps = false;
+	for (auto& thumb : thumbnails)
+		if (thumb.second.map)
+		{
+			have_maps = true;
+			break;
+		}
+
+	if (have_maps)
+	{
+		if (thumb_maps_valid)
+		{
+			for (auto& map : thumb_maps)
+			{
+				if (map.archive)
+					continue;
+
+				for (auto lump = map.head; lump; lump = lump->nextEntry())
+				{
+					if (lump == entry || lump == entry->prevEntry())
+					{
+						removeThumbnail(map.head);
+						break;
+					}
+
+					if (lump == map.end)
+						break;
+				}
+			}
+		}
+		else
+			clearThumbnails(true);
+	}
+
+	if (structure_changed)
+		thumb_maps_valid = false;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::clearThumbnails
+//
+// Clears all entry thumbnails, or only map thumbnails if [maps_only] is true.
+// The image list slots are kept for reuse by new thumbnails
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::clearThumbnails(bool maps_only)
+{
+	thumb_maps_valid = false;
+
+	if (maps_only)
+	{
+		vector<ArchiveEntry*> maps;
+		for (auto& thumb : thumbnails)
+			if (thumb.second.map)
+				maps.push_back(thumb.first);
+		for (auto entry : maps)
+			removeThumbnail(entry);
+		return;
+	}
+
+	for (auto& thumb : thumbnails)
+		ThumbnailCache::cancel(thumb.second.ticket);
+	thumbnails.clear();
+
+	// Free all image list slots
+	thumb_free_slots.clear();
+	for (unsigned a = 0; a < thumb_slots.size(); a++)
+	{
+		thumb_slots[a] = nullptr;
+		thumb_free_slots.push_back(a);
+	}
+	thumb_next_slot = 0;
+}
+
 // ----------------------------------------------------------------------------
 // ArchiveEntryList::sortItems
 //
@@ -593,32 +1009,227 @@ int ArchiveEntryList::entrySize(long index)
 // ----------------------------------------------------------------------------
 void ArchiveEntryList::sortItems()
 {
-	lv_current = this;
-	std::sort(items.begin(), items.end(), [&](long left, long right)
+	// Items are always kept in the cached sort order, so nothing to do unless
+	// the sorting has changed
+	if (sorted_valid && sorted_column == sort_column && sorted_descend == sort_descend)
+		return;
+
+	updateSortOrder();
+
+	// Reorder items to match the new sort order
+	vector<long> order(sorted_all.size(), -1);
+	for (unsigned a = 0; a < sorted_all.size(); a++)
+		order[sorted_all[a]] = a;
+
+	vector<long> sorted;
+	sorted.reserve(items.size());
+	for (long index : items)
+		if (index >= 0 && (unsigned)index < order.size())
+			sorted.push_back(index);
+	std::sort(sorted.begin(), sorted.end(), [&](long left, long right) { return order[left] < order[right]; });
+	items.swap(sorted);
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::invalidateKeys
+//
+// Marks the cached item keys and sort order as out of date, they will be
+// rebuilt the next time the filter is applied
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::invalidateKeys()
+{
+	item_keys.reset();
+	sorted_valid = false;
+	filtered_valid = false;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::updateEntryKey
+//
+// Updates the cached key for [entry] if it is in the current directory, after
+// it was added or modified, or removed from [index]. The sort order and
+// filtered items are rebuilt the next time the filter is applied
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::updateEntryKey(ArchiveEntry* entry, KeyUpdate update, int index)
+{
+	if (!entry)
+		return;
+
+	// The entry's directory isn't known once it has been removed, so keep
+	// track of it when it's about to be
+	if (update == KeyUpdate::Removing)
+	{
+		key_removing = entry->getParentDir() == current_dir ? entry : nullptr;
+		return;
+	}
+	if (update == KeyUpdate::Removed)
+	{
+		if (entry != key_removing)
+			return;
+		key_removing = nullptr;
+	}
+	else
+	{
+		if (entry->getParentDir() != current_dir)
+			return;
+		index = current_dir->entryIndex(entry);
+	}
+
+	// Nothing to do if the keys are already out of date
+	if (!item_keys)
+		return;
+
+	sorted_valid = false;
+	filtered_valid = false;
+
+	// Check the keys match the directory as it was before the change,
+	// otherwise rebuild them all
+	unsigned count = entriesBegin() + current_dir->numEntries();
+	if (update == KeyUpdate::Added)
+		count--;
+	else if (update == KeyUpdate::Removed)
+		count++;
+	unsigned key_index = entriesBegin() + index;
+	if (index < 0 || item_keys->size() != count || key_index > count ||
+		(key_index == count && update != KeyUpdate::Added))
+	{
+		invalidateKeys();
+		return;
+	}
+
+	// Don't change the keys if a background filter is still using them
+	if (item_keys.use_count() > 1)
+		item_keys = std::make_shared<vector<ItemKey>>(*item_keys);
+
+	// Update the entry's key
+	auto key = item_keys->begin() + key_index;
+	if (update == KeyUpdate::Removed)
+	{
+		item_keys->erase(key);
+		keys_reindexed = true;
+		return;
+	}
+	if (update == KeyUpdate::Added)
+	{
+		key = item_keys->insert(key, ItemKey());
+		keys_reindexed = true;
+	}
+	key->name = entry->getName().Lower().ToStdWstring();
+	key->category = entry->getType()->category().Lower().ToStdWstring();
+	key->folder = entry->getType() == EntryType::folderType();
+	key->dir_back = false;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::updateKeys
+//
+// Rebuilds the cached filtering keys for all items in the current directory,
+// if they are out of date
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::updateKeys()
+{
+	if (item_keys)
+		return;
+
+	auto keys = std::make_shared<vector<ItemKey>>();
+	if (current_dir)
 	{
-		auto le = getEntry(left, false);
-		auto re = getEntry(right, false);
+		unsigned count = current_dir->numEntries() + current_dir->nChildren();
+		if (show_dir_back && current_dir->getParent())
+			count++;
+		keys->resize(count);
 
-		// Sort folder->entry first
-		if (le->getType() == EntryType::folderType() && re->getType() != EntryType::folderType())
-			return true;
-		if (re->getType() == EntryType::folderType() && le->getType() != EntryType::folderType())
-			return false;
+		for (unsigned a = 0; a < count; a++)
+		{
+			ArchiveEntry* entry = getEntry(a, false);
+			if (!entry)
+				continue;
 
-		// Name sort
-		if (col_name >= 0 && col_name == sortColumn())
-			return sort_descend ? le->getName() > re->getName() : le->getName() < re->getName();
+			ItemKey& key = (*keys)[a];
+			key.name = entry->getName().Lower().ToStdWstring();
+			key.category = entry->getType()->category().Lower().ToStdWstring();
+			key.folder = entry->getType() == EntryType::folderType();
+			key.dir_back = entry == entry_dir_back;
+		}
+	}
+
+	item_keys = keys;
+	sorted_valid = false;
+}
+
+// ----------------------------------------------------------------------------
+// ArchiveEntryList::updateSortOrder
+//
+// Sorts all items in the current directory by the current sort column. The
+// value to sort by is calculated once per item beforehand rather than for
+// each comparison
+// ----------------------------------------------------------------------------
+void ArchiveEntryList::updateSortOrder()
+{
+	updateKeys();
+
+	unsigned count = item_keys->size();
+	sorted_all.resize(count);
+	for (unsigned a = 0; a < count; a++)
+		sorted_all[a] = a;
+
+	sorted_column = sort_column;
+	sorted_descend = sort_descend;
+	sorted_valid = true;
+
+	// Get sort values for the current sort column
+	bool sort_name = col_name >= 0 && col_name == sort_column;
+	bool sort_size = col_size >= 0 && col_size == sort_column;
+	bool sort_index = col_index >= 0 && col_index == sort_column;
+	vector<string> sort_text;
+	vector<int> sort_sizes;
+	if (sort_size)
+	{
+		sort_sizes.resize(count);
+		for (unsigned a = 0; a < count; a++)
+			sort_sizes[a] = entrySize(a);
+	}
+	else if (sort_column >= 0 && !sort_index)
+	{
+		sort_text.resize(count);
+		for (unsigned a = 0; a < count; a++)
+		{
+			if (sort_name)
+			{
+				ArchiveEntry* entry = getEntry(a, false);
+				if (entry)
+					sort_text[a] = entry->getName();
+			}
+			else
+				sort_text[a] = getItemText(a, sort_column, a).Lower();
+		}
+	}
+
+	auto& keys = *item_keys;
+	bool descend = sort_descend;
+	std::sort(sorted_all.begin(), sorted_all.end(), [&](long left, long right)
+	{
+		// Sort folder->entry first
+		if (keys[left].folder != keys[right].folder)
+			return keys[left].folder;
 
 		// Size sort
-		if (col_size >= 0 && col_size == sortColumn())
-			return sort_descend ? entrySize(left) > entrySize(right) : entrySize(left) < entrySize(right);
+		if (sort_size && sort_sizes[left] != sort_sizes[right])
+			return descend ? sort_sizes[left] > sort_sizes[right] : sort_sizes[left] < sort_sizes[right];
 
-		// Index sort
-		if (col_index >= 0 && col_index == sortColumn())
-			return sort_descend ? left > right : left < right;
+		// Name or column text sort
+		if (!sort_text.empty())
+		{
+			int result = sort_text[left].compare(sort_text[right]);
+			if (result != 0)
+				return descend ? result > 0 : result < 0;
+		}
 
-		// Other (default) sort
-		return VirtualListView::defaultSort(left, right);
+		// Index sort (also when there is no sort column)
+		if (sort_index || sort_column < 0)
+			return descend ? left > right : left < right;
+
+		return left < right;
 	});
 }
 
@@ -848,13 +1459,72 @@ void ArchiveEntryList::labelEdited(int col, int index, string new_label)
 }
 
 // ----------------------------------------------------------------------------
-// ArchiveEntryList::onAnnouncement
+// ArchiveEntryList::onAnnouncementEvent
 //
 // Called when an announcement is recieved from the archive being managed
 // ----------------------------------------------------------------------------
-void ArchiveEntryList::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+void ArchiveEntryList::onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data)
 {
-	if (entries_update && announcer == archive && event_name != "closed")
+	static const Announcement::Id closed = Announcement::id("closed");
+	static const Announcement::Id entry_state_changed = Announcement::id("entry_state_changed");
+	static const Announcement::Id entry_added = Announcement::id("entry_added");
+	static const Announcement::Id entry_removing = Announcement::id("entry_removing");
+	static const Announcement::Id entry_removed = Announcement::id("entry_removed");
+	static const Announcement::Id entry_renaming = Announcement::id("entry_renaming");
+	static const Announcement::Id entries_changed = Announcement::id("entries_changed");
+	static const Announcement::Id entries_swapped = Announcement::id("entries_swapped");
+	static const Announcement::Id directory_added = Announcement::id("directory_added");
+	static const Announcement::Id directory_modified = Announcement::id("directory_modified");
+	static const Announcement::Id directory_removed = Announcement::id("directory_removed");
+
+	if (announcer == archive)
+	{
+		// Update the thumbnail and cached filter/sort key of the changed
+		// entry only (map thumbnails can't tell if map data has changed, so
+		// are redone). A renamed entry's key is updated when its state
+		// changes after the rename
+		if (event == entry_state_changed || event == entry_added || event == entry_removing ||
+			event == entry_removed || event == entry_renaming)
+		{
+			int32_t index = -1;
+			wxUIntPtr ptr = 0;
+			event_data.seek(0, SEEK_SET);
+			event_data.read(&index, sizeof(int32_t));
+			if (event_data.read(&ptr, sizeof(wxUIntPtr)))
+			{
+				ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
+				if (event != entry_removed)
+					invalidateThumbnail(entry, event != entry_state_changed);
+
+				if (event == entry_state_changed)
+					updateEntryKey(entry, KeyUpdate::Modified);
+				else if (event == entry_added)
+					updateEntryKey(entry, KeyUpdate::Added);
+				else if (event == entry_removing)
+					updateEntryKey(entry, KeyUpdate::Removing);
+				else if (event == entry_removed)
+					updateEntryKey(entry, KeyUpdate::Removed, index);
+			}
+		}
+
+		// Anything else changing the directory contents needs all the keys
+		// rebuilt
+		else if (event == entries_changed || event == entries_swapped)
+		{
+			clearThumbnails(true);
+			invalidateKeys();
+		}
+		else if (event == directory_added || event == directory_modified || event == directory_removed)
+			invalidateKeys();
+	}
+
+	// Don't refresh for each entry removed or renamed during a batch update,
+	// the list will be refreshed when the batch is committed
+	if (announcer == archive && archive->isBatchUpdating() &&
+		(event == entry_removing || event == entry_removed || event == entry_renaming))
+		return;
+
+	if (entries_update && announcer == archive && event != closed)
 	{
 		//updateList();
 		applyFilter();
@@ -6,9 +6,11 @@
 #include "General/ListenerAnnouncer.h"
 #include "General/SAction.h"
 #include "Archive/Archive.h"
+#include "Utility/Parallel.h"
 
 wxDECLARE_EVENT(EVT_AEL_DIR_CHANGED, wxCommandEvent);
 
+class SImage;
 class UndoManager;
 class ArchiveEntryList : public VirtualListView, public Listener, public SActionHandler
 {
@@ -19,7 +21,7 @@ public:
 	ArchiveTreeNode*	getCurrentDir() const { return current_dir; }
 
 	bool	showDirBack() const { return show_dir_back; }
-	void	showDirBack(bool db) { show_dir_back = db; }
+	void	showDirBack(bool db) { show_dir_back = db; invalidateKeys(); }
 
 	void	setArchive(Archive* archive);
 	void	setUndoManager(UndoManager* manager) { undo_manager = manager; }
@@ -49,7 +51,7 @@ public:
 	// Label editing
 	void	labelEdited(int col, int index, string new_label) override;
 
-	void	onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override;
+	void	onAnnouncementEvent(Announcer* announcer, Announcement::Id event, MemChunk& event_data) override;
 
 	// SAction handler
 	bool	handleAction(string id) override;
@@ -78,7 +80,68 @@ private:
 	int					col_type;
 	bool				entries_update;
 
-	int	entrySize(long index);
+	// Filtering/sorting
+	struct ItemKey
+	{
+		std::wstring	name;		// Lowercase name, for filter matching
+		std::wstring	category;	// Lowercase type category
+		bool			folder;
+		bool			dir_back;
+	};
+	typedef std::shared_ptr<vector<ItemKey>> KeyList;
+	enum class KeyUpdate { Added, Modified, Removing, Removed };
+
+	KeyList					item_keys;			// Keys for all items (by unfiltered index), null if out of date
+	bool					keys_reindexed;		// Items were added/removed since the list was last filtered
+	ArchiveEntry*			key_removing;		// Entry in the current directory being removed
+	vector<long>			sorted_all;			// All item indices in the current sort order
+	int						sorted_column;
+	bool					sorted_descend;
+	bool					sorted_valid;
+	vector<std::wstring>	filtered_terms;		// Filter the current items were built with
+	std::wstring			filtered_category;
+	bool					filtered_dirs;
+	bool					filtered_valid;
+	unsigned				filter_generation;
+	bool					filter_pending;
+	std::shared_ptr<bool>	filter_token;		// Expires with the list, for background filtering
+	Parallel::Worker		filter_worker;
+	vector<ArchiveEntry*>	filter_selection;	// Selection to restore once filtering finishes
+	ArchiveEntry*			filter_focus;
+	bool					filter_restore;
+
+	// Thumbnails
+	struct Thumbnail
+	{
+		int			icon;	// Image list index, -1 if not (yet) available
+		unsigned	ticket;
+		uint64_t	hash;
+		bool		map;
+	};
+	mutable std::unordered_map<ArchiveEntry*, Thumbnail>	thumbnails;
+	mutable vector<Archive::MapDesc>						thumb_maps;
+	mutable bool											thumb_maps_valid;
+	mutable vector<ArchiveEntry*>							thumb_slots;		// Entry using each image list slot
+	mutable vector<unsigned>								thumb_free_slots;
+	unsigned												thumb_next_slot;
+	int														n_type_icons;
+
+	int		entrySize(long index);
+	void	invalidateKeys();
+	void	updateEntryKey(ArchiveEntry* entry, KeyUpdate update, int index = -1);
+	void	updateKeys();
+	void	updateSortOrder();
+	void	filterFinished(
+				vector<long>& result,
+				const vector<std::wstring>& terms,
+				const std::wstring& category,
+				bool filter_dirs
+			);
+	int		thumbnailIcon(ArchiveEntry* entry) const;
+	void	addThumbnail(ArchiveEntry* entry, SImage& image, bool ok);
+	void	removeThumbnail(ArchiveEntry* entry) const;
+	void	invalidateThumbnail(ArchiveEntry* entry, bool structure_changed);
+	void	clearThumbnails(bool maps_only = false);
 };
 
 #endif//__ARCHIVE_ENTRY_LIST_H__
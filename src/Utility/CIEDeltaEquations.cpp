@@ -68,7 +68,7 @@ CVAR(Float, col_cie_tristim_z, 108.82, CVAR_SAVE)	// to illuminant D65 and 2
  * The oldest and simplest formula, merely the geometric distance
  * between two points in the colorspace.
  *******************************************************************/
-double CIE::CIE76(lab_t& col1, lab_t& col2)
+double CIE::CIE76(const lab_t& col1, const lab_t& col2)
 {
 	double dl = col1.l - col2.l;
 	double da = col1.a - col2.a;
@@ -81,7 +81,7 @@ double CIE::CIE76(lab_t& col1, lab_t& col2)
  * This one starts to become complicated as it transforms the Lab
  * colorspace into an LCh colorspace to try to be more accurate.
  *******************************************************************/
-double CIE::CIE94(lab_t& col1, lab_t& col2)
+double CIE::CIE94(const lab_t& col1, const lab_t& col2)
 {
 	double dl = col1.l - col2.l;
 	double da = col1.a - col2.a;
@@ -104,7 +104,7 @@ double CIE::CIE94(lab_t& col1, lab_t& col2)
  * children cry. Adds hue rotation and multiple compensations. But
  * it really is a lot better than CIE94 for color matching.
  *******************************************************************/
-double CIE::CIEDE2000(lab_t& col1, lab_t& col2)
+double CIE::CIEDE2000(const lab_t& col1, const lab_t& col2)
 {
 	// Compute chroma values
 	double c1 = sqrt(col1.a * col1.a + col1.b * col1.b);
@@ -45,6 +45,7 @@ MemChunk::MemChunk(uint32_t size)
 	// Init variables
 	this->size = size;
 	this->cur_ptr = 0;
+	this->version = 0;
 
 	// If a size is specified, allocate that much memory
 	if (size)
@@ -62,6 +63,7 @@ MemChunk::MemChunk(const uint8_t* data, uint32_t size)
 	this->cur_ptr = 0;
 	this->data = nullptr;
 	this->size = size;
+	this->version = 0;
 
 	// Load given data
 	importMem(data, size);
@@ -100,6 +102,7 @@ bool MemChunk::clear()
 		data = nullptr;
 		size = 0;
 		cur_ptr = 0;
+		version++;
 		return true;
 	}
 
@@ -343,6 +346,7 @@ bool MemChunk::write(const void* data, uint32_t size)
 	// Write the data and move to the byte after what was written
 	memcpy(this->data + cur_ptr, data, size);
 	cur_ptr += size;
+	version++;
 
 	// Success
 	return true;
@@ -457,6 +461,7 @@ bool MemChunk::fillData(uint8_t val)
 
 	// Fill data with value
 	memset(data, val, size);
+	version++;
 
 	// Success
 	return true;
@@ -474,6 +479,15 @@ uint32_t MemChunk::crc()
 		return 0;
 }
 
+/* MemChunk::hash
+ * Calculates a 64bit hash of the data (see Misc::hash64). Returns
+ * the hash of no data if no data is present
+ *******************************************************************/
+uint64_t MemChunk::hash()
+{
+	return Misc::hash64(data, hasData() ? size : 0);
+}
+
 
 /* MemChunk::allocData
  * Allocates [size] bytes of data and returns it, or NULL if the
@@ -504,5 +518,6 @@ uint8_t* MemChunk::allocData(uint32_t size, bool set_data)
 	if (set_data)
 		data = ndata;
 
+	version++;
 	return ndata;
 }
@@ -7,6 +7,7 @@ protected:
 	uint8_t*	data;
 	uint32_t	cur_ptr;
 	uint32_t	size;
+	uint32_t	version;	// Incremented whenever the data is (or may have been) modified
 
 	uint8_t*	allocData(uint32_t size, bool set_data = true);
 
@@ -15,11 +16,13 @@ public:
 	MemChunk(const uint8_t* data, uint32_t size);
 	~MemChunk();
 
-	uint8_t& operator[](int a) { return data[a]; }
+	uint8_t& operator[](int a) { version++; return data[a]; }
+	uint8_t operator[](int a) const { return data[a]; }
 
 	// Accessors
 	const uint8_t*	getData() const { return data; }
 	uint32_t		getSize() const { return size; }
+	uint32_t		getVersion() const { return version; }
 
 	bool hasData();
 
@@ -49,4 +52,5 @@ public:
 	// Misc
 	bool		fillData(uint8_t val);
 	uint32_t	crc();
+	uint64_t	hash();
 };
@@ -0,0 +1,319 @@
+// ----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    Parallel.cpp
+// Description: Parallel namespace, simple helpers for splitting independent
+//              work items across a number of worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+//
+// Includes
+//
+// ----------------------------------------------------------------------------
+#include "Main.h"
+#include "Parallel.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+
+// ----------------------------------------------------------------------------
+//
+// Variables
+//
+// ----------------------------------------------------------------------------
+CVAR(Int, max_worker_threads, 0, CVAR_SAVE)	// 0 = one thread per core
+
+namespace
+{
+	// A single forEach call being processed
+	struct Job
+	{
+		unsigned								count;
+		const std::function<void(unsigned)>&	func;
+		std::atomic<unsigned>					next{ 0 };
+		std::atomic<unsigned>					done{ 0 };
+		std::atomic<bool>						cancelled{ false };
+		unsigned								slots = 0;	// Number of pool threads that can still join
+		unsigned								active = 0;	// Number of pool threads working on the job
+
+		Job(unsigned count, const std::function<void(unsigned)>& func) : count{ count }, func{ func } {}
+
+		// Processes items until there are none left (or the job is cancelled)
+		void work()
+		{
+			while (!cancelled)
+			{
+				unsigned index = next++;
+				if (index >= count)
+					break;
+
+				func(index);
+				done++;
+			}
+		}
+	};
+
+	// Persistent pool of worker threads that forEach jobs are queued on.
+	// Threads are started as needed and kept until the program exits
+	class WorkerPool
+	{
+	public:
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			work_available.notify_all();
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		void run(Job& job, unsigned n_workers, const Parallel::ProgressFunc& progress)
+		{
+			// Queue the job for [n_workers] pool threads
+			if (n_workers > 0)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				while (threads.size() < n_workers)
+					threads.emplace_back([this]() { workerLoop(); });
+				job.slots = n_workers;
+				jobs.push_back(&job);
+			}
+			work_available.notify_all();
+
+			if (progress)
+			{
+				// Report progress until finished or cancelled
+				std::unique_lock<std::mutex> lock(mutex);
+				while (job.done < job.count && !job.cancelled)
+				{
+					job_finished.wait_for(lock, std::chrono::milliseconds(20));
+					if (job.done >= job.count)
+						break;
+
+					lock.unlock();
+					if (!progress(job.done, job.count))
+						job.cancelled = true;
+					lock.lock();
+				}
+			}
+			else
+			{
+				// Help out with the job on this thread
+				job.work();
+			}
+
+			// Stop any more pool threads picking up the job, and wait for the
+			// ones working on it to finish
+			std::unique_lock<std::mutex> lock(mutex);
+			auto queued = std::find(jobs.begin(), jobs.end(), &job);
+			if (queued != jobs.end())
+				jobs.erase(queued);
+			job_finished.wait(lock, [&job]() { return job.active == 0; });
+		}
+
+	private:
+		std::mutex					mutex;
+		std::condition_variable		work_available;
+		std::condition_variable		job_finished;
+		std::deque<Job*>			jobs;
+		vector<std::thread>			threads;
+		bool						stopping = false;
+
+		void workerLoop()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				work_available.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping)
+					return;
+
+				Job* job = jobs.front();
+				if (--job->slots == 0)
+					jobs.pop_front();
+				job->active++;
+
+				lock.unlock();
+				job->work();
+				lock.lock();
+
+				job->active--;
+				job_finished.notify_all();
+			}
+		}
+	};
+
+	WorkerPool& pool()
+	{
+		static WorkerPool worker_pool;
+		return worker_pool;
+	}
+}
+
+// Background thread and waiting task for a Parallel::Worker
+struct Parallel::Worker::Thread
+{
+	std::mutex				mutex;
+	std::condition_variable	task_available;
+	std::function<void()>	task;
+	std::thread				thread;
+	bool					stopping = false;
+
+	void loop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			task_available.wait(lock, [this]() { return stopping || task; });
+			if (stopping)
+				return;
+
+			auto current = std::move(task);
+			task = nullptr;
+
+			lock.unlock();
+			current();
+			lock.lock();
+		}
+	}
+};
+
+
+// ----------------------------------------------------------------------------
+//
+// Parallel Namespace Functions
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Parallel::numThreads
+//
+// Returns the number of worker threads to use. If [requested] is > 0 it is
+// used, otherwise the max_worker_threads cvar (or the number of cores if that
+// is also 0)
+// ----------------------------------------------------------------------------
+unsigned Parallel::numThreads(int requested)
+{
+	if (requested > 0)
+		return requested;
+	if (max_worker_threads > 0)
+		return max_worker_threads;
+
+	unsigned n_cores = std::thread::hardware_concurrency();
+	return n_cores > 0 ? n_cores : 1;
+}
+
+// ----------------------------------------------------------------------------
+// Parallel::forEach
+//
+// Calls [func] once for each index in [0, count), spread across [n_threads]
+// threads (see numThreads) from a persistent worker pool. [func] must be safe
+// to call concurrently for different indices.
+//
+// Without [progress], the calling thread counts as one of the threads and
+// works on the items too. With [progress], the calling thread only waits,
+// calling [progress] every 20ms - it can cancel the operation by returning
+// false, in which case any items not yet started are skipped. Returns false
+// if cancelled
+// ----------------------------------------------------------------------------
+bool Parallel::forEach(
+	unsigned count,
+	const std::function<void(unsigned)>& func,
+	ProgressFunc progress,
+	int n_threads)
+{
+	if (count == 0)
+		return true;
+
+	// Run small jobs directly
+	unsigned threads_used = MIN(numThreads(n_threads), count);
+	if (threads_used <= 1 && !progress)
+	{
+		for (unsigned a = 0; a < count; a++)
+			func(a);
+		return true;
+	}
+
+	Job job(count, func);
+	pool().run(job, progress ? threads_used : threads_used - 1, progress);
+
+	return !job.cancelled;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// Parallel::Worker Class Functions
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Parallel::Worker::Worker
+//
+// Parallel::Worker class constructor
+// ----------------------------------------------------------------------------
+Parallel::Worker::Worker() : thread{ new Thread() }
+{
+}
+
+// ----------------------------------------------------------------------------
+// Parallel::Worker::~Worker
+//
+// Parallel::Worker class destructor. Drops any waiting task and waits for the
+// current one to finish
+// ----------------------------------------------------------------------------
+Parallel::Worker::~Worker()
+{
+	{
+		std::lock_guard<std::mutex> lock(thread->mutex);
+		thread->stopping = true;
+		thread->task = nullptr;
+	}
+	thread->task_available.notify_all();
+	if (thread->thread.joinable())
+		thread->thread.join();
+}
+
+// ----------------------------------------------------------------------------
+// Parallel::Worker::queue
+//
+// Queues [task] to run on the worker thread, replacing any task that hasn't
+// started yet
+// ----------------------------------------------------------------------------
+void Parallel::Worker::queue(const std::function<void()>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(thread->mutex);
+		thread->task = task;
+		if (!thread->thread.joinable())
+		{
+			Thread* worker = thread.get();
+			thread->thread = std::thread([worker]() { worker->loop(); });
+		}
+	}
+	thread->task_available.notify_all();
+}
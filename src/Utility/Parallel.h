@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Parallel
+{
+	// Called periodically from the calling thread with the number of items
+	// processed so far and the total number, should return false to cancel
+	typedef std::function<bool(unsigned done, unsigned total)> ProgressFunc;
+
+	unsigned	numThreads(int requested = 0);
+	bool		forEach(
+					unsigned count,
+					const std::function<void(unsigned)>& func,
+					ProgressFunc progress = nullptr,
+					int n_threads = 0
+				);
+
+	// A single background thread for tasks that can be superseded, eg.
+	// filtering a list as the user types. Queueing a task replaces any task
+	// still waiting to start, so only the latest one is run after the
+	// current task finishes. The thread is started when first needed and
+	// stopped (after finishing the current task) when the worker is destroyed
+	class Worker
+	{
+	public:
+		Worker();
+		~Worker();
+
+		void	queue(const std::function<void()>& task);
+
+	private:
+		struct Thread;
+		std::unique_ptr<Thread>	thread;
+	};
+}
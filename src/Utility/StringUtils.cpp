@@ -225,3 +225,55 @@ bool StringUtils::isFloat(const string& str)
 {
 	return (re_float.Matches(str));
 }
+
+// ----------------------------------------------------------------------------
+// StringUtils::matchesWildcard
+//
+// Returns true if [str] matches [pattern], which can contain * and ?
+// wildcards (case-sensitive, same as wxString::Matches). If [prefix] is true,
+// [str] only needs to begin with [pattern] (ie. [pattern] is followed by an
+// implicit *). Works on std::wstring so it can be safely used from any thread
+// ----------------------------------------------------------------------------
+bool StringUtils::matchesWildcard(const std::wstring& str, const std::wstring& pattern, bool prefix)
+{
+	// No wildcards, just compare
+	if (pattern.find_first_of(L"*?") == std::wstring::npos)
+	{
+		if (prefix)
+			return str.compare(0, pattern.size(), pattern) == 0;
+		else
+			return str == pattern;
+	}
+
+	// Wildcard match, backtracking to the last * on a mismatch
+	size_t s = 0, p = 0;
+	size_t star = std::wstring::npos, star_s = 0;
+	while (s < str.size())
+	{
+		if (p == pattern.size() && prefix)
+			return true;	// Rest of the string is matched by the implicit trailing *
+
+		if (p < pattern.size() && pattern[p] == L'*')
+		{
+			star = p++;
+			star_s = s;
+		}
+		else if (p < pattern.size() && (pattern[p] == L'?' || pattern[p] == str[s]))
+		{
+			p++;
+			s++;
+		}
+		else if (star != std::wstring::npos)
+		{
+			p = star + 1;
+			s = ++star_s;
+		}
+		else
+			return false;
+	}
+
+	// String finished, remaining pattern must be all *
+	while (p < pattern.size() && pattern[p] == L'*')
+		p++;
+	return p == pattern.size();
+}
@@ -27,4 +27,6 @@ namespace StringUtils
 	bool	isInteger(const string& str, bool allow_hex = true);
 	bool	isHex(const string& str);
 	bool	isFloat(const string& str);
+
+	bool	matchesWildcard(const std::wstring& str, const std::wstring& pattern, bool prefix = false);
 }
@@ -301,10 +301,10 @@ struct rgba_t
 	float fb() { return (float)b / 255.0f; }
 	float fa() { return (float)a / 255.0f; }
 
-	double dr() { return (double)r / 255.0; }
-	double dg() { return (double)g / 255.0; }
-	double db() { return (double)b / 255.0; }
-	double da() { return (double)a / 255.0; }
+	double dr() const { return (double)r / 255.0; }
+	double dg() const { return (double)g / 255.0; }
+	double db() const { return (double)b / 255.0; }
+	double da() const { return (double)a / 255.0; }
 
 	bool equals(rgba_t rhs, bool alpha = false, bool index = false)
 	{
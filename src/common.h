@@ -140,6 +140,7 @@
 
 // C++
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <functional>
 #include <algorithm>